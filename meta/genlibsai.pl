@@ -0,0 +1,229 @@
+#!/usr/bin/perl
+#
+# Copyright (c) 2023 Microsoft Open Technologies, Inc.
+#
+#    Licensed under the Apache License, Version 2.0 (the "License"); you may
+#    not use this file except in compliance with the License. You may obtain
+#    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+#
+#    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+#    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+#    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+#    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+#
+#    See the Apache Version 2.0 License for specific language governing
+#    permissions and limitations under the License.
+#
+#    Microsoft would like to thank the following companies for their review and
+#    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+#    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+#
+# @file    genlibsai.pl
+#
+# @brief   This module generates libsaiapis.h, the method tables of libsai.so
+#
+# Every member of every sai_*_api_t struct is bound to one of the generic
+# libsai operations, based on its name (create_port, get_port_stats,
+# create_route_entries, ...). Members which do not follow any of those
+# patterns are bound to a stub returning SAI_STATUS_NOT_IMPLEMENTED. The
+# signature of each member is checked by the compiler in libsai.cpp, so
+# nothing is taken from this script but names.
+#
+
+BEGIN { push @INC,'.'; }
+
+use strict;
+use warnings;
+use diagnostics;
+
+use utils;
+
+our $INCLUDE_DIR = "../inc/";
+our $EXPERIMENTAL_DIR = "../experimental/";
+
+our $APIS_CONTENT = "";
+
+our %OBJECT_TYPES = ();
+our %APIS = ();
+
+sub WriteApis
+{
+    my $content = shift;
+
+    $APIS_CONTENT .= $content . "\n";
+}
+
+sub GetAllHeaderFiles
+{
+    my @headers = GetHeaderFiles();
+    my @exheaders = GetExperimentalHeaderFiles();
+
+    return (@headers, @exheaders);
+}
+
+sub ExtractObjectTypes
+{
+    for my $header (GetAllHeaderFiles())
+    {
+        my $data = ReadHeaderFile($header);
+
+        while ($data =~ /typedef\s+enum\s+_sai_object_type(?:_extensions)?_t\s*{(.+?)}/gs)
+        {
+            my $values = $1;
+
+            for my $ot ($values =~ /^\s*SAI_OBJECT_TYPE_(\w+)\b/mg)
+            {
+                next if $ot =~ /^(NULL|MAX|EXTENSIONS_RANGE_\w+)$/;
+
+                $OBJECT_TYPES{lc($ot)} = $ot;
+            }
+        }
+    }
+
+    LogError "no object types found" if scalar keys %OBJECT_TYPES == 0;
+}
+
+sub ExtractApis
+{
+    for my $header (GetAllHeaderFiles())
+    {
+        my $data = ReadHeaderFile($header);
+
+        while ($data =~ /typedef\s+struct\s+_sai_(\w+)_api_t\s*{(.+?)}\s*sai_\1_api_t\s*;/gs)
+        {
+            my $api = $1;
+            my $body = $2;
+
+            $body =~ s!/\*.*?\*/!!gs;
+
+            my @members = $body =~ /^\s*\w+\s+(\w+)\s*;/mg;
+
+            LogError "api struct sai_${api}_api_t has no members" if scalar @members == 0;
+
+            $APIS{$api} = \@members;
+        }
+    }
+
+    LogError "no api structs found" if scalar keys %APIS == 0;
+}
+
+sub GetBulkObjectType
+{
+    my $name = shift;
+
+    for my $single ($name =~ /^(\w+)ies$/ ? ("${1}y") : (), $name =~ /^(\w+)es$/ ? ($1) : (), $name =~ /^(\w+)s$/ ? ($1) : ())
+    {
+        return $OBJECT_TYPES{$single} if defined $OBJECT_TYPES{$single};
+    }
+
+    return undef;
+}
+
+sub GetMemberBinding
+{
+    my $member = shift;
+
+    my %quad = (create => "CREATE", remove => "REMOVE");
+
+    if ($member =~ /^(create|remove)_(\w+)$/)
+    {
+        return ($quad{$1}, $OBJECT_TYPES{$2}) if defined $OBJECT_TYPES{$2};
+
+        my $ot = GetBulkObjectType($2);
+
+        return ("BULK_$quad{$1}", $ot) if defined $ot;
+    }
+
+    if ($member =~ /^(set|get)_(\w+)_attribute$/)
+    {
+        my $op = uc($1);
+
+        return ($op, $OBJECT_TYPES{$2}) if defined $OBJECT_TYPES{$2};
+
+        my $ot = GetBulkObjectType($2);
+
+        return ("BULK_$op", $ot) if defined $ot;
+    }
+
+    if ($member =~ /^get_(\w+)_stats(_ext)?$/ and defined $OBJECT_TYPES{$1})
+    {
+        return ((defined $2) ? "GET_STATS_EXT" : "GET_STATS", $OBJECT_TYPES{$1});
+    }
+
+    if ($member =~ /^clear_(\w+)_stats$/ and defined $OBJECT_TYPES{$1})
+    {
+        return ("CLEAR_STATS", $OBJECT_TYPES{$1});
+    }
+
+    return ();
+}
+
+sub CreateApiTables
+{
+    WriteApis "/* Method tables of all SAI APIs */";
+    WriteApis "";
+
+    for my $api (sort keys %APIS)
+    {
+        WriteApis "static sai_${api}_api_t libsai_${api}_api;";
+    }
+
+    WriteApis "";
+    WriteApis "static void libsai_apis_init(void)";
+    WriteApis "{";
+
+    for my $api (sort keys %APIS)
+    {
+        for my $member (@{ $APIS{$api} })
+        {
+            my ($op, $ot) = GetMemberBinding($member);
+
+            if (defined $op)
+            {
+                WriteApis "    LIBSAI_METHOD($api, $member, $op, $ot);";
+            }
+            else
+            {
+                WriteApis "    LIBSAI_STUB($api, $member);";
+            }
+        }
+    }
+
+    WriteApis "}";
+    WriteApis "";
+    WriteApis "static void* libsai_api_table(";
+    WriteApis "        _In_ sai_api_t api)";
+    WriteApis "{";
+    WriteApis "    switch ((int)api)";
+    WriteApis "    {";
+
+    for my $api (sort keys %APIS)
+    {
+        WriteApis "        case SAI_API_" . uc($api) . ":";
+        WriteApis "            return &libsai_${api}_api;";
+    }
+
+    WriteApis "        default:";
+    WriteApis "            return NULL;";
+    WriteApis "    }";
+    WriteApis "}";
+}
+
+ExtractObjectTypes();
+
+ExtractApis();
+
+WriteApis "/* generated by genlibsai.pl, do not edit */";
+WriteApis "";
+WriteApis "#ifndef __LIBSAIAPIS_H__";
+WriteApis "#define __LIBSAIAPIS_H__";
+WriteApis "";
+
+CreateApiTables();
+
+WriteApis "";
+WriteApis "#endif /* __LIBSAIAPIS_H__ */";
+
+ExitOnErrors();
+
+WriteFile("libsaiapis.h", $APIS_CONTENT);
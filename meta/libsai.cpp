@@ -19,27 +19,4339 @@
  *
  * @file    libsai.cpp
  *
- * @brief   This module contains dummy libsai.so just for linkage test
+ * @brief   This module contains an in-memory, metadata driven libsai.so
+ *
+ * Objects are kept in one hash table per object type, and every create,
+ * remove, set and get is validated against the SAI metadata the way a
+ * vendor implementation would do it. Nothing is programmed anywhere, this
+ * is meant to run and benchmark SAI applications on a plain Linux host.
+ */
+
+extern "C" {
+#include <sai.h>
+#include "saimetadata.h"
+#include "saimetadatavalidator.h"
+}
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+ * Profile keys, read through sai_service_method_table_t::profile_get_value
+ * when the switch is created.
+ */
+#define LIBSAI_KEY_PORT_COUNT       "SAI_LIBSAI_PORT_COUNT"
+#define LIBSAI_KEY_POOL_CAPACITY    "SAI_LIBSAI_POOL_CAPACITY"
+#define LIBSAI_KEY_VENDOR_ID        "SAI_LIBSAI_VENDOR_ID"
+
+#define LIBSAI_DEFAULT_PORT_COUNT   32
+#define LIBSAI_LANES_PER_PORT       4
+#define LIBSAI_DEFAULT_PORT_SPEED   100000
+#define LIBSAI_DEFAULT_VLAN_ID      1
+#define LIBSAI_DEFAULT_POOL_CAPACITY    (1024 * 1024)
+#define LIBSAI_RESOURCE_ATTRS_MAX   4
+
+static sai_status_t libsai_attr_status(
+        _In_ sai_status_t status,
+        _In_ uint32_t index)
+{
+    return status + SAI_STATUS_CODE((sai_status_t)index);
+}
+
+/*
+ * Call visitor(a_count, a_list, b_count, b_list) for every list held by
+ * an attribute value of the given type, on two values at once.
+ */
+
+#define LIBSAI_VISIT(member) \
+    visitor(a.member.count, a.member.list, b.member.count, b.member.list)
+
+template <typename V>
+static void libsai_visit_lists(
+        _In_ sai_attr_value_type_t type,
+        _Inout_ sai_attribute_value_t &a,
+        _Inout_ sai_attribute_value_t &b,
+        _Inout_ V &visitor)
+{
+    switch (type)
+    {
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            LIBSAI_VISIT(objlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            LIBSAI_VISIT(u8list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT8_LIST:
+            LIBSAI_VISIT(s8list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            LIBSAI_VISIT(u16list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT16_LIST:
+            LIBSAI_VISIT(s16list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            LIBSAI_VISIT(u32list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT32_LIST:
+            LIBSAI_VISIT(s32list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT16_RANGE_LIST:
+            LIBSAI_VISIT(u16rangelist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_VLAN_LIST:
+            LIBSAI_VISIT(vlanlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_QOS_MAP_LIST:
+            LIBSAI_VISIT(qosmap);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_MAP_LIST:
+            LIBSAI_VISIT(maplist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+            LIBSAI_VISIT(aclfield.data.objlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_UINT8_LIST:
+            LIBSAI_VISIT(aclfield.data.u8list);
+            LIBSAI_VISIT(aclfield.mask.u8list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+            LIBSAI_VISIT(aclaction.parameter.objlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_CAPABILITY:
+            LIBSAI_VISIT(aclcapability.action_list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_RESOURCE_LIST:
+            LIBSAI_VISIT(aclresource);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_TLV_LIST:
+            LIBSAI_VISIT(tlvlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_SEGMENT_LIST:
+            LIBSAI_VISIT(segmentlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_IP_ADDRESS_LIST:
+            LIBSAI_VISIT(ipaddrlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_EYE_VALUES_LIST:
+            LIBSAI_VISIT(porteyevalues);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_SYSTEM_PORT_CONFIG_LIST:
+            LIBSAI_VISIT(sysportconfiglist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_ERR_STATUS_LIST:
+            LIBSAI_VISIT(porterror);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_LANE_LATCH_STATUS_LIST:
+            LIBSAI_VISIT(portlanelatchstatuslist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_JSON:
+            LIBSAI_VISIT(json.json);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_IP_PREFIX_LIST:
+            LIBSAI_VISIT(ipprefixlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_CHAIN_LIST:
+            LIBSAI_VISIT(aclchainlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_FREQUENCY_OFFSET_PPM_LIST:
+            LIBSAI_VISIT(portfrequencyoffsetppmlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_SNR_LIST:
+            LIBSAI_VISIT(portsnrlist);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static size_t libsai_list_bytes(
+        _In_ size_t count,
+        _In_ size_t elemsize)
+{
+    return (count * elemsize + sizeof(uint64_t) - 1) & ~(sizeof(uint64_t) - 1);
+}
+
+/* sums up the storage needed by the b lists */
+class libsai_list_size
+{
+    public:
+
+        libsai_list_size(): m_bytes(0) {}
+
+        template <typename T>
+        void operator()(uint32_t &, T *&, uint32_t &count, T *&list)
+        {
+            if (list != NULL)
+            {
+                m_bytes += libsai_list_bytes(count, sizeof(T));
+            }
+        }
+
+        size_t m_bytes;
+};
+
+/* copies the b lists into buffer and points the a lists at the copies */
+class libsai_list_copy
+{
+    public:
+
+        explicit libsai_list_copy(uint8_t *buffer): m_next(buffer) {}
+
+        template <typename T>
+        void operator()(uint32_t &a_count, T *&a_list, uint32_t &count, T *&list)
+        {
+            if (list == NULL || count == 0)
+            {
+                a_count = 0;
+                a_list = NULL;
+                return;
+            }
+
+            a_list = reinterpret_cast<T*>(static_cast<void*>(m_next));
+            a_count = count;
+
+            memcpy(static_cast<void*>(a_list), static_cast<const void*>(list), count * sizeof(T));
+
+            m_next += libsai_list_bytes(count, sizeof(T));
+        }
+
+        uint8_t *m_next;
+};
+
+/*
+ * a holds the stored lists, b the caller buffers: copies what fits into
+ * the caller buffers and points a back at them, with the stored counts.
+ */
+class libsai_list_get
+{
+    public:
+
+        libsai_list_get(): m_status(SAI_STATUS_SUCCESS) {}
+
+        template <typename T>
+        void operator()(uint32_t &a_count, T *&a_list, uint32_t &user_count, T *&user_list)
+        {
+            if (a_count > user_count)
+            {
+                m_status = SAI_STATUS_BUFFER_OVERFLOW;
+            }
+            else if (a_count != 0 && user_list == NULL)
+            {
+                m_status = SAI_STATUS_INVALID_PARAMETER;
+            }
+            else if (a_count != 0)
+            {
+                memcpy(static_cast<void*>(user_list), static_cast<const void*>(a_list), a_count * sizeof(T));
+            }
+
+            a_list = user_list;
+        }
+
+        sai_status_t m_status;
+};
+
+/* points a back at the caller buffers with empty lists */
+class libsai_list_empty
+{
+    public:
+
+        template <typename T>
+        void operator()(uint32_t &a_count, T *&a_list, uint32_t &, T *&user_list)
+        {
+            a_count = 0;
+            a_list = user_list;
+        }
+};
+
+/* keeps the a counts and drops the a lists */
+class libsai_list_count
+{
+    public:
+
+        template <typename T>
+        void operator()(uint32_t &, T *&a_list, uint32_t &, T *&)
+        {
+            a_list = NULL;
+        }
+};
+
+/*
+ * Points the a lists, counts kept, at consecutive lists of buffer laid out
+ * the way libsai_list_copy writes them. Fails when buffer is too short.
+ */
+class libsai_list_map
+{
+    public:
+
+        libsai_list_map(
+                _In_ const uint8_t *buffer,
+                _In_ size_t bytes):
+            m_next(buffer),
+            m_left(bytes),
+            m_valid(true)
+        {
+        }
+
+        template <typename T>
+        void operator()(uint32_t &a_count, T *&a_list, uint32_t &, T *&)
+        {
+            size_t bytes = libsai_list_bytes(a_count, sizeof(T));
+
+            if (a_count == 0 || bytes > m_left)
+            {
+                m_valid &= (a_count == 0);
+
+                a_count = 0;
+                a_list = NULL;
+                return;
+            }
+
+            a_list = reinterpret_cast<T*>(const_cast<void*>(static_cast<const void*>(m_next)));
+
+            m_next += bytes;
+            m_left -= bytes;
+        }
+
+        const uint8_t *m_next;
+
+        size_t m_left;
+
+        bool m_valid;
+};
+
+static bool libsai_is_acl_disabled(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t &value)
+{
+    if (md->isaclfield)
+    {
+        return !value.aclfield.enable;
+    }
+
+    if (md->isaclaction)
+    {
+        return !value.aclaction.enable;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Attribute kept by the store, owning the data of its lists
+ */
+class libsai_attr
+{
+    public:
+
+        libsai_attr():
+            m_md(NULL)
+        {
+            memset(&m_attr, 0, sizeof(m_attr));
+        }
+
+        libsai_attr(
+                _In_ const sai_attr_metadata_t *md,
+                _In_ const sai_attribute_t &attr):
+            m_md(md)
+        {
+            assign(attr);
+        }
+
+        libsai_attr(
+                _In_ const libsai_attr &other):
+            m_md(other.m_md)
+        {
+            assign(other.m_attr);
+        }
+
+        libsai_attr& operator=(
+                _In_ const libsai_attr &other);
+
+        const sai_attribute_t& attr() const { return m_attr; }
+
+        /* lists of attr(), back to back as libsai_list_copy lays them out */
+        const std::vector<uint64_t>& data() const { return m_data; }
+
+        /*
+         * Copy the value into attr, whose lists are buffers of the caller.
+         * Lists which do not fit get their count set to the size needed
+         * and SAI_STATUS_BUFFER_OVERFLOW is returned.
+         */
+        sai_status_t get(
+                _Inout_ sai_attribute_t &attr) const;
+
+        /* Copy the value into attr, lists as their count only */
+        void get_counts(
+                _Inout_ sai_attribute_t &attr) const;
+
+        /* Zero attr, keeping the caller list buffers with a count of 0 */
+        static void empty(
+                _In_ const sai_attr_metadata_t *md,
+                _Inout_ sai_attribute_t &attr);
+
+    private:
+
+        void assign(
+                _In_ const sai_attribute_t &attr);
+
+        const sai_attr_metadata_t *m_md;
+
+        sai_attribute_t m_attr;
+
+        // backing store of all lists of m_attr
+        std::vector<uint64_t> m_data;
+};
+
+libsai_attr& libsai_attr::operator=(
+        _In_ const libsai_attr &other)
+{
+    if (this != &other)
+    {
+        m_md = other.m_md;
+
+        assign(other.m_attr);
+    }
+
+    return *this;
+}
+
+void libsai_attr::assign(
+        _In_ const sai_attribute_t &attr)
+{
+    sai_attribute_value_t value = attr.value;
+
+    m_attr = attr;
+
+    if (m_md == NULL)
+    {
+        return;
+    }
+
+    if (libsai_is_acl_disabled(m_md, value))
+    {
+        memset(&m_attr.value, 0, sizeof(m_attr.value));
+
+        m_attr.value.aclfield.enable = false;
+
+        return;
+    }
+
+    libsai_list_size size;
+
+    libsai_visit_lists(m_md->attrvaluetype, m_attr.value, value, size);
+
+    m_data.assign(size.m_bytes / sizeof(uint64_t), 0);
+
+    libsai_list_copy copy(reinterpret_cast<uint8_t*>(m_data.data()));
+
+    libsai_visit_lists(m_md->attrvaluetype, m_attr.value, value, copy);
+}
+
+sai_status_t libsai_attr::get(
+        _Inout_ sai_attribute_t &attr) const
+{
+    sai_attribute_value_t user = attr.value;
+
+    attr.value = m_attr.value;
+
+    libsai_list_get get;
+
+    libsai_visit_lists(m_md->attrvaluetype, attr.value, user, get);
+
+    return get.m_status;
+}
+
+void libsai_attr::get_counts(
+        _Inout_ sai_attribute_t &attr) const
+{
+    attr = m_attr;
+
+    sai_attribute_value_t unused = attr.value;
+
+    libsai_list_count count;
+
+    libsai_visit_lists(m_md->attrvaluetype, attr.value, unused, count);
+}
+
+void libsai_attr::empty(
+        _In_ const sai_attr_metadata_t *md,
+        _Inout_ sai_attribute_t &attr)
+{
+    sai_attribute_value_t user = attr.value;
+
+    memset(&attr.value, 0, sizeof(attr.value));
+
+    libsai_list_empty empty;
+
+    libsai_visit_lists(md->attrvaluetype, attr.value, user, empty);
+}
+
+/**
+ * @brief Object id layout
+ *
+ *   bits 63..56   switch index
+ *   bits 55..40   object type
+ *   bits 39..0    index of the object among the objects of that type
+ *                 on that switch
+ *
+ * Extension object types have bit 55 set, the other bits of the field
+ * hold their offset from SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START. The
+ * object type field of a valid OID is never 0, so neither is the OID.
+ * A switch is encoded with its own switch index as object index.
+ */
+class libsai_oid
+{
+    public:
+
+        static const uint32_t SWITCH_INDEX_MAX = 0xff;
+
+        static const uint64_t OBJECT_INDEX_MAX = 0xffffffffffULL;
+
+        static sai_object_id_t encode(
+                _In_ uint32_t switch_index,
+                _In_ sai_object_type_t object_type,
+                _In_ uint64_t object_index);
+
+        /* SAI_OBJECT_TYPE_NULL when the field is no valid object type */
+        static sai_object_type_t object_type(
+                _In_ sai_object_id_t oid);
+
+        static uint32_t switch_index(
+                _In_ sai_object_id_t oid);
+
+        static uint64_t object_index(
+                _In_ sai_object_id_t oid);
+
+        /* OID of the switch oid belongs to, SAI_NULL_OBJECT_ID when invalid */
+        static sai_object_id_t switch_id(
+                _In_ sai_object_id_t oid);
+
+    private:
+
+        static const int SWITCH_INDEX_SHIFT = 56;
+        static const int OBJECT_TYPE_SHIFT = 40;
+
+        static const uint64_t OBJECT_TYPE_MASK = 0xffff;
+        static const uint64_t OBJECT_TYPE_EXTENSION = 0x8000;
+};
+
+sai_object_id_t libsai_oid::encode(
+        _In_ uint32_t switch_index,
+        _In_ sai_object_type_t object_type,
+        _In_ uint64_t object_index)
+{
+    uint64_t type = (uint64_t)object_type;
+
+    if (type >= SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START)
+    {
+        type = OBJECT_TYPE_EXTENSION | (type - SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START);
+    }
+
+    return ((uint64_t)switch_index << SWITCH_INDEX_SHIFT) |
+        (type << OBJECT_TYPE_SHIFT) |
+        (object_index & OBJECT_INDEX_MAX);
+}
+
+sai_object_type_t libsai_oid::object_type(
+        _In_ sai_object_id_t oid)
+{
+    uint64_t type = (oid >> OBJECT_TYPE_SHIFT) & OBJECT_TYPE_MASK;
+
+    if (type & OBJECT_TYPE_EXTENSION)
+    {
+        type = (type & ~OBJECT_TYPE_EXTENSION) + SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START;
+
+        return (type < SAI_OBJECT_TYPE_EXTENSIONS_RANGE_END) ? (sai_object_type_t)type : SAI_OBJECT_TYPE_NULL;
+    }
+
+    return (type < SAI_OBJECT_TYPE_MAX) ? (sai_object_type_t)type : SAI_OBJECT_TYPE_NULL;
+}
+
+uint32_t libsai_oid::switch_index(
+        _In_ sai_object_id_t oid)
+{
+    return (uint32_t)(oid >> SWITCH_INDEX_SHIFT);
+}
+
+uint64_t libsai_oid::object_index(
+        _In_ sai_object_id_t oid)
+{
+    return oid & OBJECT_INDEX_MAX;
+}
+
+sai_object_id_t libsai_oid::switch_id(
+        _In_ sai_object_id_t oid)
+{
+    if (object_type(oid) == SAI_OBJECT_TYPE_NULL)
+    {
+        return SAI_NULL_OBJECT_ID;
+    }
+
+    return encode(switch_index(oid), SAI_OBJECT_TYPE_SWITCH, switch_index(oid));
+}
+
+/**
+ * @brief Allocator of object indexes
+ *
+ * Released indexes are kept on a free list and handed out again before
+ * any new one, most recently released first. Both operations are constant
+ * time, and the indexes in use stay packed below the high water mark no
+ * matter how many create/remove cycles went by.
+ */
+class libsai_index_allocator
+{
+    public:
+
+        explicit libsai_index_allocator(
+                _In_ uint64_t max_index = libsai_oid::OBJECT_INDEX_MAX):
+            m_next(0),
+            m_max_index(max_index)
+        {
+        }
+
+        /* false when all indexes up to max_index are in use */
+        bool allocate(
+                _Out_ uint64_t &index);
+
+        void release(
+                _In_ uint64_t index);
+
+        void clear();
+
+        /*
+         * Start over with exactly the indexes of used in use, the ones in
+         * between going on the free list. used gets sorted.
+         */
+        void restore(
+                _Inout_ std::vector<uint64_t> &used);
+
+    private:
+
+        std::vector<uint64_t> m_free;
+
+        uint64_t m_next;
+
+        uint64_t m_max_index;
+};
+
+bool libsai_index_allocator::allocate(
+        _Out_ uint64_t &index)
+{
+    if (!m_free.empty())
+    {
+        index = m_free.back();
+
+        m_free.pop_back();
+
+        return true;
+    }
+
+    if (m_next > m_max_index)
+    {
+        return false;
+    }
+
+    index = m_next++;
+
+    return true;
+}
+
+void libsai_index_allocator::release(
+        _In_ uint64_t index)
+{
+    if (index + 1 == m_next)
+    {
+        m_next--;
+    }
+    else
+    {
+        m_free.push_back(index);
+    }
+}
+
+void libsai_index_allocator::clear()
+{
+    m_free.clear();
+
+    m_next = 0;
+}
+
+void libsai_index_allocator::restore(
+        _Inout_ std::vector<uint64_t> &used)
+{
+    clear();
+
+    if (used.empty())
+    {
+        return;
+    }
+
+    std::sort(used.begin(), used.end());
+
+    m_next = used.back() + 1;
+
+    /* gaps are pushed highest first, so the lowest is handed out first */
+
+    uint64_t gap_end = m_next;
+
+    for (auto it = used.rbegin(); it != used.rend(); ++it)
+    {
+        for (uint64_t index = gap_end; index > *it + 1; index--)
+        {
+            m_free.push_back(index - 1);
+        }
+
+        gap_end = *it;
+    }
+
+    for (uint64_t index = gap_end; index > 0; index--)
+    {
+        m_free.push_back(index - 1);
+    }
+}
+
+/**
+ * @brief Resource pool, see libsai_resources
+ */
+typedef struct _libsai_pool_t
+{
+    uint32_t switch_index;
+
+    sai_object_type_t object_type;
+
+    // values of the resource type attributes of object_type, in order
+    uint64_t values[LIBSAI_RESOURCE_ATTRS_MAX];
+
+    std::atomic<uint64_t> used;
+
+} libsai_pool_t;
+
+/**
+ * @brief Resource accounting
+ *
+ * Objects are counted in pools: one per switch, object type and values of
+ * the resource type attributes of that object type, like the IP family of
+ * route entries or the stage of ACL tables. Every pool holds up to
+ * capacity() objects.
+ *
+ * Pools are only ever appended, and published once filled in, and their
+ * counters are atomic: available() takes no lock, so that availability
+ * polling does not stall on the store mutex while objects are created in
+ * bulk. Everything else is called with the store mutex held.
+ */
+class libsai_resources
+{
+    public:
+
+        static const uint32_t NO_POOL = 0xffffffff;
+
+        static const size_t POOLS_MAX = 4096;
+
+        static const size_t ATTRS_MAX = LIBSAI_RESOURCE_ATTRS_MAX;
+
+        libsai_resources();
+
+        ~libsai_resources();
+
+        /* Pick the resource type attributes of every object type */
+        void build();
+
+        const std::vector<const sai_attr_metadata_t*>& attrs(
+                _In_ sai_object_type_t object_type) const;
+
+        static uint64_t value(
+                _In_ const sai_attr_metadata_t *md,
+                _In_ const sai_attribute_value_t &value);
+
+        void set_capacity(
+                _In_ uint64_t capacity);
+
+        /*
+         * Pool of objects of object_type on that switch with those values
+         * of attrs(), created on first use. NO_POOL once POOLS_MAX pools
+         * are in use, such objects are then not accounted.
+         */
+        uint32_t pool(
+                _In_ uint32_t switch_index,
+                _In_ sai_object_type_t object_type,
+                _In_ const uint64_t *values);
+
+        bool full(
+                _In_ uint32_t pool) const;
+
+        void update(
+                _In_ uint32_t pool,
+                _In_ int delta);
+
+        /* Empty all pools of that switch */
+        void reset(
+                _In_ uint32_t switch_index);
+
+        void clear();
+
+        /*
+         * Objects of object_type which can still be created on that switch,
+         * counting the objects of all pools whose values match values[i]
+         * for every bit i set in mask against a single capacity.
+         */
+        uint64_t available(
+                _In_ uint32_t switch_index,
+                _In_ sai_object_type_t object_type,
+                _In_ uint32_t mask,
+                _In_ const uint64_t *values) const;
+
+    private:
+
+        std::unordered_map<int, std::vector<const sai_attr_metadata_t*> > m_attrs;
+
+        std::vector<const sai_attr_metadata_t*> m_no_attrs;
+
+        std::atomic<uint64_t> m_capacity;
+
+        libsai_pool_t m_pools[POOLS_MAX];
+
+        // number of pools of m_pools readers may look at
+        std::atomic<size_t> m_pool_count;
+
+        // pool index per switch index, object type and values
+        std::unordered_map<std::string, uint32_t> m_index;
+};
+
+libsai_resources::libsai_resources():
+    m_capacity(LIBSAI_DEFAULT_POOL_CAPACITY),
+    m_pool_count(0)
+{
+}
+
+libsai_resources::~libsai_resources()
+{
+}
+
+void libsai_resources::build()
+{
+    m_attrs.clear();
+
+    for (size_t idx = 1; sai_metadata_all_object_type_infos[idx] != NULL; idx++)
+    {
+        const sai_object_type_info_t *info = sai_metadata_all_object_type_infos[idx];
+
+        for (size_t i = 0; i < info->attrmetadatalength; i++)
+        {
+            const sai_attr_metadata_t *md = info->attrmetadata[i];
+
+            if (!md->isresourcetype)
+            {
+                continue;
+            }
+
+            std::vector<const sai_attr_metadata_t*> &attrs = m_attrs[info->objecttype];
+
+            if (attrs.size() == ATTRS_MAX)
+            {
+                SAI_META_LOG_WARN("%s is not accounted, too many resource type attributes", md->attridname);
+
+                continue;
+            }
+
+            attrs.push_back(md);
+        }
+    }
+}
+
+const std::vector<const sai_attr_metadata_t*>& libsai_resources::attrs(
+        _In_ sai_object_type_t object_type) const
+{
+    auto it = m_attrs.find(object_type);
+
+    return (it == m_attrs.end()) ? m_no_attrs : it->second;
+}
+
+uint64_t libsai_resources::value(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t &value)
+{
+    switch (md->attrvaluetype)
+    {
+        case SAI_ATTR_VALUE_TYPE_BOOL:
+            return value.booldata;
+
+        case SAI_ATTR_VALUE_TYPE_UINT8:
+            return value.u8;
+
+        case SAI_ATTR_VALUE_TYPE_UINT16:
+            return value.u16;
+
+        case SAI_ATTR_VALUE_TYPE_UINT32:
+            return value.u32;
+
+        case SAI_ATTR_VALUE_TYPE_INT32:
+            return (uint64_t)(int64_t)value.s32;
+
+        case SAI_ATTR_VALUE_TYPE_UINT64:
+            return value.u64;
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            return value.oid;
+
+        default:
+            return 0;
+    }
+}
+
+void libsai_resources::set_capacity(
+        _In_ uint64_t capacity)
+{
+    m_capacity.store(capacity, std::memory_order_relaxed);
+}
+
+uint32_t libsai_resources::pool(
+        _In_ uint32_t switch_index,
+        _In_ sai_object_type_t object_type,
+        _In_ const uint64_t *values)
+{
+    std::string key(reinterpret_cast<const char*>(&switch_index), sizeof(switch_index));
+
+    key.append(reinterpret_cast<const char*>(&object_type), sizeof(object_type));
+    key.append(reinterpret_cast<const char*>(values), ATTRS_MAX * sizeof(uint64_t));
+
+    auto it = m_index.find(key);
+
+    if (it != m_index.end())
+    {
+        return it->second;
+    }
+
+    size_t count = m_pool_count.load(std::memory_order_relaxed);
+
+    if (count == POOLS_MAX)
+    {
+        return NO_POOL;
+    }
+
+    libsai_pool_t &p = m_pools[count];
+
+    p.switch_index = switch_index;
+    p.object_type = object_type;
+
+    memcpy(p.values, values, sizeof(p.values));
+
+    p.used.store(0, std::memory_order_relaxed);
+
+    m_pool_count.store(count + 1, std::memory_order_release);
+
+    m_index[key] = (uint32_t)count;
+
+    return (uint32_t)count;
+}
+
+bool libsai_resources::full(
+        _In_ uint32_t pool) const
+{
+    if (pool == NO_POOL)
+    {
+        return false;
+    }
+
+    return m_pools[pool].used.load(std::memory_order_relaxed) >= m_capacity.load(std::memory_order_relaxed);
+}
+
+void libsai_resources::update(
+        _In_ uint32_t pool,
+        _In_ int delta)
+{
+    if (pool == NO_POOL)
+    {
+        return;
+    }
+
+    if (delta > 0)
+    {
+        m_pools[pool].used.fetch_add((uint64_t)delta, std::memory_order_relaxed);
+    }
+    else
+    {
+        m_pools[pool].used.fetch_sub((uint64_t)-delta, std::memory_order_relaxed);
+    }
+}
+
+void libsai_resources::reset(
+        _In_ uint32_t switch_index)
+{
+    size_t count = m_pool_count.load(std::memory_order_relaxed);
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        if (m_pools[idx].switch_index == switch_index)
+        {
+            m_pools[idx].used.store(0, std::memory_order_relaxed);
+        }
+    }
+}
+
+void libsai_resources::clear()
+{
+    /* pools stay, readers may be looking at them */
+
+    size_t count = m_pool_count.load(std::memory_order_relaxed);
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        m_pools[idx].used.store(0, std::memory_order_relaxed);
+    }
+}
+
+uint64_t libsai_resources::available(
+        _In_ uint32_t switch_index,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t mask,
+        _In_ const uint64_t *values) const
+{
+    uint64_t used = 0;
+
+    size_t count = m_pool_count.load(std::memory_order_acquire);
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        const libsai_pool_t &p = m_pools[idx];
+
+        if (p.switch_index != switch_index || p.object_type != object_type)
+        {
+            continue;
+        }
+
+        bool match = true;
+
+        for (size_t i = 0; i < ATTRS_MAX; i++)
+        {
+            match &= !(mask & (1u << i)) || p.values[i] == values[i];
+        }
+
+        if (match)
+        {
+            used += p.used.load(std::memory_order_relaxed);
+        }
+    }
+
+    uint64_t capacity = m_capacity.load(std::memory_order_relaxed);
+
+    return (used >= capacity) ? 0 : capacity - used;
+}
+
+/**
+ * @brief Attribute capabilities per vendor
+ *
+ * Built once from the capability metadata generated out of the vendor
+ * .cap files (see cap.pm), so that a query is a lookup on the vendor id
+ * and one on the attribute. Attributes which have no entry for a vendor
+ * get what libsai itself implements: everything their flags allow, and
+ * all values of their enum.
+ */
+class libsai_capabilities
+{
+    public:
+
+        libsai_capabilities();
+
+        ~libsai_capabilities();
+
+        void build();
+
+        void get(
+                _In_ uint64_t vendor_id,
+                _In_ const sai_attr_metadata_t *md,
+                _Out_ sai_attr_capability_t &capability) const;
+
+        /* Values are left NULL when all values of the enum are implemented */
+        void get_enum_values(
+                _In_ uint64_t vendor_id,
+                _In_ const sai_attr_metadata_t *md,
+                _Out_ size_t &count,
+                _Out_ const int *&values) const;
+
+    private:
+
+        const sai_attr_capability_metadata_t* find(
+                _In_ uint64_t vendor_id,
+                _In_ const sai_attr_metadata_t *md) const;
+
+        typedef std::unordered_map<const sai_attr_metadata_t*, const sai_attr_capability_metadata_t*> libsai_vendor_caps_t;
+
+        std::unordered_map<uint64_t, libsai_vendor_caps_t> m_vendors;
+};
+
+libsai_capabilities::libsai_capabilities()
+{
+}
+
+libsai_capabilities::~libsai_capabilities()
+{
+}
+
+void libsai_capabilities::build()
+{
+    m_vendors.clear();
+
+    for (size_t idx = 1; sai_metadata_all_object_type_infos[idx] != NULL; idx++)
+    {
+        const sai_object_type_info_t *info = sai_metadata_all_object_type_infos[idx];
+
+        for (size_t i = 0; i < info->attrmetadatalength; i++)
+        {
+            const sai_attr_metadata_t *md = info->attrmetadata[i];
+
+            for (size_t c = 0; c < md->capabilitylength; c++)
+            {
+                m_vendors[md->capability[c]->vendorid][md] = md->capability[c];
+            }
+        }
+    }
+}
+
+const sai_attr_capability_metadata_t* libsai_capabilities::find(
+        _In_ uint64_t vendor_id,
+        _In_ const sai_attr_metadata_t *md) const
+{
+    auto vendor = m_vendors.find(vendor_id);
+
+    if (vendor == m_vendors.end())
+    {
+        return NULL;
+    }
+
+    auto it = vendor->second.find(md);
+
+    return (it == vendor->second.end()) ? NULL : it->second;
+}
+
+void libsai_capabilities::get(
+        _In_ uint64_t vendor_id,
+        _In_ const sai_attr_metadata_t *md,
+        _Out_ sai_attr_capability_t &capability) const
+{
+    const sai_attr_capability_metadata_t *cap = find(vendor_id, md);
+
+    if (cap != NULL)
+    {
+        capability = cap->operationcapability;
+
+        return;
+    }
+
+    capability.create_implemented = md->ismandatoryoncreate || md->iscreateonly || md->iscreateandset;
+    capability.set_implemented = md->iscreateandset;
+    capability.get_implemented = true;
+}
+
+void libsai_capabilities::get_enum_values(
+        _In_ uint64_t vendor_id,
+        _In_ const sai_attr_metadata_t *md,
+        _Out_ size_t &count,
+        _Out_ const int *&values) const
+{
+    const sai_attr_capability_metadata_t *cap = find(vendor_id, md);
+
+    if (cap != NULL && cap->enumvaluescount != 0)
+    {
+        count = cap->enumvaluescount;
+        values = cap->enumvalues;
+
+        return;
+    }
+
+    count = md->enummetadata->valuescount;
+    values = md->enummetadata->values;
+}
+
+/**
+ * @brief Object kept by the store
+ */
+typedef struct _libsai_object_t
+{
+    sai_object_meta_key_t meta_key;
+
+    sai_object_id_t switch_id;
+
+    std::map<sai_attr_id_t, libsai_attr> attrs;
+
+    // number of keys and attributes of other objects holding this OID
+    uint32_t refcount;
+
+    // resource pool the object is accounted in
+    uint32_t pool;
+
+} libsai_object_t;
+
+/**
+ * @brief Where objects of each type may hold OIDs of other objects
+ *
+ * Built from the reverse graph of every object type, turned around: for
+ * each depending object type, the key members and the attributes which
+ * may reference another object. Read only attributes are left out, they
+ * report state of the switch and do not keep anything in use.
+ */
+class libsai_ref_graph
+{
+    public:
+
+        void build();
+
+        const std::vector<const sai_attr_metadata_t*>& attrs(
+                _In_ sai_object_type_t object_type) const;
+
+        const std::vector<const sai_struct_member_info_t*>& members(
+                _In_ sai_object_type_t object_type) const;
+
+        /* Call fn(oid) for every non NULL OID held by value */
+        template <typename F>
+        static void for_each_oid(
+                _In_ const sai_attr_metadata_t *md,
+                _In_ const sai_attribute_value_t &value,
+                _In_ F fn);
+
+    private:
+
+        std::unordered_map<int, std::vector<const sai_attr_metadata_t*> > m_attrs;
+
+        std::unordered_map<int, std::vector<const sai_struct_member_info_t*> > m_members;
+
+        std::vector<const sai_attr_metadata_t*> m_no_attrs;
+
+        std::vector<const sai_struct_member_info_t*> m_no_members;
+};
+
+void libsai_ref_graph::build()
+{
+    m_attrs.clear();
+    m_members.clear();
+
+    std::set<const sai_attr_metadata_t*> attrs;
+    std::set<const sai_struct_member_info_t*> members;
+
+    for (size_t idx = 1; sai_metadata_all_object_type_infos[idx] != NULL; idx++)
+    {
+        const sai_object_type_info_t *info = sai_metadata_all_object_type_infos[idx];
+
+        for (size_t i = 0; i < info->revgraphmemberscount; i++)
+        {
+            const sai_rev_graph_member_t *rm = info->revgraphmembers[i];
+
+            if (rm->attrmetadata != NULL)
+            {
+                if (!rm->attrmetadata->isreadonly && attrs.insert(rm->attrmetadata).second)
+                {
+                    m_attrs[rm->depobjecttype].push_back(rm->attrmetadata);
+                }
+            }
+            else if (rm->structmember != NULL && members.insert(rm->structmember).second)
+            {
+                m_members[rm->depobjecttype].push_back(rm->structmember);
+            }
+        }
+    }
+}
+
+const std::vector<const sai_attr_metadata_t*>& libsai_ref_graph::attrs(
+        _In_ sai_object_type_t object_type) const
+{
+    auto it = m_attrs.find(object_type);
+
+    return (it == m_attrs.end()) ? m_no_attrs : it->second;
+}
+
+const std::vector<const sai_struct_member_info_t*>& libsai_ref_graph::members(
+        _In_ sai_object_type_t object_type) const
+{
+    auto it = m_members.find(object_type);
+
+    return (it == m_members.end()) ? m_no_members : it->second;
+}
+
+template <typename F>
+void libsai_ref_graph::for_each_oid(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t &value,
+        _In_ F fn)
+{
+    const sai_object_list_t *objlist = NULL;
+
+    sai_object_id_t oid = SAI_NULL_OBJECT_ID;
+
+    if (libsai_is_acl_disabled(md, value))
+    {
+        return;
+    }
+
+    switch (md->attrvaluetype)
+    {
+        case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            oid = value.oid;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+            oid = value.aclfield.data.oid;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+            oid = value.aclaction.parameter.oid;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            objlist = &value.objlist;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+            objlist = &value.aclfield.data.objlist;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+            objlist = &value.aclaction.parameter.objlist;
+            break;
+
+        default:
+            return;
+    }
+
+    if (oid != SAI_NULL_OBJECT_ID)
+    {
+        fn(oid);
+    }
+
+    for (uint32_t idx = 0; objlist != NULL && idx < objlist->count; idx++)
+    {
+        if (objlist->list[idx] != SAI_NULL_OBJECT_ID)
+        {
+            fn(objlist->list[idx]);
+        }
+    }
+}
+
+/**
+ * @brief Objects of one type on one switch
+ *
+ * Objects and their keys are kept in two parallel dense arrays, so that
+ * any run of keys can be copied out as is, and hashed on their key to
+ * find their slot. Erasing moves the last object into the freed slot.
+ */
+class libsai_table
+{
+    public:
+
+        libsai_table();
+
+        ~libsai_table();
+
+        libsai_object_t* find(
+                _In_ const std::string &key);
+
+        const libsai_object_t* find(
+                _In_ const std::string &key) const;
+
+        /* key must not be in the table yet */
+        libsai_object_t& insert(
+                _In_ const std::string &key,
+                _In_ const sai_object_meta_key_t &meta_key);
+
+        void erase(
+                _In_ const std::string &key);
+
+        void erase_at(
+                _In_ size_t slot);
+
+        size_t size() const { return m_objects.size(); }
+
+        void reserve(
+                _In_ size_t count);
+
+        libsai_object_t& at(
+                _In_ size_t slot) { return m_objects[slot]; }
+
+        const libsai_object_t& at(
+                _In_ size_t slot) const { return m_objects[slot]; }
+
+        /*
+         * Copy at most count keys starting at slot cursor into list, and
+         * return the cursor to pass to get the next ones, size() once all
+         * were copied. Cursors stay valid as long as nothing is erased.
+         */
+        size_t keys(
+                _In_ size_t cursor,
+                _In_ size_t count,
+                _Out_ sai_object_key_t *list) const;
+
+    private:
+
+        std::unordered_map<std::string, size_t> m_slots;
+
+        std::vector<sai_object_key_t> m_keys;
+
+        std::vector<libsai_object_t> m_objects;
+
+        // hash key of every slot, to update m_slots when moving objects
+        std::vector<std::string> m_hashes;
+};
+
+libsai_table::libsai_table()
+{
+}
+
+libsai_table::~libsai_table()
+{
+}
+
+libsai_object_t* libsai_table::find(
+        _In_ const std::string &key)
+{
+    auto it = m_slots.find(key);
+
+    return (it == m_slots.end()) ? NULL : &m_objects[it->second];
+}
+
+const libsai_object_t* libsai_table::find(
+        _In_ const std::string &key) const
+{
+    auto it = m_slots.find(key);
+
+    return (it == m_slots.end()) ? NULL : &m_objects[it->second];
+}
+
+libsai_object_t& libsai_table::insert(
+        _In_ const std::string &key,
+        _In_ const sai_object_meta_key_t &meta_key)
+{
+    m_slots[key] = m_objects.size();
+
+    m_keys.push_back(meta_key.objectkey);
+    m_hashes.push_back(key);
+    m_objects.push_back(libsai_object_t());
+
+    libsai_object_t &object = m_objects.back();
+
+    object.meta_key = meta_key;
+    object.switch_id = SAI_NULL_OBJECT_ID;
+    object.refcount = 0;
+    object.pool = libsai_resources::NO_POOL;
+
+    return object;
+}
+
+void libsai_table::erase(
+        _In_ const std::string &key)
+{
+    auto it = m_slots.find(key);
+
+    if (it != m_slots.end())
+    {
+        erase_at(it->second);
+    }
+}
+
+void libsai_table::erase_at(
+        _In_ size_t slot)
+{
+    size_t last = m_objects.size() - 1;
+
+    m_slots.erase(m_hashes[slot]);
+
+    if (slot != last)
+    {
+        m_keys[slot] = m_keys[last];
+        m_hashes[slot].swap(m_hashes[last]);
+        m_objects[slot] = std::move(m_objects[last]);
+
+        m_slots[m_hashes[slot]] = slot;
+    }
+
+    m_keys.pop_back();
+    m_hashes.pop_back();
+    m_objects.pop_back();
+}
+
+void libsai_table::reserve(
+        _In_ size_t count)
+{
+    m_slots.reserve(count);
+    m_keys.reserve(count);
+    m_objects.reserve(count);
+    m_hashes.reserve(count);
+}
+
+size_t libsai_table::keys(
+        _In_ size_t cursor,
+        _In_ size_t count,
+        _Out_ sai_object_key_t *list) const
+{
+    if (cursor >= m_keys.size())
+    {
+        return m_keys.size();
+    }
+
+    count = std::min(count, m_keys.size() - cursor);
+
+    memcpy(list, m_keys.data() + cursor, count * sizeof(sai_object_key_t));
+
+    return cursor + count;
+}
+
+/**
+ * @brief Binary dump of the store
+ *
+ * Written by sai_dbg_generate_dump() and on warm shutdown, read back on
+ * warm boot, see SAI_KEY_BOOT_TYPE. The file is a header followed by one
+ * section per switch and object type:
+ *
+ *   libsai_dump_header_t
+ *   section_count times:
+ *     libsai_dump_section_t
+ *     object_count times:
+ *       libsai_dump_object_t
+ *       attr_count times:
+ *         libsai_dump_attr_t, lists NULL
+ *         data_bytes of list data, as in libsai_attr::data()
+ *
+ * All records are a multiple of 8 bytes long, so that the lists can be
+ * used in place from a mapping of the file. OIDs are kept as they are,
+ * the objects come back with the same OIDs and refcounts. Integers are
+ * in host byte order, and the layout of keys and values is the one of
+ * the SAI headers the dump was written with, hence api_version.
+ */
+
+#define LIBSAI_DUMP_MAGIC           "SAIDUMP"
+#define LIBSAI_DUMP_VERSION         1
+
+typedef struct _libsai_dump_header_t
+{
+    char magic[8];
+
+    uint32_t version;
+
+    uint32_t section_count;
+
+    uint64_t api_version;
+
+    // sizes of sai_object_key_t and sai_attribute_value_t
+    uint32_t key_size;
+
+    uint32_t value_size;
+
+} libsai_dump_header_t;
+
+typedef struct _libsai_dump_section_t
+{
+    int32_t object_type;
+
+    uint32_t switch_index;
+
+    uint64_t object_count;
+
+} libsai_dump_section_t;
+
+typedef struct _libsai_dump_object_t
+{
+    sai_object_key_t key;
+
+    sai_object_id_t switch_id;
+
+    uint32_t refcount;
+
+    uint32_t attr_count;
+
+} libsai_dump_object_t;
+
+typedef struct _libsai_dump_attr_t
+{
+    sai_attr_id_t id;
+
+    uint32_t data_bytes;
+
+    sai_attribute_value_t value;
+
+} libsai_dump_attr_t;
+
+/* Reads records in place from a mapped dump, NULL past the end */
+class libsai_dump_reader
+{
+    public:
+
+        libsai_dump_reader(
+                _In_ const uint8_t *data,
+                _In_ size_t bytes):
+            m_next(data),
+            m_end(data + bytes)
+        {
+        }
+
+        const uint8_t* read_bytes(
+                _In_ size_t bytes)
+        {
+            if (bytes > (size_t)(m_end - m_next))
+            {
+                return NULL;
+            }
+
+            const uint8_t *p = m_next;
+
+            m_next += bytes;
+
+            return p;
+        }
+
+        template <typename T>
+        bool read(
+                _Out_ T &record)
+        {
+            const uint8_t *p = read_bytes(sizeof(T));
+
+            if (p != NULL)
+            {
+                memcpy(&record, p, sizeof(T));
+            }
+
+            return p != NULL;
+        }
+
+        size_t left() const { return (size_t)(m_end - m_next); }
+
+    private:
+
+        const uint8_t *m_next;
+
+        const uint8_t *m_end;
+};
+
+/**
+ * @brief All objects of all switches
+ *
+ * Objects are kept in one table per switch and object type, hashed on
+ * their key: the OID for object id types, or the members of the entry
+ * struct (see key()) for the others. A single mutex serializes all API
+ * calls but availability queries, see libsai_resources.
+ */
+class libsai_store
+{
+    public:
+
+        libsai_store():
+            m_switch_indexes(libsai_oid::SWITCH_INDEX_MAX),
+            m_validator(NULL)
+        {
+            memset(&m_services, 0, sizeof(m_services));
+
+            for (auto &vendor_id: m_vendor_ids)
+            {
+                vendor_id.store(0, std::memory_order_relaxed);
+            }
+        }
+
+        void set_services(
+                _In_ const sai_service_method_table_t *services);
+
+        /* Precompute the reference graph, resource attributes and capabilities */
+        void build_metadata();
+
+        sai_status_t create(
+                _Inout_ sai_object_meta_key_t &meta_key,
+                _In_ sai_object_id_t switch_id,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list);
+
+        sai_status_t remove(
+                _In_ const sai_object_meta_key_t &meta_key);
+
+        sai_status_t set(
+                _In_ const sai_object_meta_key_t &meta_key,
+                _In_ const sai_attribute_t *attr);
+
+        sai_status_t get(
+                _In_ const sai_object_meta_key_t &meta_key,
+                _In_ uint32_t attr_count,
+                _Inout_ sai_attribute_t *attr_list);
+
+        /* Counters all read 0, only the object and arguments are checked */
+        sai_status_t get_stats(
+                _In_ const sai_object_meta_key_t &meta_key,
+                _In_ uint32_t number_of_counters,
+                _In_ const sai_stat_id_t *counter_ids,
+                _Out_ uint64_t *counters);
+
+        sai_status_t clear_stats(
+                _In_ const sai_object_meta_key_t &meta_key,
+                _In_ uint32_t number_of_counters,
+                _In_ const sai_stat_id_t *counter_ids);
+
+        sai_status_t flush_fdb_entries(
+                _In_ sai_object_id_t switch_id,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list);
+
+        sai_status_t remove_all_neighbor_entries(
+                _In_ sai_object_id_t switch_id);
+
+        sai_status_t get_object_count(
+                _In_ sai_object_id_t switch_id,
+                _In_ sai_object_type_t object_type,
+                _Out_ uint32_t &count);
+
+        /*
+         * Copy at most count keys of objects of object_type on switch_id,
+         * starting at cursor, see libsai_table::keys(). With a count large
+         * enough the keys are copied in one go, otherwise the caller pages
+         * through them passing the returned cursor back.
+         */
+        sai_status_t get_object_keys(
+                _In_ sai_object_id_t switch_id,
+                _In_ sai_object_type_t object_type,
+                _Inout_ size_t &cursor,
+                _Inout_ uint32_t &count,
+                _Out_ sai_object_key_t *list);
+
+        sai_status_t bulk_get_attribute(
+                _In_ sai_object_id_t switch_id,
+                _In_ sai_object_type_t object_type,
+                _In_ uint32_t object_count,
+                _In_ const sai_object_key_t *object_key,
+                _Inout_ uint32_t *attr_count,
+                _Inout_ sai_attribute_t **attr_list,
+                _Out_ sai_status_t *object_statuses);
+
+        /*
+         * Number of objects of object_type which can still be created,
+         * see libsai_resources::available(). Takes no lock.
+         */
+        sai_status_t get_availability(
+                _In_ sai_object_id_t switch_id,
+                _In_ sai_object_type_t object_type,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list,
+                _Out_ uint64_t &count) const;
+
+        /*
+         * Capabilities of attr_id for the vendor of switch_id, see
+         * libsai_capabilities. Take no lock.
+         */
+        sai_status_t query_attribute_capability(
+                _In_ sai_object_id_t switch_id,
+                _In_ sai_object_type_t object_type,
+                _In_ sai_attr_id_t attr_id,
+                _Out_ sai_attr_capability_t &capability) const;
+
+        sai_status_t query_attribute_enum_values_capability(
+                _In_ sai_object_id_t switch_id,
+                _In_ sai_object_type_t object_type,
+                _In_ sai_attr_id_t attr_id,
+                _Inout_ sai_s32_list_t &enum_values) const;
+
+        /* Write the binary dump of all switches to file */
+        sai_status_t dump(
+                _In_ const char *file);
+
+        void clear();
+
+    private:
+
+        static const uint32_t ALL_SWITCHES = 0xffffffff;
+
+        /* Value of a profile key, NULL when not set */
+        const char* profile_value(
+                _In_ const char *key) const;
+
+        /* Take the capability vendor id of a new switch from the profile */
+        void set_vendor_id(
+                _In_ sai_object_id_t switch_id);
+
+        sai_status_t write_dump(
+                _In_ const char *file,
+                _In_ uint32_t switch_index);
+
+        /*
+         * Load the dump in file into the store, which must be empty, and
+         * return the OID of the first switch in it. The file is mapped only
+         * while loading: list data is copied into libsai_attr storage and
+         * the mapping is dropped before this returns.
+         */
+        sai_status_t restore(
+                _In_ const char *file,
+                _Out_ sai_object_id_t &switch_id);
+
+        sai_status_t restore(
+                _In_ const uint8_t *data,
+                _In_ size_t bytes,
+                _Out_ sai_object_id_t &switch_id);
+
+        static uint64_t table_id(
+                _In_ uint32_t switch_index,
+                _In_ sai_object_type_t object_type);
+
+        /* switch index of the object with that key */
+        static uint32_t switch_index(
+                _In_ const sai_object_type_info_t *info,
+                _In_ const sai_object_meta_key_t &meta_key);
+
+        libsai_table* table(
+                _In_ uint32_t switch_index,
+                _In_ sai_object_type_t object_type);
+
+        const libsai_table* table(
+                _In_ uint32_t switch_index,
+                _In_ sai_object_type_t object_type) const;
+
+        static std::string key(
+                _In_ const sai_object_type_info_t *info,
+                _In_ const sai_object_meta_key_t &meta_key);
+
+        libsai_object_t* find(
+                _In_ const sai_object_type_info_t *info,
+                _In_ const sai_object_meta_key_t &meta_key);
+
+        sai_status_t check_key(
+                _In_ const sai_object_type_info_t *info,
+                _In_ const sai_object_meta_key_t &meta_key,
+                _Out_ sai_object_id_t &switch_id);
+
+        /* Fails when an object id in attr is on another switch than switch_id */
+        sai_status_t check_switch(
+                _In_ const sai_object_type_info_t *info,
+                _In_ sai_object_id_t switch_id,
+                _In_ const sai_attribute_t &attr) const;
+
+        /*
+         * Check attributes against the metadata, see m_validator, and the
+         * switch of the object ids they reference.
+         */
+        sai_status_t check_create(
+                _In_ const sai_object_type_info_t *info,
+                _In_ sai_object_id_t switch_id,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list) const;
+
+        sai_status_t check_set(
+                _In_ const sai_object_type_info_t *info,
+                _In_ sai_object_id_t switch_id,
+                _In_ const sai_attribute_t &attr) const;
+
+        sai_status_t get_default(
+                _In_ const sai_attr_metadata_t *md,
+                _In_ const libsai_object_t &object,
+                _Inout_ sai_attribute_t &attr);
+
+        sai_object_id_t create_internal(
+                _In_ sai_object_type_t object_type,
+                _In_ sai_object_id_t switch_id,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list);
+
+        void set_internal(
+                _In_ libsai_object_t &object,
+                _In_ const sai_attribute_t &attr);
+
+        void create_switch_objects(
+                _In_ libsai_object_t &sw);
+
+        void erase(
+                _In_ const sai_object_type_info_t *info,
+                _In_ const sai_object_meta_key_t &meta_key);
+
+        libsai_object_t* find(
+                _In_ sai_object_id_t oid);
+
+        /* Add delta to the refcount of every object referenced by object */
+        void reference(
+                _In_ const libsai_object_t &object,
+                _In_ int delta);
+
+        void reference(
+                _In_ const sai_attr_metadata_t *md,
+                _In_ const sai_attribute_value_t &value,
+                _In_ int delta);
+
+        /* Object type of oid if it is an existing object, NULL otherwise */
+        sai_object_type_t exists(
+                _In_ sai_object_id_t oid) const;
+
+        /* exists() of the global store, the query of m_validator */
+        static sai_object_type_t object_type_query(
+                _In_ sai_object_id_t oid);
+
+        libsai_index_allocator& indexes(
+                _In_ uint32_t switch_index,
+                _In_ sai_object_type_t object_type);
+
+        /*
+         * Resource pool of an object, find(attr_id) returning the value of
+         * its attributes or NULL when not set.
+         */
+        template <typename F>
+        uint32_t resource_pool(
+                _In_ const sai_object_type_info_t *info,
+                _In_ const sai_object_meta_key_t &meta_key,
+                _In_ uint32_t switch_index,
+                _In_ F find);
+
+        uint32_t resource_pool(
+                _In_ const sai_object_type_info_t *info,
+                _In_ const sai_object_meta_key_t &meta_key,
+                _In_ uint32_t switch_index,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list);
+
+        std::mutex m_mutex;
+
+        sai_service_method_table_t m_services;
+
+        // tables per switch index and object type, see table_id()
+        std::unordered_map<uint64_t, libsai_table> m_tables;
+
+        libsai_index_allocator m_switch_indexes;
+
+        libsai_ref_graph m_ref_graph;
+
+        // object indexes per switch index and object type, see table_id()
+        std::unordered_map<uint64_t, libsai_index_allocator> m_indexes;
+
+        libsai_resources m_resources;
+
+        libsai_capabilities m_capabilities;
+
+        // attribute list checks shared by all calls, built by build_metadata()
+        sai_metadata_validator_t *m_validator;
+
+        // vendor id of the capabilities of each switch, per switch index
+        std::atomic<uint64_t> m_vendor_ids[libsai_oid::SWITCH_INDEX_MAX + 1];
+};
+
+void libsai_store::set_services(
+        _In_ const sai_service_method_table_t *services)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (services == NULL)
+    {
+        memset(&m_services, 0, sizeof(m_services));
+    }
+    else
+    {
+        m_services = *services;
+    }
+}
+
+void libsai_store::build_metadata()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_ref_graph.build();
+
+    m_resources.build();
+
+    m_capabilities.build();
+
+    sai_metadata_validator_free(m_validator);
+
+    m_validator = sai_metadata_validator_create(object_type_query);
+}
+
+std::string libsai_store::key(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_object_meta_key_t &meta_key)
+{
+    const char *base = reinterpret_cast<const char*>(&meta_key.objectkey.key);
+
+    if (info->isobjectid)
+    {
+        return std::string(base, sizeof(sai_object_id_t));
+    }
+
+    std::string k;
+
+    /*
+     * Entry structs are hashed member by member so that neither padding
+     * nor the unused part of IP address unions end up in the key.
+     */
+
+    for (size_t idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+
+        const char *p = base + m->offset;
+
+        sai_ip_address_t ip;
+        sai_ip_prefix_t prefix;
+
+        switch (m->membervaluetype)
+        {
+            case SAI_ATTR_VALUE_TYPE_IP_ADDRESS:
+
+                memcpy(&ip, p, sizeof(ip));
+
+                k.append(reinterpret_cast<const char*>(&ip.addr_family), sizeof(ip.addr_family));
+
+                if (ip.addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+                    k.append(reinterpret_cast<const char*>(&ip.addr.ip4), sizeof(ip.addr.ip4));
+                else
+                    k.append(reinterpret_cast<const char*>(ip.addr.ip6), sizeof(ip.addr.ip6));
+
+                break;
+
+            case SAI_ATTR_VALUE_TYPE_IP_PREFIX:
+
+                memcpy(&prefix, p, sizeof(prefix));
+
+                k.append(reinterpret_cast<const char*>(&prefix.addr_family), sizeof(prefix.addr_family));
+
+                if (prefix.addr_family == SAI_IP_ADDR_FAMILY_IPV4)
+                {
+                    k.append(reinterpret_cast<const char*>(&prefix.addr.ip4), sizeof(prefix.addr.ip4));
+                    k.append(reinterpret_cast<const char*>(&prefix.mask.ip4), sizeof(prefix.mask.ip4));
+                }
+                else
+                {
+                    k.append(reinterpret_cast<const char*>(prefix.addr.ip6), sizeof(prefix.addr.ip6));
+                    k.append(reinterpret_cast<const char*>(prefix.mask.ip6), sizeof(prefix.mask.ip6));
+                }
+
+                break;
+
+            default:
+
+                k.append(p, m->size);
+
+                break;
+        }
+    }
+
+    return k;
+}
+
+uint64_t libsai_store::table_id(
+        _In_ uint32_t switch_index,
+        _In_ sai_object_type_t object_type)
+{
+    return ((uint64_t)switch_index << 32) | (uint32_t)object_type;
+}
+
+uint32_t libsai_store::switch_index(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_object_meta_key_t &meta_key)
+{
+    if (info->isobjectid)
+    {
+        return libsai_oid::switch_index(meta_key.objectkey.key.object_id);
+    }
+
+    for (size_t idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+
+        if (strcmp(m->membername, "switch_id") == 0)
+        {
+            return libsai_oid::switch_index(m->getoid(&meta_key));
+        }
+    }
+
+    return 0;
+}
+
+libsai_table* libsai_store::table(
+        _In_ uint32_t switch_index,
+        _In_ sai_object_type_t object_type)
+{
+    auto it = m_tables.find(table_id(switch_index, object_type));
+
+    return (it == m_tables.end()) ? NULL : &it->second;
+}
+
+const libsai_table* libsai_store::table(
+        _In_ uint32_t switch_index,
+        _In_ sai_object_type_t object_type) const
+{
+    auto it = m_tables.find(table_id(switch_index, object_type));
+
+    return (it == m_tables.end()) ? NULL : &it->second;
+}
+
+libsai_object_t* libsai_store::find(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_object_meta_key_t &meta_key)
+{
+    libsai_table *t = table(switch_index(info, meta_key), info->objecttype);
+
+    return (t == NULL) ? NULL : t->find(key(info, meta_key));
+}
+
+sai_object_type_t libsai_store::exists(
+        _In_ sai_object_id_t oid) const
+{
+    sai_object_type_t object_type = libsai_oid::object_type(oid);
+
+    const libsai_table *t = table(libsai_oid::switch_index(oid), object_type);
+
+    if (t == NULL || t->find(std::string(reinterpret_cast<const char*>(&oid), sizeof(oid))) == NULL)
+    {
+        return SAI_OBJECT_TYPE_NULL;
+    }
+
+    return object_type;
+}
+
+libsai_object_t* libsai_store::find(
+        _In_ sai_object_id_t oid)
+{
+    libsai_table *t = table(libsai_oid::switch_index(oid), libsai_oid::object_type(oid));
+
+    return (t == NULL) ? NULL : t->find(std::string(reinterpret_cast<const char*>(&oid), sizeof(oid)));
+}
+
+void libsai_store::reference(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t &value,
+        _In_ int delta)
+{
+    libsai_ref_graph::for_each_oid(md, value, [&](sai_object_id_t oid) {
+            libsai_object_t *ref = find(oid);
+            if (ref != NULL)
+                ref->refcount = (uint32_t)((int64_t)ref->refcount + delta);
+            });
+}
+
+void libsai_store::reference(
+        _In_ const libsai_object_t &object,
+        _In_ int delta)
+{
+    sai_object_type_t object_type = object.meta_key.objecttype;
+
+    for (auto m: m_ref_graph.members(object_type))
+    {
+        libsai_object_t *ref = find(m->getoid(&object.meta_key));
+
+        if (ref != NULL)
+        {
+            ref->refcount = (uint32_t)((int64_t)ref->refcount + delta);
+        }
+    }
+
+    for (auto md: m_ref_graph.attrs(object_type))
+    {
+        auto it = object.attrs.find(md->attrid);
+
+        if (it != object.attrs.end())
+        {
+            reference(md, it->second.attr().value, delta);
+        }
+    }
+}
+
+libsai_index_allocator& libsai_store::indexes(
+        _In_ uint32_t switch_index,
+        _In_ sai_object_type_t object_type)
+{
+    return m_indexes[table_id(switch_index, object_type)];
+}
+
+template <typename F>
+uint32_t libsai_store::resource_pool(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ uint32_t switch_index,
+        _In_ F find)
+{
+    if (info->objecttype == SAI_OBJECT_TYPE_SWITCH)
+    {
+        return libsai_resources::NO_POOL;
+    }
+
+    const std::vector<const sai_attr_metadata_t*> &attrs = m_resources.attrs(info->objecttype);
+
+    uint64_t values[LIBSAI_RESOURCE_ATTRS_MAX] = { 0 };
+
+    for (size_t idx = 0; idx < attrs.size(); idx++)
+    {
+        const sai_attr_metadata_t *md = attrs[idx];
+
+        const sai_attribute_value_t *value = find(md->attrid);
+
+        if (value != NULL)
+        {
+            values[idx] = libsai_resources::value(md, *value);
+        }
+        else if (md->isreadonly)
+        {
+            /* the IP family of entries, taken from their key */
+
+            for (size_t i = 0; i < info->structmemberscount; i++)
+            {
+                const sai_struct_member_info_t *m = info->structmembers[i];
+
+                if (m->membervaluetype == SAI_ATTR_VALUE_TYPE_IP_ADDRESS || m->membervaluetype == SAI_ATTR_VALUE_TYPE_IP_PREFIX)
+                {
+                    sai_ip_addr_family_t family;
+
+                    /* addr_family comes first in both */
+
+                    memcpy(&family, reinterpret_cast<const char*>(&meta_key.objectkey.key) + m->offset, sizeof(family));
+
+                    values[idx] = (uint64_t)family;
+
+                    break;
+                }
+            }
+        }
+        else if (md->defaultvaluetype == SAI_DEFAULT_VALUE_TYPE_CONST && md->defaultvalue != NULL)
+        {
+            values[idx] = libsai_resources::value(md, *md->defaultvalue);
+        }
+    }
+
+    return m_resources.pool(switch_index, info->objecttype, values);
+}
+
+uint32_t libsai_store::resource_pool(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ uint32_t switch_index,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    return resource_pool(info, meta_key, switch_index, [&](sai_attr_id_t id) -> const sai_attribute_value_t* {
+            const sai_attribute_t *attr = sai_metadata_get_attr_by_id(id, attr_count, attr_list);
+            return (attr == NULL) ? NULL : &attr->value;
+            });
+}
+
+sai_status_t libsai_store::check_key(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_object_meta_key_t &meta_key,
+        _Out_ sai_object_id_t &switch_id)
+{
+    switch_id = SAI_NULL_OBJECT_ID;
+
+    for (size_t idx = 0; idx < info->structmemberscount; idx++)
+    {
+        const sai_struct_member_info_t *m = info->structmembers[idx];
+
+        if (m->membervaluetype != SAI_ATTR_VALUE_TYPE_OBJECT_ID)
+        {
+            continue;
+        }
+
+        sai_object_id_t oid = m->getoid(&meta_key);
+
+        sai_object_type_t object_type = exists(oid);
+
+        if (object_type == SAI_OBJECT_TYPE_NULL)
+        {
+            SAI_META_LOG_ERROR("%s.%s 0x%" PRIx64 " does not exist", info->objecttypename, m->membername, oid);
+
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        bool allowed = false;
+
+        for (size_t i = 0; i < m->allowedobjecttypeslength; i++)
+        {
+            allowed |= (m->allowedobjecttypes[i] == object_type);
+        }
+
+        if (!allowed)
+        {
+            SAI_META_LOG_ERROR("%s.%s 0x%" PRIx64 " has wrong object type", info->objecttypename, m->membername, oid);
+
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        sai_object_id_t oid_switch_id = libsai_oid::switch_id(oid);
+
+        if (switch_id != SAI_NULL_OBJECT_ID && switch_id != oid_switch_id)
+        {
+            SAI_META_LOG_ERROR("%s.%s 0x%" PRIx64 " is on another switch", info->objecttypename, m->membername, oid);
+
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+
+        switch_id = oid_switch_id;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::check_switch(
+        _In_ const sai_object_type_info_t *info,
+        _In_ sai_object_id_t switch_id,
+        _In_ const sai_attribute_t &attr) const
+{
+    const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(info->objecttype, attr.id);
+
+    sai_status_t status = SAI_STATUS_SUCCESS;
+
+    libsai_ref_graph::for_each_oid(md, attr.value, [&](sai_object_id_t oid) {
+            if (status == SAI_STATUS_SUCCESS && libsai_oid::switch_id(oid) != switch_id)
+            {
+                SAI_META_LOG_ERROR("%s: 0x%" PRIx64 " is on another switch", md->attridname, oid);
+                status = SAI_STATUS_INVALID_ATTR_VALUE_0;
+            }
+            });
+
+    return status;
+}
+
+sai_status_t libsai_store::check_create(
+        _In_ const sai_object_type_info_t *info,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list) const
+{
+    sai_status_t status = sai_metadata_validator_check_create(m_validator, info->objecttype, attr_count, attr_list);
+
+    if (status != SAI_STATUS_SUCCESS || switch_id == SAI_NULL_OBJECT_ID)
+    {
+        return status;
+    }
+
+    for (uint32_t idx = 0; idx < attr_count; idx++)
+    {
+        status = check_switch(info, switch_id, attr_list[idx]);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return libsai_attr_status(status, idx);
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::check_set(
+        _In_ const sai_object_type_info_t *info,
+        _In_ sai_object_id_t switch_id,
+        _In_ const sai_attribute_t &attr) const
+{
+    sai_status_t status = sai_metadata_validator_check_set(m_validator, info->objecttype, &attr);
+
+    if (status != SAI_STATUS_SUCCESS || switch_id == SAI_NULL_OBJECT_ID)
+    {
+        return status;
+    }
+
+    return check_switch(info, switch_id, attr);
+}
+
+sai_object_id_t libsai_store::create_internal(
+        _In_ sai_object_type_t object_type,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object_type);
+
+    uint64_t index;
+
+    if (object_type == SAI_OBJECT_TYPE_SWITCH)
+    {
+        if (!m_switch_indexes.allocate(index))
+        {
+            return SAI_NULL_OBJECT_ID;
+        }
+
+        switch_id = libsai_oid::encode((uint32_t)index, SAI_OBJECT_TYPE_SWITCH, index);
+    }
+    else if (!indexes(libsai_oid::switch_index(switch_id), object_type).allocate(index))
+    {
+        return SAI_NULL_OBJECT_ID;
+    }
+
+    sai_object_id_t oid = libsai_oid::encode(libsai_oid::switch_index(switch_id), object_type, index);
+
+    sai_object_meta_key_t meta_key;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = object_type;
+    meta_key.objectkey.key.object_id = oid;
+
+    /* capacity is checked by create(), objects of a new switch always fit */
+
+    uint32_t pool = resource_pool(info, meta_key, libsai_oid::switch_index(switch_id), attr_count, attr_list);
+
+    libsai_object_t &object = m_tables[table_id(libsai_oid::switch_index(switch_id), object_type)].insert(key(info, meta_key), meta_key);
+
+    object.switch_id = switch_id;
+    object.pool = pool;
+
+    m_resources.update(pool, 1);
+
+    for (uint32_t idx = 0; idx < attr_count; idx++)
+    {
+        set_internal(object, attr_list[idx]);
+    }
+
+    reference(object, 1);
+
+    return oid;
+}
+
+void libsai_store::set_internal(
+        _In_ libsai_object_t &object,
+        _In_ const sai_attribute_t &attr)
+{
+    const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object.meta_key.objecttype, attr.id);
+
+    if (md == NULL)
+    {
+        SAI_META_LOG_ERROR("unknown attribute 0x%x on object type %d", attr.id, object.meta_key.objecttype);
+
+        return;
+    }
+
+    object.attrs[attr.id] = libsai_attr(md, attr);
+}
+
+/*
+ * Objects a switch comes up with: the CPU port and the front panel ports,
+ * the default virtual router, VLAN, .1Q bridge with a bridge port per
+ * port, trap group and STP instance.
+ */
+void libsai_store::create_switch_objects(
+        _In_ libsai_object_t &sw)
+{
+    sai_object_id_t switch_id = sw.meta_key.objectkey.key.object_id;
+
+    uint32_t port_count = LIBSAI_DEFAULT_PORT_COUNT;
+
+    const char *value = profile_value(LIBSAI_KEY_PORT_COUNT);
+
+    if (value != NULL)
+    {
+        port_count = (uint32_t)strtoul(value, NULL, 0);
+    }
+
+    sai_attribute_t attrs[3];
+
+    attrs[0].id = SAI_PORT_ATTR_TYPE;
+    attrs[0].value.s32 = SAI_PORT_TYPE_CPU;
+
+    sai_object_id_t cpu_port_id = create_internal(SAI_OBJECT_TYPE_PORT, switch_id, 1, attrs);
+
+    attrs[0].id = SAI_BRIDGE_ATTR_TYPE;
+    attrs[0].value.s32 = SAI_BRIDGE_TYPE_1Q;
+
+    sai_object_id_t bridge_id = create_internal(SAI_OBJECT_TYPE_BRIDGE, switch_id, 1, attrs);
+
+    std::vector<sai_object_id_t> ports(port_count);
+
+    for (uint32_t idx = 0; idx < port_count; idx++)
+    {
+        uint32_t lanes[LIBSAI_LANES_PER_PORT];
+
+        for (uint32_t lane = 0; lane < LIBSAI_LANES_PER_PORT; lane++)
+        {
+            lanes[lane] = idx * LIBSAI_LANES_PER_PORT + lane;
+        }
+
+        attrs[0].id = SAI_PORT_ATTR_TYPE;
+        attrs[0].value.s32 = SAI_PORT_TYPE_LOGICAL;
+
+        attrs[1].id = SAI_PORT_ATTR_HW_LANE_LIST;
+        attrs[1].value.u32list.count = LIBSAI_LANES_PER_PORT;
+        attrs[1].value.u32list.list = lanes;
+
+        attrs[2].id = SAI_PORT_ATTR_SPEED;
+        attrs[2].value.u32 = LIBSAI_DEFAULT_PORT_SPEED;
+
+        ports[idx] = create_internal(SAI_OBJECT_TYPE_PORT, switch_id, 3, attrs);
+
+        attrs[0].id = SAI_BRIDGE_PORT_ATTR_TYPE;
+        attrs[0].value.s32 = SAI_BRIDGE_PORT_TYPE_PORT;
+
+        attrs[1].id = SAI_BRIDGE_PORT_ATTR_PORT_ID;
+        attrs[1].value.oid = ports[idx];
+
+        create_internal(SAI_OBJECT_TYPE_BRIDGE_PORT, switch_id, 2, attrs);
+    }
+
+    attrs[0].id = SAI_VLAN_ATTR_VLAN_ID;
+    attrs[0].value.u16 = LIBSAI_DEFAULT_VLAN_ID;
+
+    sai_object_id_t vlan_id = create_internal(SAI_OBJECT_TYPE_VLAN, switch_id, 1, attrs);
+
+    sai_object_id_t vr_id = create_internal(SAI_OBJECT_TYPE_VIRTUAL_ROUTER, switch_id, 0, NULL);
+
+    sai_object_id_t trap_group_id = create_internal(SAI_OBJECT_TYPE_HOSTIF_TRAP_GROUP, switch_id, 0, NULL);
+
+    sai_object_id_t stp_id = create_internal(SAI_OBJECT_TYPE_STP, switch_id, 0, NULL);
+
+    sai_attribute_t attr;
+
+    attr.id = SAI_SWITCH_ATTR_CPU_PORT;
+    attr.value.oid = cpu_port_id;
+    set_internal(sw, attr);
+
+    attr.id = SAI_SWITCH_ATTR_NUMBER_OF_ACTIVE_PORTS;
+    attr.value.u32 = port_count;
+    set_internal(sw, attr);
+
+    attr.id = SAI_SWITCH_ATTR_PORT_LIST;
+    attr.value.objlist.count = port_count;
+    attr.value.objlist.list = ports.data();
+    set_internal(sw, attr);
+
+    attr.id = SAI_SWITCH_ATTR_DEFAULT_VIRTUAL_ROUTER_ID;
+    attr.value.oid = vr_id;
+    set_internal(sw, attr);
+
+    attr.id = SAI_SWITCH_ATTR_DEFAULT_VLAN_ID;
+    attr.value.oid = vlan_id;
+    set_internal(sw, attr);
+
+    attr.id = SAI_SWITCH_ATTR_DEFAULT_1Q_BRIDGE_ID;
+    attr.value.oid = bridge_id;
+    set_internal(sw, attr);
+
+    attr.id = SAI_SWITCH_ATTR_DEFAULT_TRAP_GROUP;
+    attr.value.oid = trap_group_id;
+    set_internal(sw, attr);
+
+    attr.id = SAI_SWITCH_ATTR_DEFAULT_STP_INST_ID;
+    attr.value.oid = stp_id;
+    set_internal(sw, attr);
+}
+
+sai_status_t libsai_store::create(
+        _Inout_ sai_object_meta_key_t &meta_key,
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key.objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (attr_count != 0 && attr_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (meta_key.objecttype == SAI_OBJECT_TYPE_SWITCH)
+    {
+        switch_id = SAI_NULL_OBJECT_ID;
+    }
+    else if (info->isobjectid)
+    {
+        if (exists(switch_id) != SAI_OBJECT_TYPE_SWITCH)
+        {
+            SAI_META_LOG_ERROR("switch 0x%" PRIx64 " does not exist", switch_id);
+
+            return SAI_STATUS_INVALID_PARAMETER;
+        }
+    }
+    else
+    {
+        sai_status_t status = check_key(info, meta_key, switch_id);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        if (find(info, meta_key) != NULL)
+        {
+            return SAI_STATUS_ITEM_ALREADY_EXISTS;
+        }
+    }
+
+    sai_status_t status = check_create(info, switch_id, attr_count, attr_list);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    const char *capacity = profile_value(LIBSAI_KEY_POOL_CAPACITY);
+
+    if (meta_key.objecttype == SAI_OBJECT_TYPE_SWITCH && capacity != NULL)
+    {
+        m_resources.set_capacity(strtoull(capacity, NULL, 0));
+    }
+
+    const char *boot_type = profile_value(SAI_KEY_BOOT_TYPE);
+
+    if (meta_key.objecttype == SAI_OBJECT_TYPE_SWITCH && boot_type != NULL && strcmp(boot_type, "1") == 0)
+    {
+        const char *file = profile_value(SAI_KEY_WARM_BOOT_READ_FILE);
+
+        if (file == NULL || !m_tables.empty())
+        {
+            SAI_META_LOG_ERROR("warm boot needs %s and no other switch", SAI_KEY_WARM_BOOT_READ_FILE);
+
+            return SAI_STATUS_FAILURE;
+        }
+
+        status = restore(file, meta_key.objectkey.key.object_id);
+
+        if (status == SAI_STATUS_SUCCESS)
+        {
+            set_vendor_id(meta_key.objectkey.key.object_id);
+        }
+
+        return status;
+    }
+
+    uint32_t pool = resource_pool(info, meta_key, libsai_oid::switch_index(switch_id), attr_count, attr_list);
+
+    if (m_resources.full(pool))
+    {
+        SAI_META_LOG_ERROR("no %s left", info->objecttypename);
+
+        return SAI_STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    if (info->isobjectid)
+    {
+        meta_key.objectkey.key.object_id = create_internal(meta_key.objecttype, switch_id, attr_count, attr_list);
+
+        if (meta_key.objectkey.key.object_id == SAI_NULL_OBJECT_ID)
+        {
+            SAI_META_LOG_ERROR("no %s index left", info->objecttypename);
+
+            return SAI_STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        if (meta_key.objecttype == SAI_OBJECT_TYPE_SWITCH)
+        {
+            set_vendor_id(meta_key.objectkey.key.object_id);
+
+            create_switch_objects(*find(info, meta_key));
+        }
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    libsai_object_t &object = m_tables[table_id(libsai_oid::switch_index(switch_id), meta_key.objecttype)].insert(key(info, meta_key), meta_key);
+
+    object.switch_id = switch_id;
+    object.pool = pool;
+
+    m_resources.update(pool, 1);
+
+    for (uint32_t idx = 0; idx < attr_count; idx++)
+    {
+        set_internal(object, attr_list[idx]);
+    }
+
+    reference(object, 1);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+void libsai_store::erase(
+        _In_ const sai_object_type_info_t *info,
+        _In_ const sai_object_meta_key_t &meta_key)
+{
+    libsai_table *t = table(switch_index(info, meta_key), info->objecttype);
+
+    std::string k = key(info, meta_key);
+
+    libsai_object_t *object = t->find(k);
+
+    reference(*object, -1);
+
+    m_resources.update(object->pool, -1);
+
+    t->erase(k);
+
+    if (info->isobjectid)
+    {
+        sai_object_id_t oid = meta_key.objectkey.key.object_id;
+
+        indexes(libsai_oid::switch_index(oid), info->objecttype).release(libsai_oid::object_index(oid));
+    }
+}
+
+sai_status_t libsai_store::remove(
+        _In_ const sai_object_meta_key_t &meta_key)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key.objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    const libsai_object_t *object = find(info, meta_key);
+
+    if (object == NULL)
+    {
+        return info->isobjectid ? SAI_STATUS_INVALID_OBJECT_ID : SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    if (meta_key.objecttype != SAI_OBJECT_TYPE_SWITCH)
+    {
+        if (object->refcount != 0)
+        {
+            SAI_META_LOG_ERROR("%s is still used by %u objects", info->objecttypename, object->refcount);
+
+            return SAI_STATUS_OBJECT_IN_USE;
+        }
+
+        erase(info, meta_key);
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    /* removing the switch removes everything on it */
+
+    uint32_t index = libsai_oid::switch_index(meta_key.objectkey.key.object_id);
+
+    auto warm = object->attrs.find(SAI_SWITCH_ATTR_RESTART_WARM);
+
+    const char *file = profile_value(SAI_KEY_WARM_BOOT_WRITE_FILE);
+
+    if (warm != object->attrs.end() && warm->second.attr().value.booldata && file != NULL)
+    {
+        sai_status_t status = write_dump(file, index);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    for (auto it = m_tables.begin(); it != m_tables.end(); )
+    {
+        it = ((it->first >> 32) == index) ? m_tables.erase(it) : ++it;
+    }
+
+    for (auto it = m_indexes.begin(); it != m_indexes.end(); )
+    {
+        it = ((it->first >> 32) == index) ? m_indexes.erase(it) : ++it;
+    }
+
+    m_resources.reset(index);
+
+    m_switch_indexes.release(index);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::set(
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ const sai_attribute_t *attr)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key.objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (attr == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    libsai_object_t *object = find(info, meta_key);
+
+    if (object == NULL)
+    {
+        return info->isobjectid ? SAI_STATUS_INVALID_OBJECT_ID : SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    sai_status_t status = check_set(info, object->switch_id, *attr);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(info->objecttype, attr->id);
+
+    if (md->isconditional)
+    {
+        std::vector<sai_attribute_t> attrs;
+
+        for (auto &kvp: object->attrs)
+        {
+            if (kvp.first != attr->id)
+            {
+                attrs.push_back(kvp.second.attr());
+            }
+        }
+
+        attrs.push_back(*attr);
+
+        if (!sai_metadata_is_condition_met(md, (uint32_t)attrs.size(), attrs.data()))
+        {
+            SAI_META_LOG_ERROR("%s condition is not met", md->attridname);
+
+            return SAI_STATUS_INVALID_ATTRIBUTE_0;
+        }
+    }
+
+    auto it = object->attrs.find(attr->id);
+
+    if (it != object->attrs.end())
+    {
+        reference(md, it->second.attr().value, -1);
+    }
+
+    reference(md, attr->value, 1);
+
+    object->attrs[attr->id] = libsai_attr(md, *attr);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::get_default(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const libsai_object_t &object,
+        _Inout_ sai_attribute_t &attr)
+{
+    switch (md->defaultvaluetype)
+    {
+        case SAI_DEFAULT_VALUE_TYPE_CONST:
+
+            if (md->defaultvalue != NULL)
+            {
+                sai_attribute_t def;
+
+                def.id = attr.id;
+                def.value = *md->defaultvalue;
+
+                return libsai_attr(md, def).get(attr);
+            }
+
+            break;
+
+        case SAI_DEFAULT_VALUE_TYPE_ATTR_VALUE:
+
+            if (md->defaultvalueobjecttype == SAI_OBJECT_TYPE_SWITCH)
+            {
+                const sai_object_type_info_t *info = sai_metadata_get_object_type_info(SAI_OBJECT_TYPE_SWITCH);
+
+                sai_object_meta_key_t meta_key;
+
+                memset(&meta_key, 0, sizeof(meta_key));
+
+                meta_key.objecttype = SAI_OBJECT_TYPE_SWITCH;
+                meta_key.objectkey.key.object_id = object.switch_id;
+
+                const libsai_object_t *sw = find(info, meta_key);
+
+                if (sw != NULL)
+                {
+                    auto it = sw->attrs.find(md->defaultvalueattrid);
+
+                    if (it != sw->attrs.end())
+                    {
+                        return it->second.get(attr);
+                    }
+                }
+            }
+
+            break;
+
+        case SAI_DEFAULT_VALUE_TYPE_NONE:
+
+            /* conditional or valid only attribute whose condition is not met */
+
+            if (!SAI_HAS_FLAG_READ_ONLY(md->flags))
+            {
+                SAI_META_LOG_ERROR("%s is not set and has no default value", md->attridname);
+
+                return SAI_STATUS_INVALID_ATTRIBUTE_0;
+            }
+
+            break;
+
+        default:
+            break;
+    }
+
+    /*
+     * Empty lists, vendor specific and internal defaults, as well as read
+     * only attributes the store knows nothing about, read as zero.
+     */
+
+    libsai_attr::empty(md, attr);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::get(
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ uint32_t attr_count,
+        _Inout_ sai_attribute_t *attr_list)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key.objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (attr_count == 0 || attr_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    const libsai_object_t *object = find(info, meta_key);
+
+    if (object == NULL)
+    {
+        return info->isobjectid ? SAI_STATUS_INVALID_OBJECT_ID : SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    sai_status_t result = SAI_STATUS_SUCCESS;
+
+    for (uint32_t idx = 0; idx < attr_count; idx++)
+    {
+        sai_attribute_t &attr = attr_list[idx];
+
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(meta_key.objecttype, attr.id);
+
+        if (md == NULL)
+        {
+            SAI_META_LOG_ERROR("unknown attribute 0x%x on %s", attr.id, info->objecttypename);
+
+            return libsai_attr_status(SAI_STATUS_UNKNOWN_ATTRIBUTE_0, idx);
+        }
+
+        auto it = object->attrs.find(attr.id);
+
+        sai_status_t status = (it != object->attrs.end()) ? it->second.get(attr) : get_default(md, *object, attr);
+
+        if (status == SAI_STATUS_BUFFER_OVERFLOW)
+        {
+            result = status;
+        }
+        else if (status == SAI_STATUS_INVALID_ATTRIBUTE_0)
+        {
+            return libsai_attr_status(status, idx);
+        }
+        else if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+    }
+
+    return result;
+}
+
+sai_status_t libsai_store::get_stats(
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids,
+        _Out_ uint64_t *counters)
+{
+    sai_status_t status = clear_stats(meta_key, number_of_counters, counter_ids);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if (counters == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(counters, 0, number_of_counters * sizeof(uint64_t));
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::clear_stats(
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key.objecttype);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (number_of_counters == 0 || counter_ids == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (find(info, meta_key) == NULL)
+    {
+        return info->isobjectid ? SAI_STATUS_INVALID_OBJECT_ID : SAI_STATUS_ITEM_NOT_FOUND;
+    }
+
+    if (info->statenum == NULL)
+    {
+        return SAI_STATUS_NOT_SUPPORTED;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+/*
+ * Remove the FDB entries matching the SAI_FDB_FLUSH_ATTR_* filters,
+ * dynamic entries only unless SAI_FDB_FLUSH_ATTR_ENTRY_TYPE says otherwise.
+ */
+sai_status_t libsai_store::flush_fdb_entries(
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (attr_count != 0 && attr_list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (exists(switch_id) != SAI_OBJECT_TYPE_SWITCH)
+    {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    sai_object_id_t bridge_port_id = SAI_NULL_OBJECT_ID;
+    sai_object_id_t bv_id = SAI_NULL_OBJECT_ID;
+    int32_t entry_type = SAI_FDB_FLUSH_ENTRY_TYPE_DYNAMIC;
+
+    for (uint32_t idx = 0; idx < attr_count; idx++)
+    {
+        switch (attr_list[idx].id)
+        {
+            case SAI_FDB_FLUSH_ATTR_BRIDGE_PORT_ID:
+                bridge_port_id = attr_list[idx].value.oid;
+                break;
+
+            case SAI_FDB_FLUSH_ATTR_BV_ID:
+                bv_id = attr_list[idx].value.oid;
+                break;
+
+            case SAI_FDB_FLUSH_ATTR_ENTRY_TYPE:
+                entry_type = attr_list[idx].value.s32;
+                break;
+
+            default:
+                return libsai_attr_status(SAI_STATUS_UNKNOWN_ATTRIBUTE_0, idx);
+        }
+    }
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(SAI_OBJECT_TYPE_FDB_ENTRY);
+
+    libsai_table *t = table(libsai_oid::switch_index(switch_id), SAI_OBJECT_TYPE_FDB_ENTRY);
+
+    /* backwards, erasing moves the last entry into the freed slot */
+
+    for (size_t slot = (t == NULL) ? 0 : t->size(); slot-- > 0; )
+    {
+        const libsai_object_t &object = t->at(slot);
+
+        auto type = object.attrs.find(SAI_FDB_ENTRY_ATTR_TYPE);
+        auto port = object.attrs.find(SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID);
+
+        bool is_static = (type != object.attrs.end() && type->second.attr().value.s32 == SAI_FDB_ENTRY_TYPE_STATIC);
+
+        bool match =
+            (bv_id == SAI_NULL_OBJECT_ID || object.meta_key.objectkey.key.fdb_entry.bv_id == bv_id) &&
+            (bridge_port_id == SAI_NULL_OBJECT_ID || (port != object.attrs.end() && port->second.attr().value.oid == bridge_port_id)) &&
+            (entry_type == SAI_FDB_FLUSH_ENTRY_TYPE_ALL || is_static == (entry_type == SAI_FDB_FLUSH_ENTRY_TYPE_STATIC));
+
+        if (match)
+        {
+            sai_object_meta_key_t meta_key = object.meta_key;
+
+            erase(info, meta_key);
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::remove_all_neighbor_entries(
+        _In_ sai_object_id_t switch_id)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (exists(switch_id) != SAI_OBJECT_TYPE_SWITCH)
+    {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(SAI_OBJECT_TYPE_NEIGHBOR_ENTRY);
+
+    libsai_table *t = table(libsai_oid::switch_index(switch_id), SAI_OBJECT_TYPE_NEIGHBOR_ENTRY);
+
+    for (size_t slot = (t == NULL) ? 0 : t->size(); slot-- > 0; )
+    {
+        sai_object_meta_key_t meta_key = t->at(slot).meta_key;
+
+        erase(info, meta_key);
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::get_object_count(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Out_ uint32_t &count)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (exists(switch_id) != SAI_OBJECT_TYPE_SWITCH)
+    {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if (sai_metadata_get_object_type_info(object_type) == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    const libsai_table *t = table(libsai_oid::switch_index(switch_id), object_type);
+
+    count = (t == NULL) ? 0 : (uint32_t)t->size();
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::get_object_keys(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _Inout_ size_t &cursor,
+        _Inout_ uint32_t &count,
+        _Out_ sai_object_key_t *list)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (exists(switch_id) != SAI_OBJECT_TYPE_SWITCH)
+    {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if (sai_metadata_get_object_type_info(object_type) == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (count != 0 && list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    const libsai_table *t = table(libsai_oid::switch_index(switch_id), object_type);
+
+    if (t == NULL)
+    {
+        count = 0;
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    size_t next = t->keys(cursor, count, list);
+
+    count = (uint32_t)(next - std::min(cursor, next));
+
+    cursor = next;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::bulk_get_attribute(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const sai_object_key_t *object_key,
+        _Inout_ uint32_t *attr_count,
+        _Inout_ sai_attribute_t **attr_list,
+        _Out_ sai_status_t *object_statuses)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object_type);
+
+    if (info == NULL)
+    {
+        return SAI_STATUS_INVALID_OBJECT_TYPE;
+    }
+
+    if (exists(switch_id) != SAI_OBJECT_TYPE_SWITCH)
+    {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    if (object_count == 0 || object_key == NULL || attr_count == NULL || attr_list == NULL || object_statuses == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    libsai_table *t = table(libsai_oid::switch_index(switch_id), object_type);
+
+    sai_object_meta_key_t meta_key;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = object_type;
+
+    sai_status_t status = SAI_STATUS_SUCCESS;
+
+    for (uint32_t idx = 0; idx < object_count; idx++)
+    {
+        meta_key.objectkey = object_key[idx];
+
+        const libsai_object_t *object = (t == NULL) ? NULL : t->find(key(info, meta_key));
+
+        if (object == NULL)
+        {
+            object_statuses[idx] = SAI_STATUS_INVALID_OBJECT_ID;
+        }
+        else if (attr_count[idx] < object->attrs.size())
+        {
+            attr_count[idx] = (uint32_t)object->attrs.size();
+
+            object_statuses[idx] = SAI_STATUS_BUFFER_OVERFLOW;
+        }
+        else if (attr_list[idx] == NULL && !object->attrs.empty())
+        {
+            object_statuses[idx] = SAI_STATUS_INVALID_PARAMETER;
+        }
+        else
+        {
+            uint32_t count = 0;
+
+            for (auto &kvp: object->attrs)
+            {
+                kvp.second.get_counts(attr_list[idx][count++]);
+            }
+
+            attr_count[idx] = count;
+
+            object_statuses[idx] = SAI_STATUS_SUCCESS;
+        }
+
+        if (object_statuses[idx] != SAI_STATUS_SUCCESS)
+        {
+            status = SAI_STATUS_FAILURE;
+        }
+    }
+
+    return status;
+}
+
+void libsai_store::clear()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_tables.clear();
+    m_indexes.clear();
+    m_switch_indexes.clear();
+    m_resources.clear();
+
+    sai_metadata_validator_free(m_validator);
+
+    m_validator = NULL;
+}
+
+sai_status_t libsai_store::get_availability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list,
+        _Out_ uint64_t &count) const
+{
+    if (sai_metadata_get_object_type_info(object_type) == NULL || object_type == SAI_OBJECT_TYPE_SWITCH)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    if (libsai_oid::object_type(switch_id) != SAI_OBJECT_TYPE_SWITCH || (attr_count != 0 && attr_list == NULL))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    const std::vector<const sai_attr_metadata_t*> &attrs = m_resources.attrs(object_type);
+
+    uint64_t values[LIBSAI_RESOURCE_ATTRS_MAX] = { 0 };
+
+    uint32_t mask = 0;
+
+    for (uint32_t idx = 0; idx < attr_count; idx++)
+    {
+        size_t i = 0;
+
+        while (i < attrs.size() && attrs[i]->attrid != attr_list[idx].id)
+        {
+            i++;
+        }
+
+        if (i == attrs.size())
+        {
+            SAI_META_LOG_ERROR("attribute 0x%x is no resource type attribute", attr_list[idx].id);
+
+            return libsai_attr_status(SAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+        }
+
+        values[i] = libsai_resources::value(attrs[i], attr_list[idx].value);
+
+        mask |= (1u << i);
+    }
+
+    count = m_resources.available(libsai_oid::switch_index(switch_id), object_type, mask, values);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+const char* libsai_store::profile_value(
+        _In_ const char *key) const
+{
+    if (m_services.profile_get_value == NULL)
+    {
+        return NULL;
+    }
+
+    return m_services.profile_get_value(0, key);
+}
+
+void libsai_store::set_vendor_id(
+        _In_ sai_object_id_t switch_id)
+{
+    const char *value = profile_value(LIBSAI_KEY_VENDOR_ID);
+
+    uint64_t vendor_id = (value == NULL) ? 0 : strtoull(value, NULL, 0);
+
+    m_vendor_ids[libsai_oid::switch_index(switch_id)].store(vendor_id, std::memory_order_relaxed);
+}
+
+sai_status_t libsai_store::query_attribute_capability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Out_ sai_attr_capability_t &capability) const
+{
+    if (libsai_oid::object_type(switch_id) != SAI_OBJECT_TYPE_SWITCH)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_id);
+
+    if (md == NULL)
+    {
+        SAI_META_LOG_ERROR("unknown attribute 0x%x on object type %d", attr_id, object_type);
+
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    uint64_t vendor_id = m_vendor_ids[libsai_oid::switch_index(switch_id)].load(std::memory_order_relaxed);
+
+    m_capabilities.get(vendor_id, md, capability);
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::query_attribute_enum_values_capability(
+        _In_ sai_object_id_t switch_id,
+        _In_ sai_object_type_t object_type,
+        _In_ sai_attr_id_t attr_id,
+        _Inout_ sai_s32_list_t &enum_values) const
+{
+    if (libsai_oid::object_type(switch_id) != SAI_OBJECT_TYPE_SWITCH)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, attr_id);
+
+    if (md == NULL || md->enummetadata == NULL)
+    {
+        SAI_META_LOG_ERROR("attribute 0x%x on object type %d is no enum", attr_id, object_type);
+
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    uint64_t vendor_id = m_vendor_ids[libsai_oid::switch_index(switch_id)].load(std::memory_order_relaxed);
+
+    size_t count;
+
+    const int *values;
+
+    m_capabilities.get_enum_values(vendor_id, md, count, values);
+
+    if (enum_values.count < count)
+    {
+        enum_values.count = (uint32_t)count;
+
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    if (count != 0 && enum_values.list == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    for (size_t idx = 0; idx < count; idx++)
+    {
+        enum_values.list[idx] = values[idx];
+    }
+
+    enum_values.count = (uint32_t)count;
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::dump(
+        _In_ const char *file)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (file == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return write_dump(file, ALL_SWITCHES);
+}
+
+sai_status_t libsai_store::write_dump(
+        _In_ const char *file,
+        _In_ uint32_t switch_index)
+{
+    FILE *fp = fopen(file, "wb");
+
+    if (fp == NULL)
+    {
+        SAI_META_LOG_ERROR("failed to open %s: %s", file, strerror(errno));
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    setvbuf(fp, NULL, _IOFBF, 1 << 20);
+
+    libsai_dump_header_t header;
+
+    memset(&header, 0, sizeof(header));
+
+    memcpy(header.magic, LIBSAI_DUMP_MAGIC, sizeof(LIBSAI_DUMP_MAGIC));
+
+    header.version = LIBSAI_DUMP_VERSION;
+    header.api_version = SAI_API_VERSION;
+    header.key_size = (uint32_t)sizeof(sai_object_key_t);
+    header.value_size = (uint32_t)sizeof(sai_attribute_value_t);
+
+    for (auto &kvp: m_tables)
+    {
+        if (kvp.second.size() != 0 && (switch_index == ALL_SWITCHES || (kvp.first >> 32) == switch_index))
+        {
+            header.section_count++;
+        }
+    }
+
+    fwrite(&header, sizeof(header), 1, fp);
+
+    for (auto &kvp: m_tables)
+    {
+        const libsai_table &t = kvp.second;
+
+        if (t.size() == 0 || (switch_index != ALL_SWITCHES && (kvp.first >> 32) != switch_index))
+        {
+            continue;
+        }
+
+        libsai_dump_section_t section;
+
+        memset(&section, 0, sizeof(section));
+
+        section.object_type = (int32_t)(uint32_t)kvp.first;
+        section.switch_index = (uint32_t)(kvp.first >> 32);
+        section.object_count = t.size();
+
+        fwrite(&section, sizeof(section), 1, fp);
+
+        for (size_t slot = 0; slot < t.size(); slot++)
+        {
+            const libsai_object_t &object = t.at(slot);
+
+            libsai_dump_object_t record;
+
+            memset(&record, 0, sizeof(record));
+
+            record.key = object.meta_key.objectkey;
+            record.switch_id = object.switch_id;
+            record.refcount = object.refcount;
+            record.attr_count = (uint32_t)object.attrs.size();
+
+            fwrite(&record, sizeof(record), 1, fp);
+
+            for (auto &a: object.attrs)
+            {
+                const std::vector<uint64_t> &data = a.second.data();
+
+                sai_attribute_t counts;
+
+                a.second.get_counts(counts);
+
+                libsai_dump_attr_t attr;
+
+                memset(&attr, 0, sizeof(attr));
+
+                attr.id = a.first;
+                attr.data_bytes = (uint32_t)(data.size() * sizeof(uint64_t));
+                attr.value = counts.value;
+
+                fwrite(&attr, sizeof(attr), 1, fp);
+                fwrite(data.data(), sizeof(uint64_t), data.size(), fp);
+            }
+        }
+    }
+
+    bool failed = (ferror(fp) != 0);
+
+    failed |= (fclose(fp) != 0);
+
+    if (failed)
+    {
+        SAI_META_LOG_ERROR("failed to write %s", file);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t libsai_store::restore(
+        _In_ const char *file,
+        _Out_ sai_object_id_t &switch_id)
+{
+    int fd = open(file, O_RDONLY);
+
+    if (fd < 0)
+    {
+        SAI_META_LOG_ERROR("failed to open %s: %s", file, strerror(errno));
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0 || st.st_size <= 0)
+    {
+        SAI_META_LOG_ERROR("%s is empty or can not be read", file);
+
+        close(fd);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    size_t bytes = (size_t)st.st_size;
+
+    void *data = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        SAI_META_LOG_ERROR("failed to map %s: %s", file, strerror(errno));
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    madvise(data, bytes, MADV_SEQUENTIAL);
+
+    sai_status_t status = restore(static_cast<const uint8_t*>(data), bytes, switch_id);
+
+    munmap(data, bytes);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        SAI_META_LOG_ERROR("failed to restore %s", file);
+
+        m_tables.clear();
+        m_indexes.clear();
+        m_switch_indexes.clear();
+        m_resources.clear();
+    }
+
+    return status;
+}
+
+sai_status_t libsai_store::restore(
+        _In_ const uint8_t *data,
+        _In_ size_t bytes,
+        _Out_ sai_object_id_t &switch_id)
+{
+    libsai_dump_reader reader(data, bytes);
+
+    libsai_dump_header_t header;
+
+    if (!reader.read(header) ||
+            memcmp(header.magic, LIBSAI_DUMP_MAGIC, sizeof(LIBSAI_DUMP_MAGIC)) != 0 ||
+            header.version != LIBSAI_DUMP_VERSION)
+    {
+        SAI_META_LOG_ERROR("not a libsai dump, or unsupported dump version");
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    if (header.api_version != SAI_API_VERSION ||
+            header.key_size != sizeof(sai_object_key_t) ||
+            header.value_size != sizeof(sai_attribute_value_t))
+    {
+        SAI_META_LOG_ERROR("dump was written with other SAI headers, api version 0x%" PRIx64, header.api_version);
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    // object indexes in use per table, see table_id()
+    std::unordered_map<uint64_t, std::vector<uint64_t> > used;
+
+    std::vector<uint64_t> switches;
+
+    for (uint32_t idx = 0; idx < header.section_count; idx++)
+    {
+        libsai_dump_section_t section;
+
+        if (!reader.read(section))
+        {
+            SAI_META_LOG_ERROR("dump is truncated");
+
+            return SAI_STATUS_FAILURE;
+        }
+
+        sai_object_type_t object_type = (sai_object_type_t)section.object_type;
+
+        const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object_type);
+
+        if (info == NULL ||
+                section.switch_index > libsai_oid::SWITCH_INDEX_MAX ||
+                section.object_count > reader.left() / sizeof(libsai_dump_object_t))
+        {
+            SAI_META_LOG_ERROR("section %u of dump is invalid", idx);
+
+            return SAI_STATUS_FAILURE;
+        }
+
+        uint64_t tid = table_id(section.switch_index, object_type);
+
+        libsai_table &t = m_tables[tid];
+
+        t.reserve(t.size() + (size_t)section.object_count);
+
+        for (uint64_t n = 0; n < section.object_count; n++)
+        {
+            libsai_dump_object_t record;
+
+            if (!reader.read(record))
+            {
+                SAI_META_LOG_ERROR("dump is truncated");
+
+                return SAI_STATUS_FAILURE;
+            }
+
+            sai_object_meta_key_t meta_key;
+
+            memset(&meta_key, 0, sizeof(meta_key));
+
+            meta_key.objecttype = object_type;
+            meta_key.objectkey = record.key;
+
+            if (info->isobjectid)
+            {
+                sai_object_id_t oid = record.key.key.object_id;
+
+                if (libsai_oid::object_type(oid) != object_type || libsai_oid::switch_index(oid) != section.switch_index)
+                {
+                    SAI_META_LOG_ERROR("%s 0x%" PRIx64 " in dump is invalid", info->objecttypename, oid);
+
+                    return SAI_STATUS_FAILURE;
+                }
+
+                if (object_type == SAI_OBJECT_TYPE_SWITCH)
+                {
+                    switches.push_back(section.switch_index);
+                }
+                else
+                {
+                    used[tid].push_back(libsai_oid::object_index(oid));
+                }
+            }
+
+            std::string k = key(info, meta_key);
+
+            if (t.find(k) != NULL)
+            {
+                SAI_META_LOG_ERROR("%s is in dump more than once", info->objecttypename);
+
+                return SAI_STATUS_FAILURE;
+            }
+
+            libsai_object_t &object = t.insert(k, meta_key);
+
+            object.switch_id = record.switch_id;
+            object.refcount = record.refcount;
+
+            for (uint32_t i = 0; i < record.attr_count; i++)
+            {
+                libsai_dump_attr_t a;
+
+                const uint8_t *lists = NULL;
+
+                if (!reader.read(a) || (lists = reader.read_bytes(a.data_bytes)) == NULL)
+                {
+                    SAI_META_LOG_ERROR("dump is truncated");
+
+                    return SAI_STATUS_FAILURE;
+                }
+
+                const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(object_type, a.id);
+
+                if (md == NULL)
+                {
+                    SAI_META_LOG_ERROR("unknown attribute 0x%x on %s in dump", a.id, info->objecttypename);
+
+                    return SAI_STATUS_FAILURE;
+                }
+
+                sai_attribute_t attr;
+
+                attr.id = a.id;
+                attr.value = a.value;
+
+                libsai_list_map map(lists, a.data_bytes);
+
+                if (!libsai_is_acl_disabled(md, attr.value))
+                {
+                    libsai_visit_lists(md->attrvaluetype, attr.value, attr.value, map);
+                }
+
+                if (!map.m_valid || map.m_left != 0)
+                {
+                    SAI_META_LOG_ERROR("%s lists in dump are invalid", md->attridname);
+
+                    return SAI_STATUS_FAILURE;
+                }
+
+                object.attrs.emplace_hint(object.attrs.end(), a.id, libsai_attr(md, attr));
+            }
+
+            object.pool = resource_pool(info, meta_key, section.switch_index, [&](sai_attr_id_t id) -> const sai_attribute_value_t* {
+                    auto it = object.attrs.find(id);
+                    return (it == object.attrs.end()) ? NULL : &it->second.attr().value;
+                    });
+
+            m_resources.update(object.pool, 1);
+        }
+    }
+
+    if (switches.empty())
+    {
+        SAI_META_LOG_ERROR("dump holds no switch");
+
+        return SAI_STATUS_FAILURE;
+    }
+
+    for (auto &kvp: used)
+    {
+        m_indexes[kvp.first].restore(kvp.second);
+    }
+
+    m_switch_indexes.restore(switches);
+
+    switch_id = libsai_oid::encode((uint32_t)switches.front(), SAI_OBJECT_TYPE_SWITCH, switches.front());
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static libsai_store g_store;
+
+sai_object_type_t libsai_store::object_type_query(
+        _In_ sai_object_id_t oid)
+{
+    return g_store.exists(oid);
+}
+
+static bool g_initialized = false;
+
+/*
+ * Method table glue: every member of the API structs is bound by
+ * libsaiapis.h to libsai_method<decltype(member), op, object type>::call.
+ * The specializations below pick the implementation from the signature,
+ * object id and entry flavours alike; anything which matches none of
+ * them ends up on the NOT_IMPLEMENTED stub.
  */
 
-extern "C" {
-#include <sai.h>
+typedef enum _libsai_op_t
+{
+    LIBSAI_OP_CREATE,
+    LIBSAI_OP_REMOVE,
+    LIBSAI_OP_SET,
+    LIBSAI_OP_GET,
+    LIBSAI_OP_GET_STATS,
+    LIBSAI_OP_GET_STATS_EXT,
+    LIBSAI_OP_CLEAR_STATS,
+    LIBSAI_OP_BULK_CREATE,
+    LIBSAI_OP_BULK_REMOVE,
+    LIBSAI_OP_BULK_SET,
+    LIBSAI_OP_BULK_GET,
+
+} libsai_op_t;
+
+template <typename F>
+class libsai_stub;
+
+template <typename... Args>
+class libsai_stub<sai_status_t (*)(Args...)>
+{
+    public:
+
+        static sai_status_t call(Args...)
+        {
+            return SAI_STATUS_NOT_IMPLEMENTED;
+        }
+};
+
+template <typename T>
+static sai_object_meta_key_t libsai_meta_key(
+        _In_ int object_type,
+        _In_ const T &key)
+{
+    static_assert(sizeof(T) <= sizeof(sai_object_key_entry_t), "key does not fit sai_object_key_entry_t");
+
+    sai_object_meta_key_t meta_key;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = (sai_object_type_t)object_type;
+
+    memcpy(&meta_key.objectkey.key, &key, sizeof(T));
+
+    return meta_key;
+}
+
+/*
+ * Bulk calls are executed one object at a time, objects following a
+ * failure are not executed in SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR mode.
+ */
+template <typename OP>
+static sai_status_t libsai_bulk(
+        _In_ uint32_t object_count,
+        _In_ sai_bulk_op_error_mode_t mode,
+        _Out_ sai_status_t *object_statuses,
+        _In_ OP op)
+{
+    if (object_count == 0 || object_statuses == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    bool failed = false;
+
+    for (uint32_t idx = 0; idx < object_count; idx++)
+    {
+        if (failed && mode == SAI_BULK_OP_ERROR_MODE_STOP_ON_ERROR)
+        {
+            object_statuses[idx] = SAI_STATUS_NOT_EXECUTED;
+            continue;
+        }
+
+        object_statuses[idx] = op(idx);
+
+        failed |= (object_statuses[idx] != SAI_STATUS_SUCCESS);
+    }
+
+    return failed ? SAI_STATUS_FAILURE : SAI_STATUS_SUCCESS;
+}
+
+template <typename F, int OP, int OT>
+class libsai_method: public libsai_stub<F>
+{
+};
+
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t*, sai_object_id_t, uint32_t, const sai_attribute_t*), LIBSAI_OP_CREATE, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _Out_ sai_object_id_t *object_id,
+                _In_ sai_object_id_t switch_id,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list)
+        {
+            if (object_id == NULL)
+            {
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            sai_object_meta_key_t meta_key = libsai_meta_key(OT, SAI_NULL_OBJECT_ID);
+
+            sai_status_t status = g_store.create(meta_key, switch_id, attr_count, attr_list);
+
+            *object_id = meta_key.objectkey.key.object_id;
+
+            return status;
+        }
+};
+
+/* create_switch */
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t*, uint32_t, const sai_attribute_t*), LIBSAI_OP_CREATE, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _Out_ sai_object_id_t *object_id,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list)
+        {
+            return libsai_method<sai_status_t (*)(sai_object_id_t*, sai_object_id_t, uint32_t, const sai_attribute_t*), LIBSAI_OP_CREATE, OT>::call(
+                    object_id, SAI_NULL_OBJECT_ID, attr_count, attr_list);
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(const T*, uint32_t, const sai_attribute_t*), LIBSAI_OP_CREATE, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ const T *entry,
+                _In_ uint32_t attr_count,
+                _In_ const sai_attribute_t *attr_list)
+        {
+            if (entry == NULL)
+            {
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            sai_object_meta_key_t meta_key = libsai_meta_key(OT, *entry);
+
+            return g_store.create(meta_key, SAI_NULL_OBJECT_ID, attr_count, attr_list);
+        }
+};
+
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t), LIBSAI_OP_REMOVE, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ sai_object_id_t object_id)
+        {
+            return g_store.remove(libsai_meta_key(OT, object_id));
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(const T*), LIBSAI_OP_REMOVE, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ const T *entry)
+        {
+            return (entry == NULL) ? SAI_STATUS_INVALID_PARAMETER : g_store.remove(libsai_meta_key(OT, *entry));
+        }
+};
+
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t, const sai_attribute_t*), LIBSAI_OP_SET, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ sai_object_id_t object_id,
+                _In_ const sai_attribute_t *attr)
+        {
+            return g_store.set(libsai_meta_key(OT, object_id), attr);
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(const T*, const sai_attribute_t*), LIBSAI_OP_SET, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ const T *entry,
+                _In_ const sai_attribute_t *attr)
+        {
+            return (entry == NULL) ? SAI_STATUS_INVALID_PARAMETER : g_store.set(libsai_meta_key(OT, *entry), attr);
+        }
+};
+
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t, uint32_t, sai_attribute_t*), LIBSAI_OP_GET, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ sai_object_id_t object_id,
+                _In_ uint32_t attr_count,
+                _Inout_ sai_attribute_t *attr_list)
+        {
+            return g_store.get(libsai_meta_key(OT, object_id), attr_count, attr_list);
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(const T*, uint32_t, sai_attribute_t*), LIBSAI_OP_GET, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ const T *entry,
+                _In_ uint32_t attr_count,
+                _Inout_ sai_attribute_t *attr_list)
+        {
+            return (entry == NULL) ? SAI_STATUS_INVALID_PARAMETER : g_store.get(libsai_meta_key(OT, *entry), attr_count, attr_list);
+        }
+};
+
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t, uint32_t, const sai_stat_id_t*, uint64_t*), LIBSAI_OP_GET_STATS, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ sai_object_id_t object_id,
+                _In_ uint32_t number_of_counters,
+                _In_ const sai_stat_id_t *counter_ids,
+                _Out_ uint64_t *counters)
+        {
+            return g_store.get_stats(libsai_meta_key(OT, object_id), number_of_counters, counter_ids, counters);
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(const T*, uint32_t, const sai_stat_id_t*, uint64_t*), LIBSAI_OP_GET_STATS, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ const T *entry,
+                _In_ uint32_t number_of_counters,
+                _In_ const sai_stat_id_t *counter_ids,
+                _Out_ uint64_t *counters)
+        {
+            return (entry == NULL) ? SAI_STATUS_INVALID_PARAMETER : g_store.get_stats(libsai_meta_key(OT, *entry), number_of_counters, counter_ids, counters);
+        }
+};
+
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t, uint32_t, const sai_stat_id_t*, sai_stats_mode_t, uint64_t*), LIBSAI_OP_GET_STATS_EXT, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ sai_object_id_t object_id,
+                _In_ uint32_t number_of_counters,
+                _In_ const sai_stat_id_t *counter_ids,
+                _In_ sai_stats_mode_t mode,
+                _Out_ uint64_t *counters)
+        {
+            return g_store.get_stats(libsai_meta_key(OT, object_id), number_of_counters, counter_ids, counters);
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(const T*, uint32_t, const sai_stat_id_t*, sai_stats_mode_t, uint64_t*), LIBSAI_OP_GET_STATS_EXT, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ const T *entry,
+                _In_ uint32_t number_of_counters,
+                _In_ const sai_stat_id_t *counter_ids,
+                _In_ sai_stats_mode_t mode,
+                _Out_ uint64_t *counters)
+        {
+            return (entry == NULL) ? SAI_STATUS_INVALID_PARAMETER : g_store.get_stats(libsai_meta_key(OT, *entry), number_of_counters, counter_ids, counters);
+        }
+};
+
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t, uint32_t, const sai_stat_id_t*), LIBSAI_OP_CLEAR_STATS, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ sai_object_id_t object_id,
+                _In_ uint32_t number_of_counters,
+                _In_ const sai_stat_id_t *counter_ids)
+        {
+            return g_store.clear_stats(libsai_meta_key(OT, object_id), number_of_counters, counter_ids);
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(const T*, uint32_t, const sai_stat_id_t*), LIBSAI_OP_CLEAR_STATS, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ const T *entry,
+                _In_ uint32_t number_of_counters,
+                _In_ const sai_stat_id_t *counter_ids)
+        {
+            return (entry == NULL) ? SAI_STATUS_INVALID_PARAMETER : g_store.clear_stats(libsai_meta_key(OT, *entry), number_of_counters, counter_ids);
+        }
+};
+
+template <int OT>
+class libsai_method<sai_status_t (*)(sai_object_id_t, uint32_t, const uint32_t*, const sai_attribute_t**, sai_bulk_op_error_mode_t, sai_object_id_t*, sai_status_t*), LIBSAI_OP_BULK_CREATE, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ sai_object_id_t switch_id,
+                _In_ uint32_t object_count,
+                _In_ const uint32_t *attr_count,
+                _In_ const sai_attribute_t **attr_list,
+                _In_ sai_bulk_op_error_mode_t mode,
+                _Out_ sai_object_id_t *object_id,
+                _Out_ sai_status_t *object_statuses)
+        {
+            if (attr_count == NULL || attr_list == NULL || object_id == NULL)
+            {
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            return libsai_bulk(object_count, mode, object_statuses, [&](uint32_t idx) {
+                    sai_object_meta_key_t meta_key = libsai_meta_key(OT, SAI_NULL_OBJECT_ID);
+                    sai_status_t status = g_store.create(meta_key, switch_id, attr_count[idx], attr_list[idx]);
+                    object_id[idx] = meta_key.objectkey.key.object_id;
+                    return status;
+                    });
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(uint32_t, const T*, const uint32_t*, const sai_attribute_t**, sai_bulk_op_error_mode_t, sai_status_t*), LIBSAI_OP_BULK_CREATE, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ uint32_t object_count,
+                _In_ const T *entry,
+                _In_ const uint32_t *attr_count,
+                _In_ const sai_attribute_t **attr_list,
+                _In_ sai_bulk_op_error_mode_t mode,
+                _Out_ sai_status_t *object_statuses)
+        {
+            if (entry == NULL || attr_count == NULL || attr_list == NULL)
+            {
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            return libsai_bulk(object_count, mode, object_statuses, [&](uint32_t idx) {
+                    sai_object_meta_key_t meta_key = libsai_meta_key(OT, entry[idx]);
+                    return g_store.create(meta_key, SAI_NULL_OBJECT_ID, attr_count[idx], attr_list[idx]);
+                    });
+        }
+};
+
+/* object ids and entries alike, T is sai_object_id_t for the former */
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(uint32_t, const T*, sai_bulk_op_error_mode_t, sai_status_t*), LIBSAI_OP_BULK_REMOVE, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ uint32_t object_count,
+                _In_ const T *key,
+                _In_ sai_bulk_op_error_mode_t mode,
+                _Out_ sai_status_t *object_statuses)
+        {
+            if (key == NULL)
+            {
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            return libsai_bulk(object_count, mode, object_statuses, [&](uint32_t idx) {
+                    return g_store.remove(libsai_meta_key(OT, key[idx]));
+                    });
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(uint32_t, const T*, const sai_attribute_t*, sai_bulk_op_error_mode_t, sai_status_t*), LIBSAI_OP_BULK_SET, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ uint32_t object_count,
+                _In_ const T *key,
+                _In_ const sai_attribute_t *attr_list,
+                _In_ sai_bulk_op_error_mode_t mode,
+                _Out_ sai_status_t *object_statuses)
+        {
+            if (key == NULL || attr_list == NULL)
+            {
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            return libsai_bulk(object_count, mode, object_statuses, [&](uint32_t idx) {
+                    return g_store.set(libsai_meta_key(OT, key[idx]), &attr_list[idx]);
+                    });
+        }
+};
+
+template <typename T, int OT>
+class libsai_method<sai_status_t (*)(uint32_t, const T*, const uint32_t*, sai_attribute_t**, sai_bulk_op_error_mode_t, sai_status_t*), LIBSAI_OP_BULK_GET, OT>
+{
+    public:
+
+        static sai_status_t call(
+                _In_ uint32_t object_count,
+                _In_ const T *key,
+                _In_ const uint32_t *attr_count,
+                _Inout_ sai_attribute_t **attr_list,
+                _In_ sai_bulk_op_error_mode_t mode,
+                _Out_ sai_status_t *object_statuses)
+        {
+            if (key == NULL || attr_count == NULL || attr_list == NULL)
+            {
+                return SAI_STATUS_INVALID_PARAMETER;
+            }
+
+            return libsai_bulk(object_count, mode, object_statuses, [&](uint32_t idx) {
+                    return g_store.get(libsai_meta_key(OT, key[idx]), attr_count[idx], attr_list[idx]);
+                    });
+        }
+};
+
+#define LIBSAI_METHOD(api, member, op, ot) \
+    libsai_ ## api ## _api.member = libsai_method<decltype(libsai_ ## api ## _api.member), LIBSAI_OP_ ## op, SAI_OBJECT_TYPE_ ## ot>::call
+
+#define LIBSAI_STUB(api, member) \
+    libsai_ ## api ## _api.member = libsai_stub<decltype(libsai_ ## api ## _api.member)>::call
+
+#include "libsaiapis.h"
+
+static sai_status_t libsai_flush_fdb_entries(
+        _In_ sai_object_id_t switch_id,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    return g_store.flush_fdb_entries(switch_id, attr_count, attr_list);
 }
 
-// NOTE: this could be auto generated by parse.pl for auto api update
+static sai_status_t libsai_remove_all_neighbor_entries(
+        _In_ sai_object_id_t switch_id)
+{
+    return g_store.remove_all_neighbor_entries(switch_id);
+}
 
 sai_status_t sai_api_initialize(
     _In_ uint64_t flags,
     _In_ const sai_service_method_table_t *services)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (g_initialized)
+    {
+        return SAI_STATUS_FAILURE;
+    }
+
+    libsai_apis_init();
+
+    g_store.build_metadata();
+
+    libsai_fdb_api.flush_fdb_entries = libsai_flush_fdb_entries;
+    libsai_neighbor_api.remove_all_neighbor_entries = libsai_remove_all_neighbor_entries;
+
+    g_store.set_services(services);
+
+    g_initialized = true;
+
+    return SAI_STATUS_SUCCESS;
+}
 
 sai_status_t sai_api_query(
     _In_ sai_api_t api,
     _Out_ void **api_method_table)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (!g_initialized)
+    {
+        return SAI_STATUS_UNINITIALIZED;
+    }
+
+    if (api_method_table == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *api_method_table = libsai_api_table(api);
+
+    return (*api_method_table == NULL) ? SAI_STATUS_INVALID_PARAMETER : SAI_STATUS_SUCCESS;
+}
 
 sai_status_t sai_api_uninitialize(void)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (!g_initialized)
+    {
+        return SAI_STATUS_UNINITIALIZED;
+    }
+
+    g_store.clear();
+
+    g_initialized = false;
+
+    return SAI_STATUS_SUCCESS;
+}
 
 sai_status_t sai_bulk_get_attribute(
     _In_ sai_object_id_t switch_id,
@@ -49,7 +4361,9 @@ sai_status_t sai_bulk_get_attribute(
     _Inout_ uint32_t *attr_count,
     _Inout_ sai_attribute_t **attr_list,
     _Inout_ sai_status_t *object_statuses)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    return g_store.bulk_get_attribute(switch_id, object_type, object_count, object_key, attr_count, attr_list, object_statuses);
+}
 
 sai_status_t sai_bulk_object_clear_stats(
     _In_ sai_object_id_t switch_id,
@@ -76,31 +4390,83 @@ sai_status_t sai_bulk_object_get_stats(
 
 sai_status_t sai_dbg_generate_dump(
     _In_ const char *dump_file_name)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (!g_initialized)
+    {
+        return SAI_STATUS_UNINITIALIZED;
+    }
+
+    return g_store.dump(dump_file_name);
+}
 
 sai_status_t sai_get_maximum_attribute_count(
     _In_ sai_object_id_t switch_id,
     _In_ sai_object_type_t object_type,
     _Out_ uint32_t *count)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(object_type);
+
+    if (info == NULL || count == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *count = (uint32_t)info->attrmetadatalength;
+
+    return SAI_STATUS_SUCCESS;
+}
 
 sai_status_t sai_get_object_count(
     _In_ sai_object_id_t switch_id,
     _In_ sai_object_type_t object_type,
     _Out_ uint32_t *count)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (count == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return g_store.get_object_count(switch_id, object_type, *count);
+}
 
 sai_status_t sai_get_object_key(
     _In_ sai_object_id_t switch_id,
     _In_ sai_object_type_t object_type,
     _Inout_ uint32_t *object_count,
     _Inout_ sai_object_key_t *object_list)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (object_count == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    uint32_t count;
+
+    sai_status_t status = g_store.get_object_count(switch_id, object_type, count);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        return status;
+    }
+
+    if (*object_count < count)
+    {
+        *object_count = count;
+
+        return SAI_STATUS_BUFFER_OVERFLOW;
+    }
+
+    /* straight from the key array of the table into the caller list */
+
+    size_t cursor = 0;
+
+    return g_store.get_object_keys(switch_id, object_type, cursor, *object_count, object_list);
+}
 
 sai_status_t sai_log_set(
     _In_ sai_api_t api,
     _In_ sai_log_level_t log_level)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{ return SAI_STATUS_SUCCESS; }
 
 sai_status_t sai_object_type_get_availability(
     _In_ sai_object_id_t switch_id,
@@ -108,29 +4474,76 @@ sai_status_t sai_object_type_get_availability(
     _In_ uint32_t attr_count,
     _In_ const sai_attribute_t *attr_list,
     _Out_ uint64_t *count)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (!g_initialized)
+    {
+        return SAI_STATUS_UNINITIALIZED;
+    }
+
+    if (count == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return g_store.get_availability(switch_id, object_type, attr_count, attr_list, *count);
+}
 
 sai_object_type_t sai_object_type_query(
     _In_ sai_object_id_t object_id)
-{ return SAI_OBJECT_TYPE_NULL; }
+{
+    return libsai_oid::object_type(object_id);
+}
 
 sai_status_t sai_query_api_version(
     _Out_ sai_api_version_t *version)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (version == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    *version = SAI_API_VERSION;
+
+    return SAI_STATUS_SUCCESS;
+}
 
 sai_status_t sai_query_attribute_capability(
     _In_ sai_object_id_t switch_id,
     _In_ sai_object_type_t object_type,
     _In_ sai_attr_id_t attr_id,
     _Out_ sai_attr_capability_t *attr_capability)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (!g_initialized)
+    {
+        return SAI_STATUS_UNINITIALIZED;
+    }
+
+    if (attr_capability == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return g_store.query_attribute_capability(switch_id, object_type, attr_id, *attr_capability);
+}
 
 sai_status_t sai_query_attribute_enum_values_capability(
     _In_ sai_object_id_t switch_id,
     _In_ sai_object_type_t object_type,
     _In_ sai_attr_id_t attr_id,
     _Inout_ sai_s32_list_t *enum_values_capability)
-{ return SAI_STATUS_NOT_IMPLEMENTED; }
+{
+    if (!g_initialized)
+    {
+        return SAI_STATUS_UNINITIALIZED;
+    }
+
+    if (enum_values_capability == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return g_store.query_attribute_enum_values_capability(switch_id, object_type, attr_id, *enum_values_capability);
+}
 
 sai_status_t sai_query_object_stage(
     _In_ sai_object_id_t switch_id,
@@ -148,7 +4561,9 @@ sai_status_t sai_query_stats_capability(
 
 sai_object_id_t sai_switch_id_query(
     _In_ sai_object_id_t object_id)
-{ return SAI_NULL_OBJECT_ID; }
+{
+    return libsai_oid::switch_id(object_id);
+}
 
 sai_status_t sai_tam_telemetry_get_data(
     _In_ sai_object_id_t switch_id,
@@ -0,0 +1,1071 @@
+/**
+ * Copyright (c) 2023 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    libsairecord.cpp
+ *
+ * @brief   This module contains a recording libsai.so, wrapping a vendor libsai
+ *
+ * The vendor library named by SAI_RECORD_LIBRARY is loaded on first use,
+ * every global sai_* function is forwarded to it and every API table it
+ * returns from sai_api_query is replaced by a proxy table which records
+ * each create, remove, set, get and statistics call, bulk calls one line
+ * per object, to SAI_RECORD_FILE (default /tmp/sairecord.<pid>). The
+ * recording is replayed by saireplay.
+ *
+ * One line per call, fields separated by '|':
+ *
+ *   <ns>|c|<status>|<switch id>|<meta key>|<attr>|<attr>...   create
+ *   <ns>|r|<status>|<meta key>                                 remove
+ *   <ns>|s|<status>|<meta key>|<attr>                          set
+ *   <ns>|g|<status>|<meta key>|<attr>|<attr>...                get
+ *   <ns>|t|<status>|<meta key>|<counter id>...                 get stats
+ *   <ns>|e|<status>|<meta key>|<mode>|<counter id>...          get stats ext
+ *   <ns>|x|<status>|<meta key>|<counter id>...                 clear stats
+ *
+ * where ns is the time the call was made, relative to the load of this
+ * library, the status is numeric and the meta key, switch id and
+ * attributes are in saiserialize format. Gets record the returned values,
+ * and only when they succeeded. Fields are read back with the matching
+ * sai_deserialize_* function, which tells where each one ends, so a '|'
+ * inside a serialized value is not ambiguous.
+ */
+
+extern "C" {
+#include <sai.h>
+#include "saimetadata.h"
+}
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <dlfcn.h>
+#include <unistd.h>
+
+#define SAIRECORD_ENV_LIBRARY       "SAI_RECORD_LIBRARY"
+#define SAIRECORD_ENV_FILE          "SAI_RECORD_FILE"
+
+/*
+ * Scratch buffer a single serialized value must fit in, saiserialize
+ * writes without bounds. Lists of a few thousand elements fit easily.
+ */
+#define SAIRECORD_VALUE_MAX         (4 * 1024 * 1024)
+
+/* Global sai_* functions, forwarded by name to the vendor library */
+#define SAIRECORD_GLOBALS(X) \
+    X(sai_api_initialize) \
+    X(sai_api_query) \
+    X(sai_api_uninitialize) \
+    X(sai_bulk_get_attribute) \
+    X(sai_bulk_object_clear_stats) \
+    X(sai_bulk_object_get_stats) \
+    X(sai_dbg_generate_dump) \
+    X(sai_get_maximum_attribute_count) \
+    X(sai_get_object_count) \
+    X(sai_get_object_key) \
+    X(sai_log_set) \
+    X(sai_object_type_get_availability) \
+    X(sai_object_type_query) \
+    X(sai_query_api_version) \
+    X(sai_query_attribute_capability) \
+    X(sai_query_attribute_enum_values_capability) \
+    X(sai_query_object_stage) \
+    X(sai_query_stats_capability) \
+    X(sai_switch_id_query) \
+    X(sai_tam_telemetry_get_data)
+
+#define SAIRECORD_GLOBAL_POINTER(name) decltype(&::name) name;
+
+typedef struct _sairecord_vendor_t
+{
+    SAIRECORD_GLOBALS(SAIRECORD_GLOBAL_POINTER)
+
+} sairecord_vendor_t;
+
+/* Same operation names as the ones libsaiapis.h binds members to */
+typedef enum _sairecord_op_t
+{
+    SAIRECORD_OP_NONE,
+    SAIRECORD_OP_CREATE,
+    SAIRECORD_OP_REMOVE,
+    SAIRECORD_OP_SET,
+    SAIRECORD_OP_GET,
+    SAIRECORD_OP_GET_STATS,
+    SAIRECORD_OP_GET_STATS_EXT,
+    SAIRECORD_OP_CLEAR_STATS,
+    SAIRECORD_OP_BULK_CREATE,
+    SAIRECORD_OP_BULK_REMOVE,
+    SAIRECORD_OP_BULK_SET,
+    SAIRECORD_OP_BULK_GET,
+
+} sairecord_op_t;
+
+static std::once_flag g_load_once;
+static void *g_library = NULL;
+static sairecord_vendor_t g_vendor;
+
+static std::chrono::steady_clock::time_point g_start;
+
+static std::mutex g_file_mutex;
+static FILE *g_file = NULL;
+
+/* calls which could not be serialized and are missing from the recording */
+static std::atomic<uint64_t> g_dropped(0);
+
+/* Proxy table to the vendor table pointer of the same api */
+static std::map<const void*, std::atomic<const void*>*> g_tables;
+
+static thread_local std::string t_line;
+static thread_local std::vector<char> t_buffer;
+
+static uint64_t sairecord_now(void)
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - g_start).count();
+}
+
+static char* sairecord_buffer(void)
+{
+    if (t_buffer.empty())
+    {
+        t_buffer.resize(SAIRECORD_VALUE_MAX);
+    }
+
+    return t_buffer.data();
+}
+
+static std::string& sairecord_begin(
+        _In_ uint64_t ns,
+        _In_ char op,
+        _In_ sai_status_t status)
+{
+    char head[64];
+
+    snprintf(head, sizeof(head), "%" PRIu64 "|%c|%d", ns, op, status);
+
+    t_line.assign(head);
+
+    return t_line;
+}
+
+static bool sairecord_add(
+        _Inout_ std::string &line,
+        _In_ int len)
+{
+    if (len < 0)
+    {
+        g_dropped++;
+
+        return false;
+    }
+
+    line += '|';
+    line.append(sairecord_buffer(), (size_t)len);
+
+    return true;
+}
+
+static bool sairecord_add_oid(
+        _Inout_ std::string &line,
+        _In_ sai_object_id_t oid)
+{
+    return sairecord_add(line, sai_serialize_object_id(sairecord_buffer(), oid));
+}
+
+static bool sairecord_add_key(
+        _Inout_ std::string &line,
+        _In_ const sai_object_meta_key_t &meta_key)
+{
+    return sairecord_add(line, sai_serialize_object_meta_key(sairecord_buffer(), &meta_key));
+}
+
+static bool sairecord_add_attrs(
+        _Inout_ std::string &line,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    if (attr_count != 0 && attr_list == NULL)
+    {
+        g_dropped++;
+
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < attr_count; idx++)
+    {
+        const sai_attr_metadata_t *meta = sai_metadata_get_attr_metadata(object_type, attr_list[idx].id);
+
+        if (meta == NULL ||
+                !sairecord_add(line, sai_serialize_attribute(sairecord_buffer(), meta, &attr_list[idx])))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static bool sairecord_add_counters(
+        _Inout_ std::string &line,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids)
+{
+    if (number_of_counters != 0 && counter_ids == NULL)
+    {
+        g_dropped++;
+
+        return false;
+    }
+
+    for (uint32_t idx = 0; idx < number_of_counters; idx++)
+    {
+        line += '|';
+        line += std::to_string(counter_ids[idx]);
+    }
+
+    return true;
+}
+
+static void sairecord_end(
+        _Inout_ std::string &line)
+{
+    line += '\n';
+
+    std::lock_guard<std::mutex> lock(g_file_mutex);
+
+    if (g_file != NULL)
+    {
+        fwrite(line.data(), 1, line.size(), g_file);
+    }
+}
+
+static void sairecord_create(
+        _In_ uint64_t ns,
+        _In_ sai_status_t status,
+        _In_ sai_object_id_t switch_id,
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    std::string &line = sairecord_begin(ns, 'c', status);
+
+    if (sairecord_add_oid(line, switch_id) &&
+            sairecord_add_key(line, meta_key) &&
+            sairecord_add_attrs(line, meta_key.objecttype, attr_count, attr_list))
+    {
+        sairecord_end(line);
+    }
+}
+
+static void sairecord_attrs(
+        _In_ uint64_t ns,
+        _In_ char op,
+        _In_ sai_status_t status,
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    std::string &line = sairecord_begin(ns, op, status);
+
+    if (op == 'g' && status != SAI_STATUS_SUCCESS)
+    {
+        /* returned values are not valid, nothing to replay either */
+
+        attr_count = 0;
+    }
+
+    if (sairecord_add_key(line, meta_key) &&
+            sairecord_add_attrs(line, meta_key.objecttype, attr_count, attr_list))
+    {
+        sairecord_end(line);
+    }
+}
+
+static void sairecord_stats(
+        _In_ uint64_t ns,
+        _In_ char op,
+        _In_ sai_status_t status,
+        _In_ const sai_object_meta_key_t &meta_key,
+        _In_ sai_stats_mode_t mode,
+        _In_ uint32_t number_of_counters,
+        _In_ const sai_stat_id_t *counter_ids)
+{
+    std::string &line = sairecord_begin(ns, op, status);
+
+    if (!sairecord_add_key(line, meta_key))
+    {
+        return;
+    }
+
+    if (op == 'e')
+    {
+        line += '|';
+        line += std::to_string((int)mode);
+    }
+
+    if (sairecord_add_counters(line, number_of_counters, counter_ids))
+    {
+        sairecord_end(line);
+    }
+}
+
+static sai_object_meta_key_t sairecord_key(
+        _In_ int object_type,
+        _In_ sai_object_id_t object_id)
+{
+    sai_object_meta_key_t meta_key;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = (sai_object_type_t)object_type;
+    meta_key.objectkey.key.object_id = object_id;
+
+    return meta_key;
+}
+
+template <typename T>
+static sai_object_meta_key_t sairecord_key(
+        _In_ int object_type,
+        _In_ const T &entry)
+{
+    static_assert(sizeof(T) <= sizeof(sai_object_key_entry_t), "key does not fit sai_object_key_entry_t");
+
+    sai_object_meta_key_t meta_key;
+
+    memset(&meta_key, 0, sizeof(meta_key));
+
+    meta_key.objecttype = (sai_object_type_t)object_type;
+
+    memcpy(&meta_key.objectkey.key, &entry, sizeof(T));
+
+    return meta_key;
+}
+
+/*
+ * Recording of one member, picked by signature and operation the same
+ * way libsai picks its implementation. Members which match none of the
+ * specializations are forwarded unrecorded.
+ */
+template <typename F, int OP, int OT>
+class sairecord_op
+{
+    public:
+
+        template <typename... Args>
+        static void record(uint64_t, sai_status_t, Args...)
+        {
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t*, sai_object_id_t, uint32_t, const sai_attribute_t*), SAIRECORD_OP_CREATE, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                sai_object_id_t *object_id, sai_object_id_t switch_id, uint32_t attr_count, const sai_attribute_t *attr_list)
+        {
+            sai_object_id_t oid = (status == SAI_STATUS_SUCCESS && object_id != NULL) ? *object_id : SAI_NULL_OBJECT_ID;
+
+            sairecord_create(ns, status, switch_id, sairecord_key(OT, oid), attr_count, attr_list);
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t*, uint32_t, const sai_attribute_t*), SAIRECORD_OP_CREATE, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                sai_object_id_t *object_id, uint32_t attr_count, const sai_attribute_t *attr_list)
+        {
+            sai_object_id_t oid = (status == SAI_STATUS_SUCCESS && object_id != NULL) ? *object_id : SAI_NULL_OBJECT_ID;
+
+            sairecord_create(ns, status, SAI_NULL_OBJECT_ID, sairecord_key(OT, oid), attr_count, attr_list);
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(const T*, uint32_t, const sai_attribute_t*), SAIRECORD_OP_CREATE, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                const T *entry, uint32_t attr_count, const sai_attribute_t *attr_list)
+        {
+            if (entry != NULL)
+            {
+                sairecord_create(ns, status, SAI_NULL_OBJECT_ID, sairecord_key(OT, *entry), attr_count, attr_list);
+            }
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t), SAIRECORD_OP_REMOVE, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                sai_object_id_t object_id)
+        {
+            sairecord_attrs(ns, 'r', status, sairecord_key(OT, object_id), 0, NULL);
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(const T*), SAIRECORD_OP_REMOVE, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                const T *entry)
+        {
+            if (entry != NULL)
+            {
+                sairecord_attrs(ns, 'r', status, sairecord_key(OT, *entry), 0, NULL);
+            }
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t, const sai_attribute_t*), SAIRECORD_OP_SET, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                sai_object_id_t object_id, const sai_attribute_t *attr)
+        {
+            sairecord_attrs(ns, 's', status, sairecord_key(OT, object_id), 1, attr);
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(const T*, const sai_attribute_t*), SAIRECORD_OP_SET, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                const T *entry, const sai_attribute_t *attr)
+        {
+            if (entry != NULL)
+            {
+                sairecord_attrs(ns, 's', status, sairecord_key(OT, *entry), 1, attr);
+            }
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t, uint32_t, sai_attribute_t*), SAIRECORD_OP_GET, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                sai_object_id_t object_id, uint32_t attr_count, sai_attribute_t *attr_list)
+        {
+            sairecord_attrs(ns, 'g', status, sairecord_key(OT, object_id), attr_count, attr_list);
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(const T*, uint32_t, sai_attribute_t*), SAIRECORD_OP_GET, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                const T *entry, uint32_t attr_count, sai_attribute_t *attr_list)
+        {
+            if (entry != NULL)
+            {
+                sairecord_attrs(ns, 'g', status, sairecord_key(OT, *entry), attr_count, attr_list);
+            }
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t, uint32_t, const sai_stat_id_t*, uint64_t*), SAIRECORD_OP_GET_STATS, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                sai_object_id_t object_id, uint32_t number_of_counters, const sai_stat_id_t *counter_ids, uint64_t*)
+        {
+            sairecord_stats(ns, 't', status, sairecord_key(OT, object_id), SAI_STATS_MODE_READ, number_of_counters, counter_ids);
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(const T*, uint32_t, const sai_stat_id_t*, uint64_t*), SAIRECORD_OP_GET_STATS, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                const T *entry, uint32_t number_of_counters, const sai_stat_id_t *counter_ids, uint64_t*)
+        {
+            if (entry != NULL)
+            {
+                sairecord_stats(ns, 't', status, sairecord_key(OT, *entry), SAI_STATS_MODE_READ, number_of_counters, counter_ids);
+            }
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t, uint32_t, const sai_stat_id_t*, sai_stats_mode_t, uint64_t*), SAIRECORD_OP_GET_STATS_EXT, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                sai_object_id_t object_id, uint32_t number_of_counters, const sai_stat_id_t *counter_ids, sai_stats_mode_t mode, uint64_t*)
+        {
+            sairecord_stats(ns, 'e', status, sairecord_key(OT, object_id), mode, number_of_counters, counter_ids);
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(const T*, uint32_t, const sai_stat_id_t*, sai_stats_mode_t, uint64_t*), SAIRECORD_OP_GET_STATS_EXT, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                const T *entry, uint32_t number_of_counters, const sai_stat_id_t *counter_ids, sai_stats_mode_t mode, uint64_t*)
+        {
+            if (entry != NULL)
+            {
+                sairecord_stats(ns, 'e', status, sairecord_key(OT, *entry), mode, number_of_counters, counter_ids);
+            }
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t, uint32_t, const sai_stat_id_t*), SAIRECORD_OP_CLEAR_STATS, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                sai_object_id_t object_id, uint32_t number_of_counters, const sai_stat_id_t *counter_ids)
+        {
+            sairecord_stats(ns, 'x', status, sairecord_key(OT, object_id), SAI_STATS_MODE_READ, number_of_counters, counter_ids);
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(const T*, uint32_t, const sai_stat_id_t*), SAIRECORD_OP_CLEAR_STATS, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t status,
+                const T *entry, uint32_t number_of_counters, const sai_stat_id_t *counter_ids)
+        {
+            if (entry != NULL)
+            {
+                sairecord_stats(ns, 'x', status, sairecord_key(OT, *entry), SAI_STATS_MODE_READ, number_of_counters, counter_ids);
+            }
+        }
+};
+
+template <int OT>
+class sairecord_op<sai_status_t (*)(sai_object_id_t, uint32_t, const uint32_t*, const sai_attribute_t**, sai_bulk_op_error_mode_t, sai_object_id_t*, sai_status_t*), SAIRECORD_OP_BULK_CREATE, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t,
+                sai_object_id_t switch_id, uint32_t object_count, const uint32_t *attr_count, const sai_attribute_t **attr_list,
+                sai_bulk_op_error_mode_t, sai_object_id_t *object_id, sai_status_t *object_statuses)
+        {
+            if (attr_count == NULL || attr_list == NULL || object_id == NULL || object_statuses == NULL)
+            {
+                return;
+            }
+
+            for (uint32_t idx = 0; idx < object_count; idx++)
+            {
+                sai_status_t status = object_statuses[idx];
+
+                sai_object_id_t oid = (status == SAI_STATUS_SUCCESS) ? object_id[idx] : SAI_NULL_OBJECT_ID;
+
+                sairecord_create(ns, status, switch_id, sairecord_key(OT, oid), attr_count[idx], attr_list[idx]);
+            }
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(uint32_t, const T*, const uint32_t*, const sai_attribute_t**, sai_bulk_op_error_mode_t, sai_status_t*), SAIRECORD_OP_BULK_CREATE, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t,
+                uint32_t object_count, const T *entry, const uint32_t *attr_count, const sai_attribute_t **attr_list,
+                sai_bulk_op_error_mode_t, sai_status_t *object_statuses)
+        {
+            if (entry == NULL || attr_count == NULL || attr_list == NULL || object_statuses == NULL)
+            {
+                return;
+            }
+
+            for (uint32_t idx = 0; idx < object_count; idx++)
+            {
+                sairecord_create(ns, object_statuses[idx], SAI_NULL_OBJECT_ID, sairecord_key(OT, entry[idx]), attr_count[idx], attr_list[idx]);
+            }
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(uint32_t, const T*, sai_bulk_op_error_mode_t, sai_status_t*), SAIRECORD_OP_BULK_REMOVE, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t,
+                uint32_t object_count, const T *key, sai_bulk_op_error_mode_t, sai_status_t *object_statuses)
+        {
+            if (key == NULL || object_statuses == NULL)
+            {
+                return;
+            }
+
+            for (uint32_t idx = 0; idx < object_count; idx++)
+            {
+                sairecord_attrs(ns, 'r', object_statuses[idx], sairecord_key(OT, key[idx]), 0, NULL);
+            }
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(uint32_t, const T*, const sai_attribute_t*, sai_bulk_op_error_mode_t, sai_status_t*), SAIRECORD_OP_BULK_SET, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t,
+                uint32_t object_count, const T *key, const sai_attribute_t *attr_list, sai_bulk_op_error_mode_t, sai_status_t *object_statuses)
+        {
+            if (key == NULL || attr_list == NULL || object_statuses == NULL)
+            {
+                return;
+            }
+
+            for (uint32_t idx = 0; idx < object_count; idx++)
+            {
+                sairecord_attrs(ns, 's', object_statuses[idx], sairecord_key(OT, key[idx]), 1, &attr_list[idx]);
+            }
+        }
+};
+
+template <typename T, int OT>
+class sairecord_op<sai_status_t (*)(uint32_t, const T*, const uint32_t*, sai_attribute_t**, sai_bulk_op_error_mode_t, sai_status_t*), SAIRECORD_OP_BULK_GET, OT>
+{
+    public:
+
+        static void record(uint64_t ns, sai_status_t,
+                uint32_t object_count, const T *key, const uint32_t *attr_count, sai_attribute_t **attr_list,
+                sai_bulk_op_error_mode_t, sai_status_t *object_statuses)
+        {
+            if (key == NULL || attr_count == NULL || attr_list == NULL || object_statuses == NULL)
+            {
+                return;
+            }
+
+            for (uint32_t idx = 0; idx < object_count; idx++)
+            {
+                sairecord_attrs(ns, 'g', object_statuses[idx], sairecord_key(OT, key[idx]), attr_count[idx], attr_list[idx]);
+            }
+        }
+};
+
+/*
+ * Vendor table of one api struct type, set by sai_api_query. Two apis
+ * never share a struct type, so there is one per api.
+ */
+template <typename Api>
+class sairecord_table
+{
+    public:
+
+        static std::atomic<const void*> vendor;
+};
+
+template <typename Api>
+std::atomic<const void*> sairecord_table<Api>::vendor(NULL);
+
+template <typename Api, typename F, F Api::*Member, int OP, int OT>
+class sairecord_method;
+
+template <typename Api, typename... Args, sai_status_t (*Api::*Member)(Args...), int OP, int OT>
+class sairecord_method<Api, sai_status_t (*)(Args...), Member, OP, OT>
+{
+    public:
+
+        static sai_status_t call(Args... args)
+        {
+            const Api *vendor = static_cast<const Api*>(sairecord_table<Api>::vendor.load(std::memory_order_acquire));
+
+            if (vendor == NULL || vendor->*Member == NULL)
+            {
+                return SAI_STATUS_NOT_IMPLEMENTED;
+            }
+
+            uint64_t ns = sairecord_now();
+
+            sai_status_t status = (vendor->*Member)(args...);
+
+            sairecord_op<sai_status_t (*)(Args...), OP, OT>::record(ns, status, args...);
+
+            return status;
+        }
+};
+
+template <typename Api, typename F, F Api::*Member, int OP, int OT>
+static F sairecord_bind(
+        _In_ Api *proxy)
+{
+    g_tables[proxy] = &sairecord_table<Api>::vendor;
+
+    return sairecord_method<Api, F, Member, OP, OT>::call;
+}
+
+#define LIBSAI_METHOD(api, member, op, ot) \
+    libsai_ ## api ## _api.member = sairecord_bind<sai_ ## api ## _api_t, decltype(libsai_ ## api ## _api.member), &sai_ ## api ## _api_t::member, \
+            SAIRECORD_OP_ ## op, SAI_OBJECT_TYPE_ ## ot>(&libsai_ ## api ## _api)
+
+#define LIBSAI_STUB(api, member) \
+    libsai_ ## api ## _api.member = sairecord_bind<sai_ ## api ## _api_t, decltype(libsai_ ## api ## _api.member), &sai_ ## api ## _api_t::member, \
+            SAIRECORD_OP_NONE, SAI_OBJECT_TYPE_NULL>(&libsai_ ## api ## _api)
+
+#include "libsaiapis.h"
+
+/*
+ * Load the vendor library, open the recording and bind all proxy tables,
+ * once. RTLD_DEEPBIND keeps the vendor calls to its own sai_* functions
+ * inside the vendor library instead of resolving them back to the
+ * wrappers below.
+ */
+static void sairecord_load(void)
+{
+    g_start = std::chrono::steady_clock::now();
+
+    libsai_apis_init();
+
+    const char *file = getenv(SAIRECORD_ENV_FILE);
+
+    std::string file_name = (file != NULL) ? file : "/tmp/sairecord." + std::to_string(getpid());
+
+    g_file = fopen(file_name.c_str(), "w");
+
+    if (g_file == NULL)
+    {
+        fprintf(stderr, "libsairecord: failed to open %s: %s\n", file_name.c_str(), strerror(errno));
+    }
+
+    const char *library = getenv(SAIRECORD_ENV_LIBRARY);
+
+    if (library == NULL)
+    {
+        fprintf(stderr, "libsairecord: %s is not set, all calls will return SAI_STATUS_NOT_IMPLEMENTED\n", SAIRECORD_ENV_LIBRARY);
+
+        return;
+    }
+
+    g_library = dlopen(library, RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+
+    if (g_library == NULL)
+    {
+        fprintf(stderr, "libsairecord: failed to load %s: %s\n", library, dlerror());
+
+        return;
+    }
+
+#define SAIRECORD_GLOBAL_RESOLVE(name) g_vendor.name = reinterpret_cast<decltype(g_vendor.name)>(dlsym(g_library, #name));
+
+    SAIRECORD_GLOBALS(SAIRECORD_GLOBAL_RESOLVE)
+
+    sai_api_version_t version = 0;
+
+    if (g_vendor.sai_query_api_version != NULL &&
+            g_vendor.sai_query_api_version(&version) == SAI_STATUS_SUCCESS &&
+            version != SAI_API_VERSION)
+    {
+        fprintf(stderr, "libsairecord: %s was built for SAI API version %" PRIu64 ", not %" PRIu64 "\n",
+                library, version, (uint64_t)SAI_API_VERSION);
+    }
+}
+
+static void sairecord_flush(void)
+{
+    std::lock_guard<std::mutex> lock(g_file_mutex);
+
+    if (g_file != NULL)
+    {
+        fflush(g_file);
+    }
+
+    if (g_dropped != 0)
+    {
+        fprintf(stderr, "libsairecord: %" PRIu64 " calls could not be serialized and are not recorded\n", g_dropped.load());
+    }
+}
+
+template <typename R>
+class sairecord_missing
+{
+    public:
+
+        static R value()
+        {
+            return R();
+        }
+};
+
+template <>
+class sairecord_missing<sai_status_t>
+{
+    public:
+
+        static sai_status_t value()
+        {
+            return SAI_STATUS_NOT_IMPLEMENTED;
+        }
+};
+
+/*
+ * fn is taken by reference since the vendor pointers are only resolved by
+ * the first call, inside this function.
+ */
+template <typename R, typename... Args, typename... Params>
+static R sairecord_forward(
+        _In_ R (*const& fn)(Args...),
+        _In_ Params... params)
+{
+    std::call_once(g_load_once, sairecord_load);
+
+    if (fn == NULL)
+    {
+        return sairecord_missing<R>::value();
+    }
+
+    return fn(params...);
+}
+
+sai_status_t sai_api_initialize(
+    _In_ uint64_t flags,
+    _In_ const sai_service_method_table_t *services)
+{
+    return sairecord_forward(g_vendor.sai_api_initialize, flags, services);
+}
+
+sai_status_t sai_api_query(
+    _In_ sai_api_t api,
+    _Out_ void **api_method_table)
+{
+    sai_status_t status = sairecord_forward(g_vendor.sai_api_query, api, api_method_table);
+
+    if (status != SAI_STATUS_SUCCESS || api_method_table == NULL)
+    {
+        return status;
+    }
+
+    void *proxy = libsai_api_table(api);
+
+    auto it = g_tables.find(proxy);
+
+    if (it == g_tables.end())
+    {
+        /* api unknown to this build, hand out the vendor table unrecorded */
+
+        return status;
+    }
+
+    it->second->store(*api_method_table, std::memory_order_release);
+
+    *api_method_table = proxy;
+
+    return status;
+}
+
+sai_status_t sai_api_uninitialize(void)
+{
+    sai_status_t status = sairecord_forward(g_vendor.sai_api_uninitialize);
+
+    sairecord_flush();
+
+    return status;
+}
+
+sai_status_t sai_bulk_get_attribute(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t object_count,
+    _In_ const sai_object_key_t *object_key,
+    _Inout_ uint32_t *attr_count,
+    _Inout_ sai_attribute_t **attr_list,
+    _Inout_ sai_status_t *object_statuses)
+{
+    return sairecord_forward(g_vendor.sai_bulk_get_attribute,
+            switch_id, object_type, object_count, object_key, attr_count, attr_list, object_statuses);
+}
+
+sai_status_t sai_bulk_object_clear_stats(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t object_count,
+    _In_ const sai_object_key_t *object_key,
+    _In_ uint32_t number_of_counters,
+    _In_ const sai_stat_id_t *counter_ids,
+    _In_ sai_stats_mode_t mode,
+    _Inout_ sai_status_t *object_statuses)
+{
+    return sairecord_forward(g_vendor.sai_bulk_object_clear_stats,
+            switch_id, object_type, object_count, object_key, number_of_counters, counter_ids, mode, object_statuses);
+}
+
+sai_status_t sai_bulk_object_get_stats(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t object_count,
+    _In_ const sai_object_key_t *object_key,
+    _In_ uint32_t number_of_counters,
+    _In_ const sai_stat_id_t *counter_ids,
+    _In_ sai_stats_mode_t mode,
+    _Inout_ sai_status_t *object_statuses,
+    _Out_ uint64_t *counters)
+{
+    return sairecord_forward(g_vendor.sai_bulk_object_get_stats,
+            switch_id, object_type, object_count, object_key, number_of_counters, counter_ids, mode, object_statuses, counters);
+}
+
+sai_status_t sai_dbg_generate_dump(
+    _In_ const char *dump_file_name)
+{
+    sai_status_t status = sairecord_forward(g_vendor.sai_dbg_generate_dump, dump_file_name);
+
+    sairecord_flush();
+
+    return status;
+}
+
+sai_status_t sai_get_maximum_attribute_count(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _Out_ uint32_t *count)
+{
+    return sairecord_forward(g_vendor.sai_get_maximum_attribute_count, switch_id, object_type, count);
+}
+
+sai_status_t sai_get_object_count(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _Out_ uint32_t *count)
+{
+    return sairecord_forward(g_vendor.sai_get_object_count, switch_id, object_type, count);
+}
+
+sai_status_t sai_get_object_key(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _Inout_ uint32_t *object_count,
+    _Inout_ sai_object_key_t *object_list)
+{
+    return sairecord_forward(g_vendor.sai_get_object_key, switch_id, object_type, object_count, object_list);
+}
+
+sai_status_t sai_log_set(
+    _In_ sai_api_t api,
+    _In_ sai_log_level_t log_level)
+{
+    return sairecord_forward(g_vendor.sai_log_set, api, log_level);
+}
+
+sai_status_t sai_object_type_get_availability(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t attr_count,
+    _In_ const sai_attribute_t *attr_list,
+    _Out_ uint64_t *count)
+{
+    return sairecord_forward(g_vendor.sai_object_type_get_availability, switch_id, object_type, attr_count, attr_list, count);
+}
+
+sai_object_type_t sai_object_type_query(
+    _In_ sai_object_id_t object_id)
+{
+    return sairecord_forward(g_vendor.sai_object_type_query, object_id);
+}
+
+sai_status_t sai_query_api_version(
+    _Out_ sai_api_version_t *version)
+{
+    return sairecord_forward(g_vendor.sai_query_api_version, version);
+}
+
+sai_status_t sai_query_attribute_capability(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ sai_attr_id_t attr_id,
+    _Out_ sai_attr_capability_t *attr_capability)
+{
+    return sairecord_forward(g_vendor.sai_query_attribute_capability, switch_id, object_type, attr_id, attr_capability);
+}
+
+sai_status_t sai_query_attribute_enum_values_capability(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ sai_attr_id_t attr_id,
+    _Inout_ sai_s32_list_t *enum_values_capability)
+{
+    return sairecord_forward(g_vendor.sai_query_attribute_enum_values_capability, switch_id, object_type, attr_id, enum_values_capability);
+}
+
+sai_status_t sai_query_object_stage(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t attr_count,
+    _In_ const sai_attribute_t *attr_list,
+    _Out_ sai_object_stage_t *stage)
+{
+    return sairecord_forward(g_vendor.sai_query_object_stage, switch_id, object_type, attr_count, attr_list, stage);
+}
+
+sai_status_t sai_query_stats_capability(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _Inout_ sai_stat_capability_list_t *stats_capability)
+{
+    return sairecord_forward(g_vendor.sai_query_stats_capability, switch_id, object_type, stats_capability);
+}
+
+sai_object_id_t sai_switch_id_query(
+    _In_ sai_object_id_t object_id)
+{
+    return sairecord_forward(g_vendor.sai_switch_id_query, object_id);
+}
+
+sai_status_t sai_tam_telemetry_get_data(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_list_t obj_list,
+    _In_ bool clear_on_read,
+    _Inout_ sai_size_t *buffer_size,
+    _Out_ void *buffer)
+{
+    return sairecord_forward(g_vendor.sai_tam_telemetry_get_data, switch_id, obj_list, clear_on_read, buffer_size, buffer);
+}
@@ -0,0 +1,739 @@
+/**
+ * Copyright (c) 2023 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    libsaitiming.cpp
+ *
+ * @brief   This module contains a timing libsai.so, wrapping a vendor libsai
+ *
+ * The vendor library named by SAI_TIMING_LIBRARY is loaded on first use,
+ * every global sai_* function is forwarded to it and every API table it
+ * returns from sai_api_query is replaced by a proxy table with the same
+ * layout. Each call is counted and timed per (api, member) - which is per
+ * (api, operation, object type) since every member is bound to exactly
+ * one of them - into counters owned by the calling thread, so nothing is
+ * shared between threads on the call path.
+ *
+ * Counters are written to SAI_TIMING_DUMP_FILE (default /tmp/saitiming.<pid>)
+ * when SAI_TIMING_SIGNAL (default SIGUSR2, 0 disables it) is received, and
+ * to <file>.timing after each sai_dbg_generate_dump(file).
+ */
+
+extern "C" {
+#include <sai.h>
+#include <saiextensions.h>
+}
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dlfcn.h>
+#include <semaphore.h>
+#include <unistd.h>
+
+#define SAITIMING_ENV_LIBRARY       "SAI_TIMING_LIBRARY"
+#define SAITIMING_ENV_DUMP_FILE     "SAI_TIMING_DUMP_FILE"
+#define SAITIMING_ENV_SIGNAL        "SAI_TIMING_SIGNAL"
+
+/*
+ * Latency histogram: bucket b counts calls which took less than 2^b ns
+ * and at least 2^(b-1) ns, the last bucket is open ended (>= 2^26 ns,
+ * about 67 ms).
+ */
+#define SAITIMING_BUCKETS           28
+
+/* Global sai_* functions, forwarded by name to the vendor library */
+#define SAITIMING_GLOBALS(X) \
+    X(sai_api_initialize) \
+    X(sai_api_query) \
+    X(sai_api_uninitialize) \
+    X(sai_bulk_get_attribute) \
+    X(sai_bulk_object_clear_stats) \
+    X(sai_bulk_object_get_stats) \
+    X(sai_dbg_generate_dump) \
+    X(sai_get_maximum_attribute_count) \
+    X(sai_get_object_count) \
+    X(sai_get_object_key) \
+    X(sai_log_set) \
+    X(sai_object_type_get_availability) \
+    X(sai_object_type_query) \
+    X(sai_query_api_version) \
+    X(sai_query_attribute_capability) \
+    X(sai_query_attribute_enum_values_capability) \
+    X(sai_query_object_stage) \
+    X(sai_query_stats_capability) \
+    X(sai_switch_id_query) \
+    X(sai_tam_telemetry_get_data)
+
+#define SAITIMING_GLOBAL_ID(name) SAITIMING_ID_ ## name,
+#define SAITIMING_GLOBAL_POINTER(name) decltype(&::name) name;
+
+typedef enum _saitiming_global_id_t
+{
+    SAITIMING_GLOBALS(SAITIMING_GLOBAL_ID)
+
+    SAITIMING_GLOBALS_COUNT
+
+} saitiming_global_id_t;
+
+typedef struct _saitiming_vendor_t
+{
+    SAITIMING_GLOBALS(SAITIMING_GLOBAL_POINTER)
+
+} saitiming_vendor_t;
+
+/*
+ * Counters of one timed entry point in one thread. Only the owning thread
+ * writes them, so updates are plain relaxed load/store pairs, the dump
+ * reads them with relaxed loads and may see a call half accounted.
+ */
+typedef struct _saitiming_counter_t
+{
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> total_ns;
+    std::atomic<uint64_t> max_ns;
+    std::atomic<uint64_t> buckets[SAITIMING_BUCKETS];
+
+} saitiming_counter_t;
+
+typedef struct _saitiming_name_t
+{
+    const char *api;
+    const char *member;
+    const char *op;
+    const char *object_type;
+
+} saitiming_name_t;
+
+static std::once_flag g_load_once;
+static void *g_library = NULL;
+static saitiming_vendor_t g_vendor;
+
+/*
+ * Names of all timed entry points, globals first, then every api member
+ * in libsaiapis.h order. Filled once by saitiming_load() before any call
+ * can be timed and never changed afterwards.
+ */
+static std::vector<saitiming_name_t> g_names;
+
+/* Proxy table to the vendor table pointer of the same api */
+static std::map<const void*, std::atomic<const void*>*> g_tables;
+
+/*
+ * Counter arrays of all threads which made at least one call. They are
+ * never freed, so calls made by threads which since exited still show up
+ * in the dumps.
+ */
+static std::mutex g_slots_mutex;
+static std::vector<saitiming_counter_t*> g_slots;
+
+static thread_local saitiming_counter_t *t_slot = NULL;
+
+static sem_t g_dump_sem;
+
+static saitiming_counter_t* saitiming_slot(void)
+{
+    if (t_slot == NULL)
+    {
+        t_slot = new saitiming_counter_t[g_names.size()]();
+
+        std::lock_guard<std::mutex> lock(g_slots_mutex);
+
+        g_slots.push_back(t_slot);
+    }
+
+    return t_slot;
+}
+
+static uint32_t saitiming_bucket(
+        _In_ uint64_t ns)
+{
+    uint32_t bucket = (ns == 0) ? 0 : (uint32_t)(64 - __builtin_clzll(ns));
+
+    return (bucket < SAITIMING_BUCKETS) ? bucket : SAITIMING_BUCKETS - 1;
+}
+
+static void saitiming_record(
+        _In_ size_t id,
+        _In_ std::chrono::steady_clock::time_point start)
+{
+    uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count();
+
+    saitiming_counter_t& counter = saitiming_slot()[id];
+
+    counter.calls.store(counter.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counter.total_ns.store(counter.total_ns.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+
+    if (ns > counter.max_ns.load(std::memory_order_relaxed))
+    {
+        counter.max_ns.store(ns, std::memory_order_relaxed);
+    }
+
+    std::atomic<uint64_t>& bucket = counter.buckets[saitiming_bucket(ns)];
+
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+static int saitiming_dump(
+        _In_ const char *file_name)
+{
+    FILE *f = fopen(file_name, "w");
+
+    if (f == NULL)
+    {
+        fprintf(stderr, "libsaitiming: failed to open %s: %s\n", file_name, strerror(errno));
+
+        return -1;
+    }
+
+    std::vector<saitiming_counter_t*> slots;
+
+    {
+        std::lock_guard<std::mutex> lock(g_slots_mutex);
+
+        slots = g_slots;
+    }
+
+    fprintf(f, "# api member op object_type calls total_ns avg_ns max_ns [bucket_ns:calls ...]\n");
+
+    for (size_t id = 0; id < g_names.size(); id++)
+    {
+        uint64_t calls = 0;
+        uint64_t total_ns = 0;
+        uint64_t max_ns = 0;
+        uint64_t buckets[SAITIMING_BUCKETS] = { 0 };
+
+        for (auto slot: slots)
+        {
+            const saitiming_counter_t& counter = slot[id];
+
+            calls += counter.calls.load(std::memory_order_relaxed);
+            total_ns += counter.total_ns.load(std::memory_order_relaxed);
+            max_ns = std::max(max_ns, counter.max_ns.load(std::memory_order_relaxed));
+
+            for (uint32_t b = 0; b < SAITIMING_BUCKETS; b++)
+            {
+                buckets[b] += counter.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+
+        if (calls == 0)
+        {
+            continue;
+        }
+
+        const saitiming_name_t& name = g_names[id];
+
+        fprintf(f, "%s %s %s %s %" PRIu64 " %" PRIu64 " %" PRIu64 " %" PRIu64,
+                name.api, name.member, name.op, name.object_type,
+                calls, total_ns, total_ns / calls, max_ns);
+
+        for (uint32_t b = 0; b < SAITIMING_BUCKETS; b++)
+        {
+            if (buckets[b] == 0)
+            {
+                continue;
+            }
+
+            if (b == SAITIMING_BUCKETS - 1)
+            {
+                fprintf(f, " inf:%" PRIu64, buckets[b]);
+            }
+            else
+            {
+                fprintf(f, " %" PRIu64 ":%" PRIu64, (uint64_t)1 << b, buckets[b]);
+            }
+        }
+
+        fprintf(f, "\n");
+    }
+
+    return fclose(f);
+}
+
+static void saitiming_signal_handler(
+        _In_ int signo)
+{
+    /* only sem_post is async signal safe here, the dump thread does the rest */
+
+    sem_post(&g_dump_sem);
+}
+
+static void saitiming_dump_thread(
+        _In_ std::string file_name)
+{
+    while (true)
+    {
+        if (sem_wait(&g_dump_sem) != 0)
+        {
+            continue;
+        }
+
+        saitiming_dump(file_name.c_str());
+    }
+}
+
+static void saitiming_start_dump_thread(void)
+{
+    const char *signal = getenv(SAITIMING_ENV_SIGNAL);
+
+    int signo = (signal == NULL) ? SIGUSR2 : atoi(signal);
+
+    if (signo <= 0)
+    {
+        return;
+    }
+
+    const char *file = getenv(SAITIMING_ENV_DUMP_FILE);
+
+    std::string file_name = (file != NULL) ? file : "/tmp/saitiming." + std::to_string(getpid());
+
+    if (sem_init(&g_dump_sem, 0, 0) != 0)
+    {
+        fprintf(stderr, "libsaitiming: sem_init failed: %s\n", strerror(errno));
+
+        return;
+    }
+
+    std::thread(saitiming_dump_thread, file_name).detach();
+
+    struct sigaction sa;
+
+    memset(&sa, 0, sizeof(sa));
+
+    sa.sa_handler = saitiming_signal_handler;
+    sa.sa_flags = SA_RESTART;
+
+    sigemptyset(&sa.sa_mask);
+
+    if (sigaction(signo, &sa, NULL) != 0)
+    {
+        fprintf(stderr, "libsaitiming: sigaction %d failed: %s\n", signo, strerror(errno));
+    }
+}
+
+static size_t saitiming_register(
+        _In_ const char *api,
+        _In_ const char *member,
+        _In_ const char *op,
+        _In_ const char *object_type)
+{
+    saitiming_name_t name = { api, member, op, object_type };
+
+    g_names.push_back(name);
+
+    return g_names.size() - 1;
+}
+
+/*
+ * Vendor table of one api struct type, set by sai_api_query. Two apis
+ * never share a struct type, so there is one per api.
+ */
+template <typename Api>
+class saitiming_table
+{
+    public:
+
+        static std::atomic<const void*> vendor;
+};
+
+template <typename Api>
+std::atomic<const void*> saitiming_table<Api>::vendor(NULL);
+
+template <typename Api, typename F, F Api::*Member>
+class saitiming_method;
+
+template <typename Api, typename... Args, sai_status_t (*Api::*Member)(Args...)>
+class saitiming_method<Api, sai_status_t (*)(Args...), Member>
+{
+    public:
+
+        static size_t id;
+
+        static sai_status_t call(Args... args)
+        {
+            const Api *vendor = static_cast<const Api*>(saitiming_table<Api>::vendor.load(std::memory_order_acquire));
+
+            if (vendor == NULL || vendor->*Member == NULL)
+            {
+                return SAI_STATUS_NOT_IMPLEMENTED;
+            }
+
+            auto start = std::chrono::steady_clock::now();
+
+            sai_status_t status = (vendor->*Member)(args...);
+
+            saitiming_record(id, start);
+
+            return status;
+        }
+};
+
+template <typename Api, typename... Args, sai_status_t (*Api::*Member)(Args...)>
+size_t saitiming_method<Api, sai_status_t (*)(Args...), Member>::id = 0;
+
+template <typename Api, typename F, F Api::*Member>
+static F saitiming_bind(
+        _In_ Api *proxy,
+        _In_ const char *api,
+        _In_ const char *member,
+        _In_ const char *op,
+        _In_ const char *object_type)
+{
+    saitiming_method<Api, F, Member>::id = saitiming_register(api, member, op, object_type);
+
+    g_tables[proxy] = &saitiming_table<Api>::vendor;
+
+    return saitiming_method<Api, F, Member>::call;
+}
+
+#define LIBSAI_METHOD(api, member, op, ot) \
+    libsai_ ## api ## _api.member = saitiming_bind<sai_ ## api ## _api_t, decltype(libsai_ ## api ## _api.member), &sai_ ## api ## _api_t::member>( \
+            &libsai_ ## api ## _api, #api, #member, #op, #ot)
+
+#define LIBSAI_STUB(api, member) \
+    libsai_ ## api ## _api.member = saitiming_bind<sai_ ## api ## _api_t, decltype(libsai_ ## api ## _api.member), &sai_ ## api ## _api_t::member>( \
+            &libsai_ ## api ## _api, #api, #member, "-", "-")
+
+#include "libsaiapis.h"
+
+/*
+ * Load the vendor library and bind all proxy tables, once. RTLD_DEEPBIND
+ * keeps the vendor calls to its own sai_* functions inside the vendor
+ * library instead of resolving them back to the wrappers below.
+ */
+static void saitiming_load(void)
+{
+#define SAITIMING_GLOBAL_REGISTER(name) saitiming_register("sai", #name, "-", "-");
+
+    SAITIMING_GLOBALS(SAITIMING_GLOBAL_REGISTER)
+
+    libsai_apis_init();
+
+    const char *library = getenv(SAITIMING_ENV_LIBRARY);
+
+    if (library == NULL)
+    {
+        fprintf(stderr, "libsaitiming: %s is not set, all calls will return SAI_STATUS_NOT_IMPLEMENTED\n", SAITIMING_ENV_LIBRARY);
+
+        return;
+    }
+
+    g_library = dlopen(library, RTLD_NOW | RTLD_LOCAL | RTLD_DEEPBIND);
+
+    if (g_library == NULL)
+    {
+        fprintf(stderr, "libsaitiming: failed to load %s: %s\n", library, dlerror());
+
+        return;
+    }
+
+#define SAITIMING_GLOBAL_RESOLVE(name) g_vendor.name = reinterpret_cast<decltype(g_vendor.name)>(dlsym(g_library, #name));
+
+    SAITIMING_GLOBALS(SAITIMING_GLOBAL_RESOLVE)
+
+    sai_api_version_t version = 0;
+
+    if (g_vendor.sai_query_api_version != NULL &&
+            g_vendor.sai_query_api_version(&version) == SAI_STATUS_SUCCESS &&
+            version != SAI_API_VERSION)
+    {
+        fprintf(stderr, "libsaitiming: %s was built for SAI API version %" PRIu64 ", not %" PRIu64 "\n",
+                library, version, (uint64_t)SAI_API_VERSION);
+    }
+
+    saitiming_start_dump_thread();
+}
+
+template <typename R>
+class saitiming_missing
+{
+    public:
+
+        static R value()
+        {
+            return R();
+        }
+};
+
+template <>
+class saitiming_missing<sai_status_t>
+{
+    public:
+
+        static sai_status_t value()
+        {
+            return SAI_STATUS_NOT_IMPLEMENTED;
+        }
+};
+
+/*
+ * fn is taken by reference since the vendor pointers are only resolved by
+ * the first call, inside this function.
+ */
+template <typename R, typename... Args, typename... Params>
+static R saitiming_forward(
+        _In_ size_t id,
+        _In_ R (*const& fn)(Args...),
+        _In_ Params... params)
+{
+    std::call_once(g_load_once, saitiming_load);
+
+    if (fn == NULL)
+    {
+        return saitiming_missing<R>::value();
+    }
+
+    auto start = std::chrono::steady_clock::now();
+
+    R result = fn(params...);
+
+    saitiming_record(id, start);
+
+    return result;
+}
+
+sai_status_t sai_api_initialize(
+    _In_ uint64_t flags,
+    _In_ const sai_service_method_table_t *services)
+{
+    return saitiming_forward(SAITIMING_ID_sai_api_initialize, g_vendor.sai_api_initialize, flags, services);
+}
+
+sai_status_t sai_api_query(
+    _In_ sai_api_t api,
+    _Out_ void **api_method_table)
+{
+    sai_status_t status = saitiming_forward(SAITIMING_ID_sai_api_query, g_vendor.sai_api_query, api, api_method_table);
+
+    if (status != SAI_STATUS_SUCCESS || api_method_table == NULL)
+    {
+        return status;
+    }
+
+    void *proxy = libsai_api_table(api);
+
+    auto it = g_tables.find(proxy);
+
+    if (it == g_tables.end())
+    {
+        /* api unknown to this build, hand out the vendor table untimed */
+
+        return status;
+    }
+
+    it->second->store(*api_method_table, std::memory_order_release);
+
+    *api_method_table = proxy;
+
+    return status;
+}
+
+sai_status_t sai_api_uninitialize(void)
+{
+    return saitiming_forward(SAITIMING_ID_sai_api_uninitialize, g_vendor.sai_api_uninitialize);
+}
+
+sai_status_t sai_bulk_get_attribute(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t object_count,
+    _In_ const sai_object_key_t *object_key,
+    _Inout_ uint32_t *attr_count,
+    _Inout_ sai_attribute_t **attr_list,
+    _Inout_ sai_status_t *object_statuses)
+{
+    return saitiming_forward(SAITIMING_ID_sai_bulk_get_attribute, g_vendor.sai_bulk_get_attribute,
+            switch_id, object_type, object_count, object_key, attr_count, attr_list, object_statuses);
+}
+
+sai_status_t sai_bulk_object_clear_stats(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t object_count,
+    _In_ const sai_object_key_t *object_key,
+    _In_ uint32_t number_of_counters,
+    _In_ const sai_stat_id_t *counter_ids,
+    _In_ sai_stats_mode_t mode,
+    _Inout_ sai_status_t *object_statuses)
+{
+    return saitiming_forward(SAITIMING_ID_sai_bulk_object_clear_stats, g_vendor.sai_bulk_object_clear_stats,
+            switch_id, object_type, object_count, object_key, number_of_counters, counter_ids, mode, object_statuses);
+}
+
+sai_status_t sai_bulk_object_get_stats(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t object_count,
+    _In_ const sai_object_key_t *object_key,
+    _In_ uint32_t number_of_counters,
+    _In_ const sai_stat_id_t *counter_ids,
+    _In_ sai_stats_mode_t mode,
+    _Inout_ sai_status_t *object_statuses,
+    _Out_ uint64_t *counters)
+{
+    return saitiming_forward(SAITIMING_ID_sai_bulk_object_get_stats, g_vendor.sai_bulk_object_get_stats,
+            switch_id, object_type, object_count, object_key, number_of_counters, counter_ids, mode, object_statuses, counters);
+}
+
+sai_status_t sai_dbg_generate_dump(
+    _In_ const char *dump_file_name)
+{
+    sai_status_t status = saitiming_forward(SAITIMING_ID_sai_dbg_generate_dump, g_vendor.sai_dbg_generate_dump, dump_file_name);
+
+    if (dump_file_name == NULL)
+    {
+        return status;
+    }
+
+    std::string timing_file_name = std::string(dump_file_name) + ".timing";
+
+    if (saitiming_dump(timing_file_name.c_str()) != 0 && status == SAI_STATUS_SUCCESS)
+    {
+        return SAI_STATUS_FAILURE;
+    }
+
+    return status;
+}
+
+sai_status_t sai_get_maximum_attribute_count(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _Out_ uint32_t *count)
+{
+    return saitiming_forward(SAITIMING_ID_sai_get_maximum_attribute_count, g_vendor.sai_get_maximum_attribute_count,
+            switch_id, object_type, count);
+}
+
+sai_status_t sai_get_object_count(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _Out_ uint32_t *count)
+{
+    return saitiming_forward(SAITIMING_ID_sai_get_object_count, g_vendor.sai_get_object_count,
+            switch_id, object_type, count);
+}
+
+sai_status_t sai_get_object_key(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _Inout_ uint32_t *object_count,
+    _Inout_ sai_object_key_t *object_list)
+{
+    return saitiming_forward(SAITIMING_ID_sai_get_object_key, g_vendor.sai_get_object_key,
+            switch_id, object_type, object_count, object_list);
+}
+
+sai_status_t sai_log_set(
+    _In_ sai_api_t api,
+    _In_ sai_log_level_t log_level)
+{
+    return saitiming_forward(SAITIMING_ID_sai_log_set, g_vendor.sai_log_set, api, log_level);
+}
+
+sai_status_t sai_object_type_get_availability(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t attr_count,
+    _In_ const sai_attribute_t *attr_list,
+    _Out_ uint64_t *count)
+{
+    return saitiming_forward(SAITIMING_ID_sai_object_type_get_availability, g_vendor.sai_object_type_get_availability,
+            switch_id, object_type, attr_count, attr_list, count);
+}
+
+sai_object_type_t sai_object_type_query(
+    _In_ sai_object_id_t object_id)
+{
+    return saitiming_forward(SAITIMING_ID_sai_object_type_query, g_vendor.sai_object_type_query, object_id);
+}
+
+sai_status_t sai_query_api_version(
+    _Out_ sai_api_version_t *version)
+{
+    return saitiming_forward(SAITIMING_ID_sai_query_api_version, g_vendor.sai_query_api_version, version);
+}
+
+sai_status_t sai_query_attribute_capability(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ sai_attr_id_t attr_id,
+    _Out_ sai_attr_capability_t *attr_capability)
+{
+    return saitiming_forward(SAITIMING_ID_sai_query_attribute_capability, g_vendor.sai_query_attribute_capability,
+            switch_id, object_type, attr_id, attr_capability);
+}
+
+sai_status_t sai_query_attribute_enum_values_capability(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ sai_attr_id_t attr_id,
+    _Inout_ sai_s32_list_t *enum_values_capability)
+{
+    return saitiming_forward(SAITIMING_ID_sai_query_attribute_enum_values_capability, g_vendor.sai_query_attribute_enum_values_capability,
+            switch_id, object_type, attr_id, enum_values_capability);
+}
+
+sai_status_t sai_query_object_stage(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _In_ uint32_t attr_count,
+    _In_ const sai_attribute_t *attr_list,
+    _Out_ sai_object_stage_t *stage)
+{
+    return saitiming_forward(SAITIMING_ID_sai_query_object_stage, g_vendor.sai_query_object_stage,
+            switch_id, object_type, attr_count, attr_list, stage);
+}
+
+sai_status_t sai_query_stats_capability(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_type_t object_type,
+    _Inout_ sai_stat_capability_list_t *stats_capability)
+{
+    return saitiming_forward(SAITIMING_ID_sai_query_stats_capability, g_vendor.sai_query_stats_capability,
+            switch_id, object_type, stats_capability);
+}
+
+sai_object_id_t sai_switch_id_query(
+    _In_ sai_object_id_t object_id)
+{
+    return saitiming_forward(SAITIMING_ID_sai_switch_id_query, g_vendor.sai_switch_id_query, object_id);
+}
+
+sai_status_t sai_tam_telemetry_get_data(
+    _In_ sai_object_id_t switch_id,
+    _In_ sai_object_list_t obj_list,
+    _In_ bool clear_on_read,
+    _Inout_ sai_size_t *buffer_size,
+    _Out_ void *buffer)
+{
+    return saitiming_forward(SAITIMING_ID_sai_tam_telemetry_get_data, g_vendor.sai_tam_telemetry_get_data,
+            switch_id, obj_list, clear_on_read, buffer_size, buffer);
+}
@@ -31,10 +31,460 @@ extern "C" {
 }
 
 #include <iostream>
+#include <chrono>
 #include <cstring>
+#include <cstdlib>
+#include <cstddef>
+#include <map>
+#include <mutex>
+#include <new>
+#include <string>
+#include <vector>
 
 using namespace ::sai;
 
+/**
+ * @brief Bump allocator backing all SAI side buffers of a single RPC call
+ *
+ * Attribute arrays, counter arrays and list values converted from Thrift
+ * are carved out of this arena instead of being malloc'ed one by one. The
+ * arena is reset when the RPC handler returns (or throws), and its blocks
+ * are kept for the next call, so in steady state no heap allocation is
+ * done for SAI buffers at all.
+ */
+class sai_thrift_arena
+{
+    public:
+
+        sai_thrift_arena():
+            m_current(0),
+            m_offset(0)
+        {
+        }
+
+        ~sai_thrift_arena()
+        {
+            for (auto &block: m_blocks)
+            {
+                free(block.data);
+            }
+        }
+
+        void *alloc(size_t size)
+        {
+            if (size == 0)
+            {
+                return NULL;
+            }
+
+            size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+
+            while (m_current < m_blocks.size())
+            {
+                block_t &block = m_blocks[m_current];
+
+                if (m_offset + size <= block.size)
+                {
+                    void *ptr = block.data + m_offset;
+                    m_offset += size;
+                    return ptr;
+                }
+
+                m_current++;
+                m_offset = 0;
+            }
+
+            block_t block;
+            block.size = BLOCK_SIZE;
+
+            if (size > block.size)
+            {
+                block.size = size;
+            }
+
+            block.data = static_cast<char *>(malloc(block.size));
+
+            if (block.data == NULL)
+            {
+                throw std::bad_alloc();
+            }
+
+            m_blocks.push_back(block);
+
+            m_current = m_blocks.size() - 1;
+            m_offset = size;
+
+            return block.data;
+        }
+
+        void reset()
+        {
+            if (m_blocks.size() > 1)
+            {
+                // coalesce, so the next call of the same size fits in one block
+
+                size_t total = 0;
+
+                for (auto &block: m_blocks)
+                {
+                    total += block.size;
+                    free(block.data);
+                }
+
+                m_blocks.clear();
+
+                block_t block;
+                block.size = total;
+                block.data = static_cast<char *>(malloc(total));
+
+                if (block.data != NULL)
+                {
+                    m_blocks.push_back(block);
+                }
+            }
+
+            m_current = 0;
+            m_offset = 0;
+        }
+
+    private:
+
+        static const size_t ALIGNMENT = alignof(std::max_align_t);
+
+        static const size_t BLOCK_SIZE = 64 * 1024;
+
+        struct block_t
+        {
+            char *data;
+            size_t size;
+        };
+
+        std::vector<block_t> m_blocks;
+
+        size_t m_current;
+
+        size_t m_offset;
+};
+
+static thread_local sai_thrift_arena sai_thrift_rpc_arena;
+
+/**
+ * @brief Allocate an array of count elements from the current RPC arena
+ */
+template <typename T>
+static T *sai_thrift_alloc(size_t count)
+{
+    return static_cast<T *>(sai_thrift_rpc_arena.alloc(sizeof(T) * count));
+}
+
+/**
+ * @brief Releases everything allocated from the RPC arena on scope exit
+ */
+class sai_thrift_arena_scope
+{
+    public:
+
+        sai_thrift_arena_scope() = default;
+
+        ~sai_thrift_arena_scope()
+        {
+            sai_thrift_rpc_arena.reset();
+        }
+
+        sai_thrift_arena_scope(const sai_thrift_arena_scope &) = delete;
+
+        sai_thrift_arena_scope &operator=(const sai_thrift_arena_scope &) = delete;
+};
+
+/**
+ * @brief Log-linear (HDR-style) latency histogram in nanoseconds
+ *
+ * Values below 32 ns get a bucket each, above that every power of two is
+ * split into 16 buckets, so a recorded value is never more than 1/16 above
+ * the lower bound of its bucket.
+ */
+class sai_thrift_latency_histogram
+{
+    public:
+
+        sai_thrift_latency_histogram()
+        {
+            clear();
+        }
+
+        void clear()
+        {
+            memset(m_buckets, 0, sizeof(m_buckets));
+
+            m_count = 0;
+            m_sum = 0;
+            m_min = UINT64_MAX;
+            m_max = 0;
+        }
+
+        void record(uint64_t ns)
+        {
+            m_buckets[bucket_index(ns)]++;
+
+            m_count++;
+            m_sum += ns;
+
+            if (ns < m_min)
+            {
+                m_min = ns;
+            }
+
+            if (ns > m_max)
+            {
+                m_max = ns;
+            }
+        }
+
+        void to_thrift(sai_thrift_latency_histogram_t &thrift_histogram) const
+        {
+            thrift_histogram.count = m_count;
+            thrift_histogram.sum_ns = m_sum;
+            thrift_histogram.min_ns = m_count ? m_min : 0;
+            thrift_histogram.max_ns = m_max;
+            thrift_histogram.p50_ns = percentile(0.50);
+            thrift_histogram.p90_ns = percentile(0.90);
+            thrift_histogram.p99_ns = percentile(0.99);
+
+            for (int i = 0; i < BUCKET_COUNT; i++)
+            {
+                if (m_buckets[i])
+                {
+                    thrift_histogram.buckets[bucket_lower_bound(i)] = m_buckets[i];
+                }
+            }
+        }
+
+    private:
+
+        static const int SUB_BUCKET_BITS = 4;
+
+        static const int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+
+        static const int LINEAR_COUNT = 2 * SUB_BUCKET_COUNT;
+
+        static const int BUCKET_COUNT = LINEAR_COUNT + (63 - SUB_BUCKET_BITS) * SUB_BUCKET_COUNT;
+
+        static int bucket_index(uint64_t value)
+        {
+            if (value < LINEAR_COUNT)
+            {
+                return (int)value;
+            }
+
+            int msb = 63 - __builtin_clzll(value);
+
+            return LINEAR_COUNT + (msb - SUB_BUCKET_BITS - 1) * SUB_BUCKET_COUNT +
+                (int)((value >> (msb - SUB_BUCKET_BITS)) - SUB_BUCKET_COUNT);
+        }
+
+        static uint64_t bucket_lower_bound(int index)
+        {
+            if (index < LINEAR_COUNT)
+            {
+                return (uint64_t)index;
+            }
+
+            index -= LINEAR_COUNT;
+
+            int msb = index / SUB_BUCKET_COUNT + SUB_BUCKET_BITS + 1;
+
+            return (uint64_t)(SUB_BUCKET_COUNT + index % SUB_BUCKET_COUNT) << (msb - SUB_BUCKET_BITS);
+        }
+
+        uint64_t percentile(double p) const
+        {
+            uint64_t target = (uint64_t)(p * (double)m_count);
+            uint64_t seen = 0;
+
+            for (int i = 0; i < BUCKET_COUNT; i++)
+            {
+                seen += m_buckets[i];
+
+                if (seen > target)
+                {
+                    uint64_t value = bucket_lower_bound(i);
+
+                    // the bucket bound may lie outside the observed range
+
+                    if (value < m_min)
+                    {
+                        value = m_min;
+                    }
+
+                    if (value > m_max)
+                    {
+                        value = m_max;
+                    }
+
+                    return value;
+                }
+            }
+
+            return m_max;
+        }
+
+        uint64_t m_buckets[BUCKET_COUNT];
+
+        uint64_t m_count;
+
+        uint64_t m_sum;
+
+        uint64_t m_min;
+
+        uint64_t m_max;
+};
+
+/**
+ * @brief Per RPC method call counters and latency histograms
+ *
+ * Collected only when the server is started with SAI_THRIFT_RPC_STATS set
+ * in the environment. Latency of every call is split into time spent in
+ * SAI and time spent in the Thrift shim (deserialization, conversion and
+ * serialization of the reply).
+ */
+class sai_thrift_rpc_stats
+{
+    public:
+
+        static bool enabled()
+        {
+            static const bool is_enabled = getenv("SAI_THRIFT_RPC_STATS") != NULL;
+
+            return is_enabled;
+        }
+
+        void record(
+                const std::string &method,
+                uint64_t total_ns,
+                uint64_t sai_ns,
+                bool error)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            method_stats_t &stats = m_methods[method];
+
+            stats.calls++;
+
+            if (error)
+            {
+                stats.errors++;
+            }
+
+            stats.total.record(total_ns);
+            stats.sai.record(sai_ns);
+            stats.conversion.record(total_ns > sai_ns ? total_ns - sai_ns : 0);
+        }
+
+        void get(
+                std::vector<sai_thrift_rpc_stats_t> &thrift_stats,
+                bool clear)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            for (auto &kvp: m_methods)
+            {
+                sai_thrift_rpc_stats_t thrift_method_stats;
+
+                thrift_method_stats.method = kvp.first;
+                thrift_method_stats.calls = kvp.second.calls;
+                thrift_method_stats.errors = kvp.second.errors;
+
+                kvp.second.total.to_thrift(thrift_method_stats.total);
+                kvp.second.sai.to_thrift(thrift_method_stats.sai);
+                kvp.second.conversion.to_thrift(thrift_method_stats.conversion);
+
+                thrift_stats.push_back(thrift_method_stats);
+            }
+
+            if (clear)
+            {
+                m_methods.clear();
+            }
+        }
+
+    private:
+
+        struct method_stats_t
+        {
+            method_stats_t():
+                calls(0),
+                errors(0)
+            {
+            }
+
+            uint64_t calls;
+
+            uint64_t errors;
+
+            sai_thrift_latency_histogram total;
+
+            sai_thrift_latency_histogram sai;
+
+            sai_thrift_latency_histogram conversion;
+        };
+
+        std::mutex m_mutex;
+
+        std::map<std::string, method_stats_t> m_methods;
+};
+
+static sai_thrift_rpc_stats sai_thrift_rpc_stats_registry;
+
+/**
+ * @brief Timing state of the RPC currently served by this thread
+ */
+struct sai_thrift_rpc_call_t
+{
+    uint64_t start_ns;
+
+    uint64_t sai_start_ns;
+
+    uint64_t sai_ns;
+
+    bool error;
+};
+
+static thread_local sai_thrift_rpc_call_t sai_thrift_rpc_call;
+
+static uint64_t sai_thrift_now_ns()
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * @brief Mark the start of a SAI call made on behalf of the current RPC
+ */
+static void sai_thrift_sai_call_begin()
+{
+    if (sai_thrift_rpc_stats::enabled())
+    {
+        sai_thrift_rpc_call.sai_start_ns = sai_thrift_now_ns();
+    }
+}
+
+/**
+ * @brief Account the SAI call started by sai_thrift_sai_call_begin()
+ */
+static void sai_thrift_sai_call_end(
+        sai_status_t status)
+{
+    if (sai_thrift_rpc_stats::enabled())
+    {
+        sai_thrift_rpc_call.sai_ns += sai_thrift_now_ns() - sai_thrift_rpc_call.sai_start_ns;
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            sai_thrift_rpc_call.error = true;
+        }
+    }
+}
+
 /**
  * @brief Convert Thrift MAC format to SAI MAC format
  */
@@ -221,7 +671,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
             {
-                attr->value.objlist.list = (sai_object_id_t *)malloc(sizeof(sai_object_id_t) * thrift_attr.value.objlist.count);
+                attr->value.objlist.list = sai_thrift_alloc<sai_object_id_t>(thrift_attr.value.objlist.count);
                 int i = 0;
                 for (auto obj : thrift_attr.value.objlist.idlist)
                 {
@@ -232,7 +682,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_UINT8_LIST:
             {
-                attr->value.u8list.list = (uint8_t *)malloc(sizeof(uint8_t) * thrift_attr.value.u8list.count);
+                attr->value.u8list.list = sai_thrift_alloc<uint8_t>(thrift_attr.value.u8list.count);
                 int i = 0;
                 for (auto u8 : thrift_attr.value.u8list.uint8list)
                 {
@@ -243,7 +693,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_INT8_LIST:
             {
-                attr->value.s8list.list = (int8_t *)malloc(sizeof(int8_t) * thrift_attr.value.s8list.count);
+                attr->value.s8list.list = sai_thrift_alloc<int8_t>(thrift_attr.value.s8list.count);
                 int i = 0;
                 for (auto s8 : thrift_attr.value.s8list.int8list)
                 {
@@ -254,7 +704,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_UINT16_LIST:
             {
-                attr->value.u16list.list = (uint16_t *)malloc(sizeof(uint16_t) * thrift_attr.value.u16list.count);
+                attr->value.u16list.list = sai_thrift_alloc<uint16_t>(thrift_attr.value.u16list.count);
                 int i = 0;
                 for (auto u16 : thrift_attr.value.u16list.uint16list)
                 {
@@ -265,7 +715,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_INT16_LIST:
             {
-                attr->value.s16list.list = (int16_t *)malloc(sizeof(int16_t) * thrift_attr.value.s16list.count);
+                attr->value.s16list.list = sai_thrift_alloc<int16_t>(thrift_attr.value.s16list.count);
                 int i = 0;
                 for (auto s16 : thrift_attr.value.s16list.int16list)
                 {
@@ -276,7 +726,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_UINT32_LIST:
             {
-                attr->value.u32list.list = (uint32_t *)malloc(sizeof(uint32_t) * thrift_attr.value.u32list.count);
+                attr->value.u32list.list = sai_thrift_alloc<uint32_t>(thrift_attr.value.u32list.count);
                 int i = 0;
                 for (auto u32 : thrift_attr.value.u32list.uint32list)
                 {
@@ -287,7 +737,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_INT32_LIST:
             {
-                attr->value.s32list.list = (int32_t *)malloc(sizeof(int32_t) * thrift_attr.value.s32list.count);
+                attr->value.s32list.list = sai_thrift_alloc<int32_t>(thrift_attr.value.s32list.count);
                 int i = 0;
                 for (auto s32 : thrift_attr.value.s32list.int32list)
                 {
@@ -306,7 +756,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_UINT16_RANGE_LIST:
             {
-                attr->value.u16rangelist.list = (sai_u16_range_t *)malloc(sizeof(sai_u16_range_t) * thrift_attr.value.u16rangelist.count);
+                attr->value.u16rangelist.list = sai_thrift_alloc<sai_u16_range_t>(thrift_attr.value.u16rangelist.count);
                 int i = 0;
                 for (auto range : thrift_attr.value.u16rangelist.rangelist)
                 {
@@ -373,7 +823,7 @@ void convert_attr_thrift_to_sai(
             {
                 int i = 0;
                 attr->value.aclfield.enable = thrift_attr.value.aclfield.enable;
-                attr->value.aclfield.data.objlist.list = (sai_object_id_t *)malloc(sizeof(sai_object_id_t) * thrift_attr.value.aclfield.data.objlist.count);
+                attr->value.aclfield.data.objlist.list = sai_thrift_alloc<sai_object_id_t>(thrift_attr.value.aclfield.data.objlist.count);
                 for (auto obj : thrift_attr.value.aclfield.data.objlist.idlist)
                 {
                     attr->value.aclfield.data.objlist.list[i++] = obj;
@@ -385,14 +835,14 @@ void convert_attr_thrift_to_sai(
             {
                 int i = 0;
                 attr->value.aclfield.enable = thrift_attr.value.aclfield.enable;
-                attr->value.aclfield.data.u8list.list = (uint8_t *)malloc(sizeof(uint8_t) * thrift_attr.value.aclfield.data.u8list.count);
+                attr->value.aclfield.data.u8list.list = sai_thrift_alloc<uint8_t>(thrift_attr.value.aclfield.data.u8list.count);
                 for (auto obj : thrift_attr.value.aclfield.data.u8list.uint8list)
                 {
                     attr->value.aclfield.data.u8list.list[i++] = obj;
                 }
                 attr->value.aclfield.data.u8list.count = thrift_attr.value.aclfield.data.u8list.count;
                 i = 0;
-                attr->value.aclfield.mask.u8list.list = (uint8_t *)malloc(sizeof(uint8_t) * thrift_attr.value.aclfield.mask.u8list.count);
+                attr->value.aclfield.mask.u8list.list = sai_thrift_alloc<uint8_t>(thrift_attr.value.aclfield.mask.u8list.count);
                 for (auto obj : thrift_attr.value.aclfield.mask.u8list.uint8list)
                 {
                     attr->value.aclfield.mask.u8list.list[i++] = obj;
@@ -452,7 +902,7 @@ void convert_attr_thrift_to_sai(
             {
                 int i = 0;
                 attr->value.aclaction.enable = thrift_attr.value.aclaction.enable;
-                attr->value.aclaction.parameter.objlist.list = (sai_object_id_t*)malloc(sizeof(sai_object_id_t) * thrift_attr.value.aclaction.parameter.objlist.count);
+                attr->value.aclaction.parameter.objlist.list = sai_thrift_alloc<sai_object_id_t>(thrift_attr.value.aclaction.parameter.objlist.count);
                 for (auto obj : thrift_attr.value.aclaction.parameter.objlist.idlist)
                 {
                     attr->value.aclaction.parameter.objlist.list[i++] = obj;
@@ -464,7 +914,7 @@ void convert_attr_thrift_to_sai(
         case SAI_ATTR_VALUE_TYPE_ACL_CAPABILITY:
             {
                 attr->value.aclcapability.is_action_list_mandatory = thrift_attr.value.aclcapability.is_action_list_mandatory;
-                attr->value.aclcapability.action_list.list = (int32_t *)malloc(sizeof(int32_t) * thrift_attr.value.aclcapability.action_list.count);
+                attr->value.aclcapability.action_list.list = sai_thrift_alloc<int32_t>(thrift_attr.value.aclcapability.action_list.count);
                 int i = 0;
                 for (auto s32 : thrift_attr.value.aclcapability.action_list.int32list)
                 {
@@ -475,7 +925,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_ACL_RESOURCE_LIST:
             {
-                attr->value.aclresource.list = (sai_acl_resource_t *)malloc(sizeof(sai_acl_resource_t) * thrift_attr.value.aclresource.count);
+                attr->value.aclresource.list = sai_thrift_alloc<sai_acl_resource_t>(thrift_attr.value.aclresource.count);
                 int i = 0;
                 for (auto resource : thrift_attr.value.aclresource.resourcelist)
                 {
@@ -488,7 +938,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_IP_ADDRESS_LIST:
             {
-                attr->value.ipaddrlist.list = (sai_ip_address_t *)malloc(sizeof(sai_ip_address_t) * thrift_attr.value.ipaddrlist.count);
+                attr->value.ipaddrlist.list = sai_thrift_alloc<sai_ip_address_t>(thrift_attr.value.ipaddrlist.count);
                 int i = 0;
                 for (auto address : thrift_attr.value.ipaddrlist.addresslist)
                 {
@@ -499,7 +949,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_IP_PREFIX_LIST:
             {
-                attr->value.ipprefixlist.list = (sai_ip_prefix_t *)malloc(sizeof(sai_ip_prefix_t) * thrift_attr.value.ipprefixlist.count);
+                attr->value.ipprefixlist.list = sai_thrift_alloc<sai_ip_prefix_t>(thrift_attr.value.ipprefixlist.count);
                 int i = 0;
                 for (auto address : thrift_attr.value.ipprefixlist.prefixlist)
                 {
@@ -510,7 +960,7 @@ void convert_attr_thrift_to_sai(
             break;
         case SAI_ATTR_VALUE_TYPE_QOS_MAP_LIST:
             {
-                attr->value.qosmap.list = (sai_qos_map_t *)malloc(sizeof(sai_qos_map_t) * thrift_attr.value.qosmap.count);
+                attr->value.qosmap.list = sai_thrift_alloc<sai_qos_map_t>(thrift_attr.value.qosmap.count);
                 int i = 0;
                 for (auto qosmap : thrift_attr.value.qosmap.maplist)
                 {
@@ -691,7 +1141,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.objlist.idlist.push_back(attr.value.objlist.list[i]);
                 }
                 thrift_attr.value.objlist.count = attr.value.objlist.count;
-                free(attr.value.objlist.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_UINT8_LIST:
@@ -701,7 +1150,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.u8list.uint8list.push_back(attr.value.u8list.list[i]);
                 }
                 thrift_attr.value.u8list.count = attr.value.u8list.count;
-                free(attr.value.u8list.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_INT8_LIST:
@@ -711,7 +1159,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.s8list.int8list.push_back(attr.value.s8list.list[i]);
                 }
                 thrift_attr.value.s8list.count = attr.value.s8list.count;
-                free(attr.value.s8list.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_UINT16_LIST:
@@ -721,7 +1168,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.u16list.uint16list.push_back(attr.value.u16list.list[i]);
                 }
                 thrift_attr.value.u16list.count = attr.value.u16list.count;
-                free(attr.value.u16list.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_INT16_LIST:
@@ -731,7 +1177,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.s16list.int16list.push_back(attr.value.s16list.list[i]);
                 }
                 thrift_attr.value.s16list.count = attr.value.s16list.count;
-                free(attr.value.s16list.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_UINT32_LIST:
@@ -741,7 +1186,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.u32list.uint32list.push_back(attr.value.u32list.list[i]);
                 }
                 thrift_attr.value.u32list.count = attr.value.u32list.count;
-                free(attr.value.u32list.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_INT32_LIST:
@@ -751,7 +1195,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.s32list.int32list.push_back(attr.value.s32list.list[i]);
                 }
                 thrift_attr.value.s32list.count = attr.value.s32list.count;
-                free(attr.value.s32list.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_UINT32_RANGE:
@@ -772,7 +1215,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.u16rangelist.rangelist.push_back(range);
                 }
                 thrift_attr.value.u16rangelist.count = attr.value.u16rangelist.count;
-                free(attr.value.u16rangelist.list);
             }
             break;
 
@@ -783,7 +1225,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.aclcapability.action_list.int32list.push_back(attr.value.aclcapability.action_list.list[i]);
                 }
                 thrift_attr.value.aclcapability.action_list.count = attr.value.aclcapability.action_list.count;
-                free(attr.value.aclcapability.action_list.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_ACL_RESOURCE_LIST:
@@ -797,7 +1238,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.aclresource.resourcelist.push_back(resource);
                 }
                 thrift_attr.value.aclresource.count = attr.value.aclresource.count;
-                free(attr.value.aclresource.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_IP_ADDRESS_LIST:
@@ -809,7 +1249,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.ipaddrlist.addresslist.push_back(thrift_ip);
                 }
                 thrift_attr.value.ipaddrlist.count = attr.value.ipaddrlist.count;
-                free(attr.value.ipaddrlist.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_IP_PREFIX_LIST:
@@ -821,7 +1260,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.ipprefixlist.prefixlist.push_back(thrift_ip);
                 }
                 thrift_attr.value.ipprefixlist.count = attr.value.ipprefixlist.count;
-                free(attr.value.ipprefixlist.list);
             }
             break;
         case SAI_ATTR_VALUE_TYPE_QOS_MAP_LIST:
@@ -850,7 +1288,6 @@ void convert_attr_sai_to_thrift(
                     thrift_attr.value.qosmap.maplist.push_back(thrift_qos_map);
                 }
                 thrift_attr.value.qosmap.count = attr.value.qosmap.count;
-                free(attr.value.qosmap.list);
             }
             break;
         default:
@@ -889,7 +1326,10 @@ class sai_rpcHandlerFrontend:
         uint32_t attr_count = 1;
         uint64_t count = 0;
 
-        sai_object_type_get_availability(switch_id, (sai_object_type_t)object_type, attr_count, &attr, &count);
+        sai_thrift_sai_call_begin();
+        sai_status_t status = sai_object_type_get_availability(switch_id, (sai_object_type_t)object_type, attr_count, &attr, &count);
+        sai_thrift_sai_call_end(status);
+
         return count;
     }
 
@@ -941,12 +1381,16 @@ class sai_rpcHandlerFrontend:
         enum_values_capability.list = caps_list.data();
         enum_values_capability.count = caps_count;
 
+        sai_thrift_sai_call_begin();
+
         sai_status_t status = sai_query_attribute_enum_values_capability(
                 (sai_object_id_t)switch_id,
                 (sai_object_type_t)object_type,
                 (sai_attr_id_t)attr_id,
                 &enum_values_capability);
 
+        sai_thrift_sai_call_end(status);
+
         if (status == SAI_STATUS_SUCCESS)
         {
             for (uint32_t i = 0; i < enum_values_capability.count; ++i)
@@ -955,6 +1399,208 @@ class sai_rpcHandlerFrontend:
             }
         }
     }
+
+    /**
+     * @brief Thrift wrapper for sai_bulk_object_get_stats() SAI function
+     *
+     * Objects are grouped by object type and counter ids, since a single
+     * bulk call takes one counter list for all objects. When bulk stats
+     * are not implemented, counters are read object by object on the
+     * server side. Counters of all objects are returned packed in request
+     * order along with the status of each object, counters of objects
+     * which failed are left zero.
+     */
+    void sai_thrift_objects_get_stats(
+            sai_thrift_objects_stats_t &thrift_stats,
+            const std::vector<sai_thrift_object_stats_t> &thrift_objects) override
+    {
+        std::vector<int64_t> &thrift_counters = thrift_stats.counters;
+
+        typedef std::pair<sai_thrift_object_type_t, std::vector<int32_t>> group_key_t;
+
+        std::map<group_key_t, std::vector<size_t>> groups;
+
+        std::vector<size_t> offsets(thrift_objects.size());
+
+        size_t total = 0;
+
+        for (size_t idx = 0; idx < thrift_objects.size(); idx++)
+        {
+            const sai_thrift_object_stats_t &obj = thrift_objects[idx];
+
+            offsets[idx] = total;
+            total += obj.counter_ids.size();
+
+            groups[group_key_t(obj.object_type, obj.counter_ids)].push_back(idx);
+        }
+
+        thrift_counters.assign(total, 0);
+        thrift_stats.statuses.assign(thrift_objects.size(), SAI_STATUS_SUCCESS);
+
+        for (auto &group: groups)
+        {
+            const sai_object_type_t object_type = (sai_object_type_t)group.first.first;
+            const std::vector<size_t> &members = group.second;
+
+            const uint32_t object_count = (uint32_t)members.size();
+            const uint32_t counter_count = (uint32_t)group.first.second.size();
+
+            if (counter_count == 0)
+            {
+                continue;
+            }
+
+            std::vector<sai_stat_id_t> counter_ids(group.first.second.begin(), group.first.second.end());
+            std::vector<sai_object_key_t> object_keys(object_count);
+            std::vector<sai_status_t> statuses(object_count, SAI_STATUS_FAILURE);
+            std::vector<uint64_t> counters((size_t)object_count * counter_count, 0);
+
+            for (uint32_t i = 0; i < object_count; i++)
+            {
+                object_keys[i].key.object_id = thrift_objects[members[i]].object_id;
+            }
+
+            sai_thrift_sai_call_begin();
+
+            sai_status_t status = sai_bulk_object_get_stats(
+                    switch_id,
+                    object_type,
+                    object_count,
+                    object_keys.data(),
+                    counter_count,
+                    counter_ids.data(),
+                    SAI_STATS_MODE_READ,
+                    statuses.data(),
+                    counters.data());
+
+            const bool fallback = (status == SAI_STATUS_NOT_IMPLEMENTED || status == SAI_STATUS_NOT_SUPPORTED);
+
+            // falling back is no error, the per object calls below are accounted on their own
+            sai_thrift_sai_call_end(fallback ? SAI_STATUS_SUCCESS : status);
+
+            if (fallback)
+            {
+                const sai_apis_t *apis = sai_thrift_get_apis();
+
+                for (uint32_t i = 0; i < object_count; i++)
+                {
+                    sai_object_meta_key_t meta_key;
+
+                    meta_key.objecttype = object_type;
+                    meta_key.objectkey = object_keys[i];
+
+                    sai_thrift_sai_call_begin();
+
+                    statuses[i] = sai_metadata_generic_get_stats(
+                            apis,
+                            &meta_key,
+                            counter_count,
+                            counter_ids.data(),
+                            &counters[(size_t)i * counter_count]);
+
+                    sai_thrift_sai_call_end(statuses[i]);
+                }
+            }
+
+            for (uint32_t i = 0; i < object_count; i++)
+            {
+                thrift_stats.statuses[members[i]] = statuses[i];
+
+                if (statuses[i] != SAI_STATUS_SUCCESS)
+                {
+                    continue;
+                }
+
+                const size_t offset = offsets[members[i]];
+
+                for (uint32_t j = 0; j < counter_count; j++)
+                {
+                    thrift_counters[offset + j] = (int64_t)counters[(size_t)i * counter_count + j];
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Return per RPC method call counters and latency histograms
+     */
+    void sai_thrift_get_rpc_stats(
+            std::vector<sai_thrift_rpc_stats_t> &thrift_stats,
+            const bool clear) override
+    {
+        sai_thrift_rpc_stats_registry.get(thrift_stats, clear);
+    }
+
+private:
+
+    /**
+     * @brief Query all SAI API tables once, for generic metadata calls
+     */
+    static const sai_apis_t *sai_thrift_get_apis()
+    {
+        static sai_apis_t apis;
+        static std::once_flag apis_queried;
+
+        std::call_once(apis_queried, []()
+        {
+            memset(&apis, 0, sizeof(apis));
+            sai_metadata_apis_query(sai_api_query, &apis);
+        });
+
+        return &apis;
+    }
+};
+
+/**
+ * @brief Processor event handler timing every RPC from request read to reply write
+ */
+class sai_thrift_rpc_event_handler:
+    public TProcessorEventHandler
+{
+    public:
+
+        void *getContext(
+                const char *fn_name,
+                void *server_context) override
+        {
+            return &sai_thrift_rpc_call;
+        }
+
+        void preRead(
+                void *ctx,
+                const char *fn_name) override
+        {
+            sai_thrift_rpc_call_t *call = static_cast<sai_thrift_rpc_call_t *>(ctx);
+
+            call->start_ns = sai_thrift_now_ns();
+            call->sai_ns = 0;
+            call->error = false;
+        }
+
+        void handlerError(
+                void *ctx,
+                const char *fn_name) override
+        {
+            static_cast<sai_thrift_rpc_call_t *>(ctx)->error = true;
+        }
+
+        void postWrite(
+                void *ctx,
+                const char *fn_name,
+                uint32_t bytes) override
+        {
+            sai_thrift_rpc_call_t *call = static_cast<sai_thrift_rpc_call_t *>(ctx);
+
+            // fn_name is "service.method", keep just the method
+
+            const char *method = strchr(fn_name, '.');
+
+            sai_thrift_rpc_stats_registry.record(
+                    method ? method + 1 : fn_name,
+                    sai_thrift_now_ns() - call->start_ns,
+                    call->sai_ns,
+                    call->error);
+        }
 };
 
 static pthread_mutex_t cookie_mutex;
@@ -970,6 +1616,12 @@ static void *sai_thrift_rpc_server_thread(void *arg)
 
     std::shared_ptr<sai_rpcHandlerFrontend> handler(new sai_rpcHandlerFrontend());
     std::shared_ptr<TProcessor> processor(new sai_rpcProcessor(handler));
+
+    if (sai_thrift_rpc_stats::enabled())
+    {
+        processor->setEventHandler(std::make_shared<sai_thrift_rpc_event_handler>());
+    }
+
     std::shared_ptr<TServerTransport> serverTransport(new TServerSocket(port));
     std::shared_ptr<TTransportFactory> transportFactory(new TBufferedTransportFactory());
     std::shared_ptr<TProtocolFactory> protocolFactory(new TBinaryProtocolFactory());
@@ -0,0 +1,998 @@
+/**
+ * Copyright (c) 2023 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saimetadatavalidator.c
+ *
+ * @brief   This module defines SAI Metadata Validator
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+#include "saimetadatautils.h"
+#include "saimetadata.h"
+#include "saimetadatavalidator.h"
+
+/*
+ * Object types are indexed densely, extension object types following
+ * SAI_OBJECT_TYPE_MAX.
+ */
+
+#define SAI_METADATA_VALIDATOR_OBJECT_TYPE_COUNT \
+    ((int)SAI_OBJECT_TYPE_MAX + (int)(SAI_OBJECT_TYPE_EXTENSIONS_RANGE_END - SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START))
+
+#define SAI_METADATA_VALIDATOR_WORDS(bits) (((size_t)(bits) + 63) / 64)
+
+/* enums spanning more values are searched in the enum metadata */
+
+#define SAI_METADATA_VALIDATOR_ENUM_MAX_BITS 4096
+
+#define SAI_METADATA_VALIDATOR_RULE_CREATE          (1 << 0)
+#define SAI_METADATA_VALIDATOR_RULE_SET             (1 << 1)
+#define SAI_METADATA_VALIDATOR_RULE_CONDITIONAL     (1 << 2)
+#define SAI_METADATA_VALIDATOR_RULE_ENUM            (1 << 3)
+#define SAI_METADATA_VALIDATOR_RULE_OID             (1 << 4)
+
+typedef struct _sai_metadata_validator_rule_t
+{
+    const sai_attr_metadata_t *md;
+
+    uint32_t flags;
+
+    /* allowed enum values, bit n is the smallest value plus n */
+
+    int64_t enumbase;
+
+    uint32_t enumbits;
+
+    uint64_t *enummap;
+
+    /* allowed object types, bit n is object type of dense index n */
+
+    uint64_t *oidmap;
+
+} sai_metadata_validator_rule_t;
+
+typedef struct _sai_metadata_validator_plan_t
+{
+    const sai_object_type_info_t *info;
+
+    /* one rule per attribute, in attribute metadata order */
+
+    uint32_t rulecount;
+
+    sai_metadata_validator_rule_t *rules;
+
+    /* attribute ids below this count are their own rule index */
+
+    uint32_t directcount;
+
+    /* other attribute ids, sorted, and their rule indexes */
+
+    uint32_t sortedcount;
+
+    sai_attr_id_t *sortedids;
+
+    uint32_t *sortedindexes;
+
+    /* rule indexes of unconditional mandatory on create attributes */
+
+    uint64_t *mandatory;
+
+    /* rule indexes of conditional mandatory on create attributes */
+
+    uint32_t conditionalcount;
+
+    uint32_t *conditional;
+
+} sai_metadata_validator_plan_t;
+
+struct _sai_metadata_validator_t
+{
+    sai_metadata_validator_object_type_query_fn object_type_query;
+
+    sai_metadata_validator_plan_t plans[SAI_METADATA_VALIDATOR_OBJECT_TYPE_COUNT];
+};
+
+static int sai_metadata_validator_object_type_index(
+        _In_ sai_object_type_t object_type)
+{
+    if (object_type > SAI_OBJECT_TYPE_NULL && object_type < SAI_OBJECT_TYPE_MAX)
+    {
+        return (int)object_type;
+    }
+
+    if ((int)object_type >= (int)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START &&
+            (int)object_type < (int)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_END)
+    {
+        return (int)SAI_OBJECT_TYPE_MAX + ((int)object_type - (int)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START);
+    }
+
+    return -1;
+}
+
+static sai_object_type_t sai_metadata_validator_object_type(
+        _In_ int index)
+{
+    if (index < (int)SAI_OBJECT_TYPE_MAX)
+    {
+        return (sai_object_type_t)index;
+    }
+
+    return (sai_object_type_t)((int)SAI_OBJECT_TYPE_EXTENSIONS_RANGE_START + (index - (int)SAI_OBJECT_TYPE_MAX));
+}
+
+static bool sai_metadata_validator_is_bit_set(
+        _In_ const uint64_t *map,
+        _In_ size_t bit)
+{
+    return ((map[bit / 64] >> (bit % 64)) & 1) != 0;
+}
+
+static void sai_metadata_validator_set_bit(
+        _Inout_ uint64_t *map,
+        _In_ size_t bit)
+{
+    map[bit / 64] |= (uint64_t)1 << (bit % 64);
+}
+
+static sai_status_t sai_metadata_validator_attr_status(
+        _In_ sai_status_t status,
+        _In_ uint32_t index)
+{
+    return status + SAI_STATUS_CODE((sai_status_t)index);
+}
+
+static bool sai_metadata_validator_build_rule(
+        _In_ const sai_attr_metadata_t *md,
+        _Out_ sai_metadata_validator_rule_t *rule)
+{
+    rule->md = md;
+
+    if (!SAI_HAS_FLAG_READ_ONLY(md->flags))
+    {
+        rule->flags |= SAI_METADATA_VALIDATOR_RULE_CREATE;
+    }
+
+    if (SAI_HAS_FLAG_CREATE_AND_SET(md->flags))
+    {
+        rule->flags |= SAI_METADATA_VALIDATOR_RULE_SET;
+    }
+
+    if (md->isconditional)
+    {
+        rule->flags |= SAI_METADATA_VALIDATOR_RULE_CONDITIONAL;
+    }
+
+    switch (md->attrvaluetype)
+    {
+        case SAI_ATTR_VALUE_TYPE_INT32:
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_INT32:
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_INT32:
+
+            if (md->isenum && md->enummetadata != NULL)
+            {
+                rule->flags |= SAI_METADATA_VALIDATOR_RULE_ENUM;
+            }
+
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT32_LIST:
+
+            if (md->isenumlist && md->enummetadata != NULL)
+            {
+                rule->flags |= SAI_METADATA_VALIDATOR_RULE_ENUM;
+            }
+
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+
+            rule->flags |= SAI_METADATA_VALIDATOR_RULE_OID;
+
+            break;
+
+        default:
+            break;
+    }
+
+    if (rule->flags & SAI_METADATA_VALIDATOR_RULE_OID)
+    {
+        rule->oidmap = calloc(SAI_METADATA_VALIDATOR_WORDS(SAI_METADATA_VALIDATOR_OBJECT_TYPE_COUNT), sizeof(uint64_t));
+
+        if (rule->oidmap == NULL)
+        {
+            return false;
+        }
+
+        size_t i = 0;
+
+        for (; i < md->allowedobjecttypeslength; i++)
+        {
+            int index = sai_metadata_validator_object_type_index(md->allowedobjecttypes[i]);
+
+            if (index >= 0)
+            {
+                sai_metadata_validator_set_bit(rule->oidmap, (size_t)index);
+            }
+        }
+    }
+
+    if ((rule->flags & SAI_METADATA_VALIDATOR_RULE_ENUM) && md->enummetadata->valuescount != 0)
+    {
+        const sai_enum_metadata_t *emd = md->enummetadata;
+
+        int64_t min = emd->values[0];
+        int64_t max = emd->values[0];
+
+        size_t i = 1;
+
+        for (; i < emd->valuescount; i++)
+        {
+            min = (emd->values[i] < min) ? emd->values[i] : min;
+            max = (emd->values[i] > max) ? emd->values[i] : max;
+        }
+
+        if (max - min < SAI_METADATA_VALIDATOR_ENUM_MAX_BITS)
+        {
+            rule->enumbase = min;
+            rule->enumbits = (uint32_t)(max - min + 1);
+            rule->enummap = calloc(SAI_METADATA_VALIDATOR_WORDS(rule->enumbits), sizeof(uint64_t));
+
+            if (rule->enummap == NULL)
+            {
+                return false;
+            }
+
+            for (i = 0; i < emd->valuescount; i++)
+            {
+                sai_metadata_validator_set_bit(rule->enummap, (size_t)(emd->values[i] - min));
+            }
+        }
+    }
+
+    return true;
+}
+
+static bool sai_metadata_validator_build_plan(
+        _In_ const sai_object_type_info_t *info,
+        _Out_ sai_metadata_validator_plan_t *plan)
+{
+    plan->info = info;
+
+    if (info->attrmetadatalength > SAI_METADATA_VALIDATOR_MAX_ATTRS)
+    {
+        SAI_META_LOG_ERROR("%s has %zu attributes, more than SAI_METADATA_VALIDATOR_MAX_ATTRS",
+                info->objecttypename, info->attrmetadatalength);
+
+        return false;
+    }
+
+    plan->rulecount = (uint32_t)info->attrmetadatalength;
+
+    plan->rules = calloc(plan->rulecount + 1, sizeof(sai_metadata_validator_rule_t));
+    plan->sortedids = calloc(plan->rulecount + 1, sizeof(sai_attr_id_t));
+    plan->sortedindexes = calloc(plan->rulecount + 1, sizeof(uint32_t));
+    plan->mandatory = calloc(SAI_METADATA_VALIDATOR_WORDS(plan->rulecount) + 1, sizeof(uint64_t));
+    plan->conditional = calloc(plan->rulecount + 1, sizeof(uint32_t));
+
+    if (plan->rules == NULL || plan->sortedids == NULL || plan->sortedindexes == NULL ||
+            plan->mandatory == NULL || plan->conditional == NULL)
+    {
+        return false;
+    }
+
+    uint32_t idx = 0;
+
+    for (; idx < plan->rulecount; idx++)
+    {
+        const sai_attr_metadata_t *md = info->attrmetadata[idx];
+
+        if (!sai_metadata_validator_build_rule(md, &plan->rules[idx]))
+        {
+            return false;
+        }
+
+        if (plan->directcount == idx && md->attrid == idx)
+        {
+            plan->directcount++;
+        }
+
+        if (!md->ismandatoryoncreate)
+        {
+            continue;
+        }
+
+        if (md->isconditional)
+        {
+            plan->conditional[plan->conditionalcount++] = idx;
+        }
+        else
+        {
+            sai_metadata_validator_set_bit(plan->mandatory, idx);
+        }
+    }
+
+    /* insertion sort, attribute ids past the direct ones are few */
+
+    for (idx = plan->directcount; idx < plan->rulecount; idx++)
+    {
+        sai_attr_id_t attrid = info->attrmetadata[idx]->attrid;
+
+        uint32_t pos = plan->sortedcount++;
+
+        for (; pos > 0 && plan->sortedids[pos - 1] > attrid; pos--)
+        {
+            plan->sortedids[pos] = plan->sortedids[pos - 1];
+            plan->sortedindexes[pos] = plan->sortedindexes[pos - 1];
+        }
+
+        plan->sortedids[pos] = attrid;
+        plan->sortedindexes[pos] = idx;
+    }
+
+    return true;
+}
+
+static void sai_metadata_validator_free_plan(
+        _Inout_ sai_metadata_validator_plan_t *plan)
+{
+    uint32_t idx = 0;
+
+    for (; plan->rules != NULL && idx < plan->rulecount; idx++)
+    {
+        free(plan->rules[idx].enummap);
+        free(plan->rules[idx].oidmap);
+    }
+
+    free(plan->rules);
+    free(plan->sortedids);
+    free(plan->sortedindexes);
+    free(plan->mandatory);
+    free(plan->conditional);
+}
+
+sai_metadata_validator_t* sai_metadata_validator_create(
+        _In_ sai_metadata_validator_object_type_query_fn object_type_query)
+{
+    sai_metadata_validator_t *validator = calloc(1, sizeof(sai_metadata_validator_t));
+
+    if (validator == NULL)
+    {
+        return NULL;
+    }
+
+    validator->object_type_query = object_type_query;
+
+    int index = 1;
+
+    for (; index < SAI_METADATA_VALIDATOR_OBJECT_TYPE_COUNT; index++)
+    {
+        const sai_object_type_info_t *info =
+            sai_metadata_get_object_type_info(sai_metadata_validator_object_type(index));
+
+        if (info == NULL)
+        {
+            continue;
+        }
+
+        if (!sai_metadata_validator_build_plan(info, &validator->plans[index]))
+        {
+            SAI_META_LOG_ERROR("failed to build validation plan of %s", info->objecttypename);
+
+            sai_metadata_validator_free(validator);
+
+            return NULL;
+        }
+    }
+
+    return validator;
+}
+
+void sai_metadata_validator_free(
+        _In_ sai_metadata_validator_t *validator)
+{
+    if (validator == NULL)
+    {
+        return;
+    }
+
+    int index = 0;
+
+    for (; index < SAI_METADATA_VALIDATOR_OBJECT_TYPE_COUNT; index++)
+    {
+        sai_metadata_validator_free_plan(&validator->plans[index]);
+    }
+
+    free(validator);
+}
+
+static const sai_metadata_validator_plan_t* sai_metadata_validator_get_plan(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ sai_object_type_t object_type)
+{
+    int index = sai_metadata_validator_object_type_index(object_type);
+
+    if (validator == NULL || index < 0 || validator->plans[index].info == NULL)
+    {
+        SAI_META_LOG_ERROR("invalid object type %d", object_type);
+
+        return NULL;
+    }
+
+    return &validator->plans[index];
+}
+
+/* returns rule index of attribute id, or rule count when not found */
+static uint32_t sai_metadata_validator_find_rule(
+        _In_ const sai_metadata_validator_plan_t *plan,
+        _In_ sai_attr_id_t attrid)
+{
+    if (attrid < plan->directcount)
+    {
+        return attrid;
+    }
+
+    uint32_t low = 0;
+    uint32_t high = plan->sortedcount;
+
+    while (low < high)
+    {
+        uint32_t mid = low + (high - low) / 2;
+
+        if (plan->sortedids[mid] < attrid)
+        {
+            low = mid + 1;
+        }
+        else
+        {
+            high = mid;
+        }
+    }
+
+    if (low < plan->sortedcount && plan->sortedids[low] == attrid)
+    {
+        return plan->sortedindexes[low];
+    }
+
+    return plan->rulecount;
+}
+
+static bool sai_metadata_validator_is_allowed_enum_value(
+        _In_ const sai_metadata_validator_rule_t *rule,
+        _In_ int32_t value)
+{
+    if (rule->enummap == NULL)
+    {
+        return sai_metadata_is_allowed_enum_value(rule->md, value);
+    }
+
+    int64_t bit = (int64_t)value - rule->enumbase;
+
+    return bit >= 0 && bit < (int64_t)rule->enumbits && sai_metadata_validator_is_bit_set(rule->enummap, (size_t)bit);
+}
+
+static bool sai_metadata_validator_is_acl_disabled(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t *value)
+{
+    if (md->isaclfield)
+    {
+        return !value->aclfield.enable;
+    }
+
+    if (md->isaclaction)
+    {
+        return !value->aclaction.enable;
+    }
+
+    return false;
+}
+
+#define SAI_METADATA_VALIDATOR_LIST(member) \
+    if (value->member.count != 0 && value->member.list == NULL) return false
+
+/* false for lists with non zero count and NULL pointer */
+static bool sai_metadata_validator_are_lists_valid(
+        _In_ sai_attr_value_type_t type,
+        _In_ const sai_attribute_value_t *value)
+{
+    switch (type)
+    {
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            SAI_METADATA_VALIDATOR_LIST(objlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT8_LIST:
+            SAI_METADATA_VALIDATOR_LIST(u8list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT8_LIST:
+            SAI_METADATA_VALIDATOR_LIST(s8list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT16_LIST:
+            SAI_METADATA_VALIDATOR_LIST(u16list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT16_LIST:
+            SAI_METADATA_VALIDATOR_LIST(s16list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT32_LIST:
+            SAI_METADATA_VALIDATOR_LIST(u32list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT32_LIST:
+            SAI_METADATA_VALIDATOR_LIST(s32list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_UINT16_RANGE_LIST:
+            SAI_METADATA_VALIDATOR_LIST(u16rangelist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_VLAN_LIST:
+            SAI_METADATA_VALIDATOR_LIST(vlanlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_QOS_MAP_LIST:
+            SAI_METADATA_VALIDATOR_LIST(qosmap);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_MAP_LIST:
+            SAI_METADATA_VALIDATOR_LIST(maplist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+            SAI_METADATA_VALIDATOR_LIST(aclfield.data.objlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_UINT8_LIST:
+            SAI_METADATA_VALIDATOR_LIST(aclfield.data.u8list);
+            SAI_METADATA_VALIDATOR_LIST(aclfield.mask.u8list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+            SAI_METADATA_VALIDATOR_LIST(aclaction.parameter.objlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_CAPABILITY:
+            SAI_METADATA_VALIDATOR_LIST(aclcapability.action_list);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_RESOURCE_LIST:
+            SAI_METADATA_VALIDATOR_LIST(aclresource);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_TLV_LIST:
+            SAI_METADATA_VALIDATOR_LIST(tlvlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_SEGMENT_LIST:
+            SAI_METADATA_VALIDATOR_LIST(segmentlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_IP_ADDRESS_LIST:
+            SAI_METADATA_VALIDATOR_LIST(ipaddrlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_EYE_VALUES_LIST:
+            SAI_METADATA_VALIDATOR_LIST(porteyevalues);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_SYSTEM_PORT_CONFIG_LIST:
+            SAI_METADATA_VALIDATOR_LIST(sysportconfiglist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_ERR_STATUS_LIST:
+            SAI_METADATA_VALIDATOR_LIST(porterror);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_LANE_LATCH_STATUS_LIST:
+            SAI_METADATA_VALIDATOR_LIST(portlanelatchstatuslist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_JSON:
+            SAI_METADATA_VALIDATOR_LIST(json.json);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_IP_PREFIX_LIST:
+            SAI_METADATA_VALIDATOR_LIST(ipprefixlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_CHAIN_LIST:
+            SAI_METADATA_VALIDATOR_LIST(aclchainlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_FREQUENCY_OFFSET_PPM_LIST:
+            SAI_METADATA_VALIDATOR_LIST(portfrequencyoffsetppmlist);
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_PORT_SNR_LIST:
+            SAI_METADATA_VALIDATOR_LIST(portsnrlist);
+            break;
+
+        default:
+            break;
+    }
+
+    return true;
+}
+
+static sai_status_t sai_metadata_validator_check_oid(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ const sai_metadata_validator_rule_t *rule,
+        _In_ sai_object_id_t oid)
+{
+    if (oid == SAI_NULL_OBJECT_ID)
+    {
+        if (rule->md->allownullobjectid)
+        {
+            return SAI_STATUS_SUCCESS;
+        }
+
+        SAI_META_LOG_ERROR("%s: NULL object id is not allowed", rule->md->attridname);
+
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    if (validator->object_type_query == NULL)
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    int index = sai_metadata_validator_object_type_index(validator->object_type_query(oid));
+
+    if (index < 0 || !sai_metadata_validator_is_bit_set(rule->oidmap, (size_t)index))
+    {
+        SAI_META_LOG_ERROR("%s: 0x%" PRIx64 " does not exist or has wrong object type", rule->md->attridname, oid);
+
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_metadata_validator_check_value(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ const sai_metadata_validator_rule_t *rule,
+        _In_ const sai_attribute_value_t *value)
+{
+    const sai_attr_metadata_t *md = rule->md;
+
+    if (sai_metadata_validator_is_acl_disabled(md, value))
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    if (!sai_metadata_validator_are_lists_valid(md->attrvaluetype, value))
+    {
+        SAI_META_LOG_ERROR("%s: list count is not zero but list is NULL", md->attridname);
+
+        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+    }
+
+    if (!(rule->flags & (SAI_METADATA_VALIDATOR_RULE_ENUM | SAI_METADATA_VALIDATOR_RULE_OID)))
+    {
+        return SAI_STATUS_SUCCESS;
+    }
+
+    const sai_object_list_t *objlist = NULL;
+
+    int32_t enumvalue = 0;
+
+    switch (md->attrvaluetype)
+    {
+        case SAI_ATTR_VALUE_TYPE_INT32:
+            enumvalue = value->s32;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_INT32:
+            enumvalue = value->aclfield.data.s32;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_INT32:
+            enumvalue = value->aclaction.parameter.s32;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_INT32_LIST:
+            {
+                uint32_t i = 0;
+
+                for (; i < value->s32list.count; i++)
+                {
+                    if (!sai_metadata_validator_is_allowed_enum_value(rule, value->s32list.list[i]))
+                    {
+                        SAI_META_LOG_ERROR("%s: %d is not allowed", md->attridname, value->s32list.list[i]);
+
+                        return SAI_STATUS_INVALID_ATTR_VALUE_0;
+                    }
+                }
+            }
+
+            return SAI_STATUS_SUCCESS;
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            return sai_metadata_validator_check_oid(validator, rule, value->oid);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+            return sai_metadata_validator_check_oid(validator, rule, value->aclfield.data.oid);
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+            return sai_metadata_validator_check_oid(validator, rule, value->aclaction.parameter.oid);
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            objlist = &value->objlist;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+            objlist = &value->aclfield.data.objlist;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+            objlist = &value->aclaction.parameter.objlist;
+            break;
+
+        default:
+            return SAI_STATUS_SUCCESS;
+    }
+
+    if (objlist == NULL)
+    {
+        if (!sai_metadata_validator_is_allowed_enum_value(rule, enumvalue))
+        {
+            SAI_META_LOG_ERROR("%s: %d is not allowed", md->attridname, enumvalue);
+
+            return SAI_STATUS_INVALID_ATTR_VALUE_0;
+        }
+
+        return SAI_STATUS_SUCCESS;
+    }
+
+    uint32_t i = 0;
+
+    for (; i < objlist->count; i++)
+    {
+        sai_status_t status = sai_metadata_validator_check_oid(validator, rule, objlist->list[i]);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return status;
+        }
+
+        if (md->allowrepetitiononlist)
+        {
+            continue;
+        }
+
+        /* lists are short, searching previous items avoids allocating a set */
+
+        uint32_t j = 0;
+
+        for (; j < i; j++)
+        {
+            if (objlist->list[j] == objlist->list[i])
+            {
+                SAI_META_LOG_ERROR("%s: 0x%" PRIx64 " is repeated", md->attridname, objlist->list[i]);
+
+                return SAI_STATUS_INVALID_ATTR_VALUE_0;
+            }
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+static sai_status_t sai_metadata_validator_check_create_plan(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ const sai_metadata_validator_plan_t *plan,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    uint64_t seen[SAI_METADATA_VALIDATOR_WORDS(SAI_METADATA_VALIDATOR_MAX_ATTRS)];
+
+    size_t words = SAI_METADATA_VALIDATOR_WORDS(plan->rulecount);
+
+    if (attr_count != 0 && attr_list == NULL)
+    {
+        SAI_META_LOG_ERROR("attribute list is NULL");
+
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    memset(seen, 0, words * sizeof(uint64_t));
+
+    uint32_t idx = 0;
+
+    for (; idx < attr_count; idx++)
+    {
+        uint32_t index = sai_metadata_validator_find_rule(plan, attr_list[idx].id);
+
+        if (index == plan->rulecount)
+        {
+            SAI_META_LOG_ERROR("unknown attribute 0x%x on %s", attr_list[idx].id, plan->info->objecttypename);
+
+            return sai_metadata_validator_attr_status(SAI_STATUS_UNKNOWN_ATTRIBUTE_0, idx);
+        }
+
+        const sai_metadata_validator_rule_t *rule = &plan->rules[index];
+
+        if (!(rule->flags & SAI_METADATA_VALIDATOR_RULE_CREATE))
+        {
+            SAI_META_LOG_ERROR("%s is read only", rule->md->attridname);
+
+            return sai_metadata_validator_attr_status(SAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+        }
+
+        if (sai_metadata_validator_is_bit_set(seen, index))
+        {
+            SAI_META_LOG_ERROR("%s is passed more than once", rule->md->attridname);
+
+            return sai_metadata_validator_attr_status(SAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+        }
+
+        sai_metadata_validator_set_bit(seen, index);
+
+        if ((rule->flags & SAI_METADATA_VALIDATOR_RULE_CONDITIONAL) &&
+                !sai_metadata_is_condition_met(rule->md, attr_count, attr_list))
+        {
+            SAI_META_LOG_ERROR("%s is passed but its condition is not met", rule->md->attridname);
+
+            return sai_metadata_validator_attr_status(SAI_STATUS_INVALID_ATTRIBUTE_0, idx);
+        }
+
+        sai_status_t status = sai_metadata_validator_check_value(validator, rule, &attr_list[idx].value);
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            return sai_metadata_validator_attr_status(status, idx);
+        }
+    }
+
+    size_t word = 0;
+
+    for (; word < words; word++)
+    {
+        uint64_t missing = plan->mandatory[word] & ~seen[word];
+
+        if (missing == 0)
+        {
+            continue;
+        }
+
+        size_t bit = 0;
+
+        while (((missing >> bit) & 1) == 0)
+        {
+            bit++;
+        }
+
+        SAI_META_LOG_ERROR("%s is mandatory on create", plan->rules[word * 64 + bit].md->attridname);
+
+        return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+    }
+
+    for (idx = 0; idx < plan->conditionalcount; idx++)
+    {
+        const sai_attr_metadata_t *md = plan->rules[plan->conditional[idx]].md;
+
+        if (!sai_metadata_validator_is_bit_set(seen, plan->conditional[idx]) &&
+                sai_metadata_is_condition_met(md, attr_count, attr_list))
+        {
+            SAI_META_LOG_ERROR("%s is mandatory on create", md->attridname);
+
+            return SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING;
+        }
+    }
+
+    return SAI_STATUS_SUCCESS;
+}
+
+sai_status_t sai_metadata_validator_check_create(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list)
+{
+    const sai_metadata_validator_plan_t *plan = sai_metadata_validator_get_plan(validator, object_type);
+
+    if (plan == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    return sai_metadata_validator_check_create_plan(validator, plan, attr_count, attr_list);
+}
+
+sai_status_t sai_metadata_validator_check_set(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ sai_object_type_t object_type,
+        _In_ const sai_attribute_t *attr)
+{
+    const sai_metadata_validator_plan_t *plan = sai_metadata_validator_get_plan(validator, object_type);
+
+    if (plan == NULL || attr == NULL)
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    uint32_t index = sai_metadata_validator_find_rule(plan, attr->id);
+
+    if (index == plan->rulecount)
+    {
+        SAI_META_LOG_ERROR("unknown attribute 0x%x on %s", attr->id, plan->info->objecttypename);
+
+        return SAI_STATUS_UNKNOWN_ATTRIBUTE_0;
+    }
+
+    const sai_metadata_validator_rule_t *rule = &plan->rules[index];
+
+    if (!(rule->flags & SAI_METADATA_VALIDATOR_RULE_SET))
+    {
+        SAI_META_LOG_ERROR("%s can't be set", rule->md->attridname);
+
+        return SAI_STATUS_INVALID_ATTRIBUTE_0;
+    }
+
+    return sai_metadata_validator_check_value(validator, rule, &attr->value);
+}
+
+sai_status_t sai_metadata_validator_check_bulk_create(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _Out_ sai_status_t *object_statuses)
+{
+    const sai_metadata_validator_plan_t *plan = sai_metadata_validator_get_plan(validator, object_type);
+
+    if (plan == NULL || (object_count != 0 && (attr_count == NULL || attr_list == NULL)))
+    {
+        return SAI_STATUS_INVALID_PARAMETER;
+    }
+
+    sai_status_t first = SAI_STATUS_SUCCESS;
+
+    uint32_t idx = 0;
+
+    for (; idx < object_count; idx++)
+    {
+        sai_status_t status = sai_metadata_validator_check_create_plan(validator, plan, attr_count[idx], attr_list[idx]);
+
+        if (object_statuses != NULL)
+        {
+            object_statuses[idx] = status;
+        }
+
+        if (status != SAI_STATUS_SUCCESS && first == SAI_STATUS_SUCCESS)
+        {
+            first = status;
+        }
+    }
+
+    return first;
+}
@@ -0,0 +1,145 @@
+/**
+ * Copyright (c) 2023 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saimetadatavalidator.h
+ *
+ * @brief   This module defines SAI Metadata Validator
+ */
+
+#ifndef __SAIMETADATAVALIDATOR_H_
+#define __SAIMETADATAVALIDATOR_H_
+
+#include "saimetadatatypes.h"
+
+/**
+ * @defgroup SAIMETADATAVALIDATOR SAI - Metadata Validator Definitions
+ *
+ * Validates attribute lists passed to create and set against the metadata.
+ * Per object type plans are built once by sai_metadata_validator_create,
+ * after which each list is validated in a single pass without allocating
+ * memory, so one validator can be shared by any number of threads.
+ *
+ * Checked are attribute ids, flags, repeated attributes, conditions,
+ * mandatory on create attributes, enum values, lists with non zero count
+ * and NULL pointer, and NULL, repeated and object types of object ids.
+ *
+ * @{
+ */
+
+/**
+ * @brief Maximum number of attributes of a single object type
+ *
+ * Bounds the bits of passed attributes kept on the stack while a list is
+ * validated, sai_metadata_validator_create fails on larger object types.
+ */
+#define SAI_METADATA_VALIDATOR_MAX_ATTRS 2048
+
+/**
+ * @brief Validator, opaque to the user
+ */
+typedef struct _sai_metadata_validator_t sai_metadata_validator_t;
+
+/**
+ * @brief Object type query, same signature as sai_object_type_query
+ *
+ * @param[in] object_id Object id
+ *
+ * @return Object type of an existing object, #SAI_OBJECT_TYPE_NULL otherwise
+ */
+typedef sai_object_type_t (*sai_metadata_validator_object_type_query_fn)(
+        _In_ sai_object_id_t object_id);
+
+/**
+ * @brief Builds validation plans of all object types
+ *
+ * @param[in] object_type_query Query used to check object types of object
+ * ids passed in attribute values, when NULL they are not checked
+ *
+ * @return Validator or NULL in case of failure
+ */
+extern sai_metadata_validator_t* sai_metadata_validator_create(
+        _In_ sai_metadata_validator_object_type_query_fn object_type_query);
+
+/**
+ * @brief Frees validator created by sai_metadata_validator_create
+ *
+ * @param[in] validator Validator, can be NULL
+ */
+extern void sai_metadata_validator_free(
+        _In_ sai_metadata_validator_t *validator);
+
+/**
+ * @brief Validates attribute list passed to create
+ *
+ * @param[in] validator Validator
+ * @param[in] object_type Object type
+ * @param[in] attr_count Number of attributes
+ * @param[in] attr_list Attribute list
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error,
+ * with attribute index added for per attribute status codes
+ */
+extern sai_status_t sai_metadata_validator_check_create(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t attr_count,
+        _In_ const sai_attribute_t *attr_list);
+
+/**
+ * @brief Validates attribute passed to set
+ *
+ * Conditions are not checked since they depend on the other attributes
+ * of the object.
+ *
+ * @param[in] validator Validator
+ * @param[in] object_type Object type
+ * @param[in] attr Attribute
+ *
+ * @return #SAI_STATUS_SUCCESS on success, failure status code on error
+ */
+extern sai_status_t sai_metadata_validator_check_set(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ sai_object_type_t object_type,
+        _In_ const sai_attribute_t *attr);
+
+/**
+ * @brief Validates attribute lists passed to bulk create
+ *
+ * @param[in] validator Validator
+ * @param[in] object_type Object type
+ * @param[in] object_count Number of objects
+ * @param[in] attr_count List of attribute counts, one per object
+ * @param[in] attr_list List of attribute lists, one per object
+ * @param[out] object_statuses Status of each object, can be NULL
+ *
+ * @return #SAI_STATUS_SUCCESS when all objects are valid, status of the
+ * first invalid object otherwise
+ */
+extern sai_status_t sai_metadata_validator_check_bulk_create(
+        _In_ const sai_metadata_validator_t *validator,
+        _In_ sai_object_type_t object_type,
+        _In_ uint32_t object_count,
+        _In_ const uint32_t *attr_count,
+        _In_ const sai_attribute_t **attr_list,
+        _Out_ sai_status_t *object_statuses);
+
+/**
+ * @}
+ */
+#endif /** __SAIMETADATAVALIDATOR_H_ */
@@ -0,0 +1,225 @@
+/**
+ * Copyright (c) 2023 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saimetadatavalidatortest.c
+ *
+ * @brief   This module defines SAI Metadata Validator Test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sai.h>
+
+#include "saimetadata.h"
+#include "saimetadatavalidator.h"
+
+#define ASSERT_STATUS(x,s)                                          \
+    {                                                               \
+        sai_status_t _status = (x);                                 \
+        sai_status_t _expected = (s);                               \
+        if (_status != _expected){                                  \
+            fprintf(stderr,                                         \
+                    "ASSERT STATUS FAILED(%s:%d): %s: %d != %d\n",  \
+                    __func__, __LINE__, #x, _status, _expected);    \
+            exit(1);}                                               \
+    }
+
+#define ATTR_STATUS(s,i) ((s) + SAI_STATUS_CODE(i))
+
+/* test object ids carry their object type in the upper 16 bits */
+
+#define TEST_OID(ot,n) (((sai_object_id_t)(ot) << 48) | (n))
+
+static sai_object_type_t test_object_type_query(
+        _In_ sai_object_id_t oid)
+{
+    return (sai_object_type_t)(oid >> 48);
+}
+
+static sai_metadata_validator_t *g_validator = NULL;
+
+void test_create_route_entry()
+{
+    sai_attribute_t attrs[3];
+
+    attrs[0].id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attrs[0].value.s32 = SAI_PACKET_ACTION_FORWARD;
+    attrs[1].id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    attrs[1].value.oid = TEST_OID(SAI_OBJECT_TYPE_NEXT_HOP, 1);
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 2, attrs), SAI_STATUS_SUCCESS);
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 0, NULL), SAI_STATUS_SUCCESS);
+
+    attrs[1].value.oid = SAI_NULL_OBJECT_ID;
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 2, attrs), SAI_STATUS_SUCCESS);
+
+    attrs[1].value.oid = TEST_OID(SAI_OBJECT_TYPE_VLAN, 1);
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 2, attrs),
+            ATTR_STATUS(SAI_STATUS_INVALID_ATTR_VALUE_0, 1));
+
+    attrs[0].value.s32 = 100;
+    attrs[1].value.oid = TEST_OID(SAI_OBJECT_TYPE_NEXT_HOP, 1);
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 2, attrs),
+            SAI_STATUS_INVALID_ATTR_VALUE_0);
+
+    attrs[0].value.s32 = SAI_PACKET_ACTION_DROP;
+    attrs[2].id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attrs[2].value.s32 = SAI_PACKET_ACTION_DROP;
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 3, attrs),
+            ATTR_STATUS(SAI_STATUS_INVALID_ATTRIBUTE_0, 2));
+
+    attrs[2].id = SAI_ROUTE_ENTRY_ATTR_IP_ADDR_FAMILY;
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 3, attrs),
+            ATTR_STATUS(SAI_STATUS_INVALID_ATTRIBUTE_0, 2));
+
+    attrs[2].id = 0x7fffffff;
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 3, attrs),
+            ATTR_STATUS(SAI_STATUS_UNKNOWN_ATTRIBUTE_0, 2));
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_NULL, 2, attrs), SAI_STATUS_INVALID_PARAMETER);
+}
+
+void test_create_next_hop()
+{
+    sai_attribute_t attrs[3];
+
+    attrs[0].id = SAI_NEXT_HOP_ATTR_TYPE;
+    attrs[0].value.s32 = SAI_NEXT_HOP_TYPE_IP;
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_NEXT_HOP, 0, attrs),
+            SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING);
+
+    /* ip and router interface are mandatory on ip next hops */
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_NEXT_HOP, 1, attrs),
+            SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING);
+
+    attrs[1].id = SAI_NEXT_HOP_ATTR_IP;
+    attrs[1].value.ipaddr.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    attrs[1].value.ipaddr.addr.ip4 = 0x0100000a;
+    attrs[2].id = SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID;
+    attrs[2].value.oid = TEST_OID(SAI_OBJECT_TYPE_ROUTER_INTERFACE, 1);
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_NEXT_HOP, 2, attrs),
+            SAI_STATUS_MANDATORY_ATTRIBUTE_MISSING);
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_NEXT_HOP, 3, attrs), SAI_STATUS_SUCCESS);
+
+    /* passed, but the condition is not met */
+
+    attrs[0].value.s32 = SAI_NEXT_HOP_TYPE_SRV6_SIDLIST;
+
+    ASSERT_STATUS(sai_metadata_validator_check_create(g_validator, SAI_OBJECT_TYPE_NEXT_HOP, 3, attrs),
+            ATTR_STATUS(SAI_STATUS_INVALID_ATTRIBUTE_0, 1));
+}
+
+void test_set()
+{
+    sai_object_id_t sessions[2] = { TEST_OID(SAI_OBJECT_TYPE_MIRROR_SESSION, 1), TEST_OID(SAI_OBJECT_TYPE_MIRROR_SESSION, 2) };
+
+    sai_attribute_t attr;
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_PACKET_ACTION;
+    attr.value.s32 = SAI_PACKET_ACTION_TRAP;
+
+    ASSERT_STATUS(sai_metadata_validator_check_set(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, &attr), SAI_STATUS_SUCCESS);
+
+    attr.id = SAI_ROUTE_ENTRY_ATTR_IP_ADDR_FAMILY;
+
+    ASSERT_STATUS(sai_metadata_validator_check_set(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, &attr), SAI_STATUS_INVALID_ATTRIBUTE_0);
+
+    attr.id = SAI_NEXT_HOP_ATTR_TYPE;
+
+    ASSERT_STATUS(sai_metadata_validator_check_set(g_validator, SAI_OBJECT_TYPE_NEXT_HOP, &attr), SAI_STATUS_INVALID_ATTRIBUTE_0);
+
+    attr.id = SAI_PORT_ATTR_INGRESS_MIRROR_SESSION;
+    attr.value.objlist.count = 2;
+    attr.value.objlist.list = sessions;
+
+    ASSERT_STATUS(sai_metadata_validator_check_set(g_validator, SAI_OBJECT_TYPE_PORT, &attr), SAI_STATUS_SUCCESS);
+
+    sessions[1] = sessions[0];
+
+    ASSERT_STATUS(sai_metadata_validator_check_set(g_validator, SAI_OBJECT_TYPE_PORT, &attr), SAI_STATUS_INVALID_ATTR_VALUE_0);
+
+    attr.value.objlist.list = NULL;
+
+    ASSERT_STATUS(sai_metadata_validator_check_set(g_validator, SAI_OBJECT_TYPE_PORT, &attr), SAI_STATUS_INVALID_ATTR_VALUE_0);
+
+    attr.value.objlist.count = 0;
+
+    ASSERT_STATUS(sai_metadata_validator_check_set(g_validator, SAI_OBJECT_TYPE_PORT, &attr), SAI_STATUS_SUCCESS);
+}
+
+void test_bulk_create()
+{
+    sai_attribute_t valid;
+    sai_attribute_t invalid;
+
+    valid.id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    valid.value.oid = TEST_OID(SAI_OBJECT_TYPE_NEXT_HOP, 1);
+
+    invalid.id = SAI_ROUTE_ENTRY_ATTR_NEXT_HOP_ID;
+    invalid.value.oid = TEST_OID(SAI_OBJECT_TYPE_VLAN, 1);
+
+    const sai_attribute_t *attr_list[3] = { &valid, &invalid, &valid };
+
+    uint32_t attr_count[3] = { 1, 1, 1 };
+
+    sai_status_t statuses[3];
+
+    ASSERT_STATUS(sai_metadata_validator_check_bulk_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 3, attr_count, attr_list, statuses),
+            SAI_STATUS_INVALID_ATTR_VALUE_0);
+
+    ASSERT_STATUS(statuses[0], SAI_STATUS_SUCCESS);
+    ASSERT_STATUS(statuses[1], SAI_STATUS_INVALID_ATTR_VALUE_0);
+    ASSERT_STATUS(statuses[2], SAI_STATUS_SUCCESS);
+
+    attr_list[1] = &valid;
+
+    ASSERT_STATUS(sai_metadata_validator_check_bulk_create(g_validator, SAI_OBJECT_TYPE_ROUTE_ENTRY, 3, attr_count, attr_list, NULL),
+            SAI_STATUS_SUCCESS);
+}
+
+int main()
+{
+    g_validator = sai_metadata_validator_create(&test_object_type_query);
+
+    if (g_validator == NULL)
+    {
+        fprintf(stderr, "failed to create validator\n");
+        exit(1);
+    }
+
+    test_create_route_entry();
+    test_create_next_hop();
+    test_set();
+    test_bulk_create();
+
+    sai_metadata_validator_free(g_validator);
+
+    return 0;
+}
@@ -0,0 +1,1378 @@
+/**
+ * Copyright (c) 2023 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABILITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc., Marvell International Ltd.
+ *
+ * @file    saireplay.cpp
+ *
+ * @brief   This module replays a libsairecord recording against any libsai
+ *
+ * usage: saireplay [-j jobs] [-p key=value]... recording
+ *
+ * Calls which succeeded when recorded are replayed through the generic
+ * metadata quad API of whatever libsai.so is loaded, object ids of the
+ * recording being mapped to the ones the replayed calls return: created
+ * objects by their create, objects created by the switch itself (ports,
+ * default VLAN, ...) by matching the ids returned by the recorded gets.
+ *
+ * With one job the calls are replayed in recorded order. With more, each
+ * call only waits for the earlier calls it depends on: the last call which
+ * wrote an object it reads, or every call since that one when it writes
+ * the object itself. Objects a call reads are found through the reverse
+ * graph of the metadata, so two route creates through the same next hop
+ * run concurrently while a next hop create waits for its router interface.
+ *
+ * Calls are grouped into phases, runs of the same operation on the same
+ * object type, and the recorded and replayed rates of each are reported.
+ */
+
+extern "C" {
+#include <sai.h>
+#include "saimetadata.h"
+}
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cinttypes>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include <getopt.h>
+
+#define SAIREPLAY_FAILURES_SHOWN    10
+
+static std::map<std::string, std::string> g_profile;
+
+static std::map<std::string, std::string>::const_iterator g_profile_it = g_profile.end();
+
+static const char* saireplay_profile_get_value(
+        _In_ sai_switch_profile_id_t profile_id,
+        _In_ const char *variable)
+{
+    if (variable == NULL)
+    {
+        return NULL;
+    }
+
+    auto it = g_profile.find(variable);
+
+    return (it == g_profile.end()) ? NULL : it->second.c_str();
+}
+
+static int saireplay_profile_get_next_value(
+        _In_ sai_switch_profile_id_t profile_id,
+        _Out_ const char **variable,
+        _Out_ const char **value)
+{
+    if (value == NULL)
+    {
+        g_profile_it = g_profile.begin();
+
+        return 0;
+    }
+
+    if (variable == NULL || g_profile_it == g_profile.end())
+    {
+        return -1;
+    }
+
+    *variable = g_profile_it->first.c_str();
+    *value = g_profile_it->second.c_str();
+
+    g_profile_it++;
+
+    return 0;
+}
+
+static const sai_service_method_table_t g_services = {
+    saireplay_profile_get_value,
+    saireplay_profile_get_next_value,
+};
+
+static bool saireplay_is_acl_disabled(
+        _In_ const sai_attr_metadata_t *md,
+        _In_ const sai_attribute_value_t &value)
+{
+    if (md->isaclfield)
+    {
+        return !value.aclfield.enable;
+    }
+
+    if (md->isaclaction)
+    {
+        return !value.aclaction.enable;
+    }
+
+    return false;
+}
+
+/* Call fn(oid) on every non NULL OID held by value, oid can be changed */
+template <typename F>
+static void saireplay_for_each_oid(
+        _In_ const sai_attr_metadata_t *md,
+        _Inout_ sai_attribute_value_t &value,
+        _In_ F fn)
+{
+    sai_object_list_t *objlist = NULL;
+
+    sai_object_id_t *oid = NULL;
+
+    if (saireplay_is_acl_disabled(md, value))
+    {
+        return;
+    }
+
+    switch (md->attrvaluetype)
+    {
+        case SAI_ATTR_VALUE_TYPE_OBJECT_ID:
+            oid = &value.oid;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_ID:
+            oid = &value.aclfield.data.oid;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_ID:
+            oid = &value.aclaction.parameter.oid;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_OBJECT_LIST:
+            objlist = &value.objlist;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_FIELD_DATA_OBJECT_LIST:
+            objlist = &value.aclfield.data.objlist;
+            break;
+
+        case SAI_ATTR_VALUE_TYPE_ACL_ACTION_DATA_OBJECT_LIST:
+            objlist = &value.aclaction.parameter.objlist;
+            break;
+
+        default:
+            return;
+    }
+
+    if (oid != NULL && *oid != SAI_NULL_OBJECT_ID)
+    {
+        fn(*oid);
+    }
+
+    for (uint32_t idx = 0; objlist != NULL && objlist->list != NULL && idx < objlist->count; idx++)
+    {
+        if (objlist->list[idx] != SAI_NULL_OBJECT_ID)
+        {
+            fn(objlist->list[idx]);
+        }
+    }
+}
+
+/**
+ * @brief Attributes and key members through which an object type refers
+ * to other objects, from the reverse graph of all object types
+ */
+class saireplay_ref_graph
+{
+    public:
+
+        saireplay_ref_graph();
+
+        void build();
+
+        bool is_ref(
+                _In_ const sai_attr_metadata_t *md) const;
+
+        const std::vector<const sai_struct_member_info_t*>& members(
+                _In_ sai_object_type_t object_type) const;
+
+    private:
+
+        std::unordered_set<const sai_attr_metadata_t*> m_attrs;
+
+        std::unordered_map<int, std::vector<const sai_struct_member_info_t*> > m_members;
+
+        std::vector<const sai_struct_member_info_t*> m_no_members;
+};
+
+saireplay_ref_graph::saireplay_ref_graph()
+{
+}
+
+void saireplay_ref_graph::build()
+{
+    m_attrs.clear();
+    m_members.clear();
+
+    std::unordered_set<const sai_struct_member_info_t*> members;
+
+    for (size_t idx = 1; sai_metadata_all_object_type_infos[idx] != NULL; idx++)
+    {
+        const sai_object_type_info_t *info = sai_metadata_all_object_type_infos[idx];
+
+        for (size_t i = 0; i < info->revgraphmemberscount; i++)
+        {
+            const sai_rev_graph_member_t *rm = info->revgraphmembers[i];
+
+            if (rm->attrmetadata != NULL)
+            {
+                m_attrs.insert(rm->attrmetadata);
+            }
+            else if (rm->structmember != NULL && rm->structmember->getoid != NULL && rm->structmember->setoid != NULL &&
+                    members.insert(rm->structmember).second)
+            {
+                m_members[rm->depobjecttype].push_back(rm->structmember);
+            }
+        }
+    }
+}
+
+bool saireplay_ref_graph::is_ref(
+        _In_ const sai_attr_metadata_t *md) const
+{
+    return m_attrs.find(md) != m_attrs.end();
+}
+
+const std::vector<const sai_struct_member_info_t*>& saireplay_ref_graph::members(
+        _In_ sai_object_type_t object_type) const
+{
+    auto it = m_members.find(object_type);
+
+    return (it == m_members.end()) ? m_no_members : it->second;
+}
+
+/**
+ * @brief One recorded call
+ */
+typedef struct _saireplay_record_t
+{
+    size_t line;
+
+    uint64_t ns;
+
+    char op;
+
+    sai_object_id_t switch_id;
+
+    sai_object_meta_key_t meta_key;
+
+    std::vector<sai_attribute_t> attrs;
+
+    sai_stats_mode_t mode;
+
+    std::vector<sai_stat_id_t> counters;
+
+    size_t phase;
+
+} saireplay_record_t;
+
+/**
+ * @brief Consecutive calls of the same operation on the same object type
+ */
+class saireplay_phase
+{
+    public:
+
+        saireplay_phase(
+                _In_ char op,
+                _In_ sai_object_type_t object_type,
+                _In_ uint64_t ns);
+
+        char m_op;
+
+        sai_object_type_t m_object_type;
+
+        size_t m_count;
+
+        uint64_t m_first_ns;
+
+        uint64_t m_last_ns;
+
+        /* replay times, relative to the start of the replay */
+
+        std::atomic<uint64_t> m_start;
+
+        std::atomic<uint64_t> m_end;
+
+        std::atomic<size_t> m_failed;
+};
+
+saireplay_phase::saireplay_phase(
+        _In_ char op,
+        _In_ sai_object_type_t object_type,
+        _In_ uint64_t ns):
+    m_op(op),
+    m_object_type(object_type),
+    m_count(0),
+    m_first_ns(ns),
+    m_last_ns(ns),
+    m_start(UINT64_MAX),
+    m_end(0),
+    m_failed(0)
+{
+}
+
+static const char* saireplay_op_name(
+        _In_ char op)
+{
+    switch (op)
+    {
+        case 'c': return "create";
+        case 'r': return "remove";
+        case 's': return "set";
+        case 'g': return "get";
+        case 't': return "get_stats";
+        case 'e': return "get_stats_ext";
+        case 'x': return "clear_stats";
+        default: return "?";
+    }
+}
+
+class saireplay
+{
+    public:
+
+        saireplay();
+
+        ~saireplay();
+
+        bool load(
+                _In_ const char *file_name);
+
+        bool initialize();
+
+        void run(
+                _In_ unsigned int jobs);
+
+        void report() const;
+
+        void uninitialize();
+
+        size_t failed() const;
+
+    private:
+
+        bool parse(
+                _In_ const std::string &text,
+                _Out_ saireplay_record_t &record,
+                _Out_ sai_status_t &status) const;
+
+        void release(
+                _Inout_ saireplay_record_t &record) const;
+
+        void build_dependencies();
+
+        void worker();
+
+        void replay(
+                _In_ size_t index);
+
+        sai_status_t execute(
+                _Inout_ saireplay_record_t &record);
+
+        bool translate(
+                _Inout_ sai_object_id_t &oid);
+
+        void map_oid(
+                _In_ sai_object_id_t recorded,
+                _In_ sai_object_id_t replayed);
+
+        void unmap_oid(
+                _In_ sai_object_id_t recorded);
+
+        std::vector<sai_object_id_t> returned_oids(
+                _Inout_ saireplay_record_t &record) const;
+
+        uint64_t now() const;
+
+    private:
+
+        saireplay_ref_graph m_refs;
+
+        sai_apis_t m_apis;
+
+        bool m_initialized;
+
+        std::vector<saireplay_record_t> m_records;
+
+        std::deque<saireplay_phase> m_phases;
+
+        size_t m_lines;
+
+        size_t m_skipped;
+
+        size_t m_unparsable;
+
+        /* recorded to replayed object ids */
+
+        std::mutex m_oids_mutex;
+
+        std::unordered_map<sai_object_id_t, sai_object_id_t> m_oids;
+
+        /* parallel replay: calls waiting on each call, and count of calls each waits for */
+
+        std::vector<std::vector<size_t> > m_dependents;
+
+        std::vector<uint32_t> m_pending;
+
+        std::mutex m_ready_mutex;
+
+        std::condition_variable m_ready_cv;
+
+        std::deque<size_t> m_ready;
+
+        size_t m_done;
+
+        std::mutex m_failures_mutex;
+
+        size_t m_failures_shown;
+
+        std::chrono::steady_clock::time_point m_start;
+
+        uint64_t m_duration_ns;
+};
+
+saireplay::saireplay():
+    m_initialized(false),
+    m_lines(0),
+    m_skipped(0),
+    m_unparsable(0),
+    m_done(0),
+    m_failures_shown(0),
+    m_duration_ns(0)
+{
+    memset(&m_apis, 0, sizeof(m_apis));
+}
+
+saireplay::~saireplay()
+{
+    for (auto &record: m_records)
+    {
+        release(record);
+    }
+}
+
+void saireplay::release(
+        _Inout_ saireplay_record_t &record) const
+{
+    for (auto &attr: record.attrs)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(record.meta_key.objecttype, attr.id);
+
+        if (md != NULL)
+        {
+            sai_free_attribute(md, &attr);
+        }
+    }
+
+    record.attrs.clear();
+}
+
+bool saireplay::parse(
+        _In_ const std::string &text,
+        _Out_ saireplay_record_t &record,
+        _Out_ sai_status_t &status) const
+{
+    const char *buf = text.c_str();
+
+    char *end;
+
+    record.ns = strtoull(buf, &end, 10);
+
+    if (end == buf || end[0] != '|' || end[1] == 0 || end[2] != '|')
+    {
+        return false;
+    }
+
+    record.op = end[1];
+
+    buf = end + 3;
+
+    status = (sai_status_t)strtol(buf, &end, 10);
+
+    if (end == buf || *end != '|')
+    {
+        return false;
+    }
+
+    buf = end + 1;
+
+    int len;
+
+    record.switch_id = SAI_NULL_OBJECT_ID;
+
+    if (record.op == 'c')
+    {
+        len = sai_deserialize_object_id(buf, &record.switch_id);
+
+        if (len < 0 || buf[len] != '|')
+        {
+            return false;
+        }
+
+        buf += len + 1;
+    }
+
+    memset(&record.meta_key, 0, sizeof(record.meta_key));
+
+    len = sai_deserialize_object_meta_key(buf, &record.meta_key);
+
+    if (len < 0 || sai_metadata_get_object_type_info(record.meta_key.objecttype) == NULL)
+    {
+        return false;
+    }
+
+    buf += len;
+
+    bool has_mode = false;
+
+    record.mode = SAI_STATS_MODE_READ;
+
+    while (*buf == '|')
+    {
+        buf++;
+
+        if (record.op == 'c' || record.op == 's' || record.op == 'g')
+        {
+            sai_attribute_t attr;
+
+            memset(&attr, 0, sizeof(attr));
+
+            len = sai_deserialize_attribute(buf, &attr);
+
+            if (len < 0)
+            {
+                return false;
+            }
+
+            record.attrs.push_back(attr);
+
+            buf += len;
+
+            continue;
+        }
+
+        if (record.op != 't' && record.op != 'e' && record.op != 'x')
+        {
+            return false;
+        }
+
+        unsigned long value = strtoul(buf, &end, 10);
+
+        if (end == buf)
+        {
+            return false;
+        }
+
+        buf = end;
+
+        if (record.op == 'e' && !has_mode)
+        {
+            record.mode = (sai_stats_mode_t)value;
+
+            has_mode = true;
+        }
+        else
+        {
+            record.counters.push_back((sai_stat_id_t)value);
+        }
+    }
+
+    if (*buf != 0)
+    {
+        return false;
+    }
+
+    switch (record.op)
+    {
+        case 's':
+            return record.attrs.size() == 1;
+
+        case 'e':
+            return has_mode;
+
+        case 'c':
+        case 'r':
+        case 'g':
+        case 't':
+        case 'x':
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+bool saireplay::load(
+        _In_ const char *file_name)
+{
+    std::ifstream file(file_name);
+
+    if (!file)
+    {
+        fprintf(stderr, "saireplay: failed to open %s\n", file_name);
+
+        return false;
+    }
+
+    m_refs.build();
+
+    std::string text;
+
+    while (std::getline(file, text))
+    {
+        m_lines++;
+
+        saireplay_record_t record;
+
+        sai_status_t status;
+
+        record.line = m_lines;
+
+        if (!parse(text, record, status))
+        {
+            if (m_unparsable++ < SAIREPLAY_FAILURES_SHOWN)
+            {
+                fprintf(stderr, "saireplay: %s:%zu: failed to parse\n", file_name, m_lines);
+            }
+
+            release(record);
+
+            continue;
+        }
+
+        if (status != SAI_STATUS_SUCCESS)
+        {
+            m_skipped++;
+
+            release(record);
+
+            continue;
+        }
+
+        for (auto &attr: record.attrs)
+        {
+            const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(record.meta_key.objecttype, attr.id);
+
+            if (md != NULL && md->attrvaluetype == SAI_ATTR_VALUE_TYPE_POINTER)
+            {
+                /* notification pointers of the recorded process */
+
+                attr.value.ptr = NULL;
+            }
+        }
+
+        if (m_phases.empty() || m_phases.back().m_op != record.op ||
+                m_phases.back().m_object_type != record.meta_key.objecttype)
+        {
+            m_phases.emplace_back(record.op, record.meta_key.objecttype, record.ns);
+        }
+
+        saireplay_phase &phase = m_phases.back();
+
+        phase.m_count++;
+        phase.m_last_ns = record.ns;
+
+        record.phase = m_phases.size() - 1;
+
+        m_records.push_back(std::move(record));
+    }
+
+    return true;
+}
+
+bool saireplay::initialize()
+{
+    sai_status_t status = sai_api_initialize(0, &g_services);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        fprintf(stderr, "saireplay: sai_api_initialize failed: %d\n", status);
+
+        return false;
+    }
+
+    m_initialized = true;
+
+    int failed = sai_metadata_apis_query(sai_api_query, &m_apis);
+
+    if (failed != 0)
+    {
+        fprintf(stderr, "saireplay: %d apis could not be queried\n", failed);
+    }
+
+    return true;
+}
+
+void saireplay::uninitialize()
+{
+    if (m_initialized)
+    {
+        sai_api_uninitialize();
+
+        m_initialized = false;
+    }
+}
+
+uint64_t saireplay::now() const
+{
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - m_start).count();
+}
+
+bool saireplay::translate(
+        _Inout_ sai_object_id_t &oid)
+{
+    if (oid == SAI_NULL_OBJECT_ID)
+    {
+        return true;
+    }
+
+    std::lock_guard<std::mutex> lock(m_oids_mutex);
+
+    auto it = m_oids.find(oid);
+
+    if (it == m_oids.end())
+    {
+        return false;
+    }
+
+    oid = it->second;
+
+    return true;
+}
+
+void saireplay::map_oid(
+        _In_ sai_object_id_t recorded,
+        _In_ sai_object_id_t replayed)
+{
+    std::lock_guard<std::mutex> lock(m_oids_mutex);
+
+    m_oids[recorded] = replayed;
+}
+
+void saireplay::unmap_oid(
+        _In_ sai_object_id_t recorded)
+{
+    std::lock_guard<std::mutex> lock(m_oids_mutex);
+
+    m_oids.erase(recorded);
+}
+
+std::vector<sai_object_id_t> saireplay::returned_oids(
+        _Inout_ saireplay_record_t &record) const
+{
+    std::vector<sai_object_id_t> oids;
+
+    for (auto &attr: record.attrs)
+    {
+        const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(record.meta_key.objecttype, attr.id);
+
+        if (md != NULL)
+        {
+            saireplay_for_each_oid(md, attr.value, [&](sai_object_id_t &oid) { oids.push_back(oid); });
+        }
+    }
+
+    return oids;
+}
+
+sai_status_t saireplay::execute(
+        _Inout_ saireplay_record_t &record)
+{
+    sai_object_meta_key_t meta_key = record.meta_key;
+
+    const sai_object_type_info_t *info = sai_metadata_get_object_type_info(meta_key.objecttype);
+
+    bool known = true;
+
+    if (info->isobjectid)
+    {
+        if (record.op != 'c')
+        {
+            known &= translate(meta_key.objectkey.key.object_id);
+        }
+    }
+    else
+    {
+        for (auto member: m_refs.members(meta_key.objecttype))
+        {
+            sai_object_id_t oid = member->getoid(&meta_key);
+
+            known &= translate(oid);
+
+            member->setoid(&meta_key, oid);
+        }
+    }
+
+    sai_object_id_t switch_id = record.switch_id;
+
+    known &= translate(switch_id);
+
+    if (record.op == 'c' || record.op == 's')
+    {
+        for (auto &attr: record.attrs)
+        {
+            const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(meta_key.objecttype, attr.id);
+
+            if (md != NULL && m_refs.is_ref(md))
+            {
+                saireplay_for_each_oid(md, attr.value, [&](sai_object_id_t &oid) { known &= translate(oid); });
+            }
+        }
+    }
+
+    if (!known)
+    {
+        return SAI_STATUS_INVALID_OBJECT_ID;
+    }
+
+    uint32_t attr_count = (uint32_t)record.attrs.size();
+
+    uint32_t counter_count = (uint32_t)record.counters.size();
+
+    std::vector<uint64_t> counters(record.counters.size());
+
+    sai_status_t status = SAI_STATUS_FAILURE;
+
+    switch (record.op)
+    {
+        case 'c':
+
+            status = sai_metadata_generic_create(&m_apis, &meta_key, switch_id, attr_count, record.attrs.data());
+
+            if (status == SAI_STATUS_SUCCESS && info->isobjectid)
+            {
+                map_oid(record.meta_key.objectkey.key.object_id, meta_key.objectkey.key.object_id);
+            }
+
+            break;
+
+        case 'r':
+
+            status = sai_metadata_generic_remove(&m_apis, &meta_key);
+
+            if (status == SAI_STATUS_SUCCESS && info->isobjectid)
+            {
+                unmap_oid(record.meta_key.objectkey.key.object_id);
+            }
+
+            break;
+
+        case 's':
+
+            status = sai_metadata_generic_set(&m_apis, &meta_key, record.attrs.data());
+
+            break;
+
+        case 'g':
+            {
+                /*
+                 * Object ids returned by the recorded get and by the replayed
+                 * one are matched in order, which is how objects created by
+                 * the switch itself get known.
+                 */
+
+                std::vector<sai_object_id_t> recorded = returned_oids(record);
+
+                status = sai_metadata_generic_get(&m_apis, &meta_key, attr_count, record.attrs.data());
+
+                if (status != SAI_STATUS_SUCCESS)
+                {
+                    break;
+                }
+
+                std::vector<sai_object_id_t> replayed = returned_oids(record);
+
+                if (recorded.size() != replayed.size())
+                {
+                    break;
+                }
+
+                std::lock_guard<std::mutex> lock(m_oids_mutex);
+
+                for (size_t idx = 0; idx < recorded.size(); idx++)
+                {
+                    m_oids.insert(std::make_pair(recorded[idx], replayed[idx]));
+                }
+            }
+
+            break;
+
+        case 't':
+
+            status = sai_metadata_generic_get_stats(&m_apis, &meta_key, counter_count, record.counters.data(), counters.data());
+
+            break;
+
+        case 'e':
+
+            status = sai_metadata_generic_get_stats_ext(&m_apis, &meta_key, counter_count, record.counters.data(), record.mode, counters.data());
+
+            break;
+
+        case 'x':
+
+            status = sai_metadata_generic_clear_stats(&m_apis, &meta_key, counter_count, record.counters.data());
+
+            break;
+
+        default:
+            break;
+    }
+
+    return status;
+}
+
+void saireplay::replay(
+        _In_ size_t index)
+{
+    saireplay_record_t &record = m_records[index];
+
+    saireplay_phase &phase = m_phases[record.phase];
+
+    uint64_t start = now();
+
+    sai_status_t status = execute(record);
+
+    uint64_t end = now();
+
+    uint64_t value = phase.m_start.load();
+
+    while (start < value && !phase.m_start.compare_exchange_weak(value, start))
+    {
+    }
+
+    value = phase.m_end.load();
+
+    while (end > value && !phase.m_end.compare_exchange_weak(value, end))
+    {
+    }
+
+    if (status == SAI_STATUS_SUCCESS)
+    {
+        return;
+    }
+
+    phase.m_failed++;
+
+    std::lock_guard<std::mutex> lock(m_failures_mutex);
+
+    if (m_failures_shown++ < SAIREPLAY_FAILURES_SHOWN)
+    {
+        const sai_object_type_info_t *info = sai_metadata_get_object_type_info(record.meta_key.objecttype);
+
+        fprintf(stderr, "saireplay: line %zu: %s %s failed: %d\n",
+                record.line, saireplay_op_name(record.op), info->objecttypename, status);
+    }
+}
+
+/*
+ * Every call reads or writes its own object and reads the objects it
+ * refers to through the reverse graph. A write waits for the previous
+ * write and all reads since, a read only for the previous write.
+ *
+ * A remove carries no attributes, and a set only the new value, so the
+ * object ids each object referenced through its create and set
+ * attributes are remembered: a remove reads all of them, a set the ones
+ * of the attribute it replaces. That keeps e.g. a parent's remove behind
+ * the removes of its members.
+ */
+void saireplay::build_dependencies()
+{
+    typedef struct _saireplay_access_t
+    {
+        bool written;
+
+        size_t writer;
+
+        std::vector<size_t> readers;
+
+        /* object ids referenced per attribute, by the last create or set */
+
+        std::map<sai_attr_id_t, std::vector<sai_object_id_t>> refs;
+
+    } saireplay_access_t;
+
+    std::unordered_map<std::string, saireplay_access_t> objects;
+
+    m_dependents.assign(m_records.size(), std::vector<size_t>());
+    m_pending.assign(m_records.size(), 0);
+
+    std::vector<size_t> deps;
+
+    for (size_t index = 0; index < m_records.size(); index++)
+    {
+        saireplay_record_t &record = m_records[index];
+
+        const sai_object_type_info_t *info = sai_metadata_get_object_type_info(record.meta_key.objecttype);
+
+        deps.clear();
+
+        auto access = [&](const std::string &object, bool write) {
+
+            saireplay_access_t &state = objects[object];
+
+            if (state.written)
+            {
+                deps.push_back(state.writer);
+            }
+
+            if (!write)
+            {
+                state.readers.push_back(index);
+
+                return;
+            }
+
+            deps.insert(deps.end(), state.readers.begin(), state.readers.end());
+
+            state.readers.clear();
+            state.written = true;
+            state.writer = index;
+        };
+
+        auto oid_object = [](sai_object_id_t oid) {
+
+            return std::string((const char*)&oid, sizeof(oid));
+        };
+
+        bool write = (record.op == 'c' || record.op == 'r' || record.op == 's' || record.op == 'x');
+
+        std::string self = info->isobjectid
+            ? oid_object(record.meta_key.objectkey.key.object_id)
+            : std::string((const char*)&record.meta_key, sizeof(record.meta_key));
+
+        access(self, write);
+
+        /* unordered_map keeps references to its elements across inserts */
+
+        auto &refs = objects[self].refs;
+
+        if (record.op == 'r')
+        {
+            for (auto &ref: refs)
+            {
+                for (auto oid: ref.second)
+                {
+                    access(oid_object(oid), false);
+                }
+            }
+
+            refs.clear();
+        }
+        else if (record.op == 'c')
+        {
+            refs.clear();
+        }
+
+        if (!info->isobjectid)
+        {
+            for (auto member: m_refs.members(record.meta_key.objecttype))
+            {
+                sai_object_id_t oid = member->getoid(&record.meta_key);
+
+                if (oid != SAI_NULL_OBJECT_ID)
+                {
+                    access(oid_object(oid), false);
+                }
+            }
+        }
+
+        if (record.switch_id != SAI_NULL_OBJECT_ID)
+        {
+            access(oid_object(record.switch_id), false);
+        }
+
+        for (auto &attr: record.attrs)
+        {
+            const sai_attr_metadata_t *md = sai_metadata_get_attr_metadata(record.meta_key.objecttype, attr.id);
+
+            if (md == NULL)
+            {
+                continue;
+            }
+
+            if (record.op == 'g')
+            {
+                /* a get may be what makes the returned object ids known */
+
+                saireplay_for_each_oid(md, attr.value, [&](sai_object_id_t &oid) { access(oid_object(oid), true); });
+            }
+            else if (m_refs.is_ref(md))
+            {
+                std::vector<sai_object_id_t> &oids = refs[attr.id];
+
+                if (record.op == 's')
+                {
+                    for (auto oid: oids)
+                    {
+                        access(oid_object(oid), false);
+                    }
+                }
+
+                if (record.op == 'c' || record.op == 's')
+                {
+                    oids.clear();
+                }
+
+                saireplay_for_each_oid(md, attr.value, [&](sai_object_id_t &oid) {
+
+                    access(oid_object(oid), false);
+
+                    if ((record.op == 'c' || record.op == 's') && oid != SAI_NULL_OBJECT_ID)
+                    {
+                        oids.push_back(oid);
+                    }
+                });
+            }
+        }
+
+        std::sort(deps.begin(), deps.end());
+
+        deps.erase(std::unique(deps.begin(), deps.end()), deps.end());
+
+        for (auto dep: deps)
+        {
+            if (dep != index)
+            {
+                m_dependents[dep].push_back(index);
+                m_pending[index]++;
+            }
+        }
+    }
+}
+
+void saireplay::worker()
+{
+    std::unique_lock<std::mutex> lock(m_ready_mutex);
+
+    while (true)
+    {
+        m_ready_cv.wait(lock, [&] { return !m_ready.empty() || m_done == m_records.size(); });
+
+        if (m_ready.empty())
+        {
+            return;
+        }
+
+        size_t index = m_ready.front();
+
+        m_ready.pop_front();
+
+        lock.unlock();
+
+        replay(index);
+
+        lock.lock();
+
+        m_done++;
+
+        for (auto dependent: m_dependents[index])
+        {
+            if (--m_pending[dependent] == 0)
+            {
+                m_ready.push_back(dependent);
+            }
+        }
+
+        if (!m_ready.empty() || m_done == m_records.size())
+        {
+            m_ready_cv.notify_all();
+        }
+    }
+}
+
+void saireplay::run(
+        _In_ unsigned int jobs)
+{
+    if (jobs > 1)
+    {
+        build_dependencies();
+
+        for (size_t index = 0; index < m_records.size(); index++)
+        {
+            if (m_pending[index] == 0)
+            {
+                m_ready.push_back(index);
+            }
+        }
+    }
+
+    m_start = std::chrono::steady_clock::now();
+
+    if (jobs <= 1)
+    {
+        for (size_t index = 0; index < m_records.size(); index++)
+        {
+            replay(index);
+        }
+    }
+    else
+    {
+        std::vector<std::thread> threads;
+
+        for (unsigned int job = 0; job < jobs; job++)
+        {
+            threads.emplace_back(&saireplay::worker, this);
+        }
+
+        for (auto &thread: threads)
+        {
+            thread.join();
+        }
+    }
+
+    m_duration_ns = now();
+}
+
+static void saireplay_print_rate(
+        _In_ size_t count,
+        _In_ uint64_t ns)
+{
+    if (ns == 0)
+    {
+        printf(" %12s", "-");
+    }
+    else
+    {
+        printf(" %12.0f", (double)count * 1e9 / (double)ns);
+    }
+}
+
+void saireplay::report() const
+{
+    printf("%5s %-13s %-40s %9s %7s %12s %12s\n",
+            "phase", "op", "object type", "calls", "failed", "recorded/s", "replayed/s");
+
+    size_t failed = 0;
+
+    for (size_t idx = 0; idx < m_phases.size(); idx++)
+    {
+        const saireplay_phase &phase = m_phases[idx];
+
+        const sai_object_type_info_t *info = sai_metadata_get_object_type_info(phase.m_object_type);
+
+        uint64_t start = phase.m_start.load();
+        uint64_t end = phase.m_end.load();
+
+        printf("%5zu %-13s %-40s %9zu %7zu", idx, saireplay_op_name(phase.m_op), info->objecttypename,
+                phase.m_count, phase.m_failed.load());
+
+        saireplay_print_rate(phase.m_count, phase.m_last_ns - phase.m_first_ns);
+        saireplay_print_rate(phase.m_count, (end > start) ? end - start : 0);
+
+        printf("\n");
+
+        failed += phase.m_failed.load();
+    }
+
+    printf("\n%zu lines, %zu calls replayed, %zu failed, %zu failed when recorded, %zu unparsable\n",
+            m_lines, m_records.size(), failed, m_skipped, m_unparsable);
+
+    printf("replayed in %.3f s,", (double)m_duration_ns / 1e9);
+
+    saireplay_print_rate(m_records.size(), m_duration_ns);
+
+    printf(" calls/s\n");
+}
+
+size_t saireplay::failed() const
+{
+    size_t failed = 0;
+
+    for (auto &phase: m_phases)
+    {
+        failed += phase.m_failed.load();
+    }
+
+    return failed;
+}
+
+static void saireplay_usage(void)
+{
+    fprintf(stderr, "usage: saireplay [-j jobs] [-p key=value]... recording\n\n");
+    fprintf(stderr, "    -j jobs        replay on jobs threads, in dependency order (default 1, in recorded order)\n");
+    fprintf(stderr, "    -p key=value   switch profile value, can be repeated\n");
+}
+
+int main(int argc, char **argv)
+{
+    unsigned int jobs = 1;
+
+    int opt;
+
+    while ((opt = getopt(argc, argv, "j:p:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'j':
+                jobs = (unsigned int)strtoul(optarg, NULL, 10);
+                break;
+
+            case 'p':
+                {
+                    const char *eq = strchr(optarg, '=');
+
+                    if (eq == NULL)
+                    {
+                        saireplay_usage();
+                        return 1;
+                    }
+
+                    g_profile[std::string(optarg, (size_t)(eq - optarg))] = eq + 1;
+                }
+
+                break;
+
+            default:
+                saireplay_usage();
+                return 1;
+        }
+    }
+
+    if (optind != argc - 1)
+    {
+        saireplay_usage();
+        return 1;
+    }
+
+    saireplay replay;
+
+    if (!replay.load(argv[optind]) || !replay.initialize())
+    {
+        return 1;
+    }
+
+    replay.run(jobs);
+
+    replay.report();
+
+    replay.uninitialize();
+
+    return replay.failed() ? 1 : 0;
+}
@@ -3326,3 +3326,36 @@ class SwitchDefaultVlanTest(SaiHelper):
                 self.client,
                 bv_id=self.default_vlan_id,
                 entry_type=SAI_FDB_ENTRY_TYPE_DYNAMIC)
+
+
+class ObjectsGetStatsRpcStatsTest(SaiHelper):
+    """
+    Verify that sai_thrift_objects_get_stats falling back to per object
+    reads, when bulk stats are not implemented (as in libsai), is not
+    counted as an RPC error. Needs the RPC server started with
+    SAI_THRIFT_RPC_STATS set, skipped otherwise.
+    """
+
+    def runTest(self):
+        counter_ids = [SAI_PORT_STAT_IF_IN_OCTETS, SAI_PORT_STAT_IF_OUT_OCTETS]
+        objects = [sai_thrift_object_stats_t(object_type=SAI_OBJECT_TYPE_PORT,
+                                             object_id=port,
+                                             counter_ids=counter_ids)
+                   for port in [self.port0, self.port1]]
+
+        self.client.sai_thrift_get_rpc_stats(True)
+
+        result = self.client.sai_thrift_objects_get_stats(objects)
+
+        self.assertEqual(len(result.counters), len(objects) * len(counter_ids))
+        self.assertEqual(result.statuses, [SAI_STATUS_SUCCESS] * len(objects))
+
+        rpc_stats = {stats.method: stats
+                     for stats in self.client.sai_thrift_get_rpc_stats(False)}
+
+        if not rpc_stats:
+            raise SkipTest('RPC stats are not enabled on the server')
+
+        stats = rpc_stats['sai_thrift_objects_get_stats']
+        self.assertEqual(stats.calls, 1)
+        self.assertEqual(stats.errors, 0)
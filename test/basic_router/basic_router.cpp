@@ -30,6 +30,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <unistd.h>
 #include <string.h>
 #include <arpa/inet.h>
@@ -46,6 +47,9 @@
 #include "neighbor_mgr.h"
 #include "route_mgr.h"
 #include "nexthopgrp_mgr.h"
+#include "reconcile_mgr.h"
+#include "route_loader.h"
+#include "route_pipeline.h"
 #include "nexthop_mgr.h"
 #include "fdb_mgr.h"
 #include "basic_router.h"
@@ -680,6 +684,8 @@ protected:
         neighbor_mgr = new NeighborMgr(nexthop_mgr);
         nexthopgrp_mgr = new NextHopGrpMgr(neighbor_mgr);
         route_mgr = new RouteMgr(neighbor_mgr, nexthopgrp_mgr);
+        neighbor_mgr->SetRouteMgr(route_mgr);
+        neighbor_mgr->SetNextHopGrpMgr(nexthopgrp_mgr);
         fdb_mgr = new FdbMgr();
 
 
@@ -883,9 +889,10 @@ static void route_removing()
     neighbor_mgr->Show();
 
     ipAddr = IpAddress("192.168.1.1");
-    ASSERT_TRUE(!neighbor_mgr->Del(ipAddr));
+    ASSERT_TRUE(neighbor_mgr->Del(ipAddr));
 
-    LOGG(TEST_INFO, TESTCASE, "*** expected failure to remove the neighbor 192.168.1.1 ***\n");
+    LOGG(TEST_INFO, TESTCASE, "*** the neighbor 192.168.1.1 left the ECMP group, the other nexthops stay ***\n");
+    ASSERT_EQ(2u, nexthopgrp_mgr->GetNextHopGrpEntry(IpAddresses("192.168.1.1,192.168.2.1,192.169.3.1"))->members.size());
 
     LOGG(TEST_INFO, TESTCASE, "--- remove route 192.0.0.0/8 with ECMP group, the last route use neighbor 192.168.1.1 ---\n");
     prefix = IpPrefix("192.0.0.0/8");
@@ -909,6 +916,606 @@ TEST_F(saiUnitTest, route_unittest)
     neighbor_mgr->Show();
 }
 
+static void route_batch_test()
+{
+    neighbor_adding();
+
+    IpPrefix prefix;
+    IpAddresses nexthops;
+
+    route_mgr->SetBatchThresholds(4, 1000);
+
+    LOGG(TEST_INFO, TESTCASE, "--- queue 3 routes, below the batch size ---\n");
+    nexthops = IpAddresses("192.168.1.1");
+    ASSERT_TRUE(route_mgr->AddBatch(IpPrefix("10.1.0.0/16"), nexthops));
+    ASSERT_TRUE(route_mgr->AddBatch(IpPrefix("10.2.0.0/16"), nexthops));
+    ASSERT_TRUE(route_mgr->AddBatch(IpPrefix("10.3.0.0/16"), nexthops));
+    ASSERT_EQ(3u, route_mgr->Pending());
+
+    LOGG(TEST_INFO, TESTCASE, "--- update a queued route, it stays a single entry ---\n");
+    nexthops = IpAddresses("172.16.20.22");
+    ASSERT_TRUE(route_mgr->AddBatch(IpPrefix("10.3.0.0/16"), nexthops));
+    ASSERT_EQ(3u, route_mgr->Pending());
+
+    LOGG(TEST_INFO, TESTCASE, "--- 4th route reaches the batch size and flushes ---\n");
+    nexthops = IpAddresses("0.0.0.0");
+    ASSERT_TRUE(route_mgr->AddBatch(IpPrefix("10.4.0.0/16"), nexthops));
+    ASSERT_EQ(0u, route_mgr->Pending());
+
+    route_mgr->Show();
+
+    LOGG(TEST_INFO, TESTCASE, "--- remove the routes in a batch ---\n");
+    ASSERT_TRUE(route_mgr->DelBatch(IpPrefix("10.1.0.0/16")));
+    ASSERT_TRUE(route_mgr->DelBatch(IpPrefix("10.2.0.0/16")));
+    ASSERT_TRUE(route_mgr->DelBatch(IpPrefix("10.3.0.0/16")));
+    ASSERT_TRUE(route_mgr->DelBatch(IpPrefix("10.4.0.0/16")));
+    ASSERT_TRUE(route_mgr->Flush());
+    ASSERT_EQ(0u, route_mgr->Pending());
+
+    route_mgr->Show();
+    route_mgr->SetBatchThresholds(ROUTE_BATCH_DEFAULT_SIZE, ROUTE_BATCH_DEFAULT_DELAY_MS);
+}
+
+TEST_F(saiUnitTest, route_batch_unittest)
+{
+    route_batch_test();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+static void route_fib_test()
+{
+    neighbor_adding();
+
+    IpPrefix matched;
+    const std::vector<IpAddress>* nexthops;
+    std::vector<IpPrefix> covered;
+
+    LOGG(TEST_INFO, TESTCASE, "--- add overlapping IPv4 and IPv6 routes ---\n");
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.0.0.0/8"), IpAddresses("192.168.1.1")));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.1.0.0/16"), IpAddresses("172.16.20.22")));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.1.2.0/24"), IpAddresses("0.0.0.0")));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("2001:db8::/32"), IpAddresses("0.0.0.0")));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("2001:db8:1::/48"), IpAddresses("0.0.0.0")));
+    ASSERT_TRUE(route_mgr->ValidateFib());
+
+    LOGG(TEST_INFO, TESTCASE, "--- host bits are cleared however a prefix is built ---\n");
+    ASSERT_TRUE(IpPrefix("10.1.2.1/24") == IpPrefix(IpAddress("10.1.2.1"), 24));
+    ASSERT_TRUE(IpPrefix("10.1.2.1/24") == IpPrefix("10.1.2.0/24"));
+    ASSERT_TRUE(IpPrefix("2001:db8:1::1/48") == IpPrefix(IpAddress("2001:db8:1::1"), 48));
+    ASSERT_EQ(1u, route_mgr->Routes().count(IpPrefix("10.1.2.1/24")));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.1.2.1/24"), IpAddresses("0.0.0.0")));
+    ASSERT_EQ(5u, route_mgr->Routes().size());
+    ASSERT_TRUE(route_mgr->ValidateFib());
+
+    LOGG(TEST_INFO, TESTCASE, "--- longest prefix match ---\n");
+    nexthops = route_mgr->Lookup(IpAddress("10.1.2.3"), &matched);
+    ASSERT_TRUE(nexthops != NULL);
+    ASSERT_TRUE(matched == IpPrefix("10.1.2.0/24"));
+
+    nexthops = route_mgr->Lookup(IpAddress("10.1.3.3"), &matched);
+    ASSERT_TRUE(nexthops != NULL);
+    ASSERT_TRUE(IpAddresses(*nexthops) == IpAddresses("172.16.20.22"));
+    ASSERT_TRUE(matched == IpPrefix("10.1.0.0/16"));
+
+    nexthops = route_mgr->Lookup(IpAddress("2001:db8:1:2::1"), &matched);
+    ASSERT_TRUE(nexthops != NULL);
+    ASSERT_TRUE(matched == IpPrefix("2001:db8:1::/48"));
+
+    ASSERT_TRUE(route_mgr->Lookup(IpAddress("11.0.0.1")) == NULL);
+    ASSERT_TRUE(route_mgr->Lookup(IpAddress("2001:db9::1")) == NULL);
+
+    LOGG(TEST_INFO, TESTCASE, "--- routes covered by a prefix ---\n");
+    route_mgr->CoveredRoutes(IpPrefix("10.1.0.0/16"), covered);
+    ASSERT_EQ(2u, covered.size());
+
+    covered.clear();
+    route_mgr->CoveredRoutes(IpPrefix("2001:db8::/16"), covered);
+    ASSERT_EQ(2u, covered.size());
+
+    LOGG(TEST_INFO, TESTCASE, "--- recursive nexthop resolution ---\n");
+    IpAddresses resolved;
+    ASSERT_TRUE(route_mgr->ResolveNextHops(IpAddresses("10.200.0.1"), resolved));
+    ASSERT_TRUE(resolved == IpAddresses("192.168.1.1"));
+
+    resolved = IpAddresses();
+    ASSERT_FALSE(route_mgr->ResolveNextHops(IpAddresses("10.1.2.1"), resolved));
+
+    LOGG(TEST_INFO, TESTCASE, "--- a removed route falls back to the covering one ---\n");
+    ASSERT_TRUE(route_mgr->Del(IpPrefix("10.1.2.0/24")));
+    ASSERT_TRUE(route_mgr->Lookup(IpAddress("10.1.2.3"), &matched) != NULL);
+    ASSERT_TRUE(matched == IpPrefix("10.1.0.0/16"));
+    ASSERT_TRUE(route_mgr->ValidateFib());
+
+    route_mgr->Show();
+}
+
+TEST_F(saiUnitTest, route_fib_unittest)
+{
+    route_fib_test();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_TRUE(route_mgr->ValidateFib());
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+static void route_ecmp_update_test()
+{
+    neighbor_adding();
+
+    IpAddresses nexthops2("192.168.2.1,192.169.3.1");
+    IpAddresses nexthops3("192.168.1.1,192.168.2.1,192.169.3.1");
+    const NextHopGrpEntry* nhgEntry;
+
+    LOGG(TEST_INFO, TESTCASE, "--- two routes share one ECMP group ---\n");
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.10.0.0/16"), nexthops2));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.20.0.0/16"), nexthops2));
+    ASSERT_TRUE((nhgEntry = nexthopgrp_mgr->GetNextHopGrpEntry(nexthops2)) != NULL);
+    ASSERT_EQ(2u, nhgEntry->members.size());
+
+    LOGG(TEST_INFO, TESTCASE, "--- a shared group is left alone ---\n");
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.20.0.0/16"), nexthops3));
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(nexthops2) != NULL);
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(nexthops3) != NULL);
+
+    LOGG(TEST_INFO, TESTCASE, "--- the last route releases the group ---\n");
+    ASSERT_TRUE(route_mgr->Del(IpPrefix("10.10.0.0/16")));
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(nexthops2) == NULL);
+
+    LOGG(TEST_INFO, TESTCASE, "--- dropping one nexthop edits the group in place ---\n");
+    sai_object_id_t nhg_id = nexthopgrp_mgr->GetNextHopGrpEntry(nexthops3)->nhg_id;
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.20.0.0/16"), nexthops2));
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(nexthops3) == NULL);
+    ASSERT_TRUE((nhgEntry = nexthopgrp_mgr->GetNextHopGrpEntry(nexthops2)) != NULL);
+    ASSERT_EQ(nhg_id, nhgEntry->nhg_id);
+    ASSERT_EQ(2u, nhgEntry->members.size());
+
+    LOGG(TEST_INFO, TESTCASE, "--- neighbor flap only touches the member ---\n");
+    ASSERT_TRUE(nexthopgrp_mgr->RemoveNextHop(IpAddress("192.168.2.1")));
+    ASSERT_EQ(1u, nexthopgrp_mgr->GetNextHopGrpEntry(nexthops2)->members.size());
+    ASSERT_TRUE(nexthopgrp_mgr->RestoreNextHop(IpAddress("192.168.2.1")));
+    ASSERT_EQ(2u, nexthopgrp_mgr->GetNextHopGrpEntry(nexthops2)->members.size());
+
+    LOGG(TEST_INFO, TESTCASE, "--- neighbor removed and added back under an ECMP route ---\n");
+    ASSERT_TRUE(neighbor_mgr->Del(IpAddress("192.168.2.1")));
+    ASSERT_TRUE((nhgEntry = nexthopgrp_mgr->GetNextHopGrpEntry(nexthops2)) != NULL);
+    ASSERT_EQ(1u, nhgEntry->members.size());
+    ASSERT_TRUE(nhgEntry->members.find(IpAddress("192.168.2.1")) == nhgEntry->members.end());
+
+    ASSERT_TRUE(neighbor_mgr->Add(IpAddress("192.168.2.1"), g_dst_mac[2], g_intfAlias[2], g_rif_id[2]));
+    ASSERT_TRUE((nhgEntry = nexthopgrp_mgr->GetNextHopGrpEntry(nexthops2)) != NULL);
+    ASSERT_EQ(2u, nhgEntry->members.size());
+
+    for (std::map<IpAddress, sai_object_id_t>::const_iterator it = nhgEntry->members.begin();
+         it != nhgEntry->members.end(); it++)
+    {
+        ASSERT_EQ(neighbor_mgr->GetNeighborEntry(it->first)->nhid, it->second);
+    }
+
+    route_mgr->ShowECMP();
+}
+
+TEST_F(saiUnitTest, route_ecmp_update_unittest)
+{
+    route_ecmp_update_test();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(IpAddresses("192.168.2.1,192.169.3.1")) == NULL);
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+#define RECONCILE_SNAPSHOT      "/tmp/basic_router_snapshot.txt"
+
+static void route_reconcile_test()
+{
+    std::map<std::string, sai_object_id_t> rifs;
+
+    for (unsigned int i = 0; i < g_testcount; i++)
+    {
+        rifs[g_intfAlias[i]] = g_rif_id[i];
+    }
+
+    ReconcileMgr reconcile_mgr(neighbor_mgr, route_mgr, rifs);
+    ReconcileStats stats;
+
+    neighbor_adding();
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.30.0.0/16"), IpAddresses("192.168.1.1")));
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.31.0.0/16"), IpAddresses("192.168.2.1,192.169.3.1")));
+
+    LOGG(TEST_INFO, TESTCASE, "--- the saved state reconciles to nothing ---\n");
+    ASSERT_TRUE(reconcile_mgr.Save(RECONCILE_SNAPSHOT));
+    ASSERT_TRUE(reconcile_mgr.Reconcile(RECONCILE_SNAPSHOT, stats));
+    ASSERT_EQ(0u, stats.neighborsAdded + stats.neighborsUpdated + stats.neighborsRemoved);
+    ASSERT_EQ(0u, stats.routesAdded + stats.routesUpdated + stats.routesRemoved);
+
+    LOGG(TEST_INFO, TESTCASE, "--- only the differences are applied ---\n");
+    ReconcileSnapshot desired;
+    ASSERT_TRUE(ReconcileMgr::Load(RECONCILE_SNAPSHOT, desired));
+
+    desired.routes.erase(IpPrefix("10.30.0.0/16"));
+    desired.routes[IpPrefix("10.31.0.0/16")] = IpAddresses("192.168.1.1,192.168.2.1");
+    desired.routes[IpPrefix("10.32.0.0/16")] = IpAddresses("172.16.20.22");
+    desired.neighbors.erase(IpAddress("24.58.202.118"));
+
+    ASSERT_TRUE(reconcile_mgr.Reconcile(desired, stats));
+    ASSERT_EQ(1u, stats.routesAdded);
+    ASSERT_EQ(1u, stats.routesUpdated);
+    ASSERT_EQ(1u, stats.routesRemoved);
+    ASSERT_EQ(1u, stats.neighborsRemoved);
+    ASSERT_TRUE(neighbor_mgr->GetNeighborEntry(IpAddress("24.58.202.118")) == NULL);
+    ASSERT_TRUE(route_mgr->ValidateFib());
+
+    LOGG(TEST_INFO, TESTCASE, "--- a neighbor in use by routes moves to another interface ---\n");
+    desired.neighbors[IpAddress("192.168.1.1")].intfAlias = g_intfAlias[3];
+
+    ASSERT_TRUE(reconcile_mgr.Reconcile(desired, stats));
+    ASSERT_EQ(1u, stats.neighborsUpdated);
+    ASSERT_EQ(0u, stats.routesAdded + stats.routesUpdated + stats.routesRemoved);
+    ASSERT_EQ(g_intfAlias[3], neighbor_mgr->GetNeighborEntry(IpAddress("192.168.1.1"))->intfAlias);
+    ASSERT_TRUE(route_mgr->Routes().count(IpPrefix("10.31.0.0/16")));
+    ASSERT_TRUE(route_mgr->ValidateFib());
+
+    const NextHopGrpEntry* nhgEntry = nexthopgrp_mgr->GetNextHopGrpEntry(IpAddresses("192.168.1.1,192.168.2.1"));
+    ASSERT_TRUE(nhgEntry != NULL);
+    ASSERT_EQ(2u, nhgEntry->members.size());
+    ASSERT_EQ(neighbor_mgr->GetNeighborEntry(IpAddress("192.168.1.1"))->nhid,
+              nhgEntry->members.at(IpAddress("192.168.1.1")));
+
+    LOGG(TEST_INFO, TESTCASE, "--- a route without any neighbor is parked, not added ---\n");
+    desired.routes[IpPrefix("10.33.0.0/16")] = IpAddresses("10.99.0.1");
+
+    ASSERT_TRUE(reconcile_mgr.Reconcile(desired, stats));
+    ASSERT_EQ(1u, stats.routesParked);
+    ASSERT_EQ(0u, stats.routesAdded + stats.routesUpdated + stats.routesRemoved);
+    ASSERT_EQ(1u, route_mgr->Parked());
+
+    ASSERT_TRUE(reconcile_mgr.Save(RECONCILE_SNAPSHOT));
+    ASSERT_TRUE(reconcile_mgr.Reconcile(RECONCILE_SNAPSHOT, stats));
+    ASSERT_EQ(1u, stats.routesParked);
+    ASSERT_EQ(0u, stats.routesAdded + stats.routesUpdated + stats.routesRemoved);
+
+    LOGG(TEST_INFO, TESTCASE, "--- a parked route no longer wanted is removed ---\n");
+    desired.routes.erase(IpPrefix("10.33.0.0/16"));
+
+    ASSERT_TRUE(reconcile_mgr.Reconcile(desired, stats));
+    ASSERT_EQ(0u, stats.routesParked);
+    ASSERT_EQ(1u, stats.routesRemoved);
+    ASSERT_EQ(0u, route_mgr->Parked());
+
+    route_mgr->Show();
+    remove(RECONCILE_SNAPSHOT);
+}
+
+TEST_F(saiUnitTest, route_reconcile_unittest)
+{
+    route_reconcile_test();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+#define ROUTE_SCALE_FILE        "/tmp/basic_router_routes.txt"
+#define ROUTE_SCALE_ROUTES      10000
+
+/*
+ * FIB scale benchmark. Set BASIC_ROUTER_ROUTE_FILE to load a route dump
+ * (nexthops must be among the neighbors neighbor_adding() creates),
+ * otherwise a synthetic mix of IPv4 and IPv6 routes is generated.
+ */
+static void route_scale_test()
+{
+    neighbor_adding();
+
+    const char* routeFile = getenv("BASIC_ROUTER_ROUTE_FILE");
+
+    if (!routeFile)
+    {
+        FILE* file = fopen(ROUTE_SCALE_FILE, "w");
+        ASSERT_TRUE(file != NULL);
+
+        for (unsigned int i = 0; i < ROUTE_SCALE_ROUTES; i++)
+        {
+            if (i % 4 == 3)
+            {
+                fprintf(file, "2001:db8:%x::/48 192.168.1.1,172.16.20.22\n", i);
+            }
+            else
+            {
+                fprintf(file, "20.%u.%u.0/24 %s\n", (i >> 8) & 0xff, i & 0xff,
+                        (i & 1) ? "192.168.1.1" : "192.168.2.1,192.169.3.1");
+            }
+        }
+
+        fclose(file);
+        routeFile = ROUTE_SCALE_FILE;
+    }
+
+    RouteLoader loader(route_mgr);
+    RouteLoadStats stats;
+    size_t batchSize;
+    unsigned int batchDelayMs;
+
+    route_mgr->SetBatchThresholds(16, 250);
+
+    ASSERT_TRUE(loader.Open(routeFile));
+    ASSERT_TRUE(loader.Load(ROUTE_LOADER_DEFAULT_BATCH, stats));
+    RouteLoader::Report(stats);
+
+    route_mgr->GetBatchThresholds(batchSize, batchDelayMs);
+    route_mgr->SetBatchThresholds(ROUTE_BATCH_DEFAULT_SIZE, ROUTE_BATCH_DEFAULT_DELAY_MS);
+    ASSERT_EQ(16u, batchSize);
+    ASSERT_EQ(250u, batchDelayMs);
+
+    ASSERT_EQ(stats.routes, route_mgr->Routes().size());
+    ASSERT_TRUE(route_mgr->ValidateFib());
+
+    if (routeFile == std::string(ROUTE_SCALE_FILE))
+    {
+        remove(ROUTE_SCALE_FILE);
+    }
+}
+
+TEST_F(saiUnitTest, route_scale_unittest)
+{
+    route_scale_test();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+#define ROUTE_PIPELINE_PRODUCERS    4
+#define ROUTE_PIPELINE_PREFIXES     256
+#define ROUTE_PIPELINE_FLAPS        20
+
+static void route_pipeline_producer(RoutePipeline* pipeline, int id)
+{
+    char prefix[32];
+
+    // every prefix flaps, then settles on the same nexthop
+    for (int flap = 0; flap < ROUTE_PIPELINE_FLAPS; flap++)
+    {
+        for (int i = 0; i < ROUTE_PIPELINE_PREFIXES; i++)
+        {
+            snprintf(prefix, sizeof(prefix), "30.%d.%d.0/24", id, i);
+
+            if (flap % 2)
+            {
+                pipeline->Del(IpPrefix(prefix));
+            }
+            else
+            {
+                pipeline->Add(IpPrefix(prefix), IpAddresses("192.168.2.1,192.169.3.1"));
+            }
+        }
+    }
+
+    for (int i = 0; i < ROUTE_PIPELINE_PREFIXES; i++)
+    {
+        snprintf(prefix, sizeof(prefix), "30.%d.%d.0/24", id, i);
+        pipeline->Add(IpPrefix(prefix), IpAddresses("192.168.1.1"));
+    }
+}
+
+static void route_pipeline_test()
+{
+    neighbor_adding();
+
+    RoutePipeline pipeline(route_mgr);
+    RoutePipelineStats stats;
+    std::vector<std::thread> producers;
+
+    LOGG(TEST_INFO, TESTCASE, "--- %d producers flapping %d prefixes each ---\n",
+         ROUTE_PIPELINE_PRODUCERS, ROUTE_PIPELINE_PREFIXES);
+
+    pipeline.Start();
+
+    for (int id = 0; id < ROUTE_PIPELINE_PRODUCERS; id++)
+    {
+        producers.push_back(std::thread(route_pipeline_producer, &pipeline, id));
+    }
+
+    for (size_t i = 0; i < producers.size(); i++)
+    {
+        producers[i].join();
+    }
+
+    pipeline.Drain();
+    pipeline.Stop();
+    pipeline.GetStats(stats);
+
+    LOGG(TEST_INFO, TESTCASE, "received %lu intents, %lu superseded, %lu applied in %lu batches\n",
+         stats.received, stats.superseded, stats.applied, stats.batches);
+
+    ASSERT_EQ(0u, stats.failed);
+    ASSERT_EQ(stats.received, stats.superseded + stats.applied);
+    ASSERT_EQ((size_t)ROUTE_PIPELINE_PRODUCERS * ROUTE_PIPELINE_PREFIXES, route_mgr->Routes().size());
+
+    const RouteTable& routes = route_mgr->Routes();
+
+    for (RouteTable::const_iterator it = routes.begin(); it != routes.end(); ++it)
+    {
+        ASSERT_TRUE(route_mgr->NextHops(it->second) == IpAddresses("192.168.1.1"));
+    }
+
+    LOGG(TEST_INFO, TESTCASE, "--- a neighbor coming up while the pipeline runs ---\n");
+    RoutePipeline resolver(route_mgr);
+
+    neighbor_mgr->SetRoutePipeline(&resolver);
+    resolver.Start();
+    resolver.Add(IpPrefix("31.0.0.0/16"), IpAddresses("192.168.5.1"));
+    resolver.Drain();
+    bool added = neighbor_mgr->Add(IpAddress("192.168.5.1"), g_dst_mac[0], g_intfAlias[0], g_rif_id[0]);
+    resolver.Drain();
+    resolver.Stop();
+    neighbor_mgr->SetRoutePipeline(NULL);
+    resolver.GetStats(stats);
+
+    ASSERT_TRUE(added);
+    ASSERT_EQ(2u, stats.applied);
+    ASSERT_EQ(0u, route_mgr->Parked());
+    ASSERT_EQ(1u, route_mgr->Routes().count(IpPrefix("31.0.0.0/16")));
+    ASSERT_TRUE(route_mgr->ValidateFib());
+
+    LOGG(TEST_INFO, TESTCASE, "--- the pipeline gives RouteMgr its own thresholds back ---\n");
+    size_t batchSize;
+    unsigned int batchDelayMs;
+
+    route_mgr->SetBatchThresholds(16, 250);
+    resolver.Start();
+    resolver.Stop();
+    route_mgr->GetBatchThresholds(batchSize, batchDelayMs);
+    route_mgr->SetBatchThresholds(ROUTE_BATCH_DEFAULT_SIZE, ROUTE_BATCH_DEFAULT_DELAY_MS);
+
+    ASSERT_EQ(16u, batchSize);
+    ASSERT_EQ(250u, batchDelayMs);
+}
+
+TEST_F(saiUnitTest, route_pipeline_unittest)
+{
+    route_pipeline_test();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+#define ROUTE_NEXTHOP_SET_PREFIXES  256
+
+static void route_nexthop_set_test()
+{
+    neighbor_adding();
+
+    size_t sets = route_mgr->NextHopSets();
+    char prefix[32];
+
+    LOGG(TEST_INFO, TESTCASE, "--- routes over two nexthop sets share two ids ---\n");
+    for (int i = 0; i < ROUTE_NEXTHOP_SET_PREFIXES; i++)
+    {
+        snprintf(prefix, sizeof(prefix), "10.40.%d.0/24", i);
+        ASSERT_TRUE(route_mgr->Add(IpPrefix(prefix),
+                    IpAddresses(i % 2 ? "192.169.3.1,192.168.2.1" : "192.168.1.1")));
+    }
+
+    ASSERT_EQ(sets + 2, route_mgr->NextHopSets());
+
+    const RouteTable& routes = route_mgr->Routes();
+    NextHopSetId ecmp = routes.at(IpPrefix("10.40.1.0/24"));
+
+    ASSERT_EQ(ecmp, routes.at(IpPrefix("10.40.255.0/24")));
+    ASSERT_NE(ecmp, routes.at(IpPrefix("10.40.0.0/24")));
+    ASSERT_TRUE(route_mgr->NextHops(ecmp) == IpAddresses("192.168.2.1,192.169.3.1"));
+
+    LOGG(TEST_INFO, TESTCASE, "--- the last route releases its set ---\n");
+    for (int i = 1; i < ROUTE_NEXTHOP_SET_PREFIXES; i += 2)
+    {
+        snprintf(prefix, sizeof(prefix), "10.40.%d.0/24", i);
+        ASSERT_TRUE(route_mgr->Del(IpPrefix(prefix)));
+    }
+
+    ASSERT_EQ(sets + 1, route_mgr->NextHopSets());
+    ASSERT_TRUE(nexthopgrp_mgr->GetNextHopGrpEntry(IpAddresses("192.168.2.1,192.169.3.1")) == NULL);
+    ASSERT_TRUE(route_mgr->ValidateFib());
+}
+
+TEST_F(saiUnitTest, route_nexthop_set_unittest)
+{
+    size_t sets = route_mgr->NextHopSets();
+
+    route_nexthop_set_test();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_EQ(sets, route_mgr->NextHopSets());
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+static void route_pending_resolution_test()
+{
+    neighbor_adding();
+
+    IpAddress pendingNh("192.168.5.1");
+    IpAddresses nexthops("192.168.1.1,192.168.5.1");
+    const NextHopGrpEntry* nhgEntry;
+
+    LOGG(TEST_INFO, TESTCASE, "--- a route without any neighbor is parked ---\n");
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.50.0.0/16"), IpAddresses("192.168.5.1")));
+    ASSERT_EQ(1u, route_mgr->Parked());
+    ASSERT_EQ(0u, route_mgr->Routes().count(IpPrefix("10.50.0.0/16")));
+
+    LOGG(TEST_INFO, TESTCASE, "--- an ECMP route starts with the resolved members ---\n");
+    ASSERT_TRUE(route_mgr->Add(IpPrefix("10.51.0.0/16"), nexthops));
+    ASSERT_TRUE((nhgEntry = nexthopgrp_mgr->GetNextHopGrpEntry(nexthops)) != NULL);
+    ASSERT_EQ(1u, nhgEntry->members.size());
+
+    LOGG(TEST_INFO, TESTCASE, "--- the neighbor coming up completes both ---\n");
+    ASSERT_TRUE(neighbor_mgr->Add(pendingNh, g_dst_mac[0], g_intfAlias[0], g_rif_id[0]));
+    ASSERT_EQ(0u, route_mgr->Parked());
+    ASSERT_EQ(1u, route_mgr->Routes().count(IpPrefix("10.50.0.0/16")));
+    ASSERT_EQ(2u, nexthopgrp_mgr->GetNextHopGrpEntry(nexthops)->members.size());
+    ASSERT_TRUE(route_mgr->ValidateFib());
+}
+
+TEST_F(saiUnitTest, route_pending_resolution_unittest)
+{
+    route_pending_resolution_test();
+
+    ASSERT_TRUE(route_mgr->EraseAll());
+    ASSERT_TRUE(neighbor_mgr->EraseAll());
+}
+
+#define FDB_SCALE_ENTRIES       65536
+#define FDB_SCALE_VLAN          (PANEL_PORT_VLAN_START + 1)
+
+static void fdb_scale_test()
+{
+    const FdbEntry* fdbEntry = fdb_mgr->GetFdbEntry(g_dst_mac[0], FDB_SCALE_VLAN);
+    ASSERT_TRUE(fdbEntry != NULL);
+
+    sai_object_id_t port_id = fdbEntry->port_id;
+    size_t base = fdb_mgr->Size();
+    std::vector<FdbEntry> entries(FDB_SCALE_ENTRIES);
+
+    for (unsigned int i = 0; i < FDB_SCALE_ENTRIES; i++)
+    {
+        uint8_t mac[6] = { 0x00, 0x44, 0x00, (uint8_t)(i >> 16), (uint8_t)(i >> 8), (uint8_t)i };
+
+        entries[i].macAddr = MacAddress(mac);
+        entries[i].vlan_id = FDB_SCALE_VLAN;
+        entries[i].type = SAI_FDB_ENTRY_STATIC;
+        entries[i].port_id = port_id;
+        entries[i].pkt_action = SAI_PACKET_ACTION_FORWARD;
+    }
+
+    LOGG(TEST_INFO, TESTCASE, "--- add %u fdb entries in one batch ---\n", FDB_SCALE_ENTRIES);
+    ASSERT_TRUE(fdb_mgr->AddBatch(entries));
+    ASSERT_EQ(base + FDB_SCALE_ENTRIES, fdb_mgr->Size());
+
+    LOGG(TEST_INFO, TESTCASE, "--- adding them again is a no-op ---\n");
+    ASSERT_TRUE(fdb_mgr->AddBatch(entries));
+    ASSERT_EQ(base + FDB_SCALE_ENTRIES, fdb_mgr->Size());
+
+    for (unsigned int i = 0; i < FDB_SCALE_ENTRIES; i += 4099)
+    {
+        ASSERT_TRUE(fdb_mgr->GetFdbEntry(entries[i].macAddr, FDB_SCALE_VLAN) != NULL);
+    }
+
+    LOGG(TEST_INFO, TESTCASE, "--- remove one, then flush the vlan ---\n");
+    ASSERT_TRUE(fdb_mgr->Del(entries[1].macAddr, FDB_SCALE_VLAN));
+    ASSERT_TRUE(fdb_mgr->GetFdbEntry(entries[1].macAddr, FDB_SCALE_VLAN) == NULL);
+
+    ASSERT_TRUE(fdb_mgr->FlushVlan(FDB_SCALE_VLAN));
+    ASSERT_TRUE(fdb_mgr->GetFdbEntry(g_dst_mac[0], FDB_SCALE_VLAN) == NULL);
+
+    // put back the entry basic_router_setup() created in that vlan
+    ASSERT_TRUE(fdb_mgr->Add(g_dst_mac[0], FDB_SCALE_VLAN, SAI_FDB_ENTRY_STATIC,
+                             port_id, SAI_PACKET_ACTION_FORWARD));
+    ASSERT_EQ(base, fdb_mgr->Size());
+}
+
+TEST_F(saiUnitTest, fdb_scale_unittest)
+{
+    fdb_scale_test();
+}
+
 static void tearup_tests(void)
 {
 
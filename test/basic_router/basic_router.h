@@ -26,4 +26,10 @@ extern "C" {
 #include "sai.h"
 }
 
+#include "ip.h"
+
 #define SAI_OID_TYPE_CHECK(oid, type)         (sai_object_type_query(oid) == type)
+
+// fill the SAI representation of an address or prefix, for either family
+void ToSaiIpAddress(const IpAddress& ip, sai_ip_address_t& sai_ip);
+void ToSaiIpPrefix(const IpPrefix& prefix, sai_ip_prefix_t& sai_prefix);
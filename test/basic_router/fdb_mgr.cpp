@@ -34,23 +34,234 @@
 #include <stdio.h>
 #include <string>
 #include <vector>
+#include <unordered_set>
 #include <arpa/inet.h>
 #include <string.h>
 
 extern sai_fdb_api_t* sai_fdb_api;
 
+FdbMgr::FdbMgr() :
+    m_Slots(FDB_TABLE_MIN_SLOTS, FDB_INDEX_NONE),
+    m_Size(0),
+    m_VlanHead(FDB_VLAN_COUNT, FDB_INDEX_NONE)
+{
+}
+
+uint64_t FdbMgr::PackKey(const MacAddress &macAddr, sai_uint32_t vlan_id)
+{
+    const uint8_t *mac = macAddr.to_bytes();
+    uint64_t key = 0;
+
+    for (int i = 0; i < 6; i++)
+    {
+        key = (key << 8) | mac[i];
+    }
+
+    return (key << 12) | (vlan_id & (FDB_VLAN_COUNT - 1));
+}
+
+size_t FdbMgr::HashKey(uint64_t key)
+{
+    // splitmix64 finalizer, spreads sequential macs over the whole table
+    key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    key = (key ^ (key >> 27)) * 0x94d049bb133111ebULL;
+
+    return (size_t)(key ^ (key >> 31));
+}
+
+void FdbMgr::FillSaiFdbEntry(const FdbEntry &fdbEntry, sai_fdb_entry_t &saifdbent)
+{
+    memset(&saifdbent, 0, sizeof(saifdbent));
+    memcpy(saifdbent.mac_address, fdbEntry.macAddr.to_bytes(), sizeof(sai_mac_t));
+    saifdbent.vlan_id = fdbEntry.vlan_id;
+}
+
+uint32_t FdbMgr::Find(uint64_t key) const
+{
+    size_t mask = m_Slots.size() - 1;
+
+    for (size_t slot = HashKey(key) & mask; ; slot = (slot + 1) & mask)
+    {
+        uint32_t idx = m_Slots[slot];
+
+        if (idx == FDB_INDEX_NONE || m_Nodes[idx].key == key)
+        {
+            return idx;
+        }
+    }
+}
+
+void FdbMgr::Rehash(size_t slots)
+{
+    size_t mask = slots - 1;
+
+    m_Slots.assign(slots, FDB_INDEX_NONE);
+
+    for (uint32_t idx = 0; idx < m_Nodes.size(); idx++)
+    {
+        if (!m_Nodes[idx].used)
+        {
+            continue;
+        }
+
+        size_t slot = HashKey(m_Nodes[idx].key) & mask;
+
+        while (m_Slots[slot] != FDB_INDEX_NONE)
+        {
+            slot = (slot + 1) & mask;
+        }
+
+        m_Slots[slot] = idx;
+    }
+}
+
+uint32_t FdbMgr::Insert(const FdbEntry &fdbEntry)
+{
+    // keep the load factor at or below 1/2
+    if (2 * (m_Size + 1) > m_Slots.size())
+    {
+        Rehash(2 * m_Slots.size());
+    }
+
+    uint32_t idx;
+
+    if (m_FreeNodes.empty())
+    {
+        idx = (uint32_t)m_Nodes.size();
+        m_Nodes.push_back(FdbNode());
+    }
+    else
+    {
+        idx = m_FreeNodes.back();
+        m_FreeNodes.pop_back();
+    }
+
+    FdbNode &node = m_Nodes[idx];
+    node.entry = fdbEntry;
+    node.key = PackKey(fdbEntry.macAddr, fdbEntry.vlan_id);
+    node.used = true;
+
+    size_t mask = m_Slots.size() - 1;
+    size_t slot = HashKey(node.key) & mask;
+
+    while (m_Slots[slot] != FDB_INDEX_NONE)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    m_Slots[slot] = idx;
+
+    // link at the head of the port and vlan lists
+    std::unordered_map<sai_object_id_t, uint32_t>::iterator itport = m_PortHead.find(fdbEntry.port_id);
+    uint32_t &vlanHead = m_VlanHead[fdbEntry.vlan_id & (FDB_VLAN_COUNT - 1)];
+
+    node.prevPort = FDB_INDEX_NONE;
+    node.nextPort = (itport == m_PortHead.end()) ? FDB_INDEX_NONE : itport->second;
+    node.prevVlan = FDB_INDEX_NONE;
+    node.nextVlan = vlanHead;
+
+    if (node.nextPort != FDB_INDEX_NONE)
+    {
+        m_Nodes[node.nextPort].prevPort = idx;
+    }
+
+    if (node.nextVlan != FDB_INDEX_NONE)
+    {
+        m_Nodes[node.nextVlan].prevVlan = idx;
+    }
+
+    m_PortHead[fdbEntry.port_id] = idx;
+    vlanHead = idx;
+
+    m_Size++;
+
+    return idx;
+}
+
+void FdbMgr::Erase(uint32_t idx)
+{
+    FdbNode &node = m_Nodes[idx];
+    size_t mask = m_Slots.size() - 1;
+    size_t slot = HashKey(node.key) & mask;
+
+    while (m_Slots[slot] != idx)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    // backward shift deletion, so lookups never need tombstones
+    size_t next = (slot + 1) & mask;
+
+    while (m_Slots[next] != FDB_INDEX_NONE)
+    {
+        size_t home = HashKey(m_Nodes[m_Slots[next]].key) & mask;
+
+        // move the entry back unless its home lies in (slot, next]
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            m_Slots[slot] = m_Slots[next];
+            slot = next;
+        }
+
+        next = (next + 1) & mask;
+    }
+
+    m_Slots[slot] = FDB_INDEX_NONE;
+
+    if (node.prevPort != FDB_INDEX_NONE)
+    {
+        m_Nodes[node.prevPort].nextPort = node.nextPort;
+    }
+    else if (node.nextPort != FDB_INDEX_NONE)
+    {
+        m_PortHead[node.entry.port_id] = node.nextPort;
+    }
+    else
+    {
+        m_PortHead.erase(node.entry.port_id);
+    }
+
+    if (node.nextPort != FDB_INDEX_NONE)
+    {
+        m_Nodes[node.nextPort].prevPort = node.prevPort;
+    }
+
+    if (node.prevVlan != FDB_INDEX_NONE)
+    {
+        m_Nodes[node.prevVlan].nextVlan = node.nextVlan;
+    }
+    else
+    {
+        m_VlanHead[node.entry.vlan_id & (FDB_VLAN_COUNT - 1)] = node.nextVlan;
+    }
+
+    if (node.nextVlan != FDB_INDEX_NONE)
+    {
+        m_Nodes[node.nextVlan].prevVlan = node.prevVlan;
+    }
+
+    node.used = false;
+    m_FreeNodes.push_back(idx);
+    m_Size--;
+}
+
 void FdbMgr::Show()
 {
     const FdbEntry* fdbEntry;
     MacAddress mac;
-    std::vector<FdbEntry>::iterator it;
+    std::vector<FdbNode>::iterator it;
 
     LOGG(TEST_DEBUG, FDB, "\t--- --- --- --- --- --- Fdb Entry Table --- --- --- --- --- --- \n");
     LOGG(TEST_DEBUG, FDB, "\t{%-20s %-10s} {%-10s %-14s %-10s}\n", "mac", "valn_id", "type", "port id", "pkt act");
 
-    for (it = m_FdbVector.begin(); it != m_FdbVector.end(); ++it)
+    for (it = m_Nodes.begin(); it != m_Nodes.end(); ++it)
     {
-        fdbEntry = &(*it);
+        if (!it->used)
+        {
+            continue;
+        }
+
+        fdbEntry = &it->entry;
         mac = fdbEntry->macAddr;
         LOGG(TEST_DEBUG, FDB, "\t{%-20s %-10hu} {%-10s 0x%-12lx %-10s}\n",
              mac.to_string().c_str(),
@@ -82,15 +293,11 @@ bool FdbMgr::Add( MacAddress macAddr,
     LOGG(TEST_INFO, FDB, "lookup fdb_entry {mac %-15s vlan_id %hu} \n",
          macAddr.to_string().c_str(), vlan_id);
 
-    for (std::vector<FdbEntry>::iterator it = m_FdbVector.begin();
-            it != m_FdbVector.end(); ++it)
+    if (Find(PackKey(macAddr, vlan_id)) != FDB_INDEX_NONE)
     {
-        if (it->macAddr == macAddr && it->vlan_id == vlan_id )
-        {
-            LOGG(TEST_DEBUG, FDB, "fdb_entry {mac %-15s vlan_id %hu} already exists\n",
-                 macAddr.to_string().c_str(), vlan_id);
-            return true;
-        }
+        LOGG(TEST_DEBUG, FDB, "fdb_entry {mac %-15s vlan_id %hu} already exists\n",
+             macAddr.to_string().c_str(), vlan_id);
+        return true;
     }
 
     sai_status_t status;
@@ -105,8 +312,7 @@ bool FdbMgr::Add( MacAddress macAddr,
     fdbattrs[2].id = SAI_FDB_ENTRY_ATTR_PACKET_ACTION;
     fdbattrs[2].value.s32 = pkt_action;
 
-    memcpy(saifdbent.mac_address, macAddr.to_bytes(), sizeof(sai_mac_t));
-    saifdbent.vlan_id = vlan_id;
+    FillSaiFdbEntry(fdbEntry, saifdbent);
 
     LOGG(TEST_INFO, FDB, "create sai_fdb_entry {mac %-15s vlan_id %hu}\n",
          macAddr.to_string().c_str(), saifdbent.vlan_id);
@@ -119,7 +325,7 @@ bool FdbMgr::Add( MacAddress macAddr,
         return false;
     }
 
-    m_FdbVector.push_back(fdbEntry);
+    Insert(fdbEntry);
 
     return true;
 }
@@ -130,18 +336,9 @@ bool FdbMgr::Del(MacAddress macAddr,
     sai_status_t status;
     sai_fdb_entry_t saifdbent;
 
+    uint32_t idx = Find(PackKey(macAddr, vlan_id));
 
-    std::vector<FdbEntry>::iterator it;
-
-    for (it = m_FdbVector.begin(); it != m_FdbVector.end(); ++it)
-    {
-        if ((it->macAddr == macAddr) && (it->vlan_id == vlan_id))
-        {
-            break;
-        }
-    }
-
-    if (it == m_FdbVector.end() )
+    if (idx == FDB_INDEX_NONE)
     {
         LOGG(TEST_DEBUG, FDB, "fdb_entry {mac %-15s vlan_id %hu} does not exist\n",
              macAddr.to_string().c_str(), vlan_id);
@@ -149,8 +346,7 @@ bool FdbMgr::Del(MacAddress macAddr,
         return true;
     }
 
-    memcpy(saifdbent.mac_address, macAddr.to_bytes(), sizeof(sai_mac_t));
-    saifdbent.vlan_id = it->vlan_id;
+    FillSaiFdbEntry(m_Nodes[idx].entry, saifdbent);
 
     LOGG(TEST_INFO, FDB, "remove sai_fdb_entry {mac %-15s vlan_id %hu}\n",
          macAddr.to_string().c_str(), saifdbent.vlan_id);
@@ -165,57 +361,177 @@ bool FdbMgr::Del(MacAddress macAddr,
         return false;
     }
 
-    m_FdbVector.erase(it);
+    Erase(idx);
 
     return true;
 }
 
 bool FdbMgr::EraseAll()
 {
-    sai_status_t status;
-    sai_fdb_entry_t saifdbent;
-    MacAddress macAddr;
+    std::vector<uint32_t> idxs;
+
+    for (uint32_t idx = 0; idx < m_Nodes.size(); idx++)
+    {
+        if (m_Nodes[idx].used)
+        {
+            idxs.push_back(idx);
+        }
+    }
+
+    return RemoveEntries(idxs);
+}
 
-    std::vector<FdbEntry>::const_iterator it;
+bool FdbMgr::FlushPort(sai_object_id_t port_id)
+{
+    std::vector<uint32_t> idxs;
+    std::unordered_map<sai_object_id_t, uint32_t>::const_iterator it = m_PortHead.find(port_id);
 
-    for (it = m_FdbVector.begin(); it != m_FdbVector.end(); it++)
+    if (it != m_PortHead.end())
     {
-        macAddr = it->macAddr;
-        memcpy(saifdbent.mac_address, macAddr.to_bytes(), sizeof(sai_mac_t));
-        saifdbent.vlan_id = it->vlan_id;
+        for (uint32_t idx = it->second; idx != FDB_INDEX_NONE; idx = m_Nodes[idx].nextPort)
+        {
+            idxs.push_back(idx);
+        }
+    }
 
-        LOGG(TEST_INFO, FDB, "remove sai_fdb_entry {mac %-15s vlan_id %hu}\n",
-             macAddr.to_string().c_str(), saifdbent.vlan_id);
+    LOGG(TEST_INFO, FDB, "flush %zu fdb entries on port 0x%lx\n", idxs.size(), port_id);
+
+    return RemoveEntries(idxs);
+}
+
+bool FdbMgr::FlushVlan(sai_uint32_t vlan_id)
+{
+    std::vector<uint32_t> idxs;
+
+    for (uint32_t idx = m_VlanHead[vlan_id & (FDB_VLAN_COUNT - 1)]; idx != FDB_INDEX_NONE; idx = m_Nodes[idx].nextVlan)
+    {
+        idxs.push_back(idx);
+    }
+
+    LOGG(TEST_INFO, FDB, "flush %zu fdb entries in vlan %u\n", idxs.size(), vlan_id);
+
+    return RemoveEntries(idxs);
+}
+
+bool FdbMgr::AddBatch(const std::vector<FdbEntry> &entries)
+{
+    std::vector<FdbEntry> pending;
+    std::unordered_set<uint64_t> keys;
 
-        status = sai_fdb_api->remove_fdb_entry(&saifdbent);
+    pending.reserve(entries.size());
 
-        if (status != SAI_STATUS_SUCCESS)
+    // skip entries already programmed, and repeats within the batch
+    for (size_t i = 0; i < entries.size(); i++)
+    {
+        uint64_t key = PackKey(entries[i].macAddr, entries[i].vlan_id);
+
+        if (Find(key) != FDB_INDEX_NONE || !keys.insert(key).second)
         {
-            LOGG(TEST_ERR, FDB, "fail to remove sai_fdb_entry {mac %-15s vlan_id %hu}\n",
-                 macAddr.to_string().c_str(), saifdbent.vlan_id);
-            return false;
+            continue;
         }
+
+        pending.push_back(entries[i]);
     }
 
-    m_FdbVector.clear();
-    return true;
+    return CreateEntries(pending);
 }
 
-const FdbEntry* FdbMgr::GetFdbEntry(const MacAddress &mac, const sai_uint32_t &vlan_id) const
+bool FdbMgr::CreateEntries(const std::vector<FdbEntry> &entries)
 {
-    std::vector<FdbEntry>::const_iterator it;
+    uint32_t count = (uint32_t)entries.size();
+
+    if (count == 0)
+    {
+        return true;
+    }
 
-    for (it = m_FdbVector.begin(); it != m_FdbVector.end(); ++it)
+    std::vector<sai_status_t> statuses(count, SAI_STATUS_SUCCESS);
+
+    LOGG(TEST_INFO, FDB, "sai_fdb_api->create_fdb_entry %u entries\n", count);
+
+    // the fdb api has no bulk create, the entries go in one by one
+    for (uint32_t i = 0; i < count; i++)
+    {
+        sai_fdb_entry_t saifdbent;
+        sai_attribute_t fdbattrs[3];
+
+        fdbattrs[0].id = SAI_FDB_ENTRY_ATTR_TYPE;
+        fdbattrs[0].value.s32 = entries[i].type;
+        fdbattrs[1].id = SAI_FDB_ENTRY_ATTR_PORT_ID;
+        fdbattrs[1].value.oid = entries[i].port_id;
+        fdbattrs[2].id = SAI_FDB_ENTRY_ATTR_PACKET_ACTION;
+        fdbattrs[2].value.s32 = entries[i].pkt_action;
+
+        FillSaiFdbEntry(entries[i], saifdbent);
+
+        statuses[i] = sai_fdb_api->create_fdb_entry(&saifdbent, 3, fdbattrs);
+    }
+
+    bool ok = true;
+
+    for (uint32_t i = 0; i < count; i++)
     {
-        if ((it->macAddr == mac) && (it->vlan_id == vlan_id))
+        if (statuses[i] != SAI_STATUS_SUCCESS)
         {
-            break;
+            MacAddress macAddr = entries[i].macAddr;
+            LOGG(TEST_ERR, FDB, "fail to create sai_fdb_entry {mac %-15s vlan_id %hu} rc=0x%x\n",
+                 macAddr.to_string().c_str(), entries[i].vlan_id, -statuses[i]);
+            ok = false;
+            continue;
         }
+
+        Insert(entries[i]);
     }
 
-    if (it != m_FdbVector.end())
+    return ok;
+}
+
+bool FdbMgr::RemoveEntries(const std::vector<uint32_t> &idxs)
+{
+    uint32_t count = (uint32_t)idxs.size();
+
+    if (count == 0)
+    {
+        return true;
+    }
+
+    std::vector<sai_fdb_entry_t> saifdbents(count);
+    std::vector<sai_status_t> statuses(count, SAI_STATUS_SUCCESS);
+
+    LOGG(TEST_INFO, FDB, "sai_fdb_api->remove_fdb_entry %u entries\n", count);
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        FillSaiFdbEntry(m_Nodes[idxs[i]].entry, saifdbents[i]);
+        statuses[i] = sai_fdb_api->remove_fdb_entry(&saifdbents[i]);
+    }
+
+    bool ok = true;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        if (statuses[i] != SAI_STATUS_SUCCESS)
+        {
+            MacAddress macAddr = m_Nodes[idxs[i]].entry.macAddr;
+            LOGG(TEST_ERR, FDB, "fail to remove sai_fdb_entry {mac %-15s vlan_id %hu} rc=0x%x\n",
+                 macAddr.to_string().c_str(), saifdbents[i].vlan_id, -statuses[i]);
+            ok = false;
+            continue;
+        }
+
+        Erase(idxs[i]);
+    }
+
+    return ok;
+}
+
+const FdbEntry* FdbMgr::GetFdbEntry(const MacAddress &mac, const sai_uint32_t &vlan_id) const
+{
+    uint32_t idx = Find(PackKey(mac, vlan_id));
+
+    if (idx != FDB_INDEX_NONE)
     {
-        return &(*it);
+        return &m_Nodes[idx].entry;
     }
     else
     {
@@ -22,6 +22,7 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <saitypes.h>
 #include <saifdb.h>
 
@@ -39,11 +40,50 @@ struct FdbEntry
     sai_int32_t pkt_action;
 };
 
+#define FDB_INDEX_NONE          0xFFFFFFFFu
+#define FDB_VLAN_COUNT          4096
+#define FDB_TABLE_MIN_SLOTS     1024
+
 class FdbMgr
 {
-    std::vector<FdbEntry> m_FdbVector;
+    /*
+     * Entries live in m_Nodes and are found through m_Slots, an open
+     * addressing (linear probing) table keyed on the packed mac48/vlan12.
+     * Each node is also linked into a list per port and per vlan, so a
+     * flush only walks the entries it removes.
+     */
+    struct FdbNode
+    {
+        FdbEntry entry;
+        uint64_t key;
+        uint32_t prevPort, nextPort;
+        uint32_t prevVlan, nextVlan;
+        bool used;
+    };
+
+    std::vector<FdbNode> m_Nodes;
+    std::vector<uint32_t> m_FreeNodes;
+    std::vector<uint32_t> m_Slots;
+    size_t m_Size;
+
+    std::unordered_map<sai_object_id_t, uint32_t> m_PortHead;
+    std::vector<uint32_t> m_VlanHead;
+
+    static uint64_t PackKey(const MacAddress &macAddr, sai_uint32_t vlan_id);
+    static size_t HashKey(uint64_t key);
+    static void FillSaiFdbEntry(const FdbEntry &fdbEntry, sai_fdb_entry_t &saifdbent);
+
+    uint32_t Find(uint64_t key) const;
+    uint32_t Insert(const FdbEntry &fdbEntry);
+    void Erase(uint32_t idx);
+    void Rehash(size_t slots);
+
+    bool CreateEntries(const std::vector<FdbEntry> &entries);
+    bool RemoveEntries(const std::vector<uint32_t> &idxs);
 
 public:
+    FdbMgr();
+
     bool Add(MacAddress macAddr,
              sai_uint32_t vlan_id,
              sai_int32_t type,
@@ -54,5 +94,17 @@ public:
     bool EraseAll();
     void Show();
 
+    /*
+     * Program all new entries in one pass, entries already in the table
+     * and repeats within the batch are skipped.
+     */
+    bool AddBatch(const std::vector<FdbEntry> &entries);
+
+    // remove every entry learnt on port_id or in vlan_id
+    bool FlushPort(sai_object_id_t port_id);
+    bool FlushVlan(sai_uint32_t vlan_id);
+
+    size_t Size() const { return m_Size; }
+
     const FdbEntry* GetFdbEntry(const MacAddress &, const sai_uint32_t &) const;
 };
@@ -24,20 +24,39 @@
 #include <stdexcept>
 
 #include "ip.h"
+#include "basic_router.h"
 
 IpAddress::IpAddress(const std::string &ipstr)
 {
-    if (inet_pton(AF_INET, ipstr.c_str(), &m_addr) != 1)
+    memset(m_bytes, 0, sizeof(m_bytes));
+
+    if (inet_pton(AF_INET, ipstr.c_str(), m_bytes) == 1)
+    {
+        m_v6 = false;
+    }
+    else if (inet_pton(AF_INET6, ipstr.c_str(), m_bytes) == 1)
+    {
+        m_v6 = true;
+    }
+    else
     {
         std::string errmsg = "cannot convert " + ipstr + " to ip address";
         throw std::invalid_argument(errmsg);
     }
 }
 
+IpAddress IpAddress::FromV6(const uint8_t *addr6)
+{
+    IpAddress ip;
+    memcpy(ip.m_bytes, addr6, IPV6_ADDR_LEN);
+    ip.m_v6 = true;
+    return ip;
+}
+
 const std::string IpAddress::to_string() const
 {
-    char str[INET_ADDRSTRLEN];
-    inet_ntop(AF_INET, &m_addr, str, INET_ADDRSTRLEN);
+    char str[INET6_ADDRSTRLEN];
+    inet_ntop(m_v6 ? AF_INET6 : AF_INET, m_bytes, str, INET6_ADDRSTRLEN);
     std::string addrstr(str);
     return addrstr;
 }
@@ -76,6 +95,11 @@ void IpAddresses::add(const std::string &ipstr)
     m_addrSet.insert(ip);
 }
 
+void IpAddresses::add(const IpAddress &ip)
+{
+    m_addrSet.insert(ip);
+}
+
 const std::string IpAddresses::to_string() const
 {
     std::string addrList;
@@ -116,27 +140,150 @@ IpPrefix::IpPrefix(
     std::string maskStr = prefix.substr(pos + 1);
     m_maskLen = std::stoi(maskStr);
 
-    if (m_maskLen < 0 || m_maskLen > 32)
+    if (m_maskLen < 0 || m_maskLen > m_addr.BitLen())
     {
         std::string errmsg = "cannot convert " + ipStr + " to ip prefix";
         throw std::invalid_argument(errmsg);
     }
 
-    m_mask = htonl(((uint64_t)0xFFFFFFFF << (32 - m_maskLen)) & 0xFFFFFFFF);
+    SetMask();
 }
 
-bool IpPrefix::operator<(const IpPrefix &o) const
+IpPrefix::IpPrefix(const IpAddress &addr, int maskLen)
 {
-    uint64_t addrmask = ((uint64_t)m_addr.addr()) << 32 | m_mask.addr();
-    uint64_t o_addrmask = ((uint64_t)o.m_addr.addr()) << 32 | o.m_mask.addr();
+    if (maskLen < 0 || maskLen > addr.BitLen())
+    {
+        std::string errmsg = "cannot convert " + addr.to_string() + " to ip prefix";
+        throw std::invalid_argument(errmsg);
+    }
 
-    if (addrmask < o_addrmask)
-        return true;
+    m_maskLen = maskLen;
+    m_addr = addr;
 
-    return false;
+    SetMask();
+}
+
+void IpPrefix::SetMask()
+{
+    uint8_t mask[IPV6_ADDR_LEN];
+
+    memset(mask, 0, sizeof(mask));
+
+    for (int i = 0; i < m_maskLen; i++)
+    {
+        mask[i / 8] = (uint8_t)(mask[i / 8] | (0x80 >> (i % 8)));
+    }
+
+    // keep the network part only, so a host address can be passed in
+    uint8_t bytes[IPV6_ADDR_LEN];
+
+    for (int i = 0; i < IPV6_ADDR_LEN; i++)
+    {
+        bytes[i] = (uint8_t)(m_addr.Bytes()[i] & mask[i]);
+    }
+
+    if (m_addr.IsV4())
+    {
+        uint32_t mask4, addr4;
+        memcpy(&mask4, mask, IPV4_ADDR_LEN);
+        memcpy(&addr4, bytes, IPV4_ADDR_LEN);
+        m_mask = IpAddress(mask4);
+        m_addr = IpAddress(addr4);
+    }
+    else
+    {
+        m_mask = IpAddress::FromV6(mask);
+        m_addr = IpAddress::FromV6(bytes);
+    }
+}
+
+bool IpPrefix::Contains(const IpAddress &addr) const
+{
+    if (addr.IsV4() != m_addr.IsV4())
+    {
+        return false;
+    }
+
+    const uint8_t *a = addr.Bytes();
+    const uint8_t *p = m_addr.Bytes();
+    const uint8_t *m = m_mask.Bytes();
+
+    for (int i = 0; i < m_addr.Len(); i++)
+    {
+        if ((a[i] & m[i]) != (p[i] & m[i]))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool IpPrefix::Contains(const IpPrefix &prefix) const
+{
+    return prefix.m_maskLen >= m_maskLen && Contains(prefix.m_addr);
+}
+
+bool IpPrefix::operator<(const IpPrefix &o) const
+{
+    if (m_addr != o.m_addr)
+    {
+        return m_addr < o.m_addr;
+    }
+
+    return m_maskLen < o.m_maskLen;
 }
 
 const std::string IpPrefix::to_string() const
 {
-    return (m_addr.to_string() + "/" + m_mask.to_string());
+    if (m_addr.IsV4())
+    {
+        return (m_addr.to_string() + "/" + m_mask.to_string());
+    }
+
+    return (m_addr.to_string() + "/" + std::to_string(m_maskLen));
+}
+
+void ToSaiIpAddress(const IpAddress& ip, sai_ip_address_t& sai_ip)
+{
+    memset(&sai_ip, 0, sizeof(sai_ip));
+
+    if (ip.IsV4())
+    {
+        sai_ip.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        sai_ip.addr.ip4 = ip.addr();
+    }
+    else
+    {
+        sai_ip.addr_family = SAI_IP_ADDR_FAMILY_IPV6;
+        memcpy(sai_ip.addr.ip6, ip.Bytes(), IPV6_ADDR_LEN);
+    }
+}
+
+void ToSaiIpPrefix(const IpPrefix& prefix, sai_ip_prefix_t& sai_prefix)
+{
+    // Addr() and Mask() return copies, keep them alive while reading the bytes
+    const IpAddress ipAddr = prefix.Addr();
+    const IpAddress ipMask = prefix.Mask();
+    const uint8_t *addr = ipAddr.Bytes();
+    const uint8_t *mask = ipMask.Bytes();
+
+    memset(&sai_prefix, 0, sizeof(sai_prefix));
+
+    if (prefix.IsV4())
+    {
+        sai_prefix.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+        sai_prefix.addr.ip4 = prefix.Addr().addr() & prefix.Mask().addr();
+        sai_prefix.mask.ip4 = prefix.Mask().addr();
+    }
+    else
+    {
+        sai_prefix.addr_family = SAI_IP_ADDR_FAMILY_IPV6;
+
+        for (int i = 0; i < IPV6_ADDR_LEN; i++)
+        {
+            sai_prefix.addr.ip6[i] = (uint8_t)(addr[i] & mask[i]);
+            sai_prefix.mask.ip6[i] = mask[i];
+        }
+    }
 }
@@ -22,40 +22,86 @@
 #pragma once
 
 #include <stdint.h>
+#include <string.h>
 #include <string>
 #include <set>
+#include <vector>
 #include "log.h"
 
+#define IPV4_ADDR_LEN   4
+#define IPV6_ADDR_LEN   16
+
 class IpAddress
 {
 public:
-    IpAddress() : m_addr(0) {}
-    IpAddress(uint32_t addr)
+    IpAddress() : m_v6(false)
+    {
+        memset(m_bytes, 0, sizeof(m_bytes));
+    }
+    IpAddress(uint32_t addr) : m_v6(false)
     {
-        m_addr = addr;
+        memset(m_bytes, 0, sizeof(m_bytes));
+        memcpy(m_bytes, &addr, IPV4_ADDR_LEN);
     }
     IpAddress(const std::string &ipstr);
 
-    // the address is in network order
+    // addr6 is 16 bytes in network order
+    static IpAddress FromV6(const uint8_t *addr6);
+
+    bool IsV4() const
+    {
+        return !m_v6;
+    }
+
+    // the address is in network order, IPv4 only
     uint32_t addr() const
     {
-        return m_addr;
+        uint32_t addr;
+        memcpy(&addr, m_bytes, IPV4_ADDR_LEN);
+        return addr;
+    }
+
+    // address bytes in network order, Len() of them are valid
+    const uint8_t *Bytes() const
+    {
+        return m_bytes;
+    }
+
+    int Len() const
+    {
+        return m_v6 ? IPV6_ADDR_LEN : IPV4_ADDR_LEN;
+    }
+
+    int BitLen() const
+    {
+        return 8 * Len();
     }
 
     bool operator<(const IpAddress &o) const
     {
-        return (m_addr < o.m_addr);
+        if (m_v6 != o.m_v6)
+        {
+            return !m_v6;
+        }
+
+        return memcmp(m_bytes, o.m_bytes, Len()) < 0;
     }
 
     bool operator==(const IpAddress &o) const
     {
-        return (m_addr == o.m_addr);
+        return m_v6 == o.m_v6 && memcmp(m_bytes, o.m_bytes, Len()) == 0;
+    }
+
+    bool operator!=(const IpAddress &o) const
+    {
+        return !(*this == o);
     }
 
     const std::string to_string() const;
 
 private:
-    uint32_t m_addr;
+    uint8_t m_bytes[IPV6_ADDR_LEN];
+    bool m_v6;
 };
 
 class IpAddresses
@@ -66,7 +112,11 @@ public:
     // ipStrList is a list IPs separated by ","
     IpAddresses(const std::string &ipstrList);
 
+    // addrs in ascending order, as kept by NextHopSetTable
+    explicit IpAddresses(const std::vector<IpAddress> &addrs) : m_addrSet(addrs.begin(), addrs.end()) {}
+
     void add(const std::string &ipstr);
+    void add(const IpAddress &ip);
 
     bool operator<(const IpAddresses &o) const;
 
@@ -103,8 +153,16 @@ public:
 
     IpPrefix(const std::string &);
 
+    // host bits of addr are cleared
+    IpPrefix(const IpAddress &addr, int maskLen);
+
     const std::string to_string() const;
 
+    bool IsV4() const
+    {
+        return m_addr.IsV4();
+    }
+
     IpAddress Addr() const
     {
         return m_addr;
@@ -120,11 +178,12 @@ public:
         return m_maskLen;
     }
 
+    // saturates at 2^31 for IPv6 prefixes
     uint32_t SubnetSize() const
     {
         uint32_t i = 1;
 
-        for (int j = 0; j < 32 - m_maskLen; ++j)
+        for (int j = 0; j < m_addr.BitLen() - m_maskLen && j < 31; ++j)
         {
             i *= 2;
         }
@@ -132,11 +191,22 @@ public:
         return i;
     }
 
+    // the address or prefix falls into this prefix
+    bool Contains(const IpAddress &addr) const;
+    bool Contains(const IpPrefix &prefix) const;
+
     bool operator<(const IpPrefix &o) const;
 
+    bool operator==(const IpPrefix &o) const
+    {
+        return m_addr == o.m_addr && m_maskLen == o.m_maskLen;
+    }
+
 private:
+    // build m_mask from m_maskLen and clear the host bits of m_addr
+    void SetMask();
+
     IpAddress m_addr;
     IpAddress m_mask;
     int m_maskLen;
 };
-
@@ -42,6 +42,7 @@
 #define NXTHG           "NEXTHOPGRP"
 #define NEXTHOP         "NEXTHOP"
 #define FDB             "FDB"
+#define RECONCILE       "RECONCILE"
 
 extern void LOGG(int priority, const char* title, const char* format, ...);
 extern int curr_log_level;
@@ -0,0 +1,389 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+/*
+ * Path-compressed binary trie for longest prefix match over N byte keys
+ * (N = 4 for IPv4, 16 for IPv6).
+ *
+ * Nodes live in a single vector and link to each other by 32-bit index,
+ * index 0 is the root (the zero length prefix). Only nodes which carry a
+ * value or branch to two children are kept, so the trie never has more
+ * than 2 * Size() + 1 nodes. Freed nodes are recycled through a free list.
+ */
+template <size_t N, typename V>
+class LpmTrie
+{
+    struct Node
+    {
+        uint32_t child[2];
+        V value;
+        uint8_t key[N];
+        uint8_t len;
+        bool hasValue;
+    };
+
+    std::vector<Node> m_nodes;
+    std::vector<uint32_t> m_free;
+    size_t m_size;
+
+    static int GetBit(const uint8_t *key, int bit)
+    {
+        return (key[bit / 8] >> (7 - bit % 8)) & 1;
+    }
+
+    // number of leading bits a and b have in common, at most maxLen
+    static int CommonLen(const uint8_t *a, const uint8_t *b, int maxLen)
+    {
+        int len = 0;
+
+        for (size_t i = 0; i < N && len < maxLen; i++, len += 8)
+        {
+            uint8_t diff = (uint8_t)(a[i] ^ b[i]);
+
+            if (diff)
+            {
+                len += __builtin_clz(diff) - 24;
+                break;
+            }
+        }
+
+        return len < maxLen ? len : maxLen;
+    }
+
+    uint32_t NewNode(const uint8_t *key, int len)
+    {
+        uint32_t idx;
+
+        if (m_free.empty())
+        {
+            idx = (uint32_t)m_nodes.size();
+            m_nodes.push_back(Node());
+        }
+        else
+        {
+            idx = m_free.back();
+            m_free.pop_back();
+        }
+
+        Node &node = m_nodes[idx];
+        node.child[0] = node.child[1] = 0;
+        node.value = V();
+        node.len = (uint8_t)len;
+        node.hasValue = false;
+
+        // keep only the prefix bits, so keys compare equal bit for bit
+        memset(node.key, 0, N);
+        memcpy(node.key, key, (len + 7) / 8);
+
+        if (len % 8)
+        {
+            node.key[len / 8] = (uint8_t)(node.key[len / 8] & (0xFF << (8 - len % 8)));
+        }
+
+        return idx;
+    }
+
+    void FreeNode(uint32_t idx)
+    {
+        m_nodes[idx].hasValue = false;
+        m_nodes[idx].value = V();
+        m_free.push_back(idx);
+    }
+
+    // exact match, fills the path from the root when requested
+    uint32_t FindNode(const uint8_t *key, int len, std::vector<uint32_t> *path) const
+    {
+        uint32_t idx = 0;
+
+        while (true)
+        {
+            const Node &node = m_nodes[idx];
+
+            if (node.len == len)
+            {
+                return idx;
+            }
+
+            if (path)
+            {
+                path->push_back(idx);
+            }
+
+            uint32_t c = node.child[GetBit(key, node.len)];
+
+            if (!c || m_nodes[c].len > len ||
+                    CommonLen(key, m_nodes[c].key, m_nodes[c].len) < m_nodes[c].len)
+            {
+                return 0;
+            }
+
+            idx = c;
+        }
+    }
+
+public:
+    LpmTrie() : m_size(0)
+    {
+        uint8_t zero[N] = {0};
+        NewNode(zero, 0);
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+    size_t NodeCount() const
+    {
+        return m_nodes.size() - m_free.size();
+    }
+
+    size_t MemoryUsage() const
+    {
+        return m_nodes.capacity() * sizeof(Node) + m_free.capacity() * sizeof(uint32_t);
+    }
+
+    void Clear()
+    {
+        uint8_t zero[N] = {0};
+
+        m_nodes.clear();
+        m_free.clear();
+        m_size = 0;
+        NewNode(zero, 0);
+    }
+
+    // insert or replace, returns false when the prefix was already present
+    bool Insert(const uint8_t *key, int len, const V &value)
+    {
+        uint32_t idx = 0;
+
+        while (true)
+        {
+            if (m_nodes[idx].len == len)
+            {
+                bool existed = m_nodes[idx].hasValue;
+                m_nodes[idx].value = value;
+                m_nodes[idx].hasValue = true;
+                m_size += existed ? 0 : 1;
+                return !existed;
+            }
+
+            int bit = GetBit(key, m_nodes[idx].len);
+            uint32_t c = m_nodes[idx].child[bit];
+
+            if (!c)
+            {
+                uint32_t leaf = NewNode(key, len);
+                m_nodes[leaf].value = value;
+                m_nodes[leaf].hasValue = true;
+                m_nodes[idx].child[bit] = leaf;
+                m_size++;
+                return true;
+            }
+
+            int clen = m_nodes[c].len;
+            int common = CommonLen(key, m_nodes[c].key, len < clen ? len : clen);
+
+            if (common == clen)
+            {
+                idx = c;
+                continue;
+            }
+
+            // the new prefix sits above c, or both hang off a new branch node
+            uint32_t n = NewNode(key, common);
+            m_nodes[n].child[GetBit(m_nodes[c].key, common)] = c;
+
+            if (common == len)
+            {
+                m_nodes[n].value = value;
+                m_nodes[n].hasValue = true;
+            }
+            else
+            {
+                uint32_t leaf = NewNode(key, len);
+                m_nodes[leaf].value = value;
+                m_nodes[leaf].hasValue = true;
+                m_nodes[n].child[GetBit(key, common)] = leaf;
+            }
+
+            m_nodes[idx].child[bit] = n;
+            m_size++;
+            return true;
+        }
+    }
+
+    // returns false when the prefix was not present
+    bool Remove(const uint8_t *key, int len)
+    {
+        std::vector<uint32_t> path;
+        uint32_t idx = FindNode(key, len, &path);
+
+        if (!m_nodes[idx].hasValue || m_nodes[idx].len != len || (idx == 0 && len != 0))
+        {
+            return false;
+        }
+
+        m_nodes[idx].hasValue = false;
+        m_nodes[idx].value = V();
+        m_size--;
+
+        // splice out nodes which no longer carry a value nor branch
+        while (idx != 0)
+        {
+            Node &node = m_nodes[idx];
+
+            if (node.hasValue || (node.child[0] && node.child[1]))
+            {
+                break;
+            }
+
+            uint32_t parent = path.back();
+            path.pop_back();
+
+            uint32_t only = node.child[0] ? node.child[0] : node.child[1];
+            int bit = m_nodes[parent].child[0] == idx ? 0 : 1;
+
+            m_nodes[parent].child[bit] = only;
+            FreeNode(idx);
+
+            if (only)
+            {
+                break;
+            }
+
+            idx = parent;
+        }
+
+        return true;
+    }
+
+    const V *Find(const uint8_t *key, int len) const
+    {
+        uint32_t idx = FindNode(key, len, NULL);
+
+        if (m_nodes[idx].len != len || !m_nodes[idx].hasValue)
+        {
+            return NULL;
+        }
+
+        return &m_nodes[idx].value;
+    }
+
+    // longest prefix covering the first len bits of key, matchLen gets its length
+    const V *Lookup(const uint8_t *key, int len, int *matchLen = NULL) const
+    {
+        uint32_t idx = 0;
+        uint32_t best = m_nodes[0].hasValue ? 0 : UINT32_MAX;
+
+        while (m_nodes[idx].len < len)
+        {
+            uint32_t c = m_nodes[idx].child[GetBit(key, m_nodes[idx].len)];
+
+            if (!c || m_nodes[c].len > len ||
+                    CommonLen(key, m_nodes[c].key, m_nodes[c].len) < m_nodes[c].len)
+            {
+                break;
+            }
+
+            idx = c;
+
+            if (m_nodes[idx].hasValue)
+            {
+                best = idx;
+            }
+        }
+
+        if (best == UINT32_MAX)
+        {
+            return NULL;
+        }
+
+        if (matchLen)
+        {
+            *matchLen = m_nodes[best].len;
+        }
+
+        return &m_nodes[best].value;
+    }
+
+    // call f(key, len, value) for every prefix covered by key/len, itself included
+    template <typename F>
+    void ForEachCovered(const uint8_t *key, int len, F f) const
+    {
+        uint32_t idx = 0;
+
+        while (m_nodes[idx].len < len)
+        {
+            uint32_t c = m_nodes[idx].child[GetBit(key, m_nodes[idx].len)];
+
+            if (!c)
+            {
+                return;
+            }
+
+            int clen = m_nodes[c].len;
+            int cmp = len < clen ? len : clen;
+
+            if (CommonLen(key, m_nodes[c].key, cmp) < cmp)
+            {
+                return;
+            }
+
+            idx = c;
+        }
+
+        std::vector<uint32_t> stack(1, idx);
+
+        while (!stack.empty())
+        {
+            const Node &node = m_nodes[stack.back()];
+            stack.pop_back();
+
+            if (node.hasValue)
+            {
+                f(node.key, (int)node.len, node.value);
+            }
+
+            for (int i = 1; i >= 0; i--)
+            {
+                if (node.child[i])
+                {
+                    stack.push_back(node.child[i]);
+                }
+            }
+        }
+    }
+
+    template <typename F>
+    void ForEach(F f) const
+    {
+        uint8_t zero[N] = {0};
+        ForEachCovered(zero, 0, f);
+    }
+};
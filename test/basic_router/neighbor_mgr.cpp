@@ -21,6 +21,9 @@
  */
 #include "nexthop_mgr.h"
 #include "neighbor_mgr.h"
+#include "nexthopgrp_mgr.h"
+#include "route_mgr.h"
+#include "route_pipeline.h"
 #include "ip.h"
 #include <saistatus.h>
 #include <saineighbor.h>
@@ -40,7 +43,7 @@
 extern sai_neighbor_api_t* sai_neighbor_api;
 extern sai_next_hop_api_t* sai_next_hop_api;
 
-NeighborMgr::NeighborMgr(NextHopMgr* nhMgr) : m_nhMgr(nhMgr)
+NeighborMgr::NeighborMgr(NextHopMgr* nhMgr) : m_nhMgr(nhMgr), m_nhgMgr(NULL), m_routeMgr(NULL), m_routePipeline(NULL)
 {
 }
 
@@ -87,8 +90,7 @@ bool NeighborMgr::Add(IpAddress ipAddr,
     //Write to the ASIC
     // add new neighbor
     sainb.rif_id = rif_id;
-    sainb.ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    sainb.ip_address.addr.ip4 = ipAddr.addr();
+    ToSaiIpAddress(ipAddr, sainb.ip_address);
 
     sai_attribute_t rif_attr;
     rif_attr.id = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
@@ -132,6 +134,16 @@ bool NeighborMgr::Add(IpAddress ipAddr,
     nbEntry.nhid = nhid;
     m_ip2NbrMap[ipAddr] = nbEntry;
 
+    // the neighbor itself is in place, a route failing here is logged by RouteMgr
+    if (m_routePipeline)
+    {
+        m_routePipeline->NeighborResolved(ipAddr);
+    }
+    else if (m_routeMgr && !m_routeMgr->NeighborResolved(ipAddr))
+    {
+        LOGG(TEST_ERR, NEIGHBOR, "fail to program routes waiting on %s\n", ipAddr.to_string().c_str());
+    }
+
     return true;
 }
 
@@ -148,16 +160,28 @@ bool NeighborMgr::Del(IpAddress ipAddr)
         return true;
     }
 
+    if (m_nhgMgr && !m_nhgMgr->RemoveNextHop(ipAddr))
+    {
+        LOGG(TEST_INFO, NEIGHBOR, "fail to remove nexthop %s from its groups\n", ipAddr.to_string().c_str());
+        return false;
+    }
+
     if (!m_nhMgr->Del(ipAddr))
     {
         LOGG(TEST_INFO, NEIGHBOR, "fail to remove nexthop\n");
+
+        // still in use by a route, put it back in its groups
+        if (m_nhgMgr && !m_nhgMgr->RestoreNextHop(ipAddr))
+        {
+            LOGG(TEST_ERR, NEIGHBOR, "fail to restore nexthop %s in its groups\n", ipAddr.to_string().c_str());
+        }
+
         return false;
     }
 
 
     sainb.rif_id = nbEntry->rif_id;
-    sainb.ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    sainb.ip_address.addr.ip4 = ipAddr.addr();
+    ToSaiIpAddress(ipAddr, sainb.ip_address);
 
     LOGG(TEST_INFO, NEIGHBOR, "sai_neighbor_api->remove_neighbor_entry ip %s rif_id 0x%lx \n",
          ipAddr.to_string().c_str(), nbEntry->rif_id);
@@ -176,11 +200,10 @@ bool NeighborMgr::Del(IpAddress ipAddr)
 
 bool NeighborMgr::EraseAll()
 {
-    std::map<IpAddress, NeighborEntry>::iterator itnb;
-
-    for (itnb = m_ip2NbrMap.begin(); itnb != m_ip2NbrMap.end(); ++itnb)
+    // Del() erases from m_ip2NbrMap, so always take the first neighbor left
+    while (!m_ip2NbrMap.empty())
     {
-        if (!NeighborMgr::Del(itnb->first))
+        if (!NeighborMgr::Del(m_ip2NbrMap.begin()->first))
         {
             return false;
         }
@@ -189,6 +212,43 @@ bool NeighborMgr::EraseAll()
     return true;
 }
 
+bool NeighborMgr::Update(IpAddress ipAddr, MacAddress macAddr)
+{
+    sai_status_t status;
+    sai_neighbor_entry_t sainb;
+
+    std::map<IpAddress, NeighborEntry>::iterator itnb = m_ip2NbrMap.find(ipAddr);
+
+    if (itnb == m_ip2NbrMap.end())
+    {
+        LOGG(TEST_ERR, NEIGHBOR, "cannot find %s in the Neighbor Table\n", ipAddr.to_string().c_str());
+        return false;
+    }
+
+    sainb.rif_id = itnb->second.rif_id;
+    ToSaiIpAddress(ipAddr, sainb.ip_address);
+
+    sai_attribute_t rif_attr;
+    rif_attr.id = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
+    memcpy(rif_attr.value.mac, macAddr.to_bytes(), 6);
+
+    LOGG(TEST_INFO, NEIGHBOR, "sai_neighbor_api->set_neighbor_attribute IPaddr[%s] MACaddr[%s]\n",
+         ipAddr.to_string().c_str(), macAddr.to_string().c_str());
+
+    status = sai_neighbor_api->set_neighbor_attribute(&sainb, &rif_attr);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        LOGG(TEST_ERR, NEIGHBOR, "fail to set mac %s for neighbor %s, rc=0x%x\n",
+             macAddr.to_string().c_str(), ipAddr.to_string().c_str(), -status);
+        return false;
+    }
+
+    itnb->second.macAddr = macAddr;
+
+    return true;
+}
+
 const NeighborEntry* NeighborMgr::GetNeighborEntry(const IpAddress &ip) const
 {
     std::map<IpAddress, NeighborEntry>::const_iterator it = m_ip2NbrMap.find(ip);
@@ -31,6 +31,9 @@
 #include "basic_router.h"
 
 class NextHopMgr;
+class NextHopGrpMgr;
+class RouteMgr;
+class RoutePipeline;
 
 struct NeighborEntry
 {
@@ -44,10 +47,41 @@ class NeighborMgr
 {
     std::map<IpAddress, NeighborEntry> m_ip2NbrMap;
     NextHopMgr* m_nhMgr;
+    NextHopGrpMgr* m_nhgMgr;
+    RouteMgr* m_routeMgr;
+    RoutePipeline* m_routePipeline;
 
 public:
     NeighborMgr(NextHopMgr* nhMgr);
 
+    /*
+     * Routes parked on a neighbor are programmed by routeMgr once it is
+     * added, from the thread calling Add(). While a RoutePipeline runs
+     * it owns the RouteMgr, so attach it with SetRoutePipeline(): the
+     * resolution is then queued behind the route intents already pushed
+     * and handled by the pipeline's consumer thread. The neighbor table
+     * itself is not locked, change it while the consumer is idle.
+     */
+    void SetRouteMgr(RouteMgr* routeMgr)
+    {
+        m_routeMgr = routeMgr;
+    }
+
+    void SetRoutePipeline(RoutePipeline* routePipeline)
+    {
+        m_routePipeline = routePipeline;
+    }
+
+    /*
+     * Del() takes the nexthop out of every group it is a member of in
+     * nhgMgr before removing it, so a group never keeps a removed nhid
+     * and gets the new one once the neighbor is added back.
+     */
+    void SetNextHopGrpMgr(NextHopGrpMgr* nhgMgr)
+    {
+        m_nhgMgr = nhgMgr;
+    }
+
     bool Add(IpAddress ipAddr,
              MacAddress macAddr,
              std::string intfAlias,
@@ -57,5 +91,13 @@ public:
     bool EraseAll();
     void Show();
 
+    // change the MAC of a known neighbor, its nexthop is kept
+    bool Update(IpAddress ipAddr, MacAddress macAddr);
+
     const NeighborEntry* GetNeighborEntry(const IpAddress &) const;
+
+    const std::map<IpAddress, NeighborEntry>& Neighbors() const
+    {
+        return m_ip2NbrMap;
+    }
 };
@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#include <algorithm>
+
+#include "nexthop_set.h"
+
+template <class Iter>
+size_t NextHopSetTable::Hash(Iter first, Iter last)
+{
+    // FNV-1a over the address family and bytes, in ascending order
+    uint64_t h = 0xcbf29ce484222325ULL;
+
+    for (Iter it = first; it != last; ++it)
+    {
+        h = (h ^ (uint64_t)it->Len()) * 0x100000001b3ULL;
+
+        for (int i = 0; i < it->Len(); i++)
+        {
+            h = (h ^ it->Bytes()[i]) * 0x100000001b3ULL;
+        }
+    }
+
+    return (size_t)h;
+}
+
+template <class Iter>
+NextHopSetId NextHopSetTable::Find(Iter first, size_t count, size_t hash) const
+{
+    auto range = m_index.equal_range(hash);
+
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        const Entry& entry = m_entries[it->second];
+
+        if (entry.addrs.size() == count && std::equal(entry.addrs.begin(), entry.addrs.end(), first))
+        {
+            return it->second;
+        }
+    }
+
+    return NEXTHOP_SET_INVALID;
+}
+
+NextHopSetId NextHopSetTable::Find(const IpAddresses& nexthops) const
+{
+    const std::set<IpAddress>& addrset = nexthops.AddrSet();
+
+    return Find(addrset.begin(), addrset.size(), Hash(addrset.begin(), addrset.end()));
+}
+
+NextHopSetId NextHopSetTable::Find(const std::vector<IpAddress>& addrs) const
+{
+    return Find(addrs.begin(), addrs.size(), Hash(addrs.begin(), addrs.end()));
+}
+
+template <class Iter>
+NextHopSetId NextHopSetTable::Acquire(Iter first, Iter last, size_t count)
+{
+    size_t hash = Hash(first, last);
+    NextHopSetId id = Find(first, count, hash);
+
+    if (id != NEXTHOP_SET_INVALID)
+    {
+        m_entries[id].refCount++;
+        return id;
+    }
+
+    if (m_free.empty())
+    {
+        id = (NextHopSetId)m_entries.size();
+        m_entries.push_back(Entry());
+    }
+    else
+    {
+        id = m_free.back();
+        m_free.pop_back();
+    }
+
+    Entry& entry = m_entries[id];
+
+    entry.addrs.assign(first, last);
+    entry.hash = hash;
+    entry.refCount = 1;
+
+    m_index.insert(std::make_pair(entry.hash, id));
+    m_size++;
+
+    return id;
+}
+
+NextHopSetId NextHopSetTable::Acquire(const IpAddresses& nexthops)
+{
+    const std::set<IpAddress>& addrset = nexthops.AddrSet();
+
+    return Acquire(addrset.begin(), addrset.end(), addrset.size());
+}
+
+NextHopSetId NextHopSetTable::Acquire(const std::vector<IpAddress>& addrs)
+{
+    return Acquire(addrs.begin(), addrs.end(), addrs.size());
+}
+
+void NextHopSetTable::Acquire(NextHopSetId id)
+{
+    m_entries[id].refCount++;
+}
+
+void NextHopSetTable::Release(NextHopSetId id)
+{
+    Entry& entry = m_entries[id];
+
+    if (entry.refCount == 0 || --entry.refCount > 0)
+    {
+        return;
+    }
+
+    auto range = m_index.equal_range(entry.hash);
+
+    for (auto it = range.first; it != range.second; ++it)
+    {
+        if (it->second == id)
+        {
+            m_index.erase(it);
+            break;
+        }
+    }
+
+    std::vector<IpAddress>().swap(entry.addrs);
+
+    m_free.push_back(id);
+    m_size--;
+}
+
+size_t NextHopSetTable::MemoryUsage() const
+{
+    size_t bytes = m_entries.size() * sizeof(Entry) +
+                   m_free.capacity() * sizeof(NextHopSetId) +
+                   m_index.size() * (sizeof(size_t) + sizeof(NextHopSetId) + 2 * sizeof(void*)) +
+                   m_index.bucket_count() * sizeof(void*);
+
+    for (size_t i = 0; i < m_entries.size(); i++)
+    {
+        bytes += m_entries[i].addrs.capacity() * sizeof(IpAddress);
+    }
+
+    return bytes;
+}
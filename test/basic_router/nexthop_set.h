@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#pragma once
+
+#include <stdint.h>
+#include <deque>
+#include <vector>
+#include <unordered_map>
+
+#include "ip.h"
+
+typedef uint32_t NextHopSetId;
+
+#define NEXTHOP_SET_INVALID     ((NextHopSetId)-1)
+
+/*
+ * Hash-consed nexthop sets. Every distinct set is stored once, as a
+ * sorted vector, and named by a 32-bit id, so tables keyed or valued by
+ * nexthop sets hold the id only and compare sets with an integer compare.
+ * One table is shared by the route and nexthop group managers, so an id
+ * means the same set to both.
+ *
+ * Ids are reference counted: Acquire() interns a set (or takes another
+ * reference on it), Release() drops one and frees the set with its last
+ * reference. Freed ids are reused. Sets are kept in a deque, references
+ * returned by Addrs() stay valid while the id is held.
+ */
+class NextHopSetTable
+{
+    struct Entry
+    {
+        std::vector<IpAddress> addrs;
+        size_t hash;
+        uint32_t refCount;
+    };
+
+    std::deque<Entry> m_entries;
+    std::vector<NextHopSetId> m_free;
+    std::unordered_multimap<size_t, NextHopSetId> m_index;
+    size_t m_size;
+
+    template <class Iter>
+    static size_t Hash(Iter first, Iter last);
+    template <class Iter>
+    NextHopSetId Find(Iter first, size_t count, size_t hash) const;
+    template <class Iter>
+    NextHopSetId Acquire(Iter first, Iter last, size_t count);
+
+public:
+    NextHopSetTable() : m_size(0) {}
+
+    // addrs must be sorted and free of duplicates, as in Addrs()
+    NextHopSetId Acquire(const IpAddresses& nexthops);
+    NextHopSetId Acquire(const std::vector<IpAddress>& addrs);
+    void Acquire(NextHopSetId id);
+    void Release(NextHopSetId id);
+
+    // id of nexthops, NEXTHOP_SET_INVALID when not interned
+    NextHopSetId Find(const IpAddresses& nexthops) const;
+    NextHopSetId Find(const std::vector<IpAddress>& addrs) const;
+
+    // a copy of the set, for callers taking IpAddresses
+    IpAddresses Get(NextHopSetId id) const
+    {
+        return IpAddresses(m_entries[id].addrs);
+    }
+
+    // the nexthops of id in ascending order
+    const std::vector<IpAddress>& Addrs(NextHopSetId id) const
+    {
+        return m_entries[id].addrs;
+    }
+
+    uint32_t RefCount(NextHopSetId id) const
+    {
+        return m_entries[id].refCount;
+    }
+
+    size_t Size() const
+    {
+        return m_size;
+    }
+
+    size_t MemoryUsage() const;
+};
@@ -47,7 +47,7 @@ NextHopGrpMgr::NextHopGrpMgr(NeighborMgr* neighborMgr) : m_neighborMgr(neighborM
 
 void NextHopGrpMgr::Show()
 {
-    std::map<IpAddresses, NextHopGrpEntry>::const_iterator it;
+    std::unordered_map<NextHopSetId, NextHopGrpEntry>::const_iterator it;
     const NextHopGrpEntry* nhgEntry;
 
     LOGG(TEST_DEBUG, NXTHG, "\t--- --- --- --- --- --- NextHopGroup Entry Table --- --- --- --- --- --- \n");
@@ -59,101 +59,214 @@ void NextHopGrpMgr::Show()
 
         LOGG(TEST_DEBUG, NXTHG, "\t0x%-12lx     %s\n",
              nhgEntry->nhg_id,
-             it->first.to_string().c_str());
+             m_nextHopSets.Get(it->first).to_string().c_str());
     }
 
     LOGG(TEST_DEBUG, NXTHG, "\t--- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- ---- \n");
 }
 
+bool NextHopGrpMgr::AddMember(NextHopGrpEntry& nhgEntry, const IpAddress& ip)
+{
+    sai_status_t status;
+
+    if (nhgEntry.members.find(ip) != nhgEntry.members.end())
+    {
+        return true;
+    }
+
+    const NeighborEntry *nbEntry = m_neighborMgr->GetNeighborEntry(ip);
+
+    if (!nbEntry)
+    {
+        LOGG(TEST_DEBUG, NXTHG, "nexthop %s has no neighbor entry, not a member of nhg_id 0x%lx yet\n",
+             ip.to_string().c_str(), nhgEntry.nhg_id);
+        return true;
+    }
+
+    LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->add_next_hop_to_group nhg_id 0x%lx nexthop %s\n",
+         nhgEntry.nhg_id, ip.to_string().c_str());
+
+    status = sai_next_hop_group_api->add_next_hop_to_group(nhgEntry.nhg_id, 1, &nbEntry->nhid);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        LOGG(TEST_ERR, NXTHG, "fail to add nexthop %s to nhg_id 0x%lx. status=0x%x\n",
+             ip.to_string().c_str(), nhgEntry.nhg_id, -status);
+        return false;
+    }
+
+    nhgEntry.members[ip] = nbEntry->nhid;
+
+    return true;
+}
+
+bool NextHopGrpMgr::RemoveMember(NextHopGrpEntry& nhgEntry, const IpAddress& ip)
+{
+    sai_status_t status;
+
+    std::map<IpAddress, sai_object_id_t>::iterator it = nhgEntry.members.find(ip);
+
+    if (it == nhgEntry.members.end())
+    {
+        return true;
+    }
+
+    LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->remove_next_hop_from_group nhg_id 0x%lx nexthop %s nhid 0x%lx\n",
+         nhgEntry.nhg_id, ip.to_string().c_str(), it->second);
+
+    status = sai_next_hop_group_api->remove_next_hop_from_group(nhgEntry.nhg_id, 1, &it->second);
+
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        LOGG(TEST_ERR, NXTHG, "fail to remove nexthop %s from nhg_id 0x%lx. status=0x%x\n",
+             ip.to_string().c_str(), nhgEntry.nhg_id, -status);
+        return false;
+    }
+
+    nhgEntry.members.erase(it);
+
+    return true;
+}
+
+void NextHopGrpMgr::Index(NextHopSetId nextHops)
+{
+    const std::vector<IpAddress>& addrs = m_nextHopSets.Addrs(nextHops);
+
+    for (std::vector<IpAddress>::const_iterator itnh = addrs.begin(); itnh != addrs.end(); itnh++)
+    {
+        m_ip2GroupsMap[*itnh].insert(nextHops);
+    }
+}
+
+void NextHopGrpMgr::Unindex(NextHopSetId nextHops)
+{
+    const std::vector<IpAddress>& addrs = m_nextHopSets.Addrs(nextHops);
+
+    for (std::vector<IpAddress>::const_iterator itnh = addrs.begin(); itnh != addrs.end(); itnh++)
+    {
+        std::map<IpAddress, std::set<NextHopSetId> >::iterator it = m_ip2GroupsMap.find(*itnh);
+
+        if (it == m_ip2GroupsMap.end())
+        {
+            continue;
+        }
+
+        it->second.erase(nextHops);
+
+        if (it->second.empty())
+        {
+            m_ip2GroupsMap.erase(it);
+        }
+    }
+}
+
 bool NextHopGrpMgr::Add(IpAddresses nextHops)
+{
+    NextHopSetId id = m_nextHopSets.Acquire(nextHops);
+    bool ok = Add(id);
+    m_nextHopSets.Release(id);
+
+    return ok;
+}
+
+bool NextHopGrpMgr::Add(NextHopSetId nextHops)
 {
     sai_status_t status;
     NextHopGrpEntry nhgEntry;
-    nhgEntry.nextHops = nextHops;
 
-    std::map<IpAddresses, NextHopGrpEntry>::iterator itnhg = m_ips2NextHGMap.find(nextHops);
+    if (m_ips2NextHGMap.find(nextHops) != m_ips2NextHGMap.end())
+    {
+        LOGG(TEST_DEBUG, NXTHG, "ECMP group %s already exists\n", m_nextHopSets.Get(nextHops).to_string().c_str());
+        return true;
+    }
 
     //create Next Hop Group
     sai_object_id_t nhg_id;
     std::vector<sai_object_id_t> nhids;
 
-    std::set<IpAddress> addrset = nextHops.AddrSet();
-
-    std::vector<sai_attribute_t> nhg_attrs;
-    sai_attribute_t nhg_attr;
+    const std::vector<IpAddress>& addrs = m_nextHopSets.Addrs(nextHops);
 
     //walkthrough the nexthops
-    for (std::set<IpAddress>::const_iterator itnh = addrset.begin(); itnh != addrset.end(); itnh++)
+    for (std::vector<IpAddress>::const_iterator itnh = addrs.begin(); itnh != addrs.end(); itnh++)
     {
         const NeighborEntry *nbEntry = m_neighborMgr->GetNeighborEntry(*itnh);
 
         if (!nbEntry)
         {
-            LOGG(TEST_ERR, NXTHG, "fail to find the neighbor entry for nexthop %s\n", itnh->to_string().c_str());
+            LOGG(TEST_DEBUG, NXTHG, "nexthop %s has no neighbor entry yet\n", itnh->to_string().c_str());
             continue;
         }
 
-        nhg_id = nbEntry->nhid;
         nhids.push_back(nbEntry->nhid);
+        nhgEntry.members[*itnh] = nbEntry->nhid;
     }
 
     //nexthops contain 0 neighbors
     if (nhids.size() == 0)
     {
-        LOGG(TEST_DEBUG, NXTHG, "cannot find the any of nexthops %s in the neighbor table\n", nextHops.to_string().c_str());
+        LOGG(TEST_DEBUG, NXTHG, "cannot find the any of nexthops %s in the neighbor table\n",
+             m_nextHopSets.Get(nextHops).to_string().c_str());
         return false;
     }
 
-    if (nhids.size() > 1)
-    {
-        nhg_attr.id = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
-        nhg_attr.value.s32 = SAI_NEXT_HOP_GROUP_ECMP;
-        nhg_attrs.push_back(nhg_attr);
-
-        nhg_attr.id = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
-        nhg_attr.value.objlist.count = nhids.size();
-        nhg_attr.value.objlist.list = nhids.data();
-        nhg_attrs.push_back(nhg_attr);
+    // the group starts with the resolved nexthops, the others are added
+    // by RestoreNextHop() once their neighbors come up
+    sai_attribute_t nhg_attrs[2];
+    nhg_attrs[0].id = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
+    nhg_attrs[0].value.s32 = SAI_NEXT_HOP_GROUP_ECMP;
+    nhg_attrs[1].id = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
+    nhg_attrs[1].value.objlist.count = (uint32_t)nhids.size();
+    nhg_attrs[1].value.objlist.list = nhids.data();
 
-        LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->create_next_hop_group %s\n",  nextHops.to_string().c_str());
-        status = sai_next_hop_group_api->create_next_hop_group(&nhg_id, nhg_attrs.size(), nhg_attrs.data());
+    LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->create_next_hop_group %s\n",
+         m_nextHopSets.Get(nextHops).to_string().c_str());
+    status = sai_next_hop_group_api->create_next_hop_group(&nhg_id, 2, nhg_attrs);
 
-        if (status != SAI_STATUS_SUCCESS)
-        {
-            LOGG(TEST_ERR, NXTHG, "fail to create ECMP group for %s. status=0x%x\n", nextHops.to_string().c_str(), -status);
-            return false;
-        }
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        LOGG(TEST_ERR, NXTHG, "fail to create ECMP group for %s. status=0x%x\n",
+             m_nextHopSets.Get(nextHops).to_string().c_str(), -status);
+        return false;
+    }
 
-        if (!SAI_OID_TYPE_CHECK(nhg_id, SAI_OBJECT_TYPE_NEXT_HOP_GROUP))
-        {
-            LOGG(TEST_ERR, NXTHG, "next hop group oid generated is not the right type\n");
-            return false;
-        }
+    if (!SAI_OID_TYPE_CHECK(nhg_id, SAI_OBJECT_TYPE_NEXT_HOP_GROUP))
+    {
+        LOGG(TEST_ERR, NXTHG, "next hop group oid generated is not the right type\n");
+        return false;
+    }
 
-        nhgEntry.nhg_id = nhg_id;
+    nhgEntry.nhg_id = nhg_id;
 
-        LOGG(TEST_DEBUG, NXTHG, "create ECMP groupnexthops %s nhg_id 0x%lx\n",
-             nextHops.to_string().c_str(), nhg_id);
-    }
+    LOGG(TEST_DEBUG, NXTHG, "create ECMP groupnexthops %s nhg_id 0x%lx\n",
+         m_nextHopSets.Get(nextHops).to_string().c_str(), nhg_id);
 
     //insert this entry to the internal data structure
+    m_nextHopSets.Acquire(nextHops);
     m_ips2NextHGMap[nextHops] = nhgEntry;
+    Index(nextHops);
+
     return true;
 }
 
 bool NextHopGrpMgr::Del(IpAddresses nextHops)
+{
+    return Del(m_nextHopSets.Find(nextHops));
+}
+
+bool NextHopGrpMgr::Del(NextHopSetId nextHops)
 {
     sai_object_id_t nhg_id;
     sai_status_t status;
 
-    const NextHopGrpEntry *nhgEntry = NextHopGrpMgr::GetNextHopGrpEntry(nextHops);
+    std::unordered_map<NextHopSetId, NextHopGrpEntry>::iterator itnhg = m_ips2NextHGMap.find(nextHops);
 
-    if (!nhgEntry)
+    if (itnhg == m_ips2NextHGMap.end())
     {
         return false;
     }
 
-    nhg_id = nhgEntry->nhg_id;
+    NextHopGrpEntry& nhgEntry = itnhg->second;
+    nhg_id = nhgEntry.nhg_id;
 
     LOGG(TEST_INFO, NXTHG, "sai_next_hop_group_api->sai_remove_next_hop_group nhg_id 0x%lx \n", nhg_id);
 
@@ -165,14 +278,124 @@ bool NextHopGrpMgr::Del(IpAddresses nextHops)
         return false;
     }
 
-    m_ips2NextHGMap.erase(nextHops);
+    Unindex(nextHops);
+    m_ips2NextHGMap.erase(itnhg);
+    m_nextHopSets.Release(nextHops);
+
+    return true;
+}
+
+bool NextHopGrpMgr::Update(const IpAddresses& from, const IpAddresses& to)
+{
+    NextHopSetId fromId = m_nextHopSets.Find(from);
+
+    if (fromId == NEXTHOP_SET_INVALID)
+    {
+        return false;
+    }
+
+    NextHopSetId toId = m_nextHopSets.Acquire(to);
+    bool ok = Update(fromId, toId);
+    m_nextHopSets.Release(toId);
+
+    return ok;
+}
+
+bool NextHopGrpMgr::Update(NextHopSetId from, NextHopSetId to)
+{
+    std::unordered_map<NextHopSetId, NextHopGrpEntry>::iterator itnhg = m_ips2NextHGMap.find(from);
+
+    if (itnhg == m_ips2NextHGMap.end() || m_ips2NextHGMap.find(to) != m_ips2NextHGMap.end())
+    {
+        return false;
+    }
+
+    NextHopGrpEntry& nhgEntry = itnhg->second;
+    const std::vector<IpAddress>& fromAddrs = m_nextHopSets.Addrs(from);
+    const std::vector<IpAddress>& toAddrs = m_nextHopSets.Addrs(to);
+
+    LOGG(TEST_INFO, NXTHG, "update ECMP group nhg_id 0x%lx %s -> %s\n", nhgEntry.nhg_id,
+         m_nextHopSets.Get(from).to_string().c_str(), m_nextHopSets.Get(to).to_string().c_str());
+
+    // add the new members first, so the group never runs empty
+    for (std::vector<IpAddress>::const_iterator itnh = toAddrs.begin(); itnh != toAddrs.end(); itnh++)
+    {
+        if (!std::binary_search(fromAddrs.begin(), fromAddrs.end(), *itnh) && !AddMember(nhgEntry, *itnh))
+        {
+            return false;
+        }
+    }
+
+    for (std::vector<IpAddress>::const_iterator itnh = fromAddrs.begin(); itnh != fromAddrs.end(); itnh++)
+    {
+        if (!std::binary_search(toAddrs.begin(), toAddrs.end(), *itnh) && !RemoveMember(nhgEntry, *itnh))
+        {
+            return false;
+        }
+    }
+
+    NextHopGrpEntry updated = nhgEntry;
+
+    Unindex(from);
+    m_ips2NextHGMap.erase(itnhg);
+
+    m_nextHopSets.Acquire(to);
+    m_ips2NextHGMap[to] = updated;
+    Index(to);
+
+    m_nextHopSets.Release(from);
+
+    return true;
+}
+
+bool NextHopGrpMgr::RemoveNextHop(const IpAddress& ip)
+{
+    std::map<IpAddress, std::set<NextHopSetId> >::const_iterator it = m_ip2GroupsMap.find(ip);
+
+    if (it == m_ip2GroupsMap.end())
+    {
+        return true;
+    }
+
+    for (std::set<NextHopSetId>::const_iterator itg = it->second.begin(); itg != it->second.end(); itg++)
+    {
+        if (!RemoveMember(m_ips2NextHGMap[*itg], ip))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool NextHopGrpMgr::RestoreNextHop(const IpAddress& ip)
+{
+    std::map<IpAddress, std::set<NextHopSetId> >::const_iterator it = m_ip2GroupsMap.find(ip);
+
+    if (it == m_ip2GroupsMap.end())
+    {
+        return true;
+    }
+
+    for (std::set<NextHopSetId>::const_iterator itg = it->second.begin(); itg != it->second.end(); itg++)
+    {
+        if (!AddMember(m_ips2NextHGMap[*itg], ip))
+        {
+            return false;
+        }
+    }
 
     return true;
 }
 
 const NextHopGrpEntry* NextHopGrpMgr::GetNextHopGrpEntry(const IpAddresses &ips) const
 {
-    std::map<IpAddresses, NextHopGrpEntry>::const_iterator it = m_ips2NextHGMap.find(ips);
+    return GetNextHopGrpEntry(m_nextHopSets.Find(ips));
+}
+
+const NextHopGrpEntry* NextHopGrpMgr::GetNextHopGrpEntry(NextHopSetId nextHops) const
+{
+    std::unordered_map<NextHopSetId, NextHopGrpEntry>::const_iterator it = m_ips2NextHGMap.find(nextHops);
 
     if (it != m_ips2NextHGMap.end())
     {
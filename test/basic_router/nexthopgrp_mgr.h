@@ -24,6 +24,7 @@
 #include <set>
 #include <map>
 #include <string>
+#include <unordered_map>
 
 extern "C"
 {
@@ -33,14 +34,17 @@ extern "C"
 #include "log.h"
 #include "ip.h"
 #include "mac.h"
+#include "nexthop_set.h"
 #include "basic_router.h"
 
 class NeighborMgr;
 
 struct NextHopGrpEntry
 {
-    IpAddresses nextHops;
     sai_object_id_t nhg_id;
+
+    // next hop id of each nexthop with a neighbor, the group's members
+    std::map<IpAddress, sai_object_id_t> members;
 };
 
 class NextHopGrpMgr
@@ -48,15 +52,50 @@ class NextHopGrpMgr
 
     NeighborMgr* m_neighborMgr;
 
-    std::map<IpAddresses, NextHopGrpEntry> m_ips2NextHGMap;
+    /*
+     * The nexthop sets of the groups, each group holds one reference.
+     * The route manager interns its sets here too, see NextHopSets().
+     */
+    NextHopSetTable m_nextHopSets;
+
+    std::unordered_map<NextHopSetId, NextHopGrpEntry> m_ips2NextHGMap;
+
+    // groups each nexthop is configured in, whether or not it is a member
+    std::map<IpAddress, std::set<NextHopSetId> > m_ip2GroupsMap;
+
+    bool AddMember(NextHopGrpEntry& nhgEntry, const IpAddress& ip);
+    bool RemoveMember(NextHopGrpEntry& nhgEntry, const IpAddress& ip);
+    void Index(NextHopSetId nextHops);
+    void Unindex(NextHopSetId nextHops);
 
 public:
     NextHopGrpMgr(NeighborMgr* neighborMgr);
 
+    NextHopSetTable& NextHopSets() { return m_nextHopSets; }
+
+    // the id versions take sets interned in NextHopSets()
     bool Add(IpAddresses nextHops);
+    bool Add(NextHopSetId nextHops);
     bool Del(IpAddresses nextHops);
+    bool Del(NextHopSetId nextHops);
     void Show();
 
+    /*
+     * Turn the group of from into the group of to in place, adding and
+     * removing the nexthops that differ. The nhg_id stays the same, so
+     * routes pointing at it need no update.
+     */
+    bool Update(const IpAddresses& from, const IpAddresses& to);
+    bool Update(NextHopSetId from, NextHopSetId to);
+
+    /*
+     * Neighbor flaps: drop ip from every group it is a member of before
+     * its nexthop goes away, and put it back once it is resolved again.
+     * Only the affected members are touched, not the routes.
+     */
+    bool RemoveNextHop(const IpAddress& ip);
+    bool RestoreNextHop(const IpAddress& ip);
+
     const NextHopGrpEntry* GetNextHopGrpEntry(const IpAddresses &) const;
+    const NextHopGrpEntry* GetNextHopGrpEntry(NextHopSetId nextHops) const;
 };
-
@@ -0,0 +1,447 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#include <string.h>
+#include <fstream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "reconcile_mgr.h"
+
+ReconcileMgr::ReconcileMgr(NeighborMgr* neighborMgr, RouteMgr* routeMgr,
+                           const std::map<std::string, sai_object_id_t>& rifs) :
+    m_neighborMgr(neighborMgr),
+    m_routeMgr(routeMgr),
+    m_rifs(rifs)
+{
+}
+
+bool ReconcileMgr::Load(const std::string& path, ReconcileSnapshot& snapshot)
+{
+    std::ifstream file(path.c_str());
+
+    if (!file)
+    {
+        LOGG(TEST_ERR, RECONCILE, "cannot open snapshot %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    int lineno = 0;
+
+    snapshot.neighbors.clear();
+    snapshot.routes.clear();
+
+    while (std::getline(file, line))
+    {
+        lineno++;
+
+        std::string::size_type comment = line.find('#');
+
+        if (comment != std::string::npos)
+        {
+            line.erase(comment);
+        }
+
+        std::istringstream fields(line);
+        std::string type, key, value, alias;
+
+        if (!(fields >> type))
+        {
+            continue;
+        }
+
+        try
+        {
+            if (type == "neighbor" && (fields >> key >> value >> alias))
+            {
+                ReconcileNeighbor neighbor;
+                uint8_t mac[6];
+
+                if (!MacAddress::TryParseBytes(value, mac))
+                {
+                    throw std::invalid_argument("bad mac " + value);
+                }
+
+                neighbor.macAddr = MacAddress(mac);
+                neighbor.intfAlias = alias;
+                snapshot.neighbors[IpAddress(key)] = neighbor;
+                continue;
+            }
+
+            if (type == "route" && (fields >> key >> value))
+            {
+                snapshot.routes[IpPrefix(key)] = IpAddresses(value);
+                continue;
+            }
+        }
+        catch (const std::exception& e)
+        {
+            LOGG(TEST_ERR, RECONCILE, "%s:%d: %s\n", path.c_str(), lineno, e.what());
+            return false;
+        }
+
+        LOGG(TEST_ERR, RECONCILE, "%s:%d: cannot parse '%s'\n", path.c_str(), lineno, line.c_str());
+        return false;
+    }
+
+    LOGG(TEST_INFO, RECONCILE, "loaded %zu neighbors and %zu routes from %s\n",
+         snapshot.neighbors.size(), snapshot.routes.size(), path.c_str());
+
+    return true;
+}
+
+bool ReconcileMgr::Save(const std::string& path) const
+{
+    std::ofstream file(path.c_str());
+
+    if (!file)
+    {
+        LOGG(TEST_ERR, RECONCILE, "cannot write snapshot %s\n", path.c_str());
+        return false;
+    }
+
+    const std::map<IpAddress, NeighborEntry>& neighbors = m_neighborMgr->Neighbors();
+
+    for (std::map<IpAddress, NeighborEntry>::const_iterator it = neighbors.begin(); it != neighbors.end(); ++it)
+    {
+        MacAddress mac = it->second.macAddr;
+        file << "neighbor " << it->first.to_string() << " " << mac.to_string() << " " << it->second.intfAlias << "\n";
+    }
+
+    // a route both in SAI and parked is wanted with its parked nexthops
+    std::map<IpPrefix, NextHopSetId> routes(m_routeMgr->ParkedRoutes());
+    routes.insert(m_routeMgr->Routes().begin(), m_routeMgr->Routes().end());
+
+    for (std::map<IpPrefix, NextHopSetId>::const_iterator it = routes.begin(); it != routes.end(); ++it)
+    {
+        // prefix length form, IpPrefix(std::string) does not take a dotted mask
+        file << "route " << it->first.Addr().to_string() << "/" << it->first.MaskLen()
+             << " " << m_routeMgr->NextHops(it->second).to_string() << "\n";
+    }
+
+    return file.good();
+}
+
+/*
+ * Walk two maps sorted on the same key in one pass, calling add for keys
+ * only in want, del for keys only in have and change for keys in both.
+ */
+template <typename K, typename H, typename W, typename Add, typename Del, typename Change>
+static void MergeDiff(const std::map<K, H>& have, const std::map<K, W>& want, Add add, Del del, Change change)
+{
+    typename std::map<K, H>::const_iterator ith = have.begin();
+    typename std::map<K, W>::const_iterator itw = want.begin();
+
+    while (ith != have.end() || itw != want.end())
+    {
+        if (itw == want.end() || (ith != have.end() && ith->first < itw->first))
+        {
+            del(ith->first, ith->second);
+            ++ith;
+        }
+        else if (ith == have.end() || itw->first < ith->first)
+        {
+            add(itw->first, itw->second);
+            ++itw;
+        }
+        else
+        {
+            change(ith->first, ith->second, itw->second);
+            ++ith;
+            ++itw;
+        }
+    }
+}
+
+bool ReconcileMgr::AddNeighbor(const IpAddress& ip, const ReconcileNeighbor& neighbor)
+{
+    std::map<std::string, sai_object_id_t>::const_iterator itrif = m_rifs.find(neighbor.intfAlias);
+
+    if (itrif == m_rifs.end())
+    {
+        LOGG(TEST_ERR, RECONCILE, "no router interface for %s, neighbor %s skipped\n",
+             neighbor.intfAlias.c_str(), ip.to_string().c_str());
+        return false;
+    }
+
+    return m_neighborMgr->Add(ip, neighbor.macAddr, neighbor.intfAlias, itrif->second);
+}
+
+bool ReconcileMgr::IsParked(const IpPrefix& prefix, const IpAddresses& nexthops) const
+{
+    std::map<IpPrefix, NextHopSetId>::const_iterator it = m_routeMgr->ParkedRoutes().find(prefix);
+
+    return it != m_routeMgr->ParkedRoutes().end() && m_routeMgr->NextHops(it->second) == nexthops;
+}
+
+bool ReconcileMgr::MoveNeighbors(const std::vector<IpAddress>& moves, const ReconcileSnapshot& desired,
+                                 ReconcileStats& stats)
+{
+    if (moves.empty())
+    {
+        return true;
+    }
+
+    // the nexthop of a neighbor cannot go while routes point at it, take
+    // those routes out, recreate the neighbor and put them back. Routes
+    // through an ECMP group stay, NeighborMgr moves the group member.
+    std::set<IpAddress> moved(moves.begin(), moves.end());
+    std::vector<IpPrefix> routes;
+
+    for (RouteTable::const_iterator it = m_routeMgr->Routes().begin(); it != m_routeMgr->Routes().end(); it++)
+    {
+        const std::vector<IpAddress>& addrs = m_routeMgr->NextHopAddrs(it->second);
+
+        if (addrs.size() == 1 && moved.count(addrs[0]))
+        {
+            routes.push_back(it->first);
+        }
+    }
+
+    LOGG(TEST_INFO, RECONCILE, "%zu neighbors change interface, %zu routes through them are reprogrammed\n",
+         moves.size(), routes.size());
+
+    bool ok = true;
+
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        ok = m_routeMgr->DelBatch(routes[i]) && ok;
+    }
+
+    ok = m_routeMgr->Flush() && ok;
+
+    for (size_t i = 0; i < moves.size(); i++)
+    {
+        if (m_neighborMgr->Del(moves[i]) && AddNeighbor(moves[i], desired.neighbors.at(moves[i])))
+        {
+            stats.neighborsUpdated++;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        std::map<IpPrefix, IpAddresses>::const_iterator itr = desired.routes.find(routes[i]);
+
+        // a route the batch failed to remove is not wanted back
+        if (itr != desired.routes.end())
+        {
+            ok = m_routeMgr->AddBatch(itr->first, itr->second) && ok;
+        }
+    }
+
+    return m_routeMgr->Flush() && ok;
+}
+
+bool ReconcileMgr::Reconcile(const ReconcileSnapshot& desired, ReconcileStats& stats)
+{
+    std::vector<IpAddress> nbrAdds, nbrMacs, nbrMoves, nbrDels;
+    std::vector<IpPrefix> routeAdds, routeSets, routeDels;
+
+    memset(&stats, 0, sizeof(stats));
+
+    // nothing may still be queued, the diff is taken against m_Routes
+    if (!m_routeMgr->Flush())
+    {
+        return false;
+    }
+
+    MergeDiff(m_neighborMgr->Neighbors(), desired.neighbors,
+              [&](const IpAddress& ip, const ReconcileNeighbor&) { nbrAdds.push_back(ip); },
+              [&](const IpAddress& ip, const NeighborEntry&) { nbrDels.push_back(ip); },
+              [&](const IpAddress& ip, const NeighborEntry& have, const ReconcileNeighbor& want)
+    {
+        if (have.intfAlias != want.intfAlias)
+        {
+            nbrMoves.push_back(ip);
+        }
+        else if (!(have.macAddr == want.macAddr))
+        {
+            nbrMacs.push_back(ip);
+        }
+        else
+        {
+            stats.unchanged++;
+        }
+    });
+
+    // a route parked on the wanted nexthops is programmed by RouteMgr as
+    // soon as a neighbor resolves, adding it again would change nothing
+    MergeDiff(m_routeMgr->Routes(), desired.routes,
+              [&](const IpPrefix& prefix, const IpAddresses& want)
+    {
+        if (IsParked(prefix, want))
+        {
+            stats.routesParked++;
+        }
+        else
+        {
+            routeAdds.push_back(prefix);
+        }
+    },
+              [&](const IpPrefix& prefix, NextHopSetId) { routeDels.push_back(prefix); },
+              [&](const IpPrefix& prefix, NextHopSetId have, const IpAddresses& want)
+    {
+        if (IsParked(prefix, want))
+        {
+            stats.routesParked++;
+        }
+        else if (m_routeMgr->NextHops(have) == want)
+        {
+            stats.unchanged++;
+        }
+        else
+        {
+            routeSets.push_back(prefix);
+        }
+    });
+
+    // parked routes only, which are no longer wanted
+    const std::map<IpPrefix, NextHopSetId>& parked = m_routeMgr->ParkedRoutes();
+
+    for (std::map<IpPrefix, NextHopSetId>::const_iterator it = parked.begin(); it != parked.end(); it++)
+    {
+        if (!desired.routes.count(it->first) && !m_routeMgr->Routes().count(it->first))
+        {
+            routeDels.push_back(it->first);
+        }
+    }
+
+    LOGG(TEST_INFO, RECONCILE, "neighbors +%zu ~%zu -%zu, routes +%zu ~%zu -%zu, %zu parked, %zu unchanged\n",
+         nbrAdds.size(), nbrMacs.size() + nbrMoves.size(), nbrDels.size(),
+         routeAdds.size(), routeSets.size(), routeDels.size(), stats.routesParked, stats.unchanged);
+
+    bool ok = true;
+
+    // 1. neighbors (and their nexthops) the routes are going to need
+    for (size_t i = 0; i < nbrMacs.size(); i++)
+    {
+        if (m_neighborMgr->Update(nbrMacs[i], desired.neighbors.at(nbrMacs[i]).macAddr))
+        {
+            stats.neighborsUpdated++;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    for (size_t i = 0; i < nbrAdds.size(); i++)
+    {
+        if (AddNeighbor(nbrAdds[i], desired.neighbors.at(nbrAdds[i])))
+        {
+            stats.neighborsAdded++;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    // 2. routes, as one batch: removes, then sets, then creates
+    for (size_t i = 0; i < routeDels.size(); i++)
+    {
+        ok = m_routeMgr->DelBatch(routeDels[i]) && ok;
+    }
+
+    for (size_t i = 0; i < routeSets.size(); i++)
+    {
+        ok = m_routeMgr->AddBatch(routeSets[i], desired.routes.at(routeSets[i])) && ok;
+    }
+
+    for (size_t i = 0; i < routeAdds.size(); i++)
+    {
+        ok = m_routeMgr->AddBatch(routeAdds[i], desired.routes.at(routeAdds[i])) && ok;
+    }
+
+    ok = m_routeMgr->Flush() && ok;
+
+    // 3. neighbors moving to another interface
+    ok = MoveNeighbors(nbrMoves, desired, stats) && ok;
+
+    // count what actually landed, a failed entry shows up on the next run
+    for (size_t i = 0; i < routeDels.size(); i++)
+    {
+        stats.routesRemoved += (m_routeMgr->Routes().count(routeDels[i]) ||
+                                m_routeMgr->ParkedRoutes().count(routeDels[i])) ? 0 : 1;
+    }
+
+    for (size_t i = 0; i < routeSets.size(); i++)
+    {
+        const IpAddresses& want = desired.routes.at(routeSets[i]);
+        RouteTable::const_iterator it = m_routeMgr->Routes().find(routeSets[i]);
+
+        if (IsParked(routeSets[i], want))
+        {
+            stats.routesParked++;
+        }
+        else if (it != m_routeMgr->Routes().end() && m_routeMgr->NextHops(it->second) == want)
+        {
+            stats.routesUpdated++;
+        }
+    }
+
+    for (size_t i = 0; i < routeAdds.size(); i++)
+    {
+        if (m_routeMgr->Routes().count(routeAdds[i]))
+        {
+            stats.routesAdded++;
+        }
+        else if (IsParked(routeAdds[i], desired.routes.at(routeAdds[i])))
+        {
+            stats.routesParked++;
+        }
+    }
+
+    // 4. neighbors nothing points at any more
+    for (size_t i = 0; i < nbrDels.size(); i++)
+    {
+        if (m_neighborMgr->Del(nbrDels[i]))
+        {
+            stats.neighborsRemoved++;
+        }
+        else
+        {
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+bool ReconcileMgr::Reconcile(const std::string& path, ReconcileStats& stats)
+{
+    ReconcileSnapshot desired;
+
+    if (!Load(path, desired))
+    {
+        return false;
+    }
+
+    return Reconcile(desired, stats);
+}
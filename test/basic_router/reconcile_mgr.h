@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#pragma once
+
+#include <map>
+#include <vector>
+#include <string>
+
+#include "log.h"
+#include "ip.h"
+#include "mac.h"
+#include "route_mgr.h"
+#include "neighbor_mgr.h"
+
+struct ReconcileNeighbor
+{
+    MacAddress macAddr;
+    std::string intfAlias;
+};
+
+/*
+ * Desired state, as read from a snapshot file. One entry per line, '#'
+ * starts a comment:
+ *
+ *   neighbor <ip> <mac> <interface alias>
+ *   route <prefix> <nexthop>[,<nexthop>...]
+ *
+ * Nexthops and nexthop groups are not listed, they follow from the
+ * neighbors and the routes.
+ */
+struct ReconcileSnapshot
+{
+    std::map<IpAddress, ReconcileNeighbor> neighbors;
+    std::map<IpPrefix, IpAddresses> routes;
+};
+
+struct ReconcileStats
+{
+    size_t neighborsAdded;
+    size_t neighborsUpdated;
+    size_t neighborsRemoved;
+    size_t routesAdded;
+    size_t routesUpdated;
+    size_t routesRemoved;
+    // wanted routes left parked until a neighbor resolves, see RouteMgr
+    size_t routesParked;
+    size_t unchanged;
+};
+
+class ReconcileMgr
+{
+    NeighborMgr* m_neighborMgr;
+    RouteMgr* m_routeMgr;
+
+    // interface alias to router interface, for the neighbors
+    std::map<std::string, sai_object_id_t> m_rifs;
+
+    bool AddNeighbor(const IpAddress& ip, const ReconcileNeighbor& neighbor);
+    bool IsParked(const IpPrefix& prefix, const IpAddresses& nexthops) const;
+    bool MoveNeighbors(const std::vector<IpAddress>& moves, const ReconcileSnapshot& desired,
+                       ReconcileStats& stats);
+
+public:
+    ReconcileMgr(NeighborMgr* neighborMgr, RouteMgr* routeMgr,
+                 const std::map<std::string, sai_object_id_t>& rifs);
+
+    static bool Load(const std::string& path, ReconcileSnapshot& snapshot);
+
+    /*
+     * Write the state held by the managers, in the format Load() reads.
+     * Parked routes are written with the nexthops they wait on.
+     */
+    bool Save(const std::string& path) const;
+
+    /*
+     * Bring the managers, and SAI, to the desired state without tearing
+     * down what is already right. Current and desired state are walked
+     * in key order side by side and only the differences are applied:
+     * new and changed neighbors first, then all route removals, updates
+     * and creations as one route batch, then the neighbors which move to
+     * another interface, then the neighbors which are no longer wanted.
+     * A moving neighbor is recreated, the routes using its nexthop alone
+     * are removed before and added back after, ECMP groups drop and
+     * regain it as a member. Nexthop groups follow their routes. Routes
+     * already parked on the wanted nexthops are counted as parked, not
+     * programmed again.
+     */
+    bool Reconcile(const ReconcileSnapshot& desired, ReconcileStats& stats);
+    bool Reconcile(const std::string& path, ReconcileStats& stats);
+};
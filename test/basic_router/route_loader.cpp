@@ -0,0 +1,382 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "route_loader.h"
+
+// a token of the mapped file, not NUL terminated
+struct StrView
+{
+    const char* p;
+    size_t len;
+};
+
+static bool IsSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+// next whitespace delimited token of line, advancing it past the token
+static bool NextToken(StrView& line, StrView& token)
+{
+    while (line.len && IsSpace(*line.p))
+    {
+        line.p++;
+        line.len--;
+    }
+
+    token.p = line.p;
+
+    while (line.len && !IsSpace(*line.p))
+    {
+        line.p++;
+        line.len--;
+    }
+
+    token.len = (size_t)(line.p - token.p);
+
+    return token.len != 0;
+}
+
+static bool ParseAddress(StrView s, IpAddress& ip)
+{
+    char buf[INET6_ADDRSTRLEN];
+    uint8_t bytes[IPV6_ADDR_LEN];
+
+    if (s.len == 0 || s.len >= sizeof(buf))
+    {
+        return false;
+    }
+
+    // inet_pton wants a C string, the token is copied onto the stack only
+    memcpy(buf, s.p, s.len);
+    buf[s.len] = '\0';
+
+    if (memchr(s.p, ':', s.len) == NULL)
+    {
+        uint32_t addr;
+
+        if (inet_pton(AF_INET, buf, &addr) != 1)
+        {
+            return false;
+        }
+
+        ip = IpAddress(addr);
+        return true;
+    }
+
+    if (inet_pton(AF_INET6, buf, bytes) != 1)
+    {
+        return false;
+    }
+
+    ip = IpAddress::FromV6(bytes);
+    return true;
+}
+
+static bool ParseRoute(StrView line, IpPrefix& prefix, IpAddresses& nexthops)
+{
+    StrView token;
+    IpAddress ip;
+
+    if (!NextToken(line, token))
+    {
+        return false;
+    }
+
+    const char* slash = (const char*)memchr(token.p, '/', token.len);
+
+    if (!slash)
+    {
+        return false;
+    }
+
+    StrView addr = { token.p, (size_t)(slash - token.p) };
+    int maskLen = 0;
+
+    for (const char* c = slash + 1; c < token.p + token.len; c++)
+    {
+        if (*c < '0' || *c > '9' || maskLen > 128)
+        {
+            return false;
+        }
+
+        maskLen = maskLen * 10 + (*c - '0');
+    }
+
+    if (slash + 1 == token.p + token.len || !ParseAddress(addr, ip) || maskLen > ip.BitLen())
+    {
+        return false;
+    }
+
+    prefix = IpPrefix(ip, maskLen);
+
+    if (!NextToken(line, token))
+    {
+        return false;
+    }
+
+    nexthops = IpAddresses();
+
+    while (token.len)
+    {
+        const char* comma = (const char*)memchr(token.p, ',', token.len);
+        StrView nh = { token.p, comma ? (size_t)(comma - token.p) : token.len };
+
+        if (!ParseAddress(nh, ip))
+        {
+            return false;
+        }
+
+        nexthops.add(ip);
+
+        token.p += nh.len + (comma ? 1 : 0);
+        token.len -= nh.len + (comma ? 1 : 0);
+    }
+
+    return true;
+}
+
+static long CurrentRssKb()
+{
+    long pages = 0;
+    long rss = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+
+    if (!f)
+    {
+        return 0;
+    }
+
+    if (fscanf(f, "%ld %ld", &pages, &rss) != 2)
+    {
+        rss = 0;
+    }
+
+    fclose(f);
+
+    return rss * (sysconf(_SC_PAGESIZE) / 1024);
+}
+
+static double Percentile(std::vector<double>& samples, double p)
+{
+    if (samples.empty())
+    {
+        return 0;
+    }
+
+    size_t rank = (size_t)(p * (double)(samples.size() - 1) + 0.5);
+
+    std::nth_element(samples.begin(), samples.begin() + rank, samples.end());
+
+    return samples[rank];
+}
+
+RouteLoader::RouteLoader(RouteMgr* routeMgr) :
+    m_routeMgr(routeMgr),
+    m_data(NULL),
+    m_size(0)
+{
+}
+
+RouteLoader::~RouteLoader()
+{
+    Close();
+}
+
+bool RouteLoader::Open(const std::string& path)
+{
+    Close();
+
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd < 0)
+    {
+        LOGG(TEST_ERR, ROUTE, "cannot open route file %s\n", path.c_str());
+        return false;
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) != 0)
+    {
+        LOGG(TEST_ERR, ROUTE, "cannot stat route file %s\n", path.c_str());
+        close(fd);
+        return false;
+    }
+
+    m_size = (size_t)st.st_size;
+
+    if (m_size == 0)
+    {
+        close(fd);
+        return true;
+    }
+
+    void* data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+
+    if (data == MAP_FAILED)
+    {
+        LOGG(TEST_ERR, ROUTE, "cannot map route file %s\n", path.c_str());
+        m_size = 0;
+        return false;
+    }
+
+    // read once front to back
+    madvise(data, m_size, MADV_SEQUENTIAL);
+    m_data = (const char*)data;
+
+    return true;
+}
+
+void RouteLoader::Close()
+{
+    if (m_data)
+    {
+        munmap((void*)m_data, m_size);
+    }
+
+    m_data = NULL;
+    m_size = 0;
+}
+
+bool RouteLoader::Load(size_t batchSize, RouteLoadStats& stats)
+{
+    std::vector<double> batchMs;
+    IpPrefix prefix;
+    IpAddresses nexthops;
+
+    memset(&stats, 0, sizeof(stats));
+
+    batchSize = batchSize ? batchSize : 1;
+
+    // flush on our batch boundaries only, the caller's thresholds are put back after
+    size_t savedBatchSize;
+    unsigned int savedBatchDelayMs;
+
+    m_routeMgr->GetBatchThresholds(savedBatchSize, savedBatchDelayMs);
+    m_routeMgr->SetBatchThresholds(batchSize + 1, UINT_MAX);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::chrono::steady_clock::time_point batchStart = start;
+    size_t queued = 0;
+
+    const char* p = m_data;
+    const char* end = m_data + m_size;
+
+    while (p < end)
+    {
+        const char* eol = (const char*)memchr(p, '\n', (size_t)(end - p));
+        eol = eol ? eol : end;
+
+        StrView line = { p, (size_t)(eol - p) };
+        p = eol + 1;
+        stats.lines++;
+
+        const char* comment = (const char*)memchr(line.p, '#', line.len);
+
+        if (comment)
+        {
+            line.len = (size_t)(comment - line.p);
+        }
+
+        StrView probe = line;
+        StrView token;
+
+        if (!NextToken(probe, token))
+        {
+            continue;
+        }
+
+        if (!ParseRoute(line, prefix, nexthops))
+        {
+            LOGG(TEST_ERR, ROUTE, "line %zu: cannot parse '%.*s'\n", stats.lines, (int)line.len, line.p);
+            stats.errors++;
+            continue;
+        }
+
+        if (!m_routeMgr->AddBatch(prefix, nexthops))
+        {
+            stats.errors++;
+            continue;
+        }
+
+        if (++queued == batchSize)
+        {
+            stats.errors += m_routeMgr->Flush() ? 0 : 1;
+
+            std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            batchMs.push_back(std::chrono::duration<double, std::milli>(now - batchStart).count());
+            batchStart = now;
+            stats.routes += queued;
+            queued = 0;
+        }
+    }
+
+    if (queued)
+    {
+        stats.errors += m_routeMgr->Flush() ? 0 : 1;
+
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        batchMs.push_back(std::chrono::duration<double, std::milli>(now - batchStart).count());
+        stats.routes += queued;
+    }
+
+    m_routeMgr->SetBatchThresholds(savedBatchSize, savedBatchDelayMs);
+
+    stats.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    stats.routesPerSec = stats.seconds > 0 ? (double)stats.routes / stats.seconds : 0;
+    stats.batches = batchMs.size();
+    stats.batchP50Ms = Percentile(batchMs, 0.50);
+    stats.batchP99Ms = Percentile(batchMs, 0.99);
+    stats.rssKb = CurrentRssKb();
+
+    struct rusage usage;
+
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+        stats.peakRssKb = usage.ru_maxrss;
+    }
+
+    return stats.errors == 0;
+}
+
+void RouteLoader::Report(const RouteLoadStats& stats)
+{
+    LOGG(TEST_NOTICE, ROUTE, "loaded %zu routes from %zu lines in %.3f s, %zu errors\n",
+         stats.routes, stats.lines, stats.seconds, stats.errors);
+    LOGG(TEST_NOTICE, ROUTE, "%.0f routes/s, %zu batches, batch p50 %.3f ms p99 %.3f ms\n",
+         stats.routesPerSec, stats.batches, stats.batchP50Ms, stats.batchP99Ms);
+    LOGG(TEST_NOTICE, ROUTE, "rss %ld kB, peak rss %ld kB\n", stats.rssKb, stats.peakRssKb);
+}
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#pragma once
+
+#include <stddef.h>
+#include <string>
+
+#include "log.h"
+#include "ip.h"
+#include "route_mgr.h"
+
+#define ROUTE_LOADER_DEFAULT_BATCH  1024
+
+struct RouteLoadStats
+{
+    size_t lines;
+    size_t routes;          // handed to RouteMgr in batches
+    size_t errors;          // unparsable lines, routes or batches that failed
+    size_t batches;
+    double seconds;
+    double routesPerSec;
+    double batchP50Ms;      // per batch, parsing and programming
+    double batchP99Ms;
+    long rssKb;             // resident set after the load
+    long peakRssKb;
+};
+
+/*
+ * Feed RouteMgr from a route dump, one route per line:
+ *
+ *   <prefix> <nexthop>[,<nexthop>...]
+ *
+ * IPv4 and IPv6 prefixes may be mixed, '#' starts a comment. The file
+ * is mapped and lines are parsed in place, so its size is bounded by
+ * the address space rather than by memory.
+ */
+class RouteLoader
+{
+    RouteMgr* m_routeMgr;
+
+    const char* m_data;
+    size_t m_size;
+
+public:
+    RouteLoader(RouteMgr* routeMgr);
+    ~RouteLoader();
+
+    bool Open(const std::string& path);
+    void Close();
+
+    // program every route, batchSize routes per RouteMgr batch
+    bool Load(size_t batchSize, RouteLoadStats& stats);
+
+    static void Report(const RouteLoadStats& stats);
+};
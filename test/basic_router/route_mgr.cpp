@@ -24,10 +24,13 @@ extern "C"
 #define typeof(x) __typeof__(x)
 
 #include <stdio.h>
+#include <string.h>
 #include "sai.h"
 }
 
 #include <vector>
+#include <algorithm>
+#include <iterator>
 #include <arpa/inet.h>
 
 #include "ip.h"
@@ -42,13 +45,17 @@ extern sai_route_api_t* sai_route_api;
 
 extern sai_object_id_t g_vr_id;
 
-RouteMgr::RouteMgr(NeighborMgr* neighborMgr, NextHopGrpMgr* nhgMgr)
+RouteMgr::RouteMgr(NeighborMgr* neighborMgr, NextHopGrpMgr* nhgMgr) :
+    m_NextHopSets(nhgMgr->NextHopSets())
 {
     m_neighborMgr = neighborMgr;
     m_nhgMgr = nhgMgr;
-    // setup black hole
-    IpAddresses ipaddrs("0.0.0.0");
-    m_EcmpGroups[ipaddrs] = 0;
+    m_BatchSize = ROUTE_BATCH_DEFAULT_SIZE;
+    m_BatchDelay = std::chrono::milliseconds(ROUTE_BATCH_DEFAULT_DELAY_MS);
+    // setup black hole, its entry holds the set's reference for good
+    m_BlackHole = m_NextHopSets.Acquire(IpAddresses("0.0.0.0"));
+    m_EcmpGroups[m_BlackHole].id = 0;
+    m_EcmpGroups[m_BlackHole].refCount = 0;
 }
 
 
@@ -62,7 +69,7 @@ void RouteMgr::Show()
         IpPrefix prefix = it->first;
         LOGG(TEST_DEBUG, ROUTE, "\t%-40s | %s\n",
              prefix.to_string().c_str(),
-             it->second.to_string().c_str());
+             m_NextHopSets.Get(it->second).to_string().c_str());
     }
 
     LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- -\n");
@@ -71,90 +78,193 @@ void RouteMgr::Show()
 void RouteMgr::ShowECMP()
 {
     LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- ECMP Group Table --- --- --- --- --- --- \n");
-    LOGG(TEST_DEBUG, ROUTE, "\t%-40s | %s\n", "nexthops", "next_hop_group_id");
-    std::map<IpAddresses, sai_object_id_t>::iterator itnhg;
+    LOGG(TEST_DEBUG, ROUTE, "\t%-40s | %-18s | %s\n", "nexthops", "next_hop_group_id", "routes");
+    std::unordered_map<NextHopSetId, NextHopRef>::const_iterator itnhg;
 
     for (itnhg = m_EcmpGroups.begin(); itnhg != m_EcmpGroups.end(); itnhg++)
     {
-        IpAddresses nexthops = itnhg->first;
-        LOGG(TEST_DEBUG, ROUTE, "\t%-40s | 0x%lx\n",
-             nexthops.to_string().c_str(),
-             itnhg->second);
+        LOGG(TEST_DEBUG, ROUTE, "\t%-40s | 0x%-16lx | %u\n",
+             m_NextHopSets.Get(itnhg->first).to_string().c_str(),
+             itnhg->second.id,
+             itnhg->second.refCount);
     }
 
     LOGG(TEST_DEBUG, ROUTE, "\t--- --- --- --- --- --- --- --- --- --- --- --- --- --- --- --- -\n");
 }
 
-bool RouteMgr::Add(IpPrefix prefix, IpAddresses nexthops)
+bool RouteMgr::GetNextHopId(NextHopSetId nexthopsId, sai_object_id_t& nhg_id)
 {
-    sai_status_t status;
-    sai_object_id_t nhg_id;
     std::vector<sai_object_id_t> nhids;
 
-    std::set<IpAddress> addrset = nexthops.AddrSet();
+    std::unordered_map<NextHopSetId, NextHopRef>::iterator itnhg = m_EcmpGroups.find(nexthopsId);
 
-    std::vector<sai_attribute_t> nhg_attrs;
-    std::map<IpAddresses, sai_object_id_t>::iterator itnhg = m_EcmpGroups.find(nexthops);
+    if (itnhg != m_EcmpGroups.end())
+    {
+        nhg_id = itnhg->second.id;
+        return true;
+    }
 
-    if (itnhg == m_EcmpGroups.end())
+    const IpAddresses nexthops = m_NextHopSets.Get(nexthopsId);
+    const std::vector<IpAddress>& addrs = m_NextHopSets.Addrs(nexthopsId);
+
+    for (std::vector<IpAddress>::const_iterator itnh = addrs.begin(); itnh != addrs.end(); itnh++)
     {
-        for (std::set<IpAddress>::const_iterator itnh = addrset.begin(); itnh != addrset.end(); itnh++)
+        const NeighborEntry *nbEntry = m_neighborMgr->GetNeighborEntry(*itnh);
+
+        if (!nbEntry)
         {
-            const NeighborEntry *nbEntry = m_neighborMgr->GetNeighborEntry(*itnh);
+            LOGG(TEST_DEBUG, ROUTE, "nexthop %s has no neighbor entry yet\n", itnh->to_string().c_str());
+            continue;
+        }
+
+        nhg_id = nbEntry->nhid;
+        nhids.push_back(nbEntry->nhid);
+    }
 
-            if (!nbEntry)
-            {
-                LOGG(TEST_ERR, ROUTE, "fail to find the neighbor entry for nexthop %s\n", itnh->to_string().c_str());
-                continue;
-            }
+    if (nhids.size() == 0)
+    {
+        LOGG(TEST_DEBUG, ROUTE, "cannot find any of nexthops %s in the neighbor table\n", nexthops.to_string().c_str());
+        return false;
+    }
 
-            nhg_id = nbEntry->nhid;
-            nhids.push_back(nbEntry->nhid);
+    // a group even with a single member resolved, the others join it as
+    // their neighbors come up, see NeighborResolved()
+    if (addrs.size() > 1)
+    {
+        if (!m_nhgMgr->Add(nexthopsId))
+        {
+            LOGG(TEST_ERR, ROUTE, "fail to add nexthop group %s\n", nexthops.to_string().c_str());
+            return false;
         }
 
-        if (nhids.size() == 0)
+        const NextHopGrpEntry *nhgEntry = m_nhgMgr->GetNextHopGrpEntry(nexthopsId);
+
+        if (!nhgEntry)
         {
-            LOGG(TEST_DEBUG, ROUTE, "cannot find any of nexthops %s in the neighbor table\n", nexthops.to_string().c_str());
+            LOGG(TEST_ERR, ROUTE, "fail to retrieve nexthop group %s\n", nexthops.to_string().c_str());
             return false;
         }
 
-        if (nhids.size() > 1)
+        nhg_id = nhgEntry->nhg_id;
+    }
+
+    // referenced once a route using it is stored, see SetRoute()
+    m_NextHopSets.Acquire(nexthopsId);
+    m_EcmpGroups[nexthopsId].id = nhg_id;
+    m_EcmpGroups[nexthopsId].refCount = 0;
+
+    return true;
+}
+
+bool RouteMgr::HasNeighbor(NextHopSetId nexthops) const
+{
+    const std::vector<IpAddress>& addrs = m_NextHopSets.Addrs(nexthops);
+
+    for (std::vector<IpAddress>::const_iterator itnh = addrs.begin(); itnh != addrs.end(); itnh++)
+    {
+        if (m_neighborMgr->GetNeighborEntry(*itnh))
         {
-            if (!m_nhgMgr->Add(nexthops))
-            {
-                LOGG(TEST_ERR, ROUTE, "fail to add nexthop group %s\n", nexthops.to_string().c_str());
-                return false;
-            }
+            return true;
+        }
+    }
 
-            const NextHopGrpEntry *nhgEntry = m_nhgMgr->GetNextHopGrpEntry(nexthops);
+    return false;
+}
 
-            if (!nhgEntry)
-            {
-                LOGG(TEST_ERR, ROUTE, "fail to retrieve nexthop group %s\n", nexthops.to_string().c_str());
-                return false;
-            }
+void RouteMgr::Park(const IpPrefix& prefix, NextHopSetId nexthops)
+{
+    Unpark(prefix);
 
-            nhg_id = nhgEntry->nhg_id;
+    LOGG(TEST_DEBUG, ROUTE, "route %s parked until one of %s resolves\n",
+         prefix.to_string().c_str(), m_NextHopSets.Get(nexthops).to_string().c_str());
+
+    m_NextHopSets.Acquire(nexthops);
+    m_Parked[prefix] = nexthops;
+
+    const std::vector<IpAddress>& addrs = m_NextHopSets.Addrs(nexthops);
+
+    for (std::vector<IpAddress>::const_iterator itnh = addrs.begin(); itnh != addrs.end(); itnh++)
+    {
+        m_ParkedByNextHop[*itnh].insert(prefix);
+    }
+}
+
+bool RouteMgr::Unpark(const IpPrefix& prefix)
+{
+    std::map<IpPrefix, NextHopSetId>::iterator it = m_Parked.find(prefix);
+
+    if (it == m_Parked.end())
+    {
+        return false;
+    }
+
+    NextHopSetId nexthops = it->second;
+    const std::vector<IpAddress>& addrs = m_NextHopSets.Addrs(nexthops);
+
+    for (std::vector<IpAddress>::const_iterator itnh = addrs.begin(); itnh != addrs.end(); itnh++)
+    {
+        std::map<IpAddress, std::set<IpPrefix> >::iterator itp = m_ParkedByNextHop.find(*itnh);
+
+        if (itp == m_ParkedByNextHop.end())
+        {
+            continue;
         }
 
-        m_EcmpGroups[nexthops] = nhg_id;
+        itp->second.erase(prefix);
+
+        if (itp->second.empty())
+        {
+            m_ParkedByNextHop.erase(itp);
+        }
     }
-    else
+
+    m_Parked.erase(it);
+    m_NextHopSets.Release(nexthops);
+
+    return true;
+}
+
+bool RouteMgr::NeighborResolved(const IpAddress& ip)
+{
+    // groups built while ip had no neighbor
+    bool ok = m_nhgMgr->RestoreNextHop(ip);
+
+    std::map<IpAddress, std::set<IpPrefix> >::const_iterator itp = m_ParkedByNextHop.find(ip);
+
+    if (itp == m_ParkedByNextHop.end())
     {
-        nhg_id = m_EcmpGroups[nexthops];
+        return ok;
     }
 
+    // Unpark() edits the index, take the routes out first
+    std::vector<std::pair<IpPrefix, NextHopSetId> > routes;
 
-    sai_unicast_route_entry_t unicast_route_entry;
-    unicast_route_entry.vr_id = g_vr_id;
-    unicast_route_entry.destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    unicast_route_entry.destination.addr.ip4 = prefix.Addr().addr();
-    unicast_route_entry.destination.mask.ip4 = prefix.Mask().addr();
+    for (std::set<IpPrefix>::const_iterator it = itp->second.begin(); it != itp->second.end(); it++)
+    {
+        routes.push_back(std::make_pair(*it, m_Parked[*it]));
+    }
 
-    sai_attribute_t route_attr;
+    LOGG(TEST_INFO, ROUTE, "neighbor %s resolved, programming %zu parked routes\n",
+         ip.to_string().c_str(), routes.size());
+
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        m_NextHopSets.Acquire(routes[i].second);
+        Unpark(routes[i].first);
+    }
 
-    if (nexthops.size() == 1 &&
-            nexthops == IpAddresses("0.0.0.0"))
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        ok = AddRouteBatch(routes[i].first, routes[i].second) && ok;
+        m_NextHopSets.Release(routes[i].second);
+    }
+
+    return Flush() && ok;
+}
+
+void RouteMgr::GetRouteAttr(NextHopSetId nexthops, sai_object_id_t nhg_id, sai_attribute_t& route_attr)
+{
+    if (nexthops == m_BlackHole)
     {
         route_attr.id = SAI_ROUTE_ATTR_PACKET_ACTION;
         route_attr.value.s32 = SAI_PACKET_ACTION_DROP;
@@ -164,6 +274,55 @@ bool RouteMgr::Add(IpPrefix prefix, IpAddresses nexthops)
         route_attr.id = SAI_ROUTE_ATTR_NEXT_HOP_ID;
         route_attr.value.oid = nhg_id;
     }
+}
+
+bool RouteMgr::Add(IpPrefix prefix, IpAddresses nexthops)
+{
+    // hold the set while the route is programmed
+    NextHopSetId id = m_NextHopSets.Acquire(nexthops);
+    bool ok = AddRoute(prefix, id);
+    m_NextHopSets.Release(id);
+
+    return ok;
+}
+
+bool RouteMgr::AddRoute(const IpPrefix& prefix, NextHopSetId nexthopsId)
+{
+    sai_status_t status;
+    sai_object_id_t nhg_id;
+    const IpAddresses nexthops = m_NextHopSets.Get(nexthopsId);
+
+    // keep the order with a batched operation still queued for this prefix
+    if (m_PendingIndex.find(prefix) != m_PendingIndex.end())
+    {
+        Flush();
+    }
+
+    Unpark(prefix);
+
+    if (UpdateInPlace(prefix, nexthopsId))
+    {
+        return true;
+    }
+
+    if (!GetNextHopId(nexthopsId, nhg_id))
+    {
+        if (HasNeighbor(nexthopsId))
+        {
+            return false;
+        }
+
+        Park(prefix, nexthopsId);
+        return true;
+    }
+
+    sai_unicast_route_entry_t unicast_route_entry;
+    unicast_route_entry.vr_id = g_vr_id;
+    ToSaiIpPrefix(prefix, unicast_route_entry.destination);
+
+    sai_attribute_t route_attr;
+
+    GetRouteAttr(nexthopsId, nhg_id, route_attr);
 
     if (m_Routes.find(prefix) == m_Routes.end())
     {
@@ -177,6 +336,7 @@ bool RouteMgr::Add(IpPrefix prefix, IpAddresses nexthops)
             LOGG(TEST_ERR, ROUTE, "fail to create route for %s, nexthop(s) are %s rc=0x%x\n",
                  prefix.to_string().c_str(),
                  nexthops.to_string().c_str(), -status);
+            RemoveUnusedNextHops(nexthopsId);
             return false;
         }
     }
@@ -192,13 +352,12 @@ bool RouteMgr::Add(IpPrefix prefix, IpAddresses nexthops)
             LOGG(TEST_ERR, ROUTE, "fail to set nexthop(s) %s for route %s, rc=0x%x",
                  nexthops.to_string().c_str(),
                  prefix.to_string().c_str(), -status);
+            RemoveUnusedNextHops(nexthopsId);
             return false;
         }
-
-        return true;
     }
 
-    m_Routes[prefix] = nexthops;
+    SetRoute(prefix, nexthopsId);
 
     return true;
 }
@@ -207,8 +366,15 @@ bool RouteMgr::Del(IpPrefix prefix)
 {
 
     RouteTable::const_iterator it;
+
+    if (m_PendingIndex.find(prefix) != m_PendingIndex.end())
+    {
+        Flush();
+    }
+
+    Unpark(prefix);
+
     it = m_Routes.find(prefix);
-    IpAddresses nexthops;
 
     if (it == m_Routes.end())
     {
@@ -222,9 +388,7 @@ bool RouteMgr::Del(IpPrefix prefix)
 
     sai_unicast_route_entry_t unicast_route_entry;
     unicast_route_entry.vr_id = g_vr_id;
-    unicast_route_entry.destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
-    unicast_route_entry.destination.addr.ip4 = prefix.Addr().addr();
-    unicast_route_entry.destination.mask.ip4 = prefix.Mask().addr();
+    ToSaiIpPrefix(prefix, unicast_route_entry.destination);
 
     sai_status_t status = sai_route_api->remove_route(&unicast_route_entry);
 
@@ -234,19 +398,49 @@ bool RouteMgr::Del(IpPrefix prefix)
         return false;
     }
 
+    return EraseRoute(prefix);
+}
 
-    sai_object_id_t nhg_id;
-    nexthops = m_Routes[prefix];
+void RouteMgr::AcquireNextHops(NextHopSetId nexthops)
+{
+    m_EcmpGroups[nexthops].refCount++;
+}
 
-    nhg_id = m_EcmpGroups[nexthops];
+bool RouteMgr::ReleaseNextHops(NextHopSetId nexthops)
+{
+    std::unordered_map<NextHopSetId, NextHopRef>::iterator itnhg = m_EcmpGroups.find(nexthops);
+
+    if (itnhg == m_EcmpGroups.end())
+    {
+        return true;
+    }
+
+    if (itnhg->second.refCount > 0)
+    {
+        itnhg->second.refCount--;
+    }
+
+    return RemoveUnusedNextHops(nexthops);
+}
+
+bool RouteMgr::RemoveUnusedNextHops(NextHopSetId nexthops)
+{
+    std::unordered_map<NextHopSetId, NextHopRef>::iterator itnhg = m_EcmpGroups.find(nexthops);
 
     //skip the entry for blackhole
-    if (nhg_id == 0)
+    if (itnhg == m_EcmpGroups.end() || itnhg->second.refCount > 0 || itnhg->second.id == 0)
     {
-        m_Routes.erase(prefix);
         return true;
     }
 
+    // queued routes are not counted and may use it, Flush() sweeps it up
+    if (!m_Pending.empty())
+    {
+        return true;
+    }
+
+    sai_object_id_t nhg_id = itnhg->second.id;
+
     //On this field, there could be next hop id and next hop group id.
     //the following handles only next hop group id
     if (SAI_OID_TYPE_CHECK(nhg_id, SAI_OBJECT_TYPE_NEXT_HOP_GROUP))
@@ -260,28 +454,107 @@ bool RouteMgr::Del(IpPrefix prefix)
         }
     }
 
-    m_EcmpGroups.erase(nexthops);
-    m_Routes.erase(prefix);
+    m_EcmpGroups.erase(itnhg);
+    m_NextHopSets.Release(nexthops);
+
+    return true;
+}
 
-    for (it = m_Routes.begin(); it != m_Routes.end(); ++it)
+bool RouteMgr::RemoveUnusedNextHops()
+{
+    std::vector<NextHopSetId> unused;
+
+    for (std::unordered_map<NextHopSetId, NextHopRef>::const_iterator itnhg = m_EcmpGroups.begin();
+            itnhg != m_EcmpGroups.end(); itnhg++)
     {
-        if (it->second == nexthops)
+        if (itnhg->second.refCount == 0 && itnhg->second.id != 0)
         {
-            break;
+            unused.push_back(itnhg->first);
         }
     }
 
-    return true;
+    bool ok = true;
+
+    for (size_t i = 0; i < unused.size(); i++)
+    {
+        ok = RemoveUnusedNextHops(unused[i]) && ok;
+    }
+
+    return ok;
 }
 
+bool RouteMgr::UpdateInPlace(const IpPrefix& prefix, NextHopSetId nexthopsId)
+{
+    RouteTable::const_iterator it = m_Routes.find(prefix);
+
+    // queued routes may still point at the group under its current set
+    if (it == m_Routes.end() || it->second == nexthopsId || !m_Pending.empty() ||
+            m_EcmpGroups.find(nexthopsId) != m_EcmpGroups.end() ||
+            nexthopsId == m_BlackHole)
+    {
+        return false;
+    }
+
+    NextHopSetId oldNexthopsId = it->second;
+    std::unordered_map<NextHopSetId, NextHopRef>::iterator itnhg = m_EcmpGroups.find(oldNexthopsId);
+
+    if (itnhg == m_EcmpGroups.end() || itnhg->second.refCount != 1 ||
+            !SAI_OID_TYPE_CHECK(itnhg->second.id, SAI_OBJECT_TYPE_NEXT_HOP_GROUP))
+    {
+        return false;
+    }
+
+    // exactly one nexthop added or removed
+    const std::vector<IpAddress>& oldAddrs = m_NextHopSets.Addrs(oldNexthopsId);
+    const std::vector<IpAddress>& newAddrs = m_NextHopSets.Addrs(nexthopsId);
+    std::vector<IpAddress> diff;
+
+    std::set_symmetric_difference(oldAddrs.begin(), oldAddrs.end(), newAddrs.begin(), newAddrs.end(),
+                                  std::back_inserter(diff));
+
+    if (diff.size() != 1)
+    {
+        return false;
+    }
+
+    const IpAddresses oldNexthops = m_NextHopSets.Get(oldNexthopsId);
+    const IpAddresses nexthops = m_NextHopSets.Get(nexthopsId);
+
+    if (!m_nhgMgr->Update(oldNexthopsId, nexthopsId))
+    {
+        LOGG(TEST_ERR, ROUTE, "fail to update nexthopgrp id 0x%lx to %s\n",
+             itnhg->second.id, nexthops.to_string().c_str());
+        return false;
+    }
+
+    LOGG(TEST_INFO, ROUTE, "route %s nexthops %s -> %s, nexthopgrp id 0x%lx updated in place\n",
+         prefix.to_string().c_str(), oldNexthops.to_string().c_str(),
+         nexthops.to_string().c_str(), itnhg->second.id);
+
+    // rekey the group unreferenced, SetRoute() takes the route's reference
+    NextHopRef ref = itnhg->second;
+    ref.refCount = 0;
+    m_EcmpGroups.erase(itnhg);
+    m_NextHopSets.Release(oldNexthopsId);
+    m_NextHopSets.Acquire(nexthopsId);
+    m_EcmpGroups[nexthopsId] = ref;
+
+    SetRoute(prefix, nexthopsId);
+
+    return true;
+}
 
 bool RouteMgr::EraseAll()
 {
-    RouteTable::const_iterator it;
+    while (!m_Parked.empty())
+    {
+        Unpark(m_Parked.begin()->first);
+    }
 
-    for (it = m_Routes.begin(); it != m_Routes.end(); ++it)
+    // Del() erases from m_Routes, so always take the first route left
+    while (!m_Routes.empty())
     {
-        if (!RouteMgr::Del(it->first))
+        if (!RouteMgr::Del(m_Routes.begin()->first))
         {
             return false;
         }
@@ -289,3 +562,440 @@ bool RouteMgr::EraseAll()
 
     return true;
 }
+
+void RouteMgr::SetBatchThresholds(size_t batchSize, unsigned int batchDelayMs)
+{
+    m_BatchSize = batchSize ? batchSize : 1;
+    m_BatchDelay = std::chrono::milliseconds(batchDelayMs);
+}
+
+void RouteMgr::GetBatchThresholds(size_t& batchSize, unsigned int& batchDelayMs) const
+{
+    batchSize = m_BatchSize;
+    batchDelayMs = (unsigned int)m_BatchDelay.count();
+}
+
+bool RouteMgr::QueueRoute(RouteOp op, const IpPrefix& prefix, NextHopSetId nexthops, const sai_attribute_t& attr)
+{
+    std::map<IpPrefix, size_t>::iterator it = m_PendingIndex.find(prefix);
+
+    // a queued route holds a reference on its nexthop set until Flush()
+    m_NextHopSets.Acquire(nexthops);
+
+    if (it != m_PendingIndex.end())
+    {
+        // same operation queued for this prefix, the latest one wins
+        PendingRoute& pending = m_Pending[it->second];
+        m_NextHopSets.Release(pending.nexthops);
+        pending.nexthops = nexthops;
+        pending.attr = attr;
+        return FlushIfDue();
+    }
+
+    if (m_Pending.empty())
+    {
+        m_BatchStart = std::chrono::steady_clock::now();
+    }
+
+    PendingRoute pending;
+    pending.op = op;
+    pending.prefix = prefix;
+    pending.nexthops = nexthops;
+    pending.attr = attr;
+
+    memset(&pending.entry, 0, sizeof(pending.entry));
+    pending.entry.vr_id = g_vr_id;
+    ToSaiIpPrefix(prefix, pending.entry.destination);
+
+    m_PendingIndex[prefix] = m_Pending.size();
+    m_Pending.push_back(pending);
+
+    return FlushIfDue();
+}
+
+bool RouteMgr::FlushIfDue()
+{
+    if (m_Pending.size() >= m_BatchSize ||
+            std::chrono::steady_clock::now() - m_BatchStart >= m_BatchDelay)
+    {
+        return Flush();
+    }
+
+    return true;
+}
+
+bool RouteMgr::AddBatch(IpPrefix prefix, IpAddresses nexthops)
+{
+    NextHopSetId id = m_NextHopSets.Acquire(nexthops);
+    bool ok = AddRouteBatch(prefix, id);
+    m_NextHopSets.Release(id);
+
+    return ok;
+}
+
+bool RouteMgr::AddRouteBatch(const IpPrefix& prefix, NextHopSetId nexthops)
+{
+    sai_object_id_t nhg_id;
+    sai_attribute_t route_attr;
+
+    std::map<IpPrefix, size_t>::iterator it = m_PendingIndex.find(prefix);
+
+    // a queued remove has to reach SAI before the route can be created again
+    if (it != m_PendingIndex.end() && m_Pending[it->second].op == ROUTE_OP_REMOVE)
+    {
+        Flush();
+    }
+
+    Unpark(prefix);
+
+    if (UpdateInPlace(prefix, nexthops))
+    {
+        return true;
+    }
+
+    if (!GetNextHopId(nexthops, nhg_id))
+    {
+        if (HasNeighbor(nexthops))
+        {
+            return false;
+        }
+
+        Park(prefix, nexthops);
+        return FlushIfDue();
+    }
+
+    GetRouteAttr(nexthops, nhg_id, route_attr);
+
+    RouteOp op = (m_Routes.find(prefix) == m_Routes.end()) ? ROUTE_OP_CREATE : ROUTE_OP_SET;
+
+    return QueueRoute(op, prefix, nexthops, route_attr);
+}
+
+bool RouteMgr::DelBatch(IpPrefix prefix)
+{
+    sai_attribute_t route_attr;
+
+    std::map<IpPrefix, size_t>::iterator it = m_PendingIndex.find(prefix);
+
+    if (it != m_PendingIndex.end())
+    {
+        if (m_Pending[it->second].op == ROUTE_OP_REMOVE)
+        {
+            return FlushIfDue();
+        }
+
+        // the route has to be in SAI before it can be removed
+        Flush();
+    }
+
+    Unpark(prefix);
+
+    if (m_Routes.find(prefix) == m_Routes.end())
+    {
+        LOGG(TEST_DEBUG, ROUTE, "cannot find route %s in the route table\n", prefix.to_string().c_str());
+        return true;
+    }
+
+    memset(&route_attr, 0, sizeof(route_attr));
+
+    return QueueRoute(ROUTE_OP_REMOVE, prefix, m_Routes[prefix], route_attr);
+}
+
+bool RouteMgr::Flush()
+{
+    std::vector<PendingRoute*> creates;
+    std::vector<PendingRoute*> sets;
+    std::vector<PendingRoute*> removes;
+
+    for (size_t i = 0; i < m_Pending.size(); i++)
+    {
+        switch (m_Pending[i].op)
+        {
+            case ROUTE_OP_CREATE:
+                creates.push_back(&m_Pending[i]);
+                break;
+            case ROUTE_OP_SET:
+                sets.push_back(&m_Pending[i]);
+                break;
+            case ROUTE_OP_REMOVE:
+                removes.push_back(&m_Pending[i]);
+                break;
+        }
+    }
+
+    // removes go first to free table space for the creates
+    bool ok = FlushOp(ROUTE_OP_REMOVE, removes);
+    ok = FlushOp(ROUTE_OP_SET, sets) && ok;
+    ok = FlushOp(ROUTE_OP_CREATE, creates) && ok;
+
+    for (size_t i = 0; i < m_Pending.size(); i++)
+    {
+        m_NextHopSets.Release(m_Pending[i].nexthops);
+    }
+
+    m_Pending.clear();
+    m_PendingIndex.clear();
+
+    // groups built for routes which failed or were requeued with other nexthops
+    ok = RemoveUnusedNextHops() && ok;
+
+    return ok;
+}
+
+void RouteMgr::TakeFlushFailures(std::set<IpPrefix>& failures)
+{
+    failures.clear();
+    failures.swap(m_FlushFailures);
+}
+
+bool RouteMgr::FlushOp(RouteOp op, std::vector<PendingRoute*>& routes)
+{
+    uint32_t count = (uint32_t)routes.size();
+
+    if (count == 0)
+    {
+        return true;
+    }
+
+    std::vector<sai_status_t> statuses(count, SAI_STATUS_SUCCESS);
+
+    LOGG(TEST_INFO, ROUTE, "sai_route_api->%s %u routes\n",
+         op == ROUTE_OP_CREATE ? "create_route" : op == ROUTE_OP_SET ? "set_route_attribute" : "remove_route",
+         count);
+
+    // the route api has no bulk calls, the batch is programmed route by route
+    for (uint32_t i = 0; i < count; i++)
+    {
+        switch (op)
+        {
+            case ROUTE_OP_CREATE:
+                statuses[i] = sai_route_api->create_route(&routes[i]->entry, 1, &routes[i]->attr);
+                break;
+            case ROUTE_OP_SET:
+                statuses[i] = sai_route_api->set_route_attribute(&routes[i]->entry, &routes[i]->attr);
+                break;
+            case ROUTE_OP_REMOVE:
+                statuses[i] = sai_route_api->remove_route(&routes[i]->entry);
+                break;
+        }
+    }
+
+    bool ok = true;
+
+    for (uint32_t i = 0; i < count; i++)
+    {
+        PendingRoute* route = routes[i];
+
+        if (statuses[i] != SAI_STATUS_SUCCESS)
+        {
+            LOGG(TEST_ERR, ROUTE, "fail to %s route %s, nexthop(s) are %s rc=0x%x\n",
+                 op == ROUTE_OP_CREATE ? "create" : op == ROUTE_OP_SET ? "set" : "remove",
+                 route->prefix.to_string().c_str(),
+                 m_NextHopSets.Get(route->nexthops).to_string().c_str(), -statuses[i]);
+            m_FlushFailures.insert(route->prefix);
+            ok = false;
+            continue;
+        }
+
+        if (!m_FlushFailures.empty())
+        {
+            m_FlushFailures.erase(route->prefix);
+        }
+
+        if (op == ROUTE_OP_REMOVE)
+        {
+            ok = EraseRoute(route->prefix) && ok;
+        }
+        else
+        {
+            SetRoute(route->prefix, route->nexthops);
+        }
+    }
+
+    return ok;
+}
+
+void RouteMgr::SetRoute(const IpPrefix& prefix, NextHopSetId nexthops)
+{
+    RouteTable::iterator it = m_Routes.find(prefix);
+
+    if (it == m_Routes.end())
+    {
+        m_Routes.insert(std::make_pair(prefix, nexthops));
+        m_NextHopSets.Acquire(nexthops);
+        AcquireNextHops(nexthops);
+    }
+    else if (it->second != nexthops)
+    {
+        NextHopSetId oldNexthops = it->second;
+
+        it->second = nexthops;
+        m_NextHopSets.Acquire(nexthops);
+        AcquireNextHops(nexthops);
+        ReleaseNextHops(oldNexthops);
+        m_NextHopSets.Release(oldNexthops);
+    }
+
+    if (prefix.IsV4())
+    {
+        m_Fib4.Insert(prefix.Addr().Bytes(), prefix.MaskLen(), nexthops);
+    }
+    else
+    {
+        m_Fib6.Insert(prefix.Addr().Bytes(), prefix.MaskLen(), nexthops);
+    }
+}
+
+bool RouteMgr::EraseRoute(const IpPrefix& prefix)
+{
+    RouteTable::iterator it = m_Routes.find(prefix);
+
+    if (it == m_Routes.end())
+    {
+        return true;
+    }
+
+    NextHopSetId nexthops = it->second;
+
+    if (prefix.IsV4())
+    {
+        m_Fib4.Remove(prefix.Addr().Bytes(), prefix.MaskLen());
+    }
+    else
+    {
+        m_Fib6.Remove(prefix.Addr().Bytes(), prefix.MaskLen());
+    }
+
+    m_Routes.erase(it);
+
+    bool ok = ReleaseNextHops(nexthops);
+    m_NextHopSets.Release(nexthops);
+
+    return ok;
+}
+
+static IpPrefix FibKeyToPrefix(bool v4, const uint8_t* key, int len)
+{
+    if (v4)
+    {
+        uint32_t addr;
+        memcpy(&addr, key, IPV4_ADDR_LEN);
+        return IpPrefix(IpAddress(addr), len);
+    }
+
+    return IpPrefix(IpAddress::FromV6(key), len);
+}
+
+const NextHopSetId* RouteMgr::FibLookup(const IpAddress& addr, int& len) const
+{
+    if (addr.IsV4())
+    {
+        return m_Fib4.Lookup(addr.Bytes(), addr.BitLen(), &len);
+    }
+
+    return m_Fib6.Lookup(addr.Bytes(), addr.BitLen(), &len);
+}
+
+const std::vector<IpAddress>* RouteMgr::Lookup(const IpAddress& addr, IpPrefix* matched) const
+{
+    int len = 0;
+    const NextHopSetId* nexthops = FibLookup(addr, len);
+
+    if (!nexthops)
+    {
+        return NULL;
+    }
+
+    if (matched)
+    {
+        *matched = IpPrefix(addr, len);
+    }
+
+    return &m_NextHopSets.Addrs(*nexthops);
+}
+
+void RouteMgr::CoveredRoutes(const IpPrefix& prefix, std::vector<IpPrefix>& routes) const
+{
+    bool v4 = prefix.IsV4();
+
+    auto collect = [&routes, v4](const uint8_t* key, int len, NextHopSetId)
+    {
+        routes.push_back(FibKeyToPrefix(v4, key, len));
+    };
+
+    if (v4)
+    {
+        m_Fib4.ForEachCovered(prefix.Addr().Bytes(), prefix.MaskLen(), collect);
+    }
+    else
+    {
+        m_Fib6.ForEachCovered(prefix.Addr().Bytes(), prefix.MaskLen(), collect);
+    }
+}
+
+bool RouteMgr::ResolveNextHops(const IpAddresses& nexthops, IpAddresses& resolved)
+{
+    return ResolveNextHops(nexthops, resolved, ROUTE_RESOLVE_MAX_DEPTH);
+}
+
+bool RouteMgr::ResolveNextHops(const IpAddresses& nexthops, IpAddresses& resolved, int depth)
+{
+    std::set<IpAddress> addrset = nexthops.AddrSet();
+
+    for (std::set<IpAddress>::const_iterator itnh = addrset.begin(); itnh != addrset.end(); itnh++)
+    {
+        if (m_neighborMgr->GetNeighborEntry(*itnh))
+        {
+            resolved.add(*itnh);
+            continue;
+        }
+
+        int len = 0;
+        const NextHopSetId* via = FibLookup(*itnh, len);
+
+        if (!via || depth == 0 || *via == m_BlackHole)
+        {
+            LOGG(TEST_DEBUG, ROUTE, "cannot resolve nexthop %s\n", itnh->to_string().c_str());
+            continue;
+        }
+
+        LOGG(TEST_DEBUG, ROUTE, "nexthop %s resolves through %s\n",
+             itnh->to_string().c_str(), IpPrefix(*itnh, len).to_string().c_str());
+
+        ResolveNextHops(m_NextHopSets.Get(*via), resolved, depth - 1);
+    }
+
+    return resolved.size() != 0;
+}
+
+bool RouteMgr::ValidateFib() const
+{
+    if (m_Fib4.Size() + m_Fib6.Size() != m_Routes.size())
+    {
+        LOGG(TEST_ERR, ROUTE, "shadow FIB holds %zu routes, route table %zu\n",
+             m_Fib4.Size() + m_Fib6.Size(), m_Routes.size());
+        return false;
+    }
+
+    for (RouteTable::const_iterator it = m_Routes.begin(); it != m_Routes.end(); it++)
+    {
+        const IpPrefix& prefix = it->first;
+        const NextHopSetId* nexthops = prefix.IsV4() ?
+            m_Fib4.Find(prefix.Addr().Bytes(), prefix.MaskLen()) :
+            m_Fib6.Find(prefix.Addr().Bytes(), prefix.MaskLen());
+
+        if (!nexthops || *nexthops != it->second)
+        {
+            LOGG(TEST_ERR, ROUTE, "route %s missing from the shadow FIB\n", prefix.to_string().c_str());
+            return false;
+        }
+    }
+
+    LOGG(TEST_DEBUG, ROUTE, "shadow FIB: %zu IPv4 routes in %zu nodes, %zu IPv6 routes in %zu nodes, %zu bytes\n",
+         m_Fib4.Size(), m_Fib4.NodeCount(), m_Fib6.Size(), m_Fib6.NodeCount(),
+         m_Fib4.MemoryUsage() + m_Fib6.MemoryUsage());
+    LOGG(TEST_DEBUG, ROUTE, "%zu distinct nexthop sets, %zu bytes\n",
+         m_NextHopSets.Size(), m_NextHopSets.MemoryUsage());
+
+    return true;
+}
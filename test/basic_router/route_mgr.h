@@ -23,7 +23,10 @@
 
 #include <set>
 #include <map>
+#include <unordered_map>
 #include <string>
+#include <vector>
+#include <chrono>
 
 extern "C"
 {
@@ -34,29 +37,174 @@ extern "C"
 
 #include "log.h"
 #include "ip.h"
+#include "lpm_trie.h"
+#include "nexthop_set.h"
 #include "basic_router.h"
 
 
 class NeighborMgr;
 class NextHopGrpMgr;
 
-typedef std::map<IpPrefix, IpAddresses> RouteTable;
+// nexthops of each route, as ids into the NextHopSetTable of NextHopGrpMgr
+typedef std::map<IpPrefix, NextHopSetId> RouteTable;
+
+#define ROUTE_BATCH_DEFAULT_SIZE        1024
+#define ROUTE_BATCH_DEFAULT_DELAY_MS    100
+#define ROUTE_RESOLVE_MAX_DEPTH         8
 
 class RouteMgr
 {
     NeighborMgr* m_neighborMgr;
     NextHopGrpMgr* m_nhgMgr;
 
+    /*
+     * Every nexthop set in use is interned once, in the table of
+     * m_nhgMgr. Routes, pending routes and m_EcmpGroups entries each hold
+     * a reference on their set.
+     */
+    NextHopSetTable& m_NextHopSets;
+    NextHopSetId m_BlackHole;
+
     RouteTable m_Routes;
 
-    std::map<IpAddresses, sai_object_id_t> m_EcmpGroups;
+    // shadow FIB per family, same values as m_Routes
+    LpmTrie<IPV4_ADDR_LEN, NextHopSetId> m_Fib4;
+    LpmTrie<IPV6_ADDR_LEN, NextHopSetId> m_Fib6;
+
+    /*
+     * nexthop or nexthop group per nexthop set, with the number of routes
+     * in m_Routes using it. Entries are released with their last route,
+     * except the black hole entry which is always kept.
+     */
+    struct NextHopRef
+    {
+        sai_object_id_t id;
+        unsigned int refCount;
+    };
+
+    std::unordered_map<NextHopSetId, NextHopRef> m_EcmpGroups;
+
+    enum RouteOp
+    {
+        ROUTE_OP_CREATE,
+        ROUTE_OP_SET,
+        ROUTE_OP_REMOVE
+    };
+
+    struct PendingRoute
+    {
+        RouteOp op;
+        IpPrefix prefix;
+        NextHopSetId nexthops;
+        sai_unicast_route_entry_t entry;
+        sai_attribute_t attr;
+    };
+
+    // routes queued by AddBatch/DelBatch, at most one per prefix
+    std::vector<PendingRoute> m_Pending;
+    std::map<IpPrefix, size_t> m_PendingIndex;
+
+    // queued routes SAI rejected when flushed, until TakeFlushFailures()
+    std::set<IpPrefix> m_FlushFailures;
+
+    /*
+     * Routes none of whose nexthops has a neighbor yet, so they are not
+     * in SAI (a route already there keeps its old nexthops meanwhile).
+     * Each is parked under every nexthop of its set, NeighborResolved()
+     * re-drives them in one batch once one of those resolves.
+     */
+    std::map<IpPrefix, NextHopSetId> m_Parked;
+    std::map<IpAddress, std::set<IpPrefix> > m_ParkedByNextHop;
+
+    size_t m_BatchSize;
+    std::chrono::milliseconds m_BatchDelay;
+    std::chrono::steady_clock::time_point m_BatchStart;
+
+    bool GetNextHopId(NextHopSetId nexthops, sai_object_id_t& nhg_id);
+    bool HasNeighbor(NextHopSetId nexthops) const;
+    void Park(const IpPrefix& prefix, NextHopSetId nexthops);
+    bool Unpark(const IpPrefix& prefix);
+    void GetRouteAttr(NextHopSetId nexthops, sai_object_id_t nhg_id, sai_attribute_t& route_attr);
+    void AcquireNextHops(NextHopSetId nexthops);
+    bool ReleaseNextHops(NextHopSetId nexthops);
+    bool RemoveUnusedNextHops(NextHopSetId nexthops);
+    bool RemoveUnusedNextHops();
+    bool UpdateInPlace(const IpPrefix& prefix, NextHopSetId nexthops);
+    bool AddRoute(const IpPrefix& prefix, NextHopSetId nexthops);
+    bool AddRouteBatch(const IpPrefix& prefix, NextHopSetId nexthops);
+    void SetRoute(const IpPrefix& prefix, NextHopSetId nexthops);
+    bool EraseRoute(const IpPrefix& prefix);
+    const NextHopSetId* FibLookup(const IpAddress& addr, int& len) const;
+    bool ResolveNextHops(const IpAddresses& nexthops, IpAddresses& resolved, int depth);
+    bool QueueRoute(RouteOp op, const IpPrefix& prefix, NextHopSetId nexthops, const sai_attribute_t& attr);
+    bool FlushIfDue();
+    bool FlushOp(RouteOp op, std::vector<PendingRoute*>& routes);
 
 public:
     RouteMgr(NeighborMgr* neighborMgr, NextHopGrpMgr* nhgMgr);
 
+    /*
+     * Add or update a route. An update moving from one nexthop set to
+     * another that differs by a single nexthop edits the ECMP group in
+     * place when no other route shares it, leaving the route untouched.
+     */
     bool Add(IpPrefix prefix, IpAddresses nexthops);
     bool Del(IpPrefix prefix);
+
+    /*
+     * Called once the neighbor of ip is installed: ECMP groups which
+     * include ip gain it as a member, and the routes parked on ip are
+     * programmed in one batch. Routes whose nexthops have no neighbor
+     * at all are parked by Add()/AddBatch(), which still return true.
+     */
+    bool NeighborResolved(const IpAddress& ip);
+    size_t Parked() const { return m_Parked.size(); }
+    const std::map<IpPrefix, NextHopSetId>& ParkedRoutes() const { return m_Parked; }
     bool EraseAll();
     void Show();
     void ShowECMP();
+
+    /*
+     * Batched mode: routes are queued and programmed together, removes
+     * first, once batchSize routes are pending or the oldest pending route
+     * waited batchDelayMs. The delay is checked on the next AddBatch or
+     * DelBatch call, call Flush() to push out whatever is still queued.
+     */
+    void SetBatchThresholds(size_t batchSize, unsigned int batchDelayMs);
+    void GetBatchThresholds(size_t& batchSize, unsigned int& batchDelayMs) const;
+    bool AddBatch(IpPrefix prefix, IpAddresses nexthops);
+    bool DelBatch(IpPrefix prefix);
+    bool Flush();
+    size_t Pending() const { return m_Pending.size(); }
+
+    // hand over the prefixes whose queued update failed in SAI since the last call
+    void TakeFlushFailures(std::set<IpPrefix>& failures);
+
+    /*
+     * Shadow FIB queries, answered from the software tries without
+     * touching SAI. Lookup() returns the nexthops of the longest prefix
+     * matching addr or NULL, CoveredRoutes() lists every route inside
+     * prefix (prefix itself included).
+     */
+    const std::vector<IpAddress>* Lookup(const IpAddress& addr, IpPrefix* matched = NULL) const;
+    void CoveredRoutes(const IpPrefix& prefix, std::vector<IpPrefix>& routes) const;
+
+    /*
+     * Replace every nexthop which is not a known neighbor by the nexthops
+     * of the route it resolves through, recursively. Returns false when
+     * nothing could be resolved.
+     */
+    bool ResolveNextHops(const IpAddresses& nexthops, IpAddresses& resolved);
+
+    // check the shadow FIB holds exactly the routes in the route table
+    bool ValidateFib() const;
+
+    const RouteTable& Routes() const { return m_Routes; }
+
+    // nexthops of a route in Routes(), NextHopAddrs() in ascending order without a copy
+    IpAddresses NextHops(NextHopSetId nexthops) const { return m_NextHopSets.Get(nexthops); }
+    const std::vector<IpAddress>& NextHopAddrs(NextHopSetId nexthops) const { return m_NextHopSets.Addrs(nexthops); }
+
+    // number of distinct nexthop sets in use
+    size_t NextHopSets() const { return m_NextHopSets.Size(); }
 };
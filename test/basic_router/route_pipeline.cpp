@@ -0,0 +1,307 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#include <limits.h>
+
+#include <chrono>
+#include <set>
+#include <vector>
+
+#include "route_pipeline.h"
+
+RoutePipeline::RoutePipeline(RouteMgr* routeMgr, size_t batchSize) :
+    m_routeMgr(routeMgr),
+    m_batchSize(batchSize ? batchSize : 1),
+    m_savedBatchSize(ROUTE_BATCH_DEFAULT_SIZE),
+    m_savedBatchDelayMs(ROUTE_BATCH_DEFAULT_DELAY_MS),
+    m_head(&m_stub),
+    m_tail(&m_stub),
+    m_running(false),
+    m_received(0),
+    m_superseded(0),
+    m_applied(0),
+    m_failed(0),
+    m_batches(0)
+{
+    m_stub.next.store(NULL, std::memory_order_relaxed);
+}
+
+RoutePipeline::~RoutePipeline()
+{
+    Stop();
+
+    // intents pushed after Stop() are dropped
+    Intent* intent;
+
+    while ((intent = Pop()) != NULL)
+    {
+        delete intent;
+    }
+}
+
+void RoutePipeline::Push(Intent* intent)
+{
+    intent->next.store(NULL, std::memory_order_relaxed);
+
+    Intent* prev = m_head.exchange(intent, std::memory_order_acq_rel);
+
+    // between the exchange and this store the consumer sees a gap and
+    // simply retries later
+    prev->next.store(intent, std::memory_order_release);
+}
+
+RoutePipeline::Intent* RoutePipeline::Pop()
+{
+    Intent* tail = m_tail;
+    Intent* next = tail->next.load(std::memory_order_acquire);
+
+    if (tail == &m_stub)
+    {
+        if (next == NULL)
+        {
+            return NULL;
+        }
+
+        m_tail = next;
+        tail = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next)
+    {
+        m_tail = next;
+        return tail;
+    }
+
+    if (tail != m_head.load(std::memory_order_acquire))
+    {
+        // a producer is half way through Push()
+        return NULL;
+    }
+
+    // tail is the last intent, put the stub behind it so it can be taken
+    Push(&m_stub);
+
+    next = tail->next.load(std::memory_order_acquire);
+
+    if (next)
+    {
+        m_tail = next;
+        return tail;
+    }
+
+    return NULL;
+}
+
+void RoutePipeline::Start()
+{
+    if (m_running.exchange(true))
+    {
+        return;
+    }
+
+    // batches are cut here, RouteMgr must not flush on its own
+    m_routeMgr->GetBatchThresholds(m_savedBatchSize, m_savedBatchDelayMs);
+    m_routeMgr->SetBatchThresholds(m_batchSize + 1, UINT_MAX);
+
+    m_consumer = std::thread(&RoutePipeline::Consume, this);
+}
+
+void RoutePipeline::Stop()
+{
+    if (!m_running.exchange(false))
+    {
+        return;
+    }
+
+    m_consumer.join();
+
+    m_routeMgr->SetBatchThresholds(m_savedBatchSize, m_savedBatchDelayMs);
+}
+
+void RoutePipeline::Add(const IpPrefix& prefix, const IpAddresses& nexthops)
+{
+    Intent* intent = new Intent;
+    intent->op = INTENT_ADD;
+    intent->prefix = prefix;
+    intent->nexthops = nexthops;
+
+    m_received++;
+    Push(intent);
+}
+
+void RoutePipeline::Del(const IpPrefix& prefix)
+{
+    Intent* intent = new Intent;
+    intent->op = INTENT_DEL;
+    intent->prefix = prefix;
+
+    m_received++;
+    Push(intent);
+}
+
+void RoutePipeline::NeighborResolved(const IpAddress& ip)
+{
+    Intent* intent = new Intent;
+    intent->op = INTENT_NEIGHBOR_RESOLVED;
+    intent->neighbor = ip;
+
+    m_received++;
+    Push(intent);
+}
+
+void RoutePipeline::Drain()
+{
+    while (m_superseded + m_applied + m_failed < m_received)
+    {
+        std::this_thread::sleep_for(std::chrono::microseconds(ROUTE_PIPELINE_IDLE_US));
+    }
+}
+
+void RoutePipeline::GetStats(RoutePipelineStats& stats) const
+{
+    stats.received = m_received;
+    stats.superseded = m_superseded;
+    stats.applied = m_applied;
+    stats.failed = m_failed;
+    stats.batches = m_batches;
+}
+
+void RoutePipeline::Consume()
+{
+    std::map<IpPrefix, Intent*> coalesced;
+
+    while (true)
+    {
+        // read the flag first: once it is off, everything pushed before
+        // Stop() is visible and drained by this last round
+        bool running = m_running;
+        size_t count = 0;
+        Intent* intent;
+
+        while (count < m_batchSize && (intent = Pop()) != NULL)
+        {
+            count++;
+
+            if (intent->op == INTENT_NEIGHBOR_RESOLVED)
+            {
+                // intents pushed before the neighbor came up go out first
+                if (!coalesced.empty())
+                {
+                    Apply(coalesced);
+                }
+
+                (m_routeMgr->NeighborResolved(intent->neighbor) ? m_applied : m_failed)++;
+                delete intent;
+                continue;
+            }
+
+            std::map<IpPrefix, Intent*>::iterator it = coalesced.find(intent->prefix);
+
+            if (it == coalesced.end())
+            {
+                coalesced[intent->prefix] = intent;
+            }
+            else
+            {
+                // queue order is producer order, the later intent wins
+                delete it->second;
+                it->second = intent;
+                m_superseded++;
+            }
+        }
+
+        if (!coalesced.empty())
+        {
+            Apply(coalesced);
+        }
+
+        if (count > 0)
+        {
+            continue;
+        }
+
+        if (!running)
+        {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::microseconds(ROUTE_PIPELINE_IDLE_US));
+    }
+}
+
+void RoutePipeline::Apply(std::map<IpPrefix, Intent*>& coalesced)
+{
+    uint64_t applied = 0;
+    uint64_t failed = 0;
+    std::vector<IpPrefix> queued;
+    std::set<IpPrefix> flushFailures;
+
+    // failures left over from outside the pipeline are not ours to count
+    m_routeMgr->TakeFlushFailures(flushFailures);
+
+    for (std::map<IpPrefix, Intent*>::iterator it = coalesced.begin(); it != coalesced.end(); ++it)
+    {
+        Intent* intent = it->second;
+        bool ok;
+
+        if (intent->op == INTENT_ADD)
+        {
+            ok = m_routeMgr->AddBatch(intent->prefix, intent->nexthops);
+        }
+        else
+        {
+            ok = m_routeMgr->DelBatch(intent->prefix);
+        }
+
+        if (ok)
+        {
+            queued.push_back(intent->prefix);
+        }
+        else
+        {
+            failed++;
+        }
+
+        delete intent;
+    }
+
+    if (!m_routeMgr->Flush())
+    {
+        LOGG(TEST_ERR, ROUTE, "route pipeline: some of %zu routes failed to program\n", coalesced.size());
+    }
+
+    // a route only counts as applied once SAI took it, whichever flush pushed it out
+    m_routeMgr->TakeFlushFailures(flushFailures);
+
+    for (size_t i = 0; i < queued.size(); i++)
+    {
+        (flushFailures.count(queued[i]) ? failed : applied)++;
+    }
+
+    LOGG(TEST_DEBUG, ROUTE, "route pipeline: applied %lu intents, %lu failed\n", applied, failed);
+
+    coalesced.clear();
+
+    m_batches++;
+    m_failed += failed;
+    m_applied += applied;
+}
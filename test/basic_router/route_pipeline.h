@@ -0,0 +1,122 @@
+/*
+ * Copyright (c) 2015 Microsoft Open Technologies, Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License"); you may
+ *    not use this file except in compliance with the License. You may obtain
+ *    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+ *    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+ *    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+ *    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+ *
+ *    See the Apache Version 2.0 License for specific language governing
+ *    permissions and limitations under the License.
+ *
+ *    Microsoft would like to thank the following companies for their review and
+ *    assistance with these files: Intel Corporation, Mellanox Technologies Ltd,
+ *    Dell Products, L.P., Facebook, Inc
+ *
+ *
+ */
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <thread>
+
+#include "log.h"
+#include "ip.h"
+#include "route_mgr.h"
+
+#define ROUTE_PIPELINE_DEFAULT_BATCH    4096
+#define ROUTE_PIPELINE_IDLE_US          500
+
+struct RoutePipelineStats
+{
+    uint64_t received;      // intents pushed by the producers, resolved neighbors included
+    uint64_t superseded;    // dropped because a later intent for the prefix came in
+    uint64_t applied;       // programmed in SAI
+    uint64_t failed;        // rejected by RouteMgr or by SAI at flush time
+    uint64_t batches;
+};
+
+/*
+ * Route updates from any number of producer threads, applied by a single
+ * consumer thread.
+ *
+ * Producers push add/delete intents on a lock-free multi-producer single
+ * consumer queue. The consumer drains up to batchSize intents at a time
+ * and keeps only the last one per prefix, so a prefix flapping within a
+ * batch costs one SAI operation instead of one per flap. What is left is
+ * programmed with RouteMgr's batch path.
+ *
+ * While the pipeline runs, the consumer thread owns the RouteMgr: nobody
+ * else may call it until Stop() returns. A neighbor coming up is queued
+ * like a route intent, see NeighborResolved(), and re-drives the routes
+ * waiting on it from the consumer thread.
+ */
+class RoutePipeline
+{
+    enum IntentOp
+    {
+        INTENT_ADD,
+        INTENT_DEL,
+        INTENT_NEIGHBOR_RESOLVED
+    };
+
+    struct Intent
+    {
+        std::atomic<Intent*> next;
+        IntentOp op;
+        IpPrefix prefix;
+        IpAddresses nexthops;
+        IpAddress neighbor;
+    };
+
+    RouteMgr* m_routeMgr;
+    size_t m_batchSize;
+
+    // RouteMgr thresholds before Start(), put back by Stop()
+    size_t m_savedBatchSize;
+    unsigned int m_savedBatchDelayMs;
+
+    // Vyukov intrusive MPSC queue: producers swap m_head, the consumer
+    // owns m_tail, m_stub keeps the queue from ever being empty
+    std::atomic<Intent*> m_head;
+    Intent* m_tail;
+    Intent m_stub;
+
+    std::thread m_consumer;
+    std::atomic<bool> m_running;
+
+    std::atomic<uint64_t> m_received;
+    std::atomic<uint64_t> m_superseded;
+    std::atomic<uint64_t> m_applied;
+    std::atomic<uint64_t> m_failed;
+    std::atomic<uint64_t> m_batches;
+
+    void Push(Intent* intent);
+    Intent* Pop();
+    void Consume();
+    void Apply(std::map<IpPrefix, Intent*>& coalesced);
+
+public:
+    RoutePipeline(RouteMgr* routeMgr, size_t batchSize = ROUTE_PIPELINE_DEFAULT_BATCH);
+    ~RoutePipeline();
+
+    void Start();
+
+    // apply whatever is still queued, then stop the consumer
+    void Stop();
+
+    // thread safe, may be called from any number of threads
+    void Add(const IpPrefix& prefix, const IpAddresses& nexthops);
+    void Del(const IpPrefix& prefix);
+    void NeighborResolved(const IpAddress& ip);
+
+    // wait until every intent pushed so far has been applied or superseded
+    void Drain();
+
+    void GetStats(RoutePipelineStats& stats) const;
+};
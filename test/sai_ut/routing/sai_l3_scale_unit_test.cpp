@@ -0,0 +1,682 @@
+/************************************************************************
+* Copyright (c) 2015 Dell Inc.
+*
+*    Licensed under the Apache License, Version 2.0 (the "License"); you may
+*    not use this file except in compliance with the License. You may obtain
+*    a copy of the License at http://www.apache.org/licenses/LICENSE-2.0
+*
+*    THIS CODE IS PROVIDED ON AN  *AS IS* BASIS, WITHOUT WARRANTIES OR
+*    CONDITIONS OF ANY KIND, EITHER EXPRESS OR IMPLIED, INCLUDING WITHOUT
+*    LIMITATION ANY IMPLIED WARRANTIES OR CONDITIONS OF TITLE, FITNESS
+*    FOR A PARTICULAR PURPOSE, MERCHANTABLITY OR NON-INFRINGEMENT.
+*
+*    See the Apache Version 2.0 License for specific language governing
+*    permissions and limitations under the License.
+*
+*
+* Module Name:
+*
+*    sai_l3_scale_unit_test.cpp
+*
+* Abstract:
+*
+*    SAI L3 SCALE TEST :- Creates, gets and removes N routes, neighbors and
+*    next hop group members, optionally from several threads against the
+*    same switch, and reports the time taken by each phase.
+*
+*    The object counts and thread counts come from the comma separated
+*    lists in SAI_UT_SCALE_COUNTS (default 1000,10000,100000,1000000) and
+*    SAI_UT_SCALE_THREADS (default 1), every combination is run. Results
+*    are printed as one JSON object per line, appended to the file named
+*    by SAI_UT_SCALE_OUTPUT when it is set.
+*
+*************************************************************************/
+
+#include "gtest/gtest.h"
+
+#include "sai_l3_unit_test_utils.h"
+
+#include <chrono>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+extern "C" {
+#include "sai.h"
+#include "saistatus.h"
+#include "saitypes.h"
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <arpa/inet.h>
+#include <inttypes.h>
+}
+
+/* One scale run: number of objects and of threads sharing the work */
+typedef struct _sai_test_scale_param_t {
+    unsigned int count;
+    unsigned int threads;
+} sai_test_scale_param_t;
+
+/* Used by gtest to name the parameterised test instances */
+void PrintTo (const sai_test_scale_param_t &param, ::std::ostream *os)
+{
+    *os << param.count << " objects, " << param.threads << " threads";
+}
+
+typedef struct _sai_test_scale_stats_t {
+    unsigned int ops;
+    unsigned int failures;
+    double       usecs;
+} sai_test_scale_stats_t;
+
+/* Scale phase operation on the object of the given index */
+typedef sai_status_t (*sai_test_scale_op_fn) (unsigned int index);
+
+class saiL3ScaleTest : public saiL3Test,
+                       public ::testing::WithParamInterface<sai_test_scale_param_t>
+{
+    public:
+        static void SetUpTestCase (void);
+        static void TearDownTestCase (void);
+
+        static std::vector<sai_test_scale_param_t> sai_test_scale_params_get (void);
+
+        void sai_test_scale_run (const char *suite, const char *op,
+                                 unsigned int count,
+                                 sai_test_scale_op_fn op_fn,
+                                 const std::vector<uint8_t> *p_mask,
+                                 std::vector<uint8_t> *p_done,
+                                 sai_test_scale_stats_t *p_stats);
+
+        static sai_status_t sai_test_scale_route_create (unsigned int index);
+        static sai_status_t sai_test_scale_route_get (unsigned int index);
+        static sai_status_t sai_test_scale_route_remove (unsigned int index);
+
+        static sai_status_t sai_test_scale_neighbor_create (unsigned int index);
+        static sai_status_t sai_test_scale_neighbor_get (unsigned int index);
+        static sai_status_t sai_test_scale_neighbor_remove (unsigned int index);
+
+        static sai_status_t sai_test_scale_group_create (unsigned int index);
+        static sai_status_t sai_test_scale_group_get (unsigned int index);
+        static sai_status_t sai_test_scale_group_remove (unsigned int index);
+        static sai_status_t sai_test_scale_member_add (unsigned int index);
+        static sai_status_t sai_test_scale_member_remove (unsigned int index);
+
+        static const unsigned int default_port = 0;
+
+        /* Next hops shared by the scaled routes and next hop groups */
+        static const unsigned int nh_pool_size = 16;
+
+        /* Routes are /24s from 64.0.0.0, neighbors hosts from 20.0.0.1 */
+        static const uint32_t route_base_addr    = 0x40000000;
+        static const uint32_t neighbor_base_addr = 0x14000001;
+
+        static sai_object_id_t  port_id;
+        static sai_object_id_t  vrf_id;
+        static sai_object_id_t  port_rif_id;
+        static sai_object_id_t  nh_pool [nh_pool_size];
+
+        /* Count of the current scale run and its next hop groups */
+        static unsigned int                  scale_count;
+        static std::vector<sai_object_id_t>  nh_group_list;
+};
+
+sai_object_id_t saiL3ScaleTest::port_id = 0;
+sai_object_id_t saiL3ScaleTest::vrf_id = 0;
+sai_object_id_t saiL3ScaleTest::port_rif_id = 0;
+sai_object_id_t saiL3ScaleTest::nh_pool [nh_pool_size];
+unsigned int saiL3ScaleTest::scale_count = 0;
+std::vector<sai_object_id_t> saiL3ScaleTest::nh_group_list;
+
+/*
+ * Parse a comma separated list of positive numbers from the environment.
+ */
+static std::vector<unsigned int> sai_test_scale_list_get (const char *env,
+                                                         const char *dflt)
+{
+    std::vector<unsigned int> list;
+    const char               *p_str = getenv (env);
+    char                     *p_end;
+    unsigned long             val;
+
+    if ((p_str == NULL) || (*p_str == '\0')) {
+        p_str = dflt;
+    }
+
+    while (*p_str != '\0')
+    {
+        val = strtoul (p_str, &p_end, 0);
+
+        if (p_end == p_str) {
+            printf ("%s: ignoring invalid value \"%s\".\n", env, p_str);
+            break;
+        }
+
+        if (val != 0) {
+            list.push_back ((unsigned int) val);
+        }
+
+        p_str = (*p_end == ',') ? p_end + 1 : p_end;
+    }
+
+    return list;
+}
+
+std::vector<sai_test_scale_param_t> saiL3ScaleTest::sai_test_scale_params_get (void)
+{
+    std::vector<sai_test_scale_param_t> params;
+    std::vector<unsigned int>           counts;
+    std::vector<unsigned int>           threads;
+    sai_test_scale_param_t              param;
+
+    counts  = sai_test_scale_list_get ("SAI_UT_SCALE_COUNTS",
+                                       "1000,10000,100000,1000000");
+    threads = sai_test_scale_list_get ("SAI_UT_SCALE_THREADS", "1");
+
+    for (size_t c = 0; c < counts.size (); c++)
+    {
+        for (size_t t = 0; t < threads.size (); t++)
+        {
+            param.count   = counts [c];
+            param.threads = threads [t];
+
+            params.push_back (param);
+        }
+    }
+
+    return params;
+}
+
+void saiL3ScaleTest::SetUpTestCase (void)
+{
+    sai_status_t   status;
+    const char    *p_neighbor_mac = "00:a1:a2:a3:a4:00";
+    char           ip_addr_str [64];
+
+    /* Base SetUpTestCase for SAI initialization */
+    saiL3Test::SetUpTestCase ();
+
+    /* SAI Router default MAC address init */
+    status = sai_test_router_mac_init (router_mac);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, status);
+
+    port_id = sai_l3_port_id_get (default_port);
+
+    /* Create a Virtual Router instance */
+    status = sai_test_vrf_create (&vrf_id, 0);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, status);
+
+    /* Create a Port RIF */
+    status = sai_test_rif_create (&port_rif_id, default_rif_attr_count,
+                                  SAI_ROUTER_INTERFACE_ATTR_VIRTUAL_ROUTER_ID,
+                                  vrf_id,
+                                  SAI_ROUTER_INTERFACE_ATTR_TYPE,
+                                  SAI_ROUTER_INTERFACE_TYPE_PORT,
+                                  SAI_ROUTER_INTERFACE_ATTR_PORT_ID,
+                                  port_id);
+
+    ASSERT_EQ (SAI_STATUS_SUCCESS, status);
+
+    /* Create the Neighbors and Next Hops shared by the scale test cases */
+    for (unsigned int count = 0; count < nh_pool_size; count++)
+    {
+        snprintf (ip_addr_str, sizeof (ip_addr_str), "11.0.0.%u", count + 1);
+
+        status = sai_test_neighbor_create (port_rif_id, SAI_IP_ADDR_FAMILY_IPV4,
+                                           ip_addr_str,
+                                           default_neighbor_attr_count,
+                                           SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS,
+                                           p_neighbor_mac);
+
+        ASSERT_EQ (SAI_STATUS_SUCCESS, status);
+
+        status = sai_test_nexthop_create (&nh_pool [count],
+                                          default_nh_attr_count,
+                                          SAI_NEXT_HOP_ATTR_TYPE,
+                                          SAI_NEXT_HOP_IP,
+                                          SAI_NEXT_HOP_ATTR_ROUTER_INTERFACE_ID,
+                                          port_rif_id,
+                                          SAI_NEXT_HOP_ATTR_IP,
+                                          SAI_IP_ADDR_FAMILY_IPV4, ip_addr_str);
+
+        ASSERT_EQ (SAI_STATUS_SUCCESS, status);
+    }
+}
+
+void saiL3ScaleTest::TearDownTestCase (void)
+{
+    sai_status_t   status;
+    char           ip_addr_str [64];
+
+    for (unsigned int count = 0; count < nh_pool_size; count++)
+    {
+        snprintf (ip_addr_str, sizeof (ip_addr_str), "11.0.0.%u", count + 1);
+
+        status = sai_test_nexthop_remove (nh_pool [count]);
+
+        EXPECT_EQ (SAI_STATUS_SUCCESS, status);
+
+        status = sai_test_neighbor_remove (port_rif_id, SAI_IP_ADDR_FAMILY_IPV4,
+                                           ip_addr_str);
+
+        EXPECT_EQ (SAI_STATUS_SUCCESS, status);
+    }
+
+    /* Remove the Port RIF */
+    status = sai_test_rif_remove (port_rif_id);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, status);
+
+    /* Remove the VRF */
+    status = sai_test_vrf_remove (vrf_id);
+
+    EXPECT_EQ (SAI_STATUS_SUCCESS, status);
+}
+
+/*
+ * Run op_fn on the objects [0, count), skipping those not set in p_mask,
+ * with the range split in contiguous slices over the threads of the test
+ * parameter. Objects for which op_fn succeeds are flagged in p_done. The
+ * timing of the phase is printed as a JSON line and recorded as a gtest
+ * property.
+ */
+void saiL3ScaleTest::sai_test_scale_run (const char *suite, const char *op,
+                                         unsigned int count,
+                                         sai_test_scale_op_fn op_fn,
+                                         const std::vector<uint8_t> *p_mask,
+                                         std::vector<uint8_t> *p_done,
+                                         sai_test_scale_stats_t *p_stats)
+{
+    const sai_test_scale_param_t        &param = GetParam ();
+    unsigned int                         threads = param.threads;
+    std::vector<sai_test_scale_stats_t>  thread_stats;
+    std::vector<std::thread>             workers;
+    double                               ops_per_sec = 0;
+    char                                 key [128];
+    const char                          *p_file;
+    FILE                                *fp;
+
+    if (threads > count) {
+        threads = (count == 0) ? 1 : count;
+    }
+
+    memset (p_stats, 0, sizeof (sai_test_scale_stats_t));
+    thread_stats.resize (threads, *p_stats);
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now ();
+
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        unsigned int begin = (unsigned int) (((uint64_t) count * t) / threads);
+        unsigned int end   = (unsigned int) (((uint64_t) count * (t + 1)) / threads);
+        sai_test_scale_stats_t *p_thread_stats = &thread_stats [t];
+
+        workers.push_back (std::thread ([=] () {
+            for (unsigned int index = begin; index < end; index++)
+            {
+                if ((p_mask != NULL) && !(*p_mask) [index]) {
+                    continue;
+                }
+
+                p_thread_stats->ops++;
+
+                if (op_fn (index) != SAI_STATUS_SUCCESS) {
+                    p_thread_stats->failures++;
+                } else if (p_done != NULL) {
+                    (*p_done) [index] = 1;
+                }
+            }
+        }));
+    }
+
+    for (unsigned int t = 0; t < threads; t++)
+    {
+        workers [t].join ();
+
+        p_stats->ops      += thread_stats [t].ops;
+        p_stats->failures += thread_stats [t].failures;
+    }
+
+    p_stats->usecs = std::chrono::duration<double, std::micro> (
+                            std::chrono::steady_clock::now () - start).count ();
+
+    if (p_stats->usecs > 0) {
+        ops_per_sec = (p_stats->ops * 1000000.0) / p_stats->usecs;
+    }
+
+    p_file = getenv ("SAI_UT_SCALE_OUTPUT");
+    fp     = ((p_file != NULL) && (*p_file != '\0')) ? fopen (p_file, "a") : NULL;
+
+    fprintf ((fp != NULL) ? fp : stdout,
+             "{\"suite\": \"%s\", \"op\": \"%s\", \"count\": %u, "
+             "\"threads\": %u, \"ops\": %u, \"failures\": %u, "
+             "\"usec\": %.0f, \"ops_per_sec\": %.0f}\n",
+             suite, op, param.count, param.threads, p_stats->ops,
+             p_stats->failures, p_stats->usecs, ops_per_sec);
+
+    if (fp != NULL) {
+        fclose (fp);
+    }
+
+    snprintf (key, sizeof (key), "%s_%s_usec", suite, op);
+    RecordProperty (key, (int) p_stats->usecs);
+}
+
+/*
+ * Route entry of the given index, a /24 pointing at a pool Next Hop.
+ */
+static void sai_test_scale_route_entry_get (sai_object_id_t vrf_id,
+                                            unsigned int index,
+                                            sai_unicast_route_entry_t *p_entry)
+{
+    memset (p_entry, 0, sizeof (sai_unicast_route_entry_t));
+
+    p_entry->vr_id                    = vrf_id;
+    p_entry->destination.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    p_entry->destination.addr.ip4    =
+        htonl (saiL3ScaleTest::route_base_addr + (index << 8));
+    p_entry->destination.mask.ip4    = htonl (0xffffff00);
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_route_create (unsigned int index)
+{
+    sai_unicast_route_entry_t entry;
+    sai_attribute_t           attr;
+
+    sai_test_scale_route_entry_get (vrf_id, index, &entry);
+
+    memset (&attr, 0, sizeof (sai_attribute_t));
+
+    attr.id        = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+    attr.value.oid = nh_pool [index % nh_pool_size];
+
+    return route_api_tbl_get ()->create_route (&entry, 1, &attr);
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_route_get (unsigned int index)
+{
+    sai_unicast_route_entry_t entry;
+    sai_attribute_t           attr;
+    sai_status_t              sai_rc;
+
+    sai_test_scale_route_entry_get (vrf_id, index, &entry);
+
+    memset (&attr, 0, sizeof (sai_attribute_t));
+
+    attr.id = SAI_ROUTE_ATTR_NEXT_HOP_ID;
+
+    sai_rc = route_api_tbl_get ()->get_route_attribute (&entry, 1, &attr);
+
+    if ((sai_rc == SAI_STATUS_SUCCESS) &&
+        (attr.value.oid != nh_pool [index % nh_pool_size])) {
+        sai_rc = SAI_STATUS_FAILURE;
+    }
+
+    return sai_rc;
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_route_remove (unsigned int index)
+{
+    sai_unicast_route_entry_t entry;
+
+    sai_test_scale_route_entry_get (vrf_id, index, &entry);
+
+    return route_api_tbl_get ()->remove_route (&entry);
+}
+
+/*
+ * Neighbor entry of the given index, with a MAC address derived from it.
+ */
+static void sai_test_scale_neighbor_entry_get (sai_object_id_t rif_id,
+                                               unsigned int index,
+                                               sai_neighbor_entry_t *p_entry,
+                                               sai_mac_t mac)
+{
+    memset (p_entry, 0, sizeof (sai_neighbor_entry_t));
+
+    p_entry->rif_id                 = rif_id;
+    p_entry->ip_address.addr_family = SAI_IP_ADDR_FAMILY_IPV4;
+    p_entry->ip_address.addr.ip4    =
+        htonl (saiL3ScaleTest::neighbor_base_addr + index);
+
+    mac [0] = 0x00;
+    mac [1] = 0xb1;
+    mac [2] = (uint8_t) (index >> 24);
+    mac [3] = (uint8_t) (index >> 16);
+    mac [4] = (uint8_t) (index >> 8);
+    mac [5] = (uint8_t) index;
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_neighbor_create (unsigned int index)
+{
+    sai_neighbor_entry_t entry;
+    sai_attribute_t      attr;
+
+    memset (&attr, 0, sizeof (sai_attribute_t));
+
+    sai_test_scale_neighbor_entry_get (port_rif_id, index, &entry,
+                                       attr.value.mac);
+
+    attr.id = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
+
+    return nbr_api_tbl_get ()->create_neighbor_entry (&entry, 1, &attr);
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_neighbor_get (unsigned int index)
+{
+    sai_neighbor_entry_t entry;
+    sai_attribute_t      attr;
+    sai_mac_t            mac;
+    sai_status_t         sai_rc;
+
+    sai_test_scale_neighbor_entry_get (port_rif_id, index, &entry, mac);
+
+    memset (&attr, 0, sizeof (sai_attribute_t));
+
+    attr.id = SAI_NEIGHBOR_ATTR_DST_MAC_ADDRESS;
+
+    sai_rc = nbr_api_tbl_get ()->get_neighbor_attribute (&entry, 1, &attr);
+
+    if ((sai_rc == SAI_STATUS_SUCCESS) &&
+        (memcmp (attr.value.mac, mac, sizeof (sai_mac_t)) != 0)) {
+        sai_rc = SAI_STATUS_FAILURE;
+    }
+
+    return sai_rc;
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_neighbor_remove (unsigned int index)
+{
+    sai_neighbor_entry_t entry;
+    sai_mac_t            mac;
+
+    sai_test_scale_neighbor_entry_get (port_rif_id, index, &entry, mac);
+
+    return nbr_api_tbl_get ()->remove_neighbor_entry (&entry);
+}
+
+/*
+ * Next hop groups are created with the first pool Next Hop, member index
+ * then adds pool Next Hop (1 + index % (nh_pool_size - 1)) to the group
+ * (index / (nh_pool_size - 1)), so every group ends up using the full pool.
+ */
+sai_status_t saiL3ScaleTest::sai_test_scale_group_create (unsigned int index)
+{
+    sai_attribute_t attr_list [2];
+
+    memset (attr_list, 0, sizeof (attr_list));
+
+    attr_list [0].id        = SAI_NEXT_HOP_GROUP_ATTR_TYPE;
+    attr_list [0].value.s32 = SAI_NEXT_HOP_GROUP_ECMP;
+
+    attr_list [1].id                    = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_LIST;
+    attr_list [1].value.objlist.count   = 1;
+    attr_list [1].value.objlist.list    = &nh_pool [0];
+
+    return nh_grp_api_tbl_get ()->create_next_hop_group (&nh_group_list [index],
+                                                         2, attr_list);
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_group_get (unsigned int index)
+{
+    sai_attribute_t attr;
+    sai_status_t    sai_rc;
+    unsigned int    members = nh_pool_size - 1;
+    unsigned int    nh_count;
+
+    /* The last group may be partially filled */
+    if (((index + 1) * members) > scale_count) {
+        members = scale_count - (index * members);
+    }
+
+    memset (&attr, 0, sizeof (sai_attribute_t));
+
+    attr.id = SAI_NEXT_HOP_GROUP_ATTR_NEXT_HOP_COUNT;
+
+    sai_rc = nh_grp_api_tbl_get ()->get_next_hop_group_attribute (
+                                               nh_group_list [index], 1, &attr);
+
+    nh_count = attr.value.u32;
+
+    if ((sai_rc == SAI_STATUS_SUCCESS) && (nh_count != (members + 1))) {
+        sai_rc = SAI_STATUS_FAILURE;
+    }
+
+    return sai_rc;
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_group_remove (unsigned int index)
+{
+    return nh_grp_api_tbl_get ()->remove_next_hop_group (nh_group_list [index]);
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_member_add (unsigned int index)
+{
+    sai_object_id_t nh_id = nh_pool [1 + (index % (nh_pool_size - 1))];
+
+    return nh_grp_api_tbl_get ()->add_next_hop_to_group (
+                             nh_group_list [index / (nh_pool_size - 1)], 1,
+                             &nh_id);
+}
+
+sai_status_t saiL3ScaleTest::sai_test_scale_member_remove (unsigned int index)
+{
+    sai_object_id_t nh_id = nh_pool [1 + (index % (nh_pool_size - 1))];
+
+    return nh_grp_api_tbl_get ()->remove_next_hop_from_group (
+                             nh_group_list [index / (nh_pool_size - 1)], 1,
+                             &nh_id);
+}
+
+/*
+ * Create N /24 routes over the pool Next Hops, get their Next Hop and
+ * remove them.
+ */
+TEST_P (saiL3ScaleTest, route_create_get_remove)
+{
+    const unsigned int      count = GetParam ().count;
+    std::vector<uint8_t>    created (count, 0);
+    sai_test_scale_stats_t  stats;
+
+    sai_test_scale_run ("route", "create", count,
+                        sai_test_scale_route_create, NULL, &created, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    sai_test_scale_run ("route", "get", count,
+                        sai_test_scale_route_get, &created, NULL, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    sai_test_scale_run ("route", "remove", count,
+                        sai_test_scale_route_remove, &created, NULL, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+}
+
+/*
+ * Create N Neighbors on the Port RIF, get their MAC address and remove
+ * them.
+ */
+TEST_P (saiL3ScaleTest, neighbor_create_get_remove)
+{
+    const unsigned int      count = GetParam ().count;
+    std::vector<uint8_t>    created (count, 0);
+    sai_test_scale_stats_t  stats;
+
+    sai_test_scale_run ("neighbor", "create", count,
+                        sai_test_scale_neighbor_create, NULL, &created, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    sai_test_scale_run ("neighbor", "get", count,
+                        sai_test_scale_neighbor_get, &created, NULL, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    sai_test_scale_run ("neighbor", "remove", count,
+                        sai_test_scale_neighbor_remove, &created, NULL, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+}
+
+/*
+ * Add N members to Next Hop groups of nh_pool_size Next Hops, get the
+ * Next Hop count of the groups, then remove the members and the groups.
+ */
+TEST_P (saiL3ScaleTest, nh_group_member_add_get_remove)
+{
+    const unsigned int      count = GetParam ().count;
+    const unsigned int      groups = (count + nh_pool_size - 2) / (nh_pool_size - 1);
+    std::vector<uint8_t>    group_created (groups, 0);
+    std::vector<uint8_t>    in_group (count, 0);
+    std::vector<uint8_t>    added (count, 0);
+    sai_test_scale_stats_t  stats;
+
+    scale_count = count;
+    nh_group_list.assign (groups, SAI_NULL_OBJECT_ID);
+
+    sai_test_scale_run ("nh_group", "create", groups,
+                        sai_test_scale_group_create, NULL, &group_created,
+                        &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    /* Members of groups which could not be created are skipped */
+    for (unsigned int index = 0; index < count; index++)
+    {
+        in_group [index] = group_created [index / (nh_pool_size - 1)];
+    }
+
+    sai_test_scale_run ("nh_group_member", "add", count,
+                        sai_test_scale_member_add, &in_group, &added, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    sai_test_scale_run ("nh_group", "get", groups,
+                        sai_test_scale_group_get, &group_created, NULL, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    sai_test_scale_run ("nh_group_member", "remove", count,
+                        sai_test_scale_member_remove, &added, NULL, &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    sai_test_scale_run ("nh_group", "remove", groups,
+                        sai_test_scale_group_remove, &group_created, NULL,
+                        &stats);
+
+    EXPECT_EQ (0u, stats.failures);
+
+    nh_group_list.clear ();
+}
+
+INSTANTIATE_TEST_CASE_P (Scale, saiL3ScaleTest,
+                         ::testing::ValuesIn (
+                             saiL3ScaleTest::sai_test_scale_params_get ()));
@@ -191,6 +191,25 @@ class saiL3Test : public ::testing::Test
             return p_sai_switch_api_tbl;
         }
 
+        /*
+         * Methods for retrieving the L3 API table pointers, for test cases
+         * calling the APIs in tight loops without the verbose wrappers.
+         */
+        static inline sai_neighbor_api_t* nbr_api_tbl_get (void)
+        {
+            return p_sai_nbr_api_tbl;
+        }
+
+        static inline sai_next_hop_group_api_t* nh_grp_api_tbl_get (void)
+        {
+            return p_sai_nh_grp_api_tbl;
+        }
+
+        static inline sai_route_api_t* route_api_tbl_get (void)
+        {
+            return p_sai_route_api_tbl;
+        }
+
         static const unsigned int default_rif_attr_count      = 3;
         static const unsigned int default_nh_attr_count       = 3;
         static const unsigned int default_neighbor_attr_count = 1;
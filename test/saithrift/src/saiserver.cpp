@@ -22,6 +22,7 @@
 #include <arpa/inet.h>
 #include "switch_sai_rpc.h"
 #include "switch_sai_rpc_server.h"
+#include "switch_sai_fdb_map.h"
 
 #define UNREFERENCED_PARAMETER(P)   (P)
 
@@ -32,109 +33,79 @@ extern "C" {
 
 
 #define SWITCH_SAI_THRIFT_RPC_SERVER_PORT 9092
+#define SWITCH_SAI_THRIFT_NOTIFICATION_SERVER_PORT 9093
 
 sai_switch_api_t* sai_switch_api;
 
 std::map<std::string, std::string> gProfileMap;
 std::map<std::set<int>, std::string> gPortMap;
 
-extern std::vector<std::pair<sai_fdb_entry_t, sai_object_id_t>> gFdbMap;
+extern sai_thrift_fdb_map gFdbMap;
 
 sai_object_id_t gSwitchId; ///< SAI switch global object ID.
 
 void on_switch_state_change(_In_ sai_object_id_t switch_id,
                             _In_ sai_switch_oper_status_t switch_oper_status)//
 {
+    sai_thrift_notify_switch_state_change(switch_id, switch_oper_status);
 }
 
 void on_fdb_event(_In_ uint32_t count,
                   _In_ sai_fdb_event_notification_data_t *data)
 {
-    sai_fdb_event_t event_type;
-    sai_fdb_entry_t fdb_entry;
-    uint32_t attr_count;
-    sai_attribute_t *attr;
-    sai_object_id_t bv_id;
-    sai_object_id_t bport_id;
-    
-    attr = data->attr;
-    event_type = data->event_type;
-    fdb_entry = data->fdb_entry;
-    bv_id = fdb_entry.bv_id;
-    attr_count = data ->attr_count;
-    
-    for (uint32_t i = 0; i < attr_count; i++)
+    sai_thrift_notify_fdb_event(count, data);
+
+    for (uint32_t i = 0; i < count; i++)
     {
-        if (attr[i].id == SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID)
-            bport_id = attr[i].value.oid;
-    }
-           
-    sai_fdb_entry_t fdb_m;
-    sai_object_id_t b_id;
-      
-    switch (event_type)
-    {   
-        case SAI_FDB_EVENT_LEARNED:
-            gFdbMap.emplace_back(std::pair<sai_fdb_entry_t, sai_object_id_t>(fdb_entry,bport_id));
-            break;
-        case SAI_FDB_EVENT_FLUSHED: 
-            if (bv_id == 0 && bport_id == 0)
-                gFdbMap.clear();
-            else
-            {
-                for (auto it = gFdbMap.begin(); it != gFdbMap.end(); )
-                {
-                    fdb_m = it->first;
-                    b_id = it->second; 				
-	            
-                    if (bport_id == 0 && bv_id == fdb_m.bv_id)
-                        it = gFdbMap.erase(it);
-                    else if (bv_id == 0 && bport_id == b_id)
-                        it = gFdbMap.erase(it);
-                    else if (bv_id == fdb_m.bv_id && bport_id == b_id)
-                        it = gFdbMap.erase(it);
-                    else
-                        it++;
-                }
-            }
-            break;
-        case SAI_FDB_EVENT_MOVE:
-            for (auto it = gFdbMap.begin(); it != gFdbMap.end(); it++)
-            {
-                fdb_m = it->first;
-                b_id = it->second; 
-                int n = memcmp ( fdb_entry.mac_address, fdb_m.mac_address, 6);
-		    
-                if (n == 0 && bv_id == fdb_m.bv_id)
-                    it->second = bport_id;
-            }
-            break;  
-        case SAI_FDB_EVENT_AGED:
-            for (auto it = gFdbMap.begin(); it != gFdbMap.end(); )
-            {
-                fdb_m = it->first;
-                b_id = it->second; 
-                int n = memcmp ( fdb_entry.mac_address, fdb_m.mac_address, 6);  
-                
-                if (n == 0 && bv_id == fdb_m.bv_id)
-                    it = gFdbMap.erase(it);   
-                else
-                    it++; 	
-            }
-            break;
-        default:
-            printf("unknown event");
-            break;
+        const sai_fdb_entry_t &fdb_entry = data[i].fdb_entry;
+        sai_object_id_t bport_id = SAI_NULL_OBJECT_ID;
+
+        for (uint32_t j = 0; j < data[i].attr_count; j++)
+        {
+            if (data[i].attr[j].id == SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID)
+                bport_id = data[i].attr[j].value.oid;
+        }
+
+        switch (data[i].event_type)
+        {
+            case SAI_FDB_EVENT_LEARNED:
+                gFdbMap.learn(fdb_entry, bport_id);
+                break;
+            case SAI_FDB_EVENT_FLUSHED:
+                gFdbMap.flush(fdb_entry.bv_id, bport_id);
+                break;
+            case SAI_FDB_EVENT_MOVE:
+                gFdbMap.move(fdb_entry, bport_id);
+                break;
+            case SAI_FDB_EVENT_AGED:
+                gFdbMap.age(fdb_entry);
+                break;
+            default:
+                printf("unknown event");
+                break;
+        }
     }
-}     
+}
 
 void on_port_state_change(_In_ uint32_t count,
                           _In_ sai_port_oper_status_notification_t *data)
 {
+    sai_thrift_notify_port_state_change(count, data);
 }
 
 void on_shutdown_request(_In_ sai_object_id_t switch_id)//
 {
+    sai_thrift_notify_switch_shutdown_request(switch_id);
+}
+
+void on_switch_asic_sdk_health_event(_In_ sai_object_id_t switch_id,
+                                     _In_ sai_switch_asic_sdk_health_severity_t severity,
+                                     _In_ sai_timespec_t timestamp,
+                                     _In_ sai_switch_asic_sdk_health_category_t category,
+                                     _In_ sai_switch_health_data_t data,
+                                     _In_ const sai_u8_list_t description)
+{
+    sai_thrift_notify_switch_asic_sdk_health_event(switch_id, severity, category, &description);
 }
 
 void on_packet_event(_In_ sai_object_id_t switch_id,
@@ -452,6 +423,15 @@ main(int argc, char* argv[])
         printf("Warn: Failed to set_switch_attribute SAI_SWITCH_ATTR_PACKET_EVENT_NOTIFY : %d \n", status);
     }
 
+    sai_attribute_t attr_health;
+    attr_health.id = SAI_SWITCH_ATTR_SWITCH_ASIC_SDK_HEALTH_EVENT_NOTIFY;
+    attr_health.value.ptr = reinterpret_cast<sai_pointer_t>(&on_switch_asic_sdk_health_event);
+    status = sai_switch_api->set_switch_attribute(gSwitchId, &attr_health);
+    if (status != SAI_STATUS_SUCCESS)
+    {
+        printf("Warn: Failed to set_switch_attribute SAI_SWITCH_ATTR_SWITCH_ASIC_SDK_HEALTH_EVENT_NOTIFY : %d \n", status);
+    }
+
     handleInitScript(options.initScript);
 
 #ifdef BRCMSAI
@@ -460,6 +440,7 @@ main(int argc, char* argv[])
 #endif
 
     start_sai_thrift_rpc_server(SWITCH_SAI_THRIFT_RPC_SERVER_PORT);
+    start_sai_thrift_notification_server(SWITCH_SAI_THRIFT_NOTIFICATION_SERVER_PORT);
 
     const sai_log_level_t log_level = SAI_LOG_LEVEL_NOTICE;
 
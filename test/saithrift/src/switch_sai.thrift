@@ -218,6 +218,30 @@ struct sai_thrift_result_t {
     2: sai_thrift_status_t status;
 }
 
+enum sai_thrift_notification_type_t {
+    SAI_THRIFT_NOTIFICATION_FDB_EVENT = 1,
+    SAI_THRIFT_NOTIFICATION_PORT_STATE_CHANGE = 2,
+    SAI_THRIFT_NOTIFICATION_SWITCH_STATE_CHANGE = 3,
+    SAI_THRIFT_NOTIFICATION_SWITCH_SHUTDOWN_REQUEST = 4,
+    SAI_THRIFT_NOTIFICATION_SWITCH_ASIC_SDK_HEALTH_EVENT = 5
+}
+
+// Pushed as a framed binary struct on the notification port.
+// event is the FDB event type, port/switch oper status or health
+// severity; status is the port error status or health category;
+// dropped counts events lost to queue overflow before this one.
+struct sai_thrift_notification_t {
+    1: sai_thrift_notification_type_t type;
+    2: i64 seq;
+    3: i64 dropped;
+    4: sai_thrift_object_id_t switch_id;
+    5: sai_thrift_object_id_t object_id;
+    6: i32 event;
+    7: i32 status;
+    8: sai_thrift_fdb_values_t fdb_values;
+    9: string description;
+}
+
 service switch_sai_rpc {
     //port API
     sai_thrift_status_t sai_thrift_set_port_attribute(1: sai_thrift_object_id_t port_id, 2: sai_thrift_attribute_t thrift_attr);
@@ -0,0 +1,211 @@
+#ifndef SWITCH_SAI_FDB_MAP_H
+#define SWITCH_SAI_FDB_MAP_H
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+
+extern "C" {
+#include <sai.h>
+}
+
+// Mirror of the FDB learned through SAI notifications.
+//
+// Entries are hashed on (mac, bv_id), with secondary indexes per bridge
+// port and per bv_id, so learning, aging, moving and flushing by port
+// and/or vlan only touch the affected entries. The notification thread
+// writes and the RPC thread reads, a single mutex guards all of it.
+class sai_thrift_fdb_map {
+public:
+    void learn(const sai_fdb_entry_t &fdb_entry, sai_object_id_t bport_id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        fdb_key_t key(fdb_entry);
+        auto it = m_entries.find(key);
+
+        if (it != m_entries.end()) {
+            unindex(key, it->second);
+            it->second.fdb_entry = fdb_entry;
+            it->second.bport_id = bport_id;
+            index(key, it->second);
+            return;
+        }
+
+        fdb_value_t value;
+        value.fdb_entry = fdb_entry;
+        value.bport_id = bport_id;
+
+        m_entries.emplace(key, value);
+        index(key, value);
+    }
+
+    // move an already known entry to another bridge port
+    void move(const sai_fdb_entry_t &fdb_entry, sai_object_id_t bport_id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        fdb_key_t key(fdb_entry);
+        auto it = m_entries.find(key);
+
+        if (it == m_entries.end() || it->second.bport_id == bport_id) {
+            return;
+        }
+
+        unindex(key, it->second);
+        it->second.bport_id = bport_id;
+        index(key, it->second);
+    }
+
+    void age(const sai_fdb_entry_t &fdb_entry) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        fdb_key_t key(fdb_entry);
+        auto it = m_entries.find(key);
+
+        if (it == m_entries.end()) {
+            return;
+        }
+
+        unindex(key, it->second);
+        m_entries.erase(it);
+    }
+
+    // SAI_NULL_OBJECT_ID in bv_id or bport_id acts as a wildcard
+    void flush(sai_object_id_t bv_id, sai_object_id_t bport_id) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (bv_id == SAI_NULL_OBJECT_ID && bport_id == SAI_NULL_OBJECT_ID) {
+            m_entries.clear();
+            m_by_bv.clear();
+            m_by_port.clear();
+            return;
+        }
+
+        auto bv_it = m_by_bv.find(bv_id);
+        auto port_it = m_by_port.find(bport_id);
+
+        const key_set_t *candidates;
+
+        if (bport_id == SAI_NULL_OBJECT_ID) {
+            candidates = (bv_it == m_by_bv.end()) ? NULL : &bv_it->second;
+        } else if (bv_id == SAI_NULL_OBJECT_ID) {
+            candidates = (port_it == m_by_port.end()) ? NULL : &port_it->second;
+        } else if (bv_it == m_by_bv.end() || port_it == m_by_port.end()) {
+            candidates = NULL;
+        } else {
+            // walk the smaller index, the other condition is checked per entry
+            candidates = (bv_it->second.size() < port_it->second.size()) ? &bv_it->second : &port_it->second;
+        }
+
+        if (candidates == NULL) {
+            return;
+        }
+
+        // the index set is modified by unindex(), so walk a copy
+        key_set_t keys(*candidates);
+
+        for (const auto &key: keys) {
+            auto it = m_entries.find(key);
+
+            if (bv_id != SAI_NULL_OBJECT_ID && it->second.fdb_entry.bv_id != bv_id) {
+                continue;
+            }
+
+            if (bport_id != SAI_NULL_OBJECT_ID && it->second.bport_id != bport_id) {
+                continue;
+            }
+
+            unindex(key, it->second);
+            m_entries.erase(it);
+        }
+    }
+
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        return m_entries.size();
+    }
+
+    // call f(fdb_entry, bport_id) for every entry, under the lock
+    void for_each(const std::function<void(const sai_fdb_entry_t &, sai_object_id_t)> &f) const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        for (const auto &kvp: m_entries) {
+            f(kvp.second.fdb_entry, kvp.second.bport_id);
+        }
+    }
+
+private:
+    struct fdb_key_t {
+        explicit fdb_key_t(const sai_fdb_entry_t &fdb_entry) : bv_id(fdb_entry.bv_id) {
+            memcpy(mac, fdb_entry.mac_address, sizeof(mac));
+        }
+
+        bool operator==(const fdb_key_t &other) const {
+            return bv_id == other.bv_id && memcmp(mac, other.mac, sizeof(mac)) == 0;
+        }
+
+        sai_mac_t mac;
+        sai_object_id_t bv_id;
+    };
+
+    struct fdb_key_hash_t {
+        size_t operator()(const fdb_key_t &key) const {
+            uint64_t h = 0;
+
+            for (size_t i = 0; i < sizeof(key.mac); i++) {
+                h = (h << 8) | key.mac[i];
+            }
+
+            // mix in bv_id, then finalize (splitmix64) so the low bits
+            // used by the bucket selection depend on every input bit
+            h ^= key.bv_id + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+
+            return (size_t)(h ^ (h >> 31));
+        }
+    };
+
+    struct fdb_value_t {
+        sai_fdb_entry_t fdb_entry;
+        sai_object_id_t bport_id;
+    };
+
+    typedef std::unordered_set<fdb_key_t, fdb_key_hash_t> key_set_t;
+
+    void index(const fdb_key_t &key, const fdb_value_t &value) {
+        m_by_bv[value.fdb_entry.bv_id].insert(key);
+        m_by_port[value.bport_id].insert(key);
+    }
+
+    void unindex(const fdb_key_t &key, const fdb_value_t &value) {
+        unindex(m_by_bv, value.fdb_entry.bv_id, key);
+        unindex(m_by_port, value.bport_id, key);
+    }
+
+    static void unindex(std::unordered_map<sai_object_id_t, key_set_t> &index,
+                        sai_object_id_t id, const fdb_key_t &key) {
+        auto it = index.find(id);
+
+        if (it == index.end()) {
+            return;
+        }
+
+        it->second.erase(key);
+
+        if (it->second.empty()) {
+            index.erase(it);
+        }
+    }
+
+    mutable std::mutex m_mutex;
+
+    std::unordered_map<fdb_key_t, fdb_value_t, fdb_key_hash_t> m_entries;
+    std::unordered_map<sai_object_id_t, key_set_t> m_by_bv;
+    std::unordered_map<sai_object_id_t, key_set_t> m_by_port;
+};
+
+#endif // SWITCH_SAI_FDB_MAP_H
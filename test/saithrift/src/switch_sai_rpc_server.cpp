@@ -29,6 +29,12 @@ limitations under the License.
 #include <string>
 #include <vector>
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
 #include <iomanip>
 
 #include <iostream>
@@ -38,6 +44,7 @@ limitations under the License.
 #include <thrift/server/TSimpleServer.h>
 #include <thrift/transport/TServerSocket.h>
 #include <thrift/transport/TBufferTransports.h>
+#include <thrift/transport/TTransportException.h>
 #include <arpa/inet.h>
 
 #include <inttypes.h>
@@ -61,6 +68,8 @@ extern "C" {
 #include <saisystemport.h>
 
 #include "arpa/inet.h"
+#include "switch_sai_rpc_server.h"
+#include "switch_sai_fdb_map.h"
 
 #define SAI_THRIFT_LOG_DBG(msg, ...) sai_thrift_timestamp_print(); \
     printf("SAI THRIFT DEBUG: %s(): " msg "\n", __FUNCTION__, ##__VA_ARGS__);
@@ -87,7 +96,7 @@ extern sai_object_id_t gSwitchId;
 
 typedef std::vector<sai_thrift_attribute_t> std_sai_thrift_attr_vctr_t;
 
-std::vector<std::pair<sai_fdb_entry_t, sai_object_id_t>>gFdbMap;
+sai_thrift_fdb_map gFdbMap;
 
 class switch_sai_rpcHandler : virtual public switch_sai_rpcIf {
 public:
@@ -769,31 +778,24 @@ public:
   }
 //listing all the fdb entries from map
   void sai_thrift_get_fdb_entries (sai_thrift_attribute_list_t& thrift_attr_list){
-      sai_mac_t mac_address;
-      sai_object_id_t bv_id;
-      sai_object_id_t bport_id;
-      sai_fdb_entry_t fdb_entry;
-
-      thrift_attr_list.attr_count = gFdbMap.size();
+      thrift_attr_list.attr_list.reserve(gFdbMap.size());
 
-      sai_fdb_entry_t fdb_m;
-      sai_object_id_t b_id;
-
-      for (auto it = gFdbMap.begin(); it != gFdbMap.end(); it++){
-          fdb_m = it->first;
-          b_id = it->second;
+      gFdbMap.for_each([&](const sai_fdb_entry_t &fdb_m, sai_object_id_t b_id) {
+          sai_fdb_entry_t fdb_entry = fdb_m;
 
           sai_thrift_fdb_values_t fdb_value;
           fdb_value.bport_id=b_id;
-          fdb_value.thrift_fdb_entry.bv_id=fdb_m.bv_id;
-          fdb_value.thrift_fdb_entry.mac_address=mac_to_sai_thrift_string(fdb_m.mac_address);
+          fdb_value.thrift_fdb_entry.bv_id=fdb_entry.bv_id;
+          fdb_value.thrift_fdb_entry.mac_address=mac_to_sai_thrift_string(fdb_entry.mac_address);
 
           sai_thrift_attribute_t thrift_fdb_attributes;
           thrift_fdb_attributes.id = SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID;
           thrift_fdb_attributes.value.fdb_values = fdb_value;
 
           thrift_attr_list.attr_list.push_back(thrift_fdb_attributes);
-      }
+      });
+
+      thrift_attr_list.attr_count = thrift_attr_list.attr_list.size();
       return;
   }
 
@@ -4371,6 +4373,336 @@ public:
     }
 };
 
+// Notification stream
+//
+// SAI notification callbacks only copy the event into a fixed size record
+// and push it to a bounded lock-free queue, so they never block on the
+// network. A publisher thread drains the queue, serializes every record as
+// a framed binary sai_thrift_notification_t and writes it to all clients
+// connected to the notification port. When the queue is full the event is
+// dropped and accounted in the "dropped" field of the next notification.
+
+#define SAI_THRIFT_NOTIFICATION_QUEUE_SIZE          1024
+#define SAI_THRIFT_NOTIFICATION_DESCRIPTION_SIZE    256
+#define SAI_THRIFT_NOTIFICATION_SEND_TIMEOUT_MS     1000
+#define SAI_THRIFT_NOTIFICATION_IDLE_WAIT_MS        10
+
+struct sai_thrift_notification_record_t {
+    sai_thrift_notification_type_t::type type;
+    sai_object_id_t switch_id;
+    sai_object_id_t object_id;
+    int32_t event;
+    int32_t status;
+    sai_fdb_entry_t fdb_entry;
+    uint32_t description_size;
+    char description[SAI_THRIFT_NOTIFICATION_DESCRIPTION_SIZE];
+};
+
+// Bounded multi-producer multi-consumer queue, each cell carries a sequence
+// number telling whether it is free for the producer at position pos
+// (seq == pos) or holds data for the consumer at position pos (seq == pos + 1).
+template<typename T, std::size_t N>
+class sai_thrift_notification_queue {
+public:
+    sai_thrift_notification_queue() noexcept : m_enqueue_pos(0), m_dequeue_pos(0)
+    {
+        for (std::size_t i = 0; i < N; i++) {
+            m_cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    bool push(const T &data) noexcept
+    {
+        cell_t *cell;
+        std::size_t pos = m_enqueue_pos.load(std::memory_order_relaxed);
+
+        while (true) {
+            cell = &m_cells[pos & (N - 1)];
+            std::size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+
+            if (diff == 0) {
+                if (m_enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        cell->data = data;
+        cell->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T &data) noexcept
+    {
+        cell_t *cell;
+        std::size_t pos = m_dequeue_pos.load(std::memory_order_relaxed);
+
+        while (true) {
+            cell = &m_cells[pos & (N - 1)];
+            std::size_t seq = cell->seq.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+
+            if (diff == 0) {
+                if (m_dequeue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = m_dequeue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        data = cell->data;
+        cell->seq.store(pos + N, std::memory_order_release);
+        return true;
+    }
+
+private:
+    static_assert((N & (N - 1)) == 0, "queue size must be a power of 2");
+
+    struct cell_t {
+        std::atomic<std::size_t> seq;
+        T data;
+    };
+
+    cell_t m_cells[N];
+    alignas(64) std::atomic<std::size_t> m_enqueue_pos;
+    alignas(64) std::atomic<std::size_t> m_dequeue_pos;
+};
+
+static sai_thrift_notification_queue<sai_thrift_notification_record_t,
+        SAI_THRIFT_NOTIFICATION_QUEUE_SIZE> gNotificationQueue;
+static std::atomic<uint64_t> gNotificationDropped(0);
+
+static std::mutex gNotificationMutex;
+static std::condition_variable gNotificationCv;
+
+static std::mutex gNotificationClientsMutex;
+static std::vector<shared_ptr<TTransport>> gNotificationClients;
+
+static void sai_thrift_notification_push(const sai_thrift_notification_record_t &record) {
+    if (!gNotificationQueue.push(record)) {
+        gNotificationDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    // not taken under the mutex, a missed wakeup is covered by the
+    // publisher's bounded idle wait
+    gNotificationCv.notify_one();
+}
+
+static void sai_thrift_notification_init(sai_thrift_notification_record_t &record, sai_thrift_notification_type_t::type type) {
+    memset(&record, 0, offsetof(sai_thrift_notification_record_t, description));
+    record.type = type;
+}
+
+static void sai_thrift_notification_to_thrift(
+        const sai_thrift_notification_record_t &record,
+        sai_thrift_notification_t &notification) {
+    char macstr[32];
+    const uint8_t *m = record.fdb_entry.mac_address;
+
+    notification.type = record.type;
+    notification.switch_id = record.switch_id;
+    notification.object_id = record.object_id;
+    notification.event = record.event;
+    notification.status = record.status;
+
+    if (record.type == sai_thrift_notification_type_t::SAI_THRIFT_NOTIFICATION_FDB_EVENT) {
+        sprintf(macstr, "%02x:%02x:%02x:%02x:%02x:%02x", m[0], m[1], m[2], m[3], m[4], m[5]);
+        notification.fdb_values.bport_id = record.object_id;
+        notification.fdb_values.thrift_fdb_entry.bv_id = record.fdb_entry.bv_id;
+        notification.fdb_values.thrift_fdb_entry.mac_address = macstr;
+    }
+
+    notification.description.assign(record.description, record.description_size);
+}
+
+// writes happen outside the clients mutex, so a slow client only holds up
+// the publisher, up to the send timeout, and never the accept thread
+static void sai_thrift_notification_send(const uint8_t *frame, uint32_t frame_size) {
+    std::vector<shared_ptr<TTransport>> clients;
+    std::vector<shared_ptr<TTransport>> failed;
+
+    {
+        std::lock_guard<std::mutex> lock(gNotificationClientsMutex);
+        clients = gNotificationClients;
+    }
+
+    for (auto &client : clients) {
+        try {
+            client->write(frame, frame_size);
+            client->flush();
+        } catch (TTransportException &e) {
+            std::cerr << "Dropping notification client: " << e.what() << std::endl;
+            client->close();
+            failed.push_back(client);
+        }
+    }
+
+    if (failed.empty()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(gNotificationClientsMutex);
+
+    for (auto &client : failed) {
+        gNotificationClients.erase(
+                std::remove(gNotificationClients.begin(), gNotificationClients.end(), client),
+                gNotificationClients.end());
+    }
+}
+
+static void * switch_sai_thrift_notification_publisher_thread(void *arg) {
+  shared_ptr<TMemoryBuffer> buffer(new TMemoryBuffer());
+  TBinaryProtocol protocol(buffer);
+  sai_thrift_notification_record_t record;
+  int64_t seq = 0;
+
+  while (true) {
+    if (!gNotificationQueue.pop(record)) {
+      std::unique_lock<std::mutex> lock(gNotificationMutex);
+      gNotificationCv.wait_for(lock, std::chrono::milliseconds(SAI_THRIFT_NOTIFICATION_IDLE_WAIT_MS));
+      continue;
+    }
+
+    sai_thrift_notification_t notification;
+    sai_thrift_notification_to_thrift(record, notification);
+    notification.seq = seq++;
+    notification.dropped = gNotificationDropped.exchange(0, std::memory_order_relaxed);
+
+    // TFramedTransport layout: 4 byte big endian length, then the payload
+    buffer->resetBuffer();
+    buffer->write((const uint8_t *)"\0\0\0\0", 4);
+    notification.write(&protocol);
+
+    uint8_t *frame;
+    uint32_t frame_size;
+    buffer->getBuffer(&frame, &frame_size);
+
+    uint32_t payload_size = htonl(frame_size - 4);
+    memcpy(frame, &payload_size, sizeof(payload_size));
+
+    sai_thrift_notification_send(frame, frame_size);
+  }
+
+  return 0;
+}
+
+static void * switch_sai_thrift_notification_server_thread(void *arg) {
+  int port = *(int *) arg;
+  TServerSocket serverSocket(port);
+
+  serverSocket.setSendTimeout(SAI_THRIFT_NOTIFICATION_SEND_TIMEOUT_MS);
+  serverSocket.listen();
+
+  while (true) {
+    shared_ptr<TTransport> client;
+
+    try {
+      client = serverSocket.accept();
+    } catch (TTransportException &e) {
+      std::cerr << "Notification server accept failed: " << e.what() << std::endl;
+      continue;
+    }
+
+    std::lock_guard<std::mutex> lock(gNotificationClientsMutex);
+    gNotificationClients.push_back(client);
+  }
+
+  return 0;
+}
+
+extern "C" {
+
+void sai_thrift_notify_fdb_event(uint32_t count, const sai_fdb_event_notification_data_t *data)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        sai_thrift_notification_record_t record;
+        sai_thrift_notification_init(record, sai_thrift_notification_type_t::SAI_THRIFT_NOTIFICATION_FDB_EVENT);
+
+        record.switch_id = data[i].fdb_entry.switch_id;
+        record.event = data[i].event_type;
+        record.fdb_entry = data[i].fdb_entry;
+
+        for (uint32_t j = 0; j < data[i].attr_count; j++) {
+            if (data[i].attr[j].id == SAI_FDB_ENTRY_ATTR_BRIDGE_PORT_ID) {
+                record.object_id = data[i].attr[j].value.oid;
+            }
+        }
+
+        sai_thrift_notification_push(record);
+    }
+}
+
+void sai_thrift_notify_port_state_change(uint32_t count, const sai_port_oper_status_notification_t *data)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        sai_thrift_notification_record_t record;
+        sai_thrift_notification_init(record, sai_thrift_notification_type_t::SAI_THRIFT_NOTIFICATION_PORT_STATE_CHANGE);
+
+        record.switch_id = gSwitchId;
+        record.object_id = data[i].port_id;
+        record.event = data[i].port_state;
+        record.status = data[i].port_error_status;
+
+        sai_thrift_notification_push(record);
+    }
+}
+
+void sai_thrift_notify_switch_state_change(sai_object_id_t switch_id, sai_switch_oper_status_t switch_oper_status)
+{
+    sai_thrift_notification_record_t record;
+    sai_thrift_notification_init(record, sai_thrift_notification_type_t::SAI_THRIFT_NOTIFICATION_SWITCH_STATE_CHANGE);
+
+    record.switch_id = switch_id;
+    record.object_id = switch_id;
+    record.event = switch_oper_status;
+
+    sai_thrift_notification_push(record);
+}
+
+void sai_thrift_notify_switch_shutdown_request(sai_object_id_t switch_id)
+{
+    sai_thrift_notification_record_t record;
+    sai_thrift_notification_init(record, sai_thrift_notification_type_t::SAI_THRIFT_NOTIFICATION_SWITCH_SHUTDOWN_REQUEST);
+
+    record.switch_id = switch_id;
+    record.object_id = switch_id;
+
+    sai_thrift_notification_push(record);
+}
+
+void sai_thrift_notify_switch_asic_sdk_health_event(
+        sai_object_id_t switch_id,
+        sai_switch_asic_sdk_health_severity_t severity,
+        sai_switch_asic_sdk_health_category_t category,
+        const sai_u8_list_t *description)
+{
+    sai_thrift_notification_record_t record;
+    sai_thrift_notification_init(record, sai_thrift_notification_type_t::SAI_THRIFT_NOTIFICATION_SWITCH_ASIC_SDK_HEALTH_EVENT);
+
+    record.switch_id = switch_id;
+    record.object_id = switch_id;
+    record.event = severity;
+    record.status = category;
+
+    if (description != NULL && description->list != NULL) {
+        record.description_size = std::min<uint32_t>(description->count, SAI_THRIFT_NOTIFICATION_DESCRIPTION_SIZE);
+        memcpy(record.description, description->list, record.description_size);
+    }
+
+    sai_thrift_notification_push(record);
+}
+
+}
+
 static void * switch_sai_thrift_rpc_server_thread(void *arg) {
   int port = *(int *) arg;
   shared_ptr<switch_sai_rpcHandler> handler(new switch_sai_rpcHandler());
@@ -4402,4 +4734,25 @@ int start_sai_thrift_rpc_server(int port)
 
     return rc;
 }
+
+int start_sai_thrift_notification_server(int port)
+{
+    static int param = port;
+    pthread_t thread;
+
+    std::cerr << "Starting SAI notification server on port " << port << std::endl;
+
+    int rc = pthread_create(&thread, NULL, switch_sai_thrift_notification_publisher_thread, NULL);
+    if (rc) {
+        return rc;
+    }
+    pthread_detach(thread);
+
+    rc = pthread_create(&thread, NULL, switch_sai_thrift_notification_server_thread, &param);
+    if (rc) {
+        return rc;
+    }
+
+    return pthread_detach(thread);
+}
 }
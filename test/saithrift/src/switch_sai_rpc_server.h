@@ -1,3 +1,17 @@
 extern "C" {
+#include <sai.h>
+
 int start_sai_thrift_rpc_server(int port);
+
+int start_sai_thrift_notification_server(int port);
+
+void sai_thrift_notify_fdb_event(uint32_t count, const sai_fdb_event_notification_data_t *data);
+void sai_thrift_notify_port_state_change(uint32_t count, const sai_port_oper_status_notification_t *data);
+void sai_thrift_notify_switch_state_change(sai_object_id_t switch_id, sai_switch_oper_status_t switch_oper_status);
+void sai_thrift_notify_switch_shutdown_request(sai_object_id_t switch_id);
+void sai_thrift_notify_switch_asic_sdk_health_event(
+        sai_object_id_t switch_id,
+        sai_switch_asic_sdk_health_severity_t severity,
+        sai_switch_asic_sdk_health_category_t category,
+        const sai_u8_list_t *description);
 }
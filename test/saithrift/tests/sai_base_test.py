@@ -23,6 +23,7 @@ import ptf.testutils as testutils
 ################################################################
 
 import switch_sai_thrift.switch_sai_rpc as switch_sai_rpc
+from switch_sai_thrift.ttypes import sai_thrift_notification_t
 from thrift.transport import TSocket
 from thrift.transport import TTransport
 from thrift.protocol import TBinaryProtocol
@@ -86,6 +87,33 @@ class ThriftInterface(BaseTest):
         BaseTest.tearDown(self)
         self.transport.close()
 
+class NotificationClient(object):
+    """
+    Receives notifications pushed by saiserver on the notification port
+    """
+    def __init__(self, server='localhost', port=9093):
+        self.socket = TSocket.TSocket(server, port)
+        self.transport = TTransport.TFramedTransport(self.socket)
+        self.protocol = TBinaryProtocol.TBinaryProtocol(self.transport)
+        self.transport.open()
+
+    def recv(self, timeout_ms=None):
+        """
+        Block until the next notification, returns None on timeout
+        """
+        self.socket.setTimeout(timeout_ms)
+        notification = sai_thrift_notification_t()
+        try:
+            notification.read(self.protocol)
+        except TTransport.TTransportException:
+            if timeout_ms is None:
+                raise
+            return None
+        return notification
+
+    def close(self):
+        self.transport.close()
+
 class ThriftInterfaceDataPlane(ThriftInterface):
     """
     Root class that sets up the thrift interface and dataplane